@@ -4,15 +4,65 @@ include $(CLEAR_VARS)
 
 LOCAL_MODULE    := AVIPlayer
 LOCAL_SRC_FILES := \
+	AudioExtractor.cpp \
+	AviProbe.cpp \
+	AvSync.cpp \
 	Common.cpp \
+	FramePool.cpp \
+	FusedReader.cpp \
+	IndexRecovery.cpp \
+	Memory.cpp \
+	MjpegDecoder.cpp \
+	OdmlIndex.cpp \
+	OpenSLAudioSink.cpp \
+	Palette.cpp \
+	Recorder.cpp \
+	Riff.cpp \
 	com_apress_aviplayer_AbstractPlayerActivity.cpp \
 	com_apress_aviplayer_BitmapPlayerActivity.cpp \
 	com_apress_aviplayer_OpenGLPlayerActivity.cpp \
-	com_apress_aviplayer_NativeWindowPlayerActivity.cpp
+	com_apress_aviplayer_NativeWindowPlayerActivity.cpp \
+	Session.cpp \
+	SessionCache.cpp \
+	WorkerPool.cpp
+
+# Add NEON optimized version on armeabi-v7a
+ifeq ($(TARGET_ARCH_ABI),armeabi-v7a)
+	LOCAL_SRC_FILES += \
+		BrightnessFilter.cpp.neon \
+		FrameFormat.cpp.neon \
+		Idct.cpp.neon \
+		Transform.cpp.neon \
+		YuvConverter.cpp.neon
+	LOCAL_STATIC_LIBRARIES += cpufeatures
+else
+	LOCAL_SRC_FILES += \
+		BrightnessFilter.cpp \
+		FrameFormat.cpp \
+		Idct.cpp \
+		Transform.cpp \
+		YuvConverter.cpp
+endif
 
 # Use AVILib static library 
 LOCAL_STATIC_LIBRARIES += avilib_static
 
+# Use WAVLib static library
+LOCAL_STATIC_LIBRARIES += wavlib_static
+
+# Huge pages for frame buffers enabled
+MY_HUGE_PAGES_ENABLED := false
+
+# If huge pages are enabled
+ifeq ($(MY_HUGE_PAGES_ENABLED),true)
+
+# Show message
+$(info Huge pages are enabled)
+
+# Advise huge pages for pooled frame buffers
+LOCAL_CFLAGS += -DMY_HUGE_PAGES_ENABLED
+endif
+
 # Link with JNI graphics
 LOCAL_LDLIBS += -ljnigraphics
 
@@ -25,7 +75,52 @@ LOCAL_LDLIBS += -lGLESv1_CM
 # Link with Android library
 LOCAL_LDLIBS += -landroid
 
+# Link with OpenSL ES
+LOCAL_LDLIBS += -lOpenSLES
+
 include $(BUILD_SHARED_LIBRARY)
 
-# Import AVILib library module
+include $(CLEAR_VARS)
+
+# Command line AVI transcoder
+LOCAL_MODULE    := avitranscode
+LOCAL_SRC_FILES := \
+	AviTranscode.cpp \
+	FusedReader.cpp \
+	IndexRecovery.cpp \
+	MjpegDecoder.cpp \
+	Palette.cpp \
+	Riff.cpp \
+	Scaler.cpp \
+	WorkerPool.cpp
+
+# Add NEON optimized version on armeabi-v7a
+ifeq ($(TARGET_ARCH_ABI),armeabi-v7a)
+	LOCAL_SRC_FILES += \
+		FrameFormat.cpp.neon \
+		Idct.cpp.neon \
+		YuvConverter.cpp.neon
+	LOCAL_STATIC_LIBRARIES += cpufeatures
+else
+	LOCAL_SRC_FILES += \
+		FrameFormat.cpp \
+		Idct.cpp \
+		YuvConverter.cpp
+endif
+
+# Use AVILib static library 
+LOCAL_STATIC_LIBRARIES += avilib_static
+
+# Use all cores of the device
+LOCAL_CFLAGS += -DMAX_WORKER_THREADS=64
+
+include $(BUILD_EXECUTABLE)
+
+# Import AVILib and WAVLib library modules
 $(call import-module, transcode-1.1.5/avilib)
+
+# Add CPU features on armeabi-v7a
+ifeq ($(TARGET_ARCH_ABI),armeabi-v7a)
+# Import Android CPU features
+$(call import-module, android/cpufeatures)
+endif
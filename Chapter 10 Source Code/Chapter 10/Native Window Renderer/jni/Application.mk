@@ -0,0 +1 @@
+APP_ABI := armeabi armeabi-v7a x86
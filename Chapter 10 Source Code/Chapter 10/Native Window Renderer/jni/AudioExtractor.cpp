@@ -0,0 +1,103 @@
+extern "C" {
+#include <avilib.h>
+#include <wavlib.h>
+}
+
+#include "AudioExtractor.h"
+#include "IndexRecovery.h"
+#include "Memory.h"
+
+long long extractAudio(
+		const char* fileName,
+		const char* wavFileName,
+		const char** errorMessage)
+{
+	long long extractedSize = -1;
+	avi_t* avi = 0;
+	WAV wav = 0;
+	WAVError error;
+	unsigned char* buffer = 0;
+	long readSize;
+
+	// Open the AVI file, the audio is read through avilib
+	avi = openIndexedAvi(fileName);
+	if (0 == avi)
+	{
+		*errorMessage = AVI_strerror();
+		goto exit;
+	}
+
+	// Only uncompressed audio can go into the WAV file as is
+	if ((0 >= AVI_audio_tracks(avi))
+			|| (WAVE_FORMAT_PCM != AVI_audio_format(avi))
+			|| (0 >= AVI_audio_rate(avi)))
+	{
+		*errorMessage = "No PCM audio track.";
+		goto exit;
+	}
+
+	// Buffer the audio is copied through
+	buffer = (unsigned char*) allocateMemory(0, MEMORY_AUDIO,
+			EXTRACT_BUFFER_SIZE);
+	if (0 == buffer)
+	{
+		*errorMessage = "Unable to allocate the audio buffer.";
+		goto exit;
+	}
+
+	// Open the WAV file for writing
+	wav = wav_open(wavFileName, WAV_WRITE, &error);
+	if (0 == wav)
+	{
+		*errorMessage = wav_strerror(error);
+		goto exit;
+	}
+
+	// Format is set before the first write
+	wav_set_rate(wav, AVI_audio_rate(avi));
+	wav_set_channels(wav, AVI_audio_channels(avi));
+	wav_set_bits(wav, AVI_audio_bits(avi));
+	wav_set_bitrate(wav, AVI_audio_rate(avi)
+			* AVI_audio_channels(avi)
+			* AVI_audio_bits(avi));
+
+	// Copy the audio chunks a buffer at a time
+	AVI_set_audio_position(avi, 0);
+	extractedSize = 0;
+
+	while (0 < (readSize = AVI_read_audio(avi, (char*) buffer,
+			EXTRACT_BUFFER_SIZE)))
+	{
+		if (readSize != wav_write_data(wav, buffer, readSize))
+		{
+			*errorMessage = "Unable to write the WAV file.";
+			extractedSize = -1;
+			goto exit;
+		}
+
+		extractedSize += readSize;
+	}
+
+	if (0 > readSize)
+	{
+		*errorMessage = AVI_strerror();
+		extractedSize = -1;
+	}
+
+exit:
+	// Header gets the final data size on close
+	if ((0 != wav) && (0 != wav_close(wav)) && (0 <= extractedSize))
+	{
+		*errorMessage = "Unable to write the WAV file.";
+		extractedSize = -1;
+	}
+
+	freeMemory(buffer);
+
+	if (0 != avi)
+	{
+		AVI_close(avi);
+	}
+
+	return extractedSize;
+}
@@ -0,0 +1,24 @@
+#pragma once
+
+/**
+ * Size of the buffer the audio is copied through. Reads
+ * and writes are done in blocks of this size, so memory
+ * use does not depend on the length of the track.
+ */
+#define EXTRACT_BUFFER_SIZE (1024 * 1024)
+
+/**
+ * Extracts the PCM audio track of the given AVI file into
+ * a WAV file. The track is streamed through a single
+ * buffer, the WAV header is completed when the file is
+ * closed.
+ *
+ * @param fileName AVI file name.
+ * @param wavFileName WAV file name.
+ * @param errorMessage [OUT] error message on failure.
+ * @return extracted audio size in bytes, or -1 on failure.
+ */
+long long extractAudio(
+		const char* fileName,
+		const char* wavFileName,
+		const char** errorMessage);
@@ -0,0 +1,126 @@
+#pragma once
+
+/**
+ * Audio reader. Gets called by the audio sink to fill its
+ * next buffer with PCM data, on the sink's own thread.
+ *
+ * @param context reader context.
+ * @param buffer buffer to fill.
+ * @param size buffer size in bytes.
+ * @return bytes read, 0 at the end of the audio.
+ */
+typedef long (*AudioReader)(
+		void* context,
+		unsigned char* buffer,
+		long size);
+
+/**
+ * PCM format of an audio sink.
+ */
+struct AudioSinkFormat
+{
+	int channels;
+	long rate;
+	int bits;
+};
+
+struct AudioSink;
+
+/**
+ * Audio sink operations. The OpenSL ES sink implements
+ * them on the device, and the simulated sink on the host,
+ * so the code that syncs to the sink runs on both.
+ */
+struct AudioSinkOps
+{
+	/**
+	 * Starts pulling buffers from the reader and playing them.
+	 */
+	bool (*start)(
+			AudioSink* sink);
+
+	/**
+	 * Pulls buffers from the reader again if the sink ran
+	 * dry at the end of the audio.
+	 */
+	void (*refill)(
+			AudioSink* sink);
+
+	/**
+	 * Gets the number of PCM frames played so far.
+	 */
+	long long (*getPlayedFrames)(
+			AudioSink* sink);
+
+	/**
+	 * Stops playing and frees the sink.
+	 */
+	void (*destroy)(
+			AudioSink* sink);
+};
+
+/**
+ * Audio sink. Implementations embed it as their first
+ * member.
+ */
+struct AudioSink
+{
+	const AudioSinkOps* ops;
+
+	AudioSinkFormat format;
+
+	// Reader of the PCM data
+	AudioReader reader;
+	void* context;
+};
+
+/**
+ * Starts the given audio sink.
+ *
+ * @param sink audio sink.
+ * @return true on success, false otherwise.
+ */
+inline bool startAudioSink(
+		AudioSink* sink)
+{
+	return sink->ops->start(sink);
+}
+
+/**
+ * Refills the given audio sink after the reader has more
+ * data, such as after seeking back from the end.
+ *
+ * @param sink audio sink.
+ */
+inline void refillAudioSink(
+		AudioSink* sink)
+{
+	sink->ops->refill(sink);
+}
+
+/**
+ * Gets the playback position of the given audio sink. This
+ * is the master clock of the audio and video playback.
+ *
+ * @param sink audio sink.
+ * @return position in microseconds.
+ */
+inline long long getAudioSinkPosition(
+		AudioSink* sink)
+{
+	return (sink->ops->getPlayedFrames(sink) * 1000000LL) / sink->format.rate;
+}
+
+/**
+ * Destroys the given audio sink.
+ *
+ * @param sink audio sink, may be 0.
+ */
+inline void destroyAudioSink(
+		AudioSink* sink)
+{
+	if (0 != sink)
+	{
+		sink->ops->destroy(sink);
+	}
+}
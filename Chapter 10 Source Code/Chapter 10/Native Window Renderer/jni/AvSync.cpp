@@ -0,0 +1,77 @@
+#include "AvSync.h"
+
+long long getFramePresentationTime(
+		const AvSync* sync,
+		long frame)
+{
+	return sync->clockOffset + (long long) ((frame * 1000000.0) / sync->frameRate);
+}
+
+long syncVideoFrame(
+		AvSync* sync,
+		long frame,
+		long long clock)
+{
+	long long drift = getFramePresentationTime(sync, frame) - clock;
+
+	// Too early, keep showing the current frame
+	if (AV_SYNC_THRESHOLD < drift)
+	{
+		sync->repeatedFrames++;
+		return -1;
+	}
+
+	// Too late, skip to the frame nearest to the clock
+	if (-AV_SYNC_THRESHOLD > drift)
+	{
+		long nearest = (long) ((((clock - sync->clockOffset) * sync->frameRate)
+				/ 1000000.0) + 0.5);
+
+		if (nearest > frame)
+		{
+			sync->droppedFrames += nearest - frame;
+			frame = nearest;
+			drift = getFramePresentationTime(sync, frame) - clock;
+		}
+	}
+
+	sync->shownFrames++;
+	sync->lastDrift = drift;
+
+	if (0 > drift)
+	{
+		drift = -drift;
+	}
+
+	sync->totalDrift += drift;
+	if (sync->maxDrift < drift)
+	{
+		sync->maxDrift = drift;
+	}
+
+	return frame;
+}
+
+long long getAvSyncDelay(
+		const AvSync* sync,
+		long frame,
+		long long clock)
+{
+	long long delay = getFramePresentationTime(sync, frame) - clock;
+
+	return (0 < delay) ? delay : 0;
+}
+
+void getAvSyncStats(
+		const AvSync* sync,
+		long long* values)
+{
+	values[AV_SYNC_SHOWN_FRAMES] = sync->shownFrames;
+	values[AV_SYNC_DROPPED_FRAMES] = sync->droppedFrames;
+	values[AV_SYNC_REPEATED_FRAMES] = sync->repeatedFrames;
+	values[AV_SYNC_LAST_DRIFT] = sync->lastDrift;
+	values[AV_SYNC_MAX_DRIFT] = sync->maxDrift;
+	values[AV_SYNC_MEAN_DRIFT] = (0 < sync->shownFrames)
+			? sync->totalDrift / sync->shownFrames
+			: 0;
+}
@@ -0,0 +1,108 @@
+#pragma once
+
+/**
+ * Video frames are kept within this many microseconds of
+ * the audio clock.
+ */
+#define AV_SYNC_THRESHOLD 20000
+
+/**
+ * Sync statistics. The values are shared with the
+ * AbstractPlayerActivity constants. Drifts are in
+ * microseconds, positive when the video is ahead.
+ */
+enum AvSyncStat
+{
+	AV_SYNC_SHOWN_FRAMES = 0,
+	AV_SYNC_DROPPED_FRAMES = 1,
+	AV_SYNC_REPEATED_FRAMES = 2,
+	AV_SYNC_LAST_DRIFT = 3,
+	AV_SYNC_MAX_DRIFT = 4,
+	AV_SYNC_MEAN_DRIFT = 5,
+	AV_SYNC_STATS = 6
+};
+
+/**
+ * Video sync to the audio master clock.
+ */
+struct AvSync
+{
+	double frameRate;
+
+	// Audio clock at frame 0, moves when seeking
+	long long clockOffset;
+
+	long long shownFrames;
+	long long droppedFrames;
+	long long repeatedFrames;
+
+	// Drift of the last shown frame, the largest one, and
+	// the sum of their magnitudes
+	long long lastDrift;
+	long long maxDrift;
+	long long totalDrift;
+
+	AvSync():
+		frameRate(0),
+		clockOffset(0),
+		shownFrames(0),
+		droppedFrames(0),
+		repeatedFrames(0),
+		lastDrift(0),
+		maxDrift(0),
+		totalDrift(0)
+	{
+
+	}
+};
+
+/**
+ * Gets the presentation time of the given frame.
+ *
+ * @param sync video sync.
+ * @param frame frame number.
+ * @return presentation time in microseconds.
+ */
+long long getFramePresentationTime(
+		const AvSync* sync,
+		long frame);
+
+/**
+ * Decides which frame to show at the given audio clock.
+ * If the next frame is early by more than the threshold,
+ * the shown frame is repeated. If it is late by more than
+ * the threshold, the frames up to the one nearest to the
+ * clock are dropped without being read.
+ *
+ * @param sync video sync.
+ * @param frame next frame number.
+ * @param clock audio clock in microseconds.
+ * @return frame to show, or -1 to repeat the shown frame.
+ */
+long syncVideoFrame(
+		AvSync* sync,
+		long frame,
+		long long clock);
+
+/**
+ * Gets the time until the given frame is due.
+ *
+ * @param sync video sync.
+ * @param frame next frame number.
+ * @param clock audio clock in microseconds.
+ * @return delay in microseconds, 0 if the frame is due.
+ */
+long long getAvSyncDelay(
+		const AvSync* sync,
+		long frame,
+		long long clock);
+
+/**
+ * Gets the sync statistics.
+ *
+ * @param sync video sync.
+ * @param values statistics, AV_SYNC_STATS of them. [OUT]
+ */
+void getAvSyncStats(
+		const AvSync* sync,
+		long long* values);
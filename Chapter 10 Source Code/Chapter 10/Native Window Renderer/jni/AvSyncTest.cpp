@@ -0,0 +1,210 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "AvSync.h"
+#include "SimulatedAudioSink.h"
+
+// Test clip, 30 frames per second of 16-bit stereo audio
+#define TEST_FRAME_RATE 30.0
+#define TEST_AUDIO_RATE 44100
+#define TEST_AUDIO_SECONDS 20
+#define TEST_BUFFER_SIZE 4096
+
+/**
+ * PCM reader of the test clip, silence until its end.
+ */
+struct TestAudio
+{
+	long long bytesLeft;
+};
+
+static long readTestAudio(
+		void* context,
+		unsigned char* buffer,
+		long size)
+{
+	TestAudio* audio = (TestAudio*) context;
+
+	if (size > audio->bytesLeft)
+	{
+		size = (long) audio->bytesLeft;
+	}
+
+	memset(buffer, 0, size);
+	audio->bytesLeft -= size;
+
+	return size;
+}
+
+/**
+ * Expected statistics, counted by the test itself.
+ */
+struct TestStats
+{
+	long long shown;
+	long long dropped;
+	long long repeated;
+	long long lastDrift;
+	long long maxDrift;
+	long long totalDrift;
+};
+
+/**
+ * Plays the test clip through the simulated sink like the
+ * render loop does. Each frame takes the given render time,
+ * every slowEvery frame takes slowTime, and the loop waits
+ * for the sync delay, or for tick if it is not 0.
+ *
+ * @return number of failed checks.
+ */
+static int runPlayback(
+		const char* name,
+		long long renderTime,
+		long slowEvery,
+		long long slowTime,
+		long long tick,
+		long frameCount)
+{
+	int failures = 0;
+	AvSync sync;
+	TestStats expected;
+	TestAudio audio;
+	AudioSinkFormat format;
+	long long values[AV_SYNC_STATS];
+	long frame = 0;
+	long shownFrame = -1;
+
+	memset(&expected, 0, sizeof(expected));
+	sync.frameRate = TEST_FRAME_RATE;
+
+	format.channels = 2;
+	format.rate = TEST_AUDIO_RATE;
+	format.bits = 16;
+	audio.bytesLeft = (long long) TEST_AUDIO_SECONDS * TEST_AUDIO_RATE * 4;
+
+	AudioSink* sink = createSimulatedAudioSink(format, TEST_BUFFER_SIZE,
+			readTestAudio, &audio);
+	if ((0 == sink) || !startAudioSink(sink))
+	{
+		printf("%s: unable to start the sink\n", name);
+		return 1;
+	}
+
+	while (frame < frameCount)
+	{
+		long long clock = getAudioSinkPosition(sink);
+		long shown = syncVideoFrame(&sync, frame, clock);
+
+		if (0 > shown)
+		{
+			// Repeated only when the frame is early
+			long long drift = getFramePresentationTime(&sync, frame) - clock;
+			if (AV_SYNC_THRESHOLD >= drift)
+			{
+				printf("%s: frame %ld repeated at drift %lld\n",
+						name, frame, drift);
+				failures++;
+			}
+
+			expected.repeated++;
+		}
+		else
+		{
+			long long drift = getFramePresentationTime(&sync, shown) - clock;
+			long long magnitude = (0 > drift) ? -drift : drift;
+
+			if (AV_SYNC_THRESHOLD < magnitude)
+			{
+				printf("%s: frame %ld shown at drift %lld\n",
+						name, shown, drift);
+				failures++;
+			}
+
+			if ((shown < frame) || (shown <= shownFrame))
+			{
+				printf("%s: frame %ld shown after %ld\n",
+						name, shown, shownFrame);
+				failures++;
+			}
+
+			expected.shown++;
+			expected.dropped += shown - frame;
+			expected.lastDrift = drift;
+			expected.totalDrift += magnitude;
+			if (expected.maxDrift < magnitude)
+			{
+				expected.maxDrift = magnitude;
+			}
+
+			shownFrame = shown;
+			frame = shown + 1;
+
+			// Rendering moves the clock on
+			advanceSimulatedAudioSink(sink,
+					((0 < slowEvery) && (0 == (shown % slowEvery)))
+							? slowTime
+							: renderTime);
+		}
+
+		// Wait for the next frame
+		if (0 < tick)
+		{
+			advanceSimulatedAudioSink(sink, tick);
+		}
+		else
+		{
+			long long delay = getAvSyncDelay(&sync, frame,
+					getAudioSinkPosition(sink));
+			advanceSimulatedAudioSink(sink, (0 < delay) ? delay : 1);
+		}
+	}
+
+	getAvSyncStats(&sync, values);
+
+	if ((expected.shown != values[AV_SYNC_SHOWN_FRAMES])
+			|| (expected.dropped != values[AV_SYNC_DROPPED_FRAMES])
+			|| (expected.repeated != values[AV_SYNC_REPEATED_FRAMES])
+			|| (expected.lastDrift != values[AV_SYNC_LAST_DRIFT])
+			|| (expected.maxDrift != values[AV_SYNC_MAX_DRIFT])
+			|| (expected.totalDrift / expected.shown
+					!= values[AV_SYNC_MEAN_DRIFT]))
+	{
+		printf("%s: statistics do not match\n", name);
+		failures++;
+	}
+
+	printf("%s: %lld shown, %lld dropped, %lld repeated, "
+			"drift last %lld max %lld mean %lld us, %s\n",
+			name,
+			values[AV_SYNC_SHOWN_FRAMES],
+			values[AV_SYNC_DROPPED_FRAMES],
+			values[AV_SYNC_REPEATED_FRAMES],
+			values[AV_SYNC_LAST_DRIFT],
+			values[AV_SYNC_MAX_DRIFT],
+			values[AV_SYNC_MEAN_DRIFT],
+			(0 == failures) ? "ok" : "FAILED");
+
+	destroyAudioSink(sink);
+
+	return failures;
+}
+
+int main()
+{
+	int failures = 0;
+
+	// Fast renderer, frames are shown on time
+	failures += runPlayback("on time", 5000, 0, 0, 0, 300);
+
+	// Short ticks, early frames are repeated
+	failures += runPlayback("repeat", 2000, 0, 0, 7000, 300);
+
+	// Slow frames fall behind, late frames are dropped
+	failures += runPlayback("drop", 5000, 25, 150000, 0, 300);
+
+	// Renderer slower than the frame rate throughout
+	failures += runPlayback("slow", 45000, 0, 0, 0, 300);
+
+	return (0 == failures) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
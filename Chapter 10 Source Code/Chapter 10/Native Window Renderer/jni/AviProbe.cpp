@@ -0,0 +1,294 @@
+#include "AviProbe.h"
+
+#include <fcntl.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "Riff.h"
+#include "WorkerPool.h"
+
+// RIFF AVI header and the hdrl list header
+#define HEADER_LIST_OFFSET 24
+
+// Minimum sizes of the chunks that are parsed
+#define AVIH_SIZE 40
+#define STRH_SIZE 36
+#define BITMAPINFOHEADER_SIZE 20
+#define WAVEFORMATEX_SIZE 16
+#define DMLH_SIZE 4
+
+/**
+ * Batch probe context.
+ */
+struct ProbeBatch
+{
+	const char* const* fileNames;
+	long long* info;
+};
+
+/**
+ * Parses the given stream list into the probe values.
+ * Only the first video and audio streams are used.
+ *
+ * @param list stream list.
+ * @param size stream list size in bytes.
+ * @param info probe values. [OUT]
+ * @param frameRate video frame rate. [OUT]
+ * @param isVideoFound video stream is parsed. [IN/OUT]
+ * @param isAudioFound audio stream is parsed. [IN/OUT]
+ */
+static void parseStreamList(
+		const unsigned char* list,
+		unsigned long size,
+		long long* info,
+		double* frameRate,
+		bool* isVideoFound,
+		bool* isAudioFound)
+{
+	unsigned long streamHeaderSize = 0;
+	unsigned long formatSize = 0;
+
+	// Stream header and format come before the indices
+	const unsigned char* streamHeader = findRiffChunk(list, size,
+			"strh", &streamHeaderSize);
+	const unsigned char* format = findRiffChunk(list, size,
+			"strf", &formatSize);
+
+	if ((0 == streamHeader) || (STRH_SIZE > streamHeaderSize)
+			|| (0 == format))
+	{
+		return;
+	}
+
+	if (!*isVideoFound && (0 == memcmp(streamHeader, "vids", 4)))
+	{
+		unsigned long scale = readRiffLong(streamHeader + 20);
+		unsigned long rate = readRiffLong(streamHeader + 24);
+		unsigned long length = readRiffLong(streamHeader + 32);
+
+		// Main header count is kept if the length is not set
+		if (0 != length)
+		{
+			info[PROBE_FRAME_COUNT] = length;
+		}
+
+		if ((0 != rate) && (0 != scale))
+		{
+			*frameRate = (double) rate / scale;
+		}
+
+		// Compressor of the frames, handler is often left empty
+		info[PROBE_COMPRESSOR] = readRiffLong(streamHeader + 4);
+
+		if (BITMAPINFOHEADER_SIZE <= formatSize)
+		{
+			// Top down frames have a negative height
+			int height = (int) readRiffLong(format + 8);
+
+			info[PROBE_WIDTH] = readRiffLong(format + 4);
+			info[PROBE_HEIGHT] = (0 > height) ? -height : height;
+			info[PROBE_COMPRESSOR] = readRiffLong(format + 16);
+		}
+
+		*isVideoFound = true;
+	}
+	else if (!*isAudioFound
+			&& (0 == memcmp(streamHeader, "auds", 4))
+			&& (WAVEFORMATEX_SIZE <= formatSize))
+	{
+		info[PROBE_AUDIO_FORMAT] = readRiffShort(format);
+		info[PROBE_AUDIO_CHANNELS] = readRiffShort(format + 2);
+		info[PROBE_AUDIO_RATE] = readRiffLong(format + 4);
+		info[PROBE_AUDIO_BITS] = readRiffShort(format + 14);
+
+		*isAudioFound = true;
+	}
+}
+
+/**
+ * Parses the given header list into the probe values. The
+ * list may be cut off at the end of the read, so the list
+ * sizes are limited to what is read.
+ *
+ * @param headerList header list.
+ * @param size header list bytes read.
+ * @param info probe values. [OUT]
+ * @return true if a video stream is found.
+ */
+static bool parseHeaderList(
+		const unsigned char* headerList,
+		unsigned long size,
+		long long* info)
+{
+	bool isVideoFound = false;
+	bool isAudioFound = false;
+	long long odmlFrameCount = -1;
+	double frameRate = 0;
+	unsigned long offset = 0;
+
+	while (offset + RIFF_CHUNK_HEADER_SIZE <= size)
+	{
+		const unsigned char* chunk = headerList + offset;
+		const unsigned char* data = chunk + RIFF_CHUNK_HEADER_SIZE;
+		unsigned long length = readRiffLong(chunk + 4);
+		unsigned long available = size - offset - RIFF_CHUNK_HEADER_SIZE;
+
+		if (length > available)
+		{
+			length = available;
+		}
+
+		if ((0 == memcmp(chunk, "avih", 4)) && (AVIH_SIZE <= length))
+		{
+			unsigned long frameTime = readRiffLong(data);
+
+			// Main header, until the stream headers are found
+			if (0 != frameTime)
+			{
+				frameRate = 1000000.0 / frameTime;
+			}
+
+			info[PROBE_FRAME_COUNT] = readRiffLong(data + 16);
+			info[PROBE_WIDTH] = readRiffLong(data + 32);
+			info[PROBE_HEIGHT] = readRiffLong(data + 36);
+		}
+		else if ((0 == memcmp(chunk, "LIST", 4)) && (4 <= length))
+		{
+			if (0 == memcmp(data, "strl", 4))
+			{
+				parseStreamList(data + 4, length - 4, info, &frameRate,
+						&isVideoFound, &isAudioFound);
+			}
+			else if (0 == memcmp(data, "odml", 4))
+			{
+				unsigned long headerSize = 0;
+				const unsigned char* header = findRiffChunk(data + 4,
+						length - 4, "dmlh", &headerSize);
+
+				// Total of all the RIFF parts of an OpenDML file,
+				// the other counts are of the first part
+				if ((0 != header) && (DMLH_SIZE <= headerSize))
+				{
+					odmlFrameCount = readRiffLong(header);
+				}
+			}
+		}
+
+		// Chunks are padded to even sizes
+		offset += RIFF_CHUNK_HEADER_SIZE + length + (length & 1);
+	}
+
+	if (0 < odmlFrameCount)
+	{
+		info[PROBE_FRAME_COUNT] = odmlFrameCount;
+	}
+
+	if (0 < frameRate)
+	{
+		info[PROBE_DURATION] = (long long) (info[PROBE_FRAME_COUNT]
+				* 1000 / frameRate);
+	}
+
+	return isVideoFound;
+}
+
+bool probeAvi(
+		const char* fileName,
+		long long* info)
+{
+	bool isProbed = false;
+	unsigned char header[PROBE_HEADER_SIZE];
+	long size;
+
+	int fileDescriptor = open(fileName, O_RDONLY);
+	if (0 > fileDescriptor)
+	{
+		goto exit;
+	}
+
+	// Headers are read at once, and only them
+	size = pread(fileDescriptor, header, sizeof(header), 0);
+	close(fileDescriptor);
+
+	if ((HEADER_LIST_OFFSET > size)
+			|| (0 != memcmp(header, "RIFF", 4))
+			|| (0 != memcmp(header + 8, "AVI ", 4))
+			|| (0 != memcmp(header + 12, "LIST", 4))
+			|| (0 != memcmp(header + 20, "hdrl", 4)))
+	{
+		goto exit;
+	}
+
+	for (int i = 0; i < PROBE_INFO_SIZE; i++)
+	{
+		info[i] = 0;
+	}
+
+	// Header list, up to where the read ends
+	size -= HEADER_LIST_OFFSET;
+	if (readRiffLong(header + 16) - 4 < (unsigned long) size)
+	{
+		size = readRiffLong(header + 16) - 4;
+	}
+
+	isProbed = parseHeaderList(header + HEADER_LIST_OFFSET, size, info);
+
+exit:
+	if (!isProbed)
+	{
+		for (int i = 0; i < PROBE_INFO_SIZE; i++)
+		{
+			info[i] = -1;
+		}
+	}
+
+	return isProbed;
+}
+
+/**
+ * Probe worker task, probes one file.
+ *
+ * @param context batch probe.
+ * @param index file index.
+ */
+static void probeTask(
+		void* context,
+		int index)
+{
+	ProbeBatch* batch = (ProbeBatch*) context;
+
+	probeAvi(batch->fileNames[index],
+			batch->info + (index * PROBE_INFO_SIZE));
+}
+
+void probeAviFiles(
+		const char* const* fileNames,
+		int count,
+		long long* info)
+{
+	if (0 >= count)
+	{
+		return;
+	}
+
+	ProbeBatch batch;
+	batch.fileNames = fileNames;
+	batch.info = info;
+
+	int threadCount = (PROBE_MAX_THREADS < count) ? PROBE_MAX_THREADS : count;
+
+	// Files are probed in place if no threads can be started
+	WorkerPool* pool = createWorkerPool(threadCount);
+	if (0 == pool)
+	{
+		for (int i = 0; i < count; i++)
+		{
+			probeTask(&batch, i);
+		}
+	}
+	else
+	{
+		runWorkerTasks(pool, probeTask, &batch, count);
+		destroyWorkerPool(pool);
+	}
+}
@@ -0,0 +1,63 @@
+#pragma once
+
+/**
+ * Bytes read from the start of the file when probing. The
+ * hdrl list is a few kilobytes, OpenDML files reserve
+ * some more for their super indices.
+ */
+#define PROBE_HEADER_SIZE (16 * 1024)
+
+/**
+ * Maximum number of threads probing files. Probing waits
+ * on the storage, not the CPU, so it is not limited to
+ * the CPU count.
+ */
+#define PROBE_MAX_THREADS 8
+
+/**
+ * Probe information. The values are shared with the
+ * AbstractPlayerActivity constants.
+ */
+enum ProbeInfo
+{
+	PROBE_WIDTH = 0,
+	PROBE_HEIGHT = 1,
+	PROBE_FRAME_COUNT = 2,
+	PROBE_DURATION = 3,
+	PROBE_COMPRESSOR = 4,
+	PROBE_AUDIO_FORMAT = 5,
+	PROBE_AUDIO_CHANNELS = 6,
+	PROBE_AUDIO_RATE = 7,
+	PROBE_AUDIO_BITS = 8,
+	PROBE_INFO_SIZE = 9
+};
+
+/**
+ * Probes the given AVI file by reading its headers with
+ * a single pread. The duration is in milliseconds, the
+ * compressor is the FOURCC of the video frames, 0 for
+ * uncompressed ones, and the audio values are 0 without
+ * audio.
+ *
+ * @param fileName file name.
+ * @param info PROBE_INFO_SIZE values. [OUT]
+ * @return true on success, false if the file is not an
+ * AVI file with a video stream.
+ */
+bool probeAvi(
+		const char* fileName,
+		long long* info);
+
+/**
+ * Probes the given AVI files on several threads. The
+ * values of the files that cannot be probed are set to
+ * -1.
+ *
+ * @param fileNames file names.
+ * @param count number of files.
+ * @param info PROBE_INFO_SIZE values for each file. [OUT]
+ */
+void probeAviFiles(
+		const char* const* fileNames,
+		int count,
+		long long* info);
@@ -0,0 +1,761 @@
+extern "C" {
+#include <avilib.h>
+}
+
+#include <fcntl.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/time.h>
+#include <unistd.h>
+
+#include "FrameFormat.h"
+#include "FusedReader.h"
+#include "IndexRecovery.h"
+#include "PixelFormat.h"
+#include "Riff.h"
+#include "Scaler.h"
+#include "WorkerPool.h"
+
+/**
+ * Frames in a batch for each thread. Threads take the
+ * frames of a batch one at a time, so uneven frames
+ * balance out within the batch.
+ */
+#define TRANSCODE_FRAMES_PER_THREAD 4
+
+// Offsets of the bit count and the image size in strf
+#define BI_BIT_COUNT_OFFSET 14
+#define BI_SIZE_IMAGE_OFFSET 20
+
+/**
+ * Output frame of a batch.
+ */
+struct TranscodeFrame
+{
+	// Source frame shown at the output frame time
+	long sourceFrame;
+
+	// Same source frame as the output frame before it
+	bool isDuplicate;
+
+	// Converted frame size, or -1 if it cannot be read
+	long size;
+	unsigned short* pixels;
+};
+
+/**
+ * Batch of output frames, converted on the worker pool
+ * and written in order by the writer thread.
+ */
+struct TranscodeBatch
+{
+	TranscodeFrame* frames;
+	int frameCount;
+};
+
+/**
+ * Transcoder state.
+ */
+struct Transcoder
+{
+	avi_t* input;
+	avi_t* output;
+	FrameFormatInfo frameFormat;
+
+	int sourceWidth;
+	int sourceHeight;
+	double sourceFrameRate;
+	long sourceFrameCount;
+
+	int width;
+	int height;
+	double frameRate;
+	long frameCount;
+	bool isDithered;
+
+	// Scaler shared by the threads, 0 if the size is kept
+	Scaler* scaler;
+
+	// Reader and source frame of each worker task
+	int threadCount;
+	WorkerPool* pool;
+	FusedReader* readers[MAX_WORKER_THREADS];
+	unsigned short* sourceFrames[MAX_WORKER_THREADS];
+
+	// One batch is converted while the other is written
+	TranscodeBatch batches[2];
+	TranscodeBatch* current;
+	volatile int nextFrame;
+
+	// Writer thread signaling
+	pthread_t writer;
+	bool isWriterStarted;
+	pthread_mutex_t mutex;
+	pthread_cond_t condition;
+	TranscodeBatch* pending;
+	TranscodeBatch* writing;
+	bool isStopping;
+	bool isFailed;
+
+	long writtenFrames;
+	long unreadFrames;
+};
+
+/**
+ * Prints the usage.
+ *
+ * @param name program name.
+ */
+static void printUsage(
+		const char* name)
+{
+	fprintf(stderr,
+			"Usage: %s [options] input.avi output.avi\n"
+			"Converts the video of the input file to raw RGB565.\n"
+			"  -w width    output width, source width by default\n"
+			"  -h height   output height, source height by default\n"
+			"  -r rate     output frame rate, source rate by default\n"
+			"  -j threads  conversion threads, all cores by default\n"
+			"  -d          dither when reducing the color depth\n",
+			name);
+}
+
+/**
+ * Gets the current time in milliseconds.
+ *
+ * @return time in milliseconds.
+ */
+static long long getTimeMillis()
+{
+	struct timeval now;
+	gettimeofday(&now, 0);
+
+	return ((long long) now.tv_sec * 1000) + (now.tv_usec / 1000);
+}
+
+/**
+ * Worker task, converts frames of the current batch until
+ * there are none left.
+ *
+ * @param context transcoder.
+ * @param index worker index, selects the reader.
+ */
+static void transcodeTask(
+		void* context,
+		int index)
+{
+	Transcoder* transcoder = (Transcoder*) context;
+	TranscodeBatch* batch = transcoder->current;
+	long rowSize = transcoder->width * Rgb565Format::BYTES_PER_PIXEL;
+	long sourceRowSize = transcoder->sourceWidth
+			* Rgb565Format::BYTES_PER_PIXEL;
+
+	while (true)
+	{
+		int i = __sync_fetch_and_add(&transcoder->nextFrame, 1);
+		if (i >= batch->frameCount)
+		{
+			break;
+		}
+
+		TranscodeFrame* frame = &batch->frames[i];
+		if (frame->isDuplicate)
+		{
+			continue;
+		}
+
+		video_index_entry* entry =
+				&transcoder->input->video_index[frame->sourceFrame];
+
+		// Converted to RGB565 straight into the output frame
+		// if the size is kept, scaled from the source frame
+		// of the worker otherwise
+		if (0 == transcoder->scaler)
+		{
+			frame->size = readFusedFrame(transcoder->readers[index],
+					transcoder->input->fdes,
+					entry->pos,
+					entry->len,
+					frame->pixels,
+					rowSize,
+					0,
+					0);
+		}
+		else
+		{
+			frame->size = readFusedFrame(transcoder->readers[index],
+					transcoder->input->fdes,
+					entry->pos,
+					entry->len,
+					transcoder->sourceFrames[index],
+					sourceRowSize,
+					0,
+					0);
+
+			if (0 < frame->size)
+			{
+				scaleFrame(transcoder->scaler,
+						transcoder->sourceFrames[index],
+						sourceRowSize,
+						frame->pixels,
+						rowSize);
+			}
+		}
+
+		if (0 < frame->size)
+		{
+			frame->size = rowSize * transcoder->height;
+		}
+		else
+		{
+			frame->size = -1;
+		}
+	}
+}
+
+/**
+ * Writer thread. Writes the frames of each batch in order
+ * while the next batch is converted.
+ *
+ * @param data transcoder.
+ * @return 0.
+ */
+static void* writeBatches(
+		void* data)
+{
+	Transcoder* transcoder = (Transcoder*) data;
+
+	pthread_mutex_lock(&transcoder->mutex);
+
+	while (true)
+	{
+		while ((0 == transcoder->pending) && !transcoder->isStopping)
+		{
+			pthread_cond_wait(&transcoder->condition, &transcoder->mutex);
+		}
+
+		if (0 == transcoder->pending)
+		{
+			break;
+		}
+
+		TranscodeBatch* batch = transcoder->pending;
+		transcoder->pending = 0;
+		transcoder->writing = batch;
+
+		pthread_cond_broadcast(&transcoder->condition);
+		pthread_mutex_unlock(&transcoder->mutex);
+
+		for (int i = 0; (i < batch->frameCount) && !transcoder->isFailed; i++)
+		{
+			TranscodeFrame* frame = &batch->frames[i];
+			int result;
+
+			if (!frame->isDuplicate && (0 > frame->size))
+			{
+				transcoder->unreadFrames++;
+			}
+
+			// Repeated and unreadable frames point to the last one,
+			// unreadable leading frames are left out
+			if (frame->isDuplicate || (0 > frame->size))
+			{
+				if (0 == transcoder->writtenFrames)
+				{
+					continue;
+				}
+
+				result = AVI_dup_frame(transcoder->output);
+			}
+			else
+			{
+				result = AVI_write_frame(transcoder->output,
+						(char*) frame->pixels,
+						frame->size,
+						1);
+			}
+
+			if (0 == result)
+			{
+				transcoder->writtenFrames++;
+			}
+			else
+			{
+				transcoder->isFailed = true;
+			}
+		}
+
+		pthread_mutex_lock(&transcoder->mutex);
+		transcoder->writing = 0;
+		pthread_cond_broadcast(&transcoder->condition);
+	}
+
+	pthread_mutex_unlock(&transcoder->mutex);
+
+	return 0;
+}
+
+/**
+ * Marks the video stream of the given AVI file as 16-bit,
+ * as avilib always writes a 24-bit format header. Raw
+ * 16-bit frames are taken as RGB565 by the players.
+ *
+ * @param fileName AVI file name.
+ * @param width frame width in pixels.
+ * @param height frame height in pixels.
+ * @return true on success.
+ */
+static bool setRgb565Header(
+		const char* fileName,
+		int width,
+		int height)
+{
+	bool isSet = false;
+	unsigned char* headerList = 0;
+	unsigned long size = 0;
+	unsigned long listSize = 0;
+	unsigned long formatSize = 0;
+	const unsigned char* list;
+	const unsigned char* format;
+	off_t offset;
+	unsigned char bitCount[2];
+	unsigned char sizeImage[4];
+
+	int fileDescriptor = open(fileName, O_RDWR);
+	if (0 > fileDescriptor)
+	{
+		goto exit;
+	}
+
+	headerList = readRiffHeaderList(fileDescriptor, &size);
+	if (0 == headerList)
+	{
+		goto exit;
+	}
+
+	list = findVideoStreamList(headerList, size, &listSize);
+	format = (0 == list) ? 0 : findRiffChunk(list, listSize, "strf",
+			&formatSize);
+
+	if ((0 == format) || (BI_SIZE_IMAGE_OFFSET + 4 > formatSize))
+	{
+		goto exit;
+	}
+
+	// Header list starts after the RIFF and the LIST headers
+	offset = 24 + (format - headerList);
+
+	bitCount[0] = 16;
+	bitCount[1] = 0;
+	writeRiffLong(sizeImage, width * height * Rgb565Format::BYTES_PER_PIXEL);
+
+	isSet = (sizeof(bitCount) == pwrite(fileDescriptor, bitCount,
+					sizeof(bitCount), offset + BI_BIT_COUNT_OFFSET))
+			&& (sizeof(sizeImage) == pwrite(fileDescriptor, sizeImage,
+					sizeof(sizeImage), offset + BI_SIZE_IMAGE_OFFSET));
+
+exit:
+	free(headerList);
+
+	if (0 <= fileDescriptor)
+	{
+		close(fileDescriptor);
+	}
+
+	return isSet;
+}
+
+/**
+ * Creates the readers, the scaler, the batches and the
+ * threads of the given transcoder.
+ *
+ * @param transcoder transcoder.
+ * @return true on success.
+ */
+static bool startTranscoder(
+		Transcoder* transcoder)
+{
+	int batchSize = transcoder->threadCount * TRANSCODE_FRAMES_PER_THREAD;
+	long frameSize = transcoder->width * transcoder->height
+			* Rgb565Format::BYTES_PER_PIXEL;
+	bool isScaled = (transcoder->width != transcoder->sourceWidth)
+			|| (transcoder->height != transcoder->sourceHeight);
+
+	transcoder->pool = createWorkerPool(transcoder->threadCount);
+	if (0 == transcoder->pool)
+	{
+		return false;
+	}
+
+	// Pool may have started fewer threads
+	transcoder->threadCount = getWorkerThreadCount(transcoder->pool);
+
+	if (isScaled)
+	{
+		transcoder->scaler = createScaler(transcoder->sourceWidth,
+				transcoder->sourceHeight,
+				transcoder->width,
+				transcoder->height);
+
+		if (0 == transcoder->scaler)
+		{
+			return false;
+		}
+	}
+
+	// Frames are read in parallel, each on a single thread
+	for (int i = 0; i < transcoder->threadCount; i++)
+	{
+		transcoder->readers[i] = createFusedReader(transcoder->sourceWidth,
+				transcoder->sourceHeight,
+				transcoder->frameFormat,
+				transcoder->isDithered,
+				1);
+
+		if (0 == transcoder->readers[i])
+		{
+			return false;
+		}
+
+		if (isScaled)
+		{
+			transcoder->sourceFrames[i] = (unsigned short*) malloc(
+					transcoder->sourceWidth * transcoder->sourceHeight
+					* Rgb565Format::BYTES_PER_PIXEL);
+
+			if (0 == transcoder->sourceFrames[i])
+			{
+				return false;
+			}
+		}
+	}
+
+	for (int b = 0; b < 2; b++)
+	{
+		TranscodeBatch* batch = &transcoder->batches[b];
+
+		batch->frames = (TranscodeFrame*) calloc(batchSize,
+				sizeof(TranscodeFrame));
+		if (0 == batch->frames)
+		{
+			return false;
+		}
+
+		for (int i = 0; i < batchSize; i++)
+		{
+			batch->frames[i].pixels = (unsigned short*) malloc(frameSize);
+			if (0 == batch->frames[i].pixels)
+			{
+				return false;
+			}
+		}
+	}
+
+	transcoder->isWriterStarted = (0 == pthread_create(&transcoder->writer,
+			0, writeBatches, transcoder));
+
+	return transcoder->isWriterStarted;
+}
+
+/**
+ * Converts all output frames, a batch at a time.
+ *
+ * @param transcoder transcoder.
+ */
+static void runTranscoder(
+		Transcoder* transcoder)
+{
+	int batchSize = transcoder->threadCount * TRANSCODE_FRAMES_PER_THREAD;
+	long lastSourceFrame = -1;
+
+	for (long first = 0, b = 0;
+			(first < transcoder->frameCount) && !transcoder->isFailed;
+			first += batchSize, b++)
+	{
+		TranscodeBatch* batch = &transcoder->batches[b % 2];
+
+		// Batch is free once the writer is done with it
+		pthread_mutex_lock(&transcoder->mutex);
+		while ((0 != transcoder->pending) || (batch == transcoder->writing))
+		{
+			pthread_cond_wait(&transcoder->condition, &transcoder->mutex);
+		}
+		pthread_mutex_unlock(&transcoder->mutex);
+
+		batch->frameCount = (transcoder->frameCount - first < batchSize)
+				? (int) (transcoder->frameCount - first)
+				: batchSize;
+
+		// Source frame at each output frame time
+		for (int i = 0; i < batch->frameCount; i++)
+		{
+			TranscodeFrame* frame = &batch->frames[i];
+
+			frame->sourceFrame = (long) (((first + i)
+					* transcoder->sourceFrameRate) / transcoder->frameRate);
+			if (frame->sourceFrame >= transcoder->sourceFrameCount)
+			{
+				frame->sourceFrame = transcoder->sourceFrameCount - 1;
+			}
+
+			frame->isDuplicate = (frame->sourceFrame == lastSourceFrame);
+			frame->size = 0;
+			lastSourceFrame = frame->sourceFrame;
+		}
+
+		// Frames are taken in order, one task per reader
+		transcoder->current = batch;
+		transcoder->nextFrame = 0;
+		runWorkerTasks(transcoder->pool, transcodeTask, transcoder,
+				transcoder->threadCount);
+
+		// Written while the next batch is converted
+		pthread_mutex_lock(&transcoder->mutex);
+		transcoder->pending = batch;
+		pthread_cond_broadcast(&transcoder->condition);
+		pthread_mutex_unlock(&transcoder->mutex);
+	}
+}
+
+/**
+ * Waits for the writer to write the pending batches and
+ * stops it.
+ *
+ * @param transcoder transcoder.
+ */
+static void stopTranscoder(
+		Transcoder* transcoder)
+{
+	if (transcoder->isWriterStarted)
+	{
+		pthread_mutex_lock(&transcoder->mutex);
+		transcoder->isStopping = true;
+		pthread_cond_broadcast(&transcoder->condition);
+		pthread_mutex_unlock(&transcoder->mutex);
+
+		pthread_join(transcoder->writer, 0);
+		transcoder->isWriterStarted = false;
+	}
+}
+
+/**
+ * Stops and frees the given transcoder.
+ *
+ * @param transcoder transcoder.
+ */
+static void destroyTranscoder(
+		Transcoder* transcoder)
+{
+	int batchSize = transcoder->threadCount * TRANSCODE_FRAMES_PER_THREAD;
+
+	stopTranscoder(transcoder);
+
+	for (int b = 0; b < 2; b++)
+	{
+		TranscodeFrame* frames = transcoder->batches[b].frames;
+
+		for (int i = 0; (0 != frames) && (i < batchSize); i++)
+		{
+			free(frames[i].pixels);
+		}
+
+		free(frames);
+	}
+
+	for (int i = 0; i < MAX_WORKER_THREADS; i++)
+	{
+		destroyFusedReader(transcoder->readers[i]);
+		free(transcoder->sourceFrames[i]);
+	}
+
+	destroyScaler(transcoder->scaler);
+	destroyWorkerPool(transcoder->pool);
+
+	pthread_cond_destroy(&transcoder->condition);
+	pthread_mutex_destroy(&transcoder->mutex);
+}
+
+int main(
+		int argc,
+		char** argv)
+{
+	int result = EXIT_FAILURE;
+	Transcoder transcoder;
+	const char* inputFileName;
+	const char* outputFileName;
+	long long startTime;
+	int option;
+
+	memset(&transcoder, 0, sizeof(transcoder));
+	pthread_mutex_init(&transcoder.mutex, 0);
+	pthread_cond_init(&transcoder.condition, 0);
+	transcoder.threadCount = getCpuCount(MAX_WORKER_THREADS);
+
+	while (-1 != (option = getopt(argc, argv, "w:h:r:j:d")))
+	{
+		switch (option)
+		{
+		case 'w':
+			transcoder.width = atoi(optarg);
+			break;
+
+		case 'h':
+			transcoder.height = atoi(optarg);
+			break;
+
+		case 'r':
+			transcoder.frameRate = atof(optarg);
+			break;
+
+		case 'j':
+			transcoder.threadCount = atoi(optarg);
+			break;
+
+		case 'd':
+			transcoder.isDithered = true;
+			break;
+
+		default:
+			printUsage(argv[0]);
+			goto exit;
+		}
+	}
+
+	if ((optind + 2 != argc)
+			|| (0 > transcoder.width)
+			|| (0 > transcoder.height)
+			|| (0 > transcoder.frameRate)
+			|| (1 > transcoder.threadCount)
+			|| (MAX_WORKER_THREADS < transcoder.threadCount))
+	{
+		printUsage(argv[0]);
+		goto exit;
+	}
+
+	inputFileName = argv[optind];
+	outputFileName = argv[optind + 1];
+
+	// Open the AVI file with its index
+	transcoder.input = openIndexedAvi(inputFileName);
+	if (0 == transcoder.input)
+	{
+		fprintf(stderr, "%s: %s\n", inputFileName, AVI_strerror());
+		goto exit;
+	}
+
+	if (!getFrameFormat(transcoder.input, &transcoder.frameFormat))
+	{
+		fprintf(stderr, "%s: Unsupported frame format.\n", inputFileName);
+		goto exit;
+	}
+
+	transcoder.sourceWidth = AVI_video_width(transcoder.input);
+	transcoder.sourceHeight = AVI_video_height(transcoder.input);
+	transcoder.sourceFrameRate = AVI_frame_rate(transcoder.input);
+	transcoder.sourceFrameCount = AVI_video_frames(transcoder.input);
+
+	if ((0 >= transcoder.sourceFrameRate)
+			|| (0 >= transcoder.sourceFrameCount))
+	{
+		fprintf(stderr, "%s: No video frames.\n", inputFileName);
+		goto exit;
+	}
+
+	// Source values unless given
+	if (0 == transcoder.width)
+	{
+		transcoder.width = transcoder.sourceWidth;
+	}
+
+	if (0 == transcoder.height)
+	{
+		transcoder.height = transcoder.sourceHeight;
+	}
+
+	if (0 == transcoder.frameRate)
+	{
+		transcoder.frameRate = transcoder.sourceFrameRate;
+	}
+
+	// Same duration at the output frame rate
+	transcoder.frameCount = (long) ((transcoder.sourceFrameCount
+			* transcoder.frameRate) / transcoder.sourceFrameRate);
+	if (0 == transcoder.frameCount)
+	{
+		transcoder.frameCount = 1;
+	}
+
+	transcoder.output = AVI_open_output_file((char*) outputFileName);
+	if (0 == transcoder.output)
+	{
+		fprintf(stderr, "%s: %s\n", outputFileName, AVI_strerror());
+		goto exit;
+	}
+
+	// Uncompressed DIB frames have no compressor
+	AVI_set_video(transcoder.output,
+			transcoder.width,
+			transcoder.height,
+			transcoder.frameRate,
+			(char*) "\0\0\0\0");
+
+	if (!startTranscoder(&transcoder))
+	{
+		fprintf(stderr, "Unable to start the transcoder.\n");
+		goto exit;
+	}
+
+	startTime = getTimeMillis();
+	runTranscoder(&transcoder);
+	stopTranscoder(&transcoder);
+
+	// Index and headers are written on close
+	if (transcoder.isFailed || (0 != AVI_close(transcoder.output)))
+	{
+		fprintf(stderr, "%s: %s\n", outputFileName, AVI_strerror());
+		transcoder.output = 0;
+		goto exit;
+	}
+
+	transcoder.output = 0;
+
+	if (!setRgb565Header(outputFileName, transcoder.width, transcoder.height))
+	{
+		fprintf(stderr, "%s: Unable to update the format header.\n",
+				outputFileName);
+		goto exit;
+	}
+
+	printf("%ld frames %dx%d at %.2f fps in %lld ms on %d threads",
+			transcoder.writtenFrames,
+			transcoder.width,
+			transcoder.height,
+			transcoder.frameRate,
+			getTimeMillis() - startTime,
+			transcoder.threadCount);
+
+	if (0 < transcoder.unreadFrames)
+	{
+		printf(", %ld unreadable frames repeated", transcoder.unreadFrames);
+	}
+
+	printf("\n");
+	result = EXIT_SUCCESS;
+
+exit:
+	destroyTranscoder(&transcoder);
+
+	if (0 != transcoder.output)
+	{
+		AVI_close(transcoder.output);
+	}
+
+	if (0 != transcoder.input)
+	{
+		AVI_close(transcoder.input);
+	}
+
+	return result;
+}
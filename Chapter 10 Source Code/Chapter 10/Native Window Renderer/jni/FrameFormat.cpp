@@ -0,0 +1,358 @@
+#include "FrameFormat.h"
+
+#include <string.h>
+
+#include "YuvConverter.h"
+
+#ifdef __ARM_NEON__
+
+#include <cpu-features.h>
+
+#include <arm_neon.h>
+
+#endif
+
+#ifdef __SSSE3__
+
+#include <tmmintrin.h>
+
+#endif
+
+// Uncompressed RGB frames
+#define BI_RGB 0
+
+/**
+ * 4x4 Bayer threshold matrix.
+ */
+static const unsigned char BAYER_MATRIX[4][4] =
+{
+	{ 0, 8, 2, 10 },
+	{ 12, 4, 14, 6 },
+	{ 3, 11, 1, 9 },
+	{ 15, 7, 13, 5 }
+};
+
+/**
+ * Row conversion kernel.
+ */
+typedef void (*ConvertKernel)(
+		const unsigned char* source,
+		unsigned short* destination,
+		int width,
+		const unsigned char* ditherRb,
+		const unsigned char* ditherG);
+
+/**
+ * Saturating add of the dither offset.
+ */
+static inline unsigned int addDither(
+		unsigned int value,
+		unsigned int dither)
+{
+	value += dither;
+
+	return (value > 255) ? 255 : value;
+}
+
+/**
+ * Generic BGR24 to RGB565 kernel. The dither rows hold the
+ * offsets of the 4 columns repeated.
+ */
+static void genericConvertBgr24(
+		const unsigned char* source,
+		unsigned short* destination,
+		int width,
+		const unsigned char* ditherRb,
+		const unsigned char* ditherG)
+{
+	for (int x = 0; x < width; x++, source += 3)
+	{
+		unsigned int b = addDither(source[0], ditherRb[x & 3]);
+		unsigned int g = addDither(source[1], ditherG[x & 3]);
+		unsigned int r = addDither(source[2], ditherRb[x & 3]);
+
+		destination[x] = ((r & 0xF8) << 8) | ((g & 0xFC) << 3) | (b >> 3);
+	}
+}
+
+#ifdef __ARM_NEON__
+/**
+ * NEON BGR24 to RGB565 kernel, 8 pixels at a time.
+ */
+static void neonConvertBgr24(
+		const unsigned char* source,
+		unsigned short* destination,
+		int width,
+		const unsigned char* ditherRb,
+		const unsigned char* ditherG)
+{
+	int x = 0;
+
+	uint8x8_t rbDither = vld1_u8(ditherRb);
+	uint8x8_t gDither = vld1_u8(ditherG);
+	uint8x8_t rMask = vdup_n_u8(0xF8);
+	uint8x8_t gMask = vdup_n_u8(0xFC);
+
+	for (; x + 8 <= width; x += 8, source += 24)
+	{
+		// Deinterleave into B, G and R
+		uint8x8x3_t bgr = vld3_u8(source);
+
+		uint8x8_t b = vqadd_u8(bgr.val[0], rbDither);
+		uint8x8_t g = vqadd_u8(bgr.val[1], gDither);
+		uint8x8_t r = vqadd_u8(bgr.val[2], rbDither);
+
+		uint16x8_t rgb = vorrq_u16(
+				vorrq_u16(vshll_n_u8(vand_u8(r, rMask), 8),
+						vshll_n_u8(vand_u8(g, gMask), 3)),
+				vmovl_u8(vshr_n_u8(b, 3)));
+
+		vst1q_u16(destination + x, rgb);
+	}
+
+	// Remaining pixels
+	genericConvertBgr24(source, destination + x, width - x, ditherRb, ditherG);
+}
+#endif
+
+#ifdef __SSSE3__
+/**
+ * SSSE3 BGR24 to RGB565 kernel, 16 pixels at a time.
+ */
+static void sseConvertBgr24(
+		const unsigned char* source,
+		unsigned short* destination,
+		int width,
+		const unsigned char* ditherRb,
+		const unsigned char* ditherG)
+{
+	int x = 0;
+
+	// Gather each channel from the three loads
+	const __m128i b0 = _mm_setr_epi8(0, 3, 6, 9, 12, 15, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1);
+	const __m128i b1 = _mm_setr_epi8(-1, -1, -1, -1, -1, -1, 2, 5, 8, 11, 14, -1, -1, -1, -1, -1);
+	const __m128i b2 = _mm_setr_epi8(-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, 1, 4, 7, 10, 13);
+	const __m128i g0 = _mm_setr_epi8(1, 4, 7, 10, 13, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1);
+	const __m128i g1 = _mm_setr_epi8(-1, -1, -1, -1, -1, 0, 3, 6, 9, 12, 15, -1, -1, -1, -1, -1);
+	const __m128i g2 = _mm_setr_epi8(-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, 2, 5, 8, 11, 14);
+	const __m128i r0 = _mm_setr_epi8(2, 5, 8, 11, 14, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1);
+	const __m128i r1 = _mm_setr_epi8(-1, -1, -1, -1, -1, 1, 4, 7, 10, 13, -1, -1, -1, -1, -1, -1);
+	const __m128i r2 = _mm_setr_epi8(-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, 0, 3, 6, 9, 12, 15);
+
+	const __m128i rbDither = _mm_loadu_si128((const __m128i*) ditherRb);
+	const __m128i gDither = _mm_loadu_si128((const __m128i*) ditherG);
+
+	const __m128i rMask = _mm_set1_epi8((char) 0xF8);
+	const __m128i gLowMask = _mm_set1_epi8((char) 0xE0);
+	const __m128i lowMask = _mm_set1_epi8(0x1F);
+	const __m128i gHighMask = _mm_set1_epi8(0x07);
+
+	for (; x + 16 <= width; x += 16, source += 48)
+	{
+		__m128i s0 = _mm_loadu_si128((const __m128i*) source);
+		__m128i s1 = _mm_loadu_si128((const __m128i*) (source + 16));
+		__m128i s2 = _mm_loadu_si128((const __m128i*) (source + 32));
+
+		__m128i b = _mm_or_si128(_mm_or_si128(_mm_shuffle_epi8(s0, b0),
+				_mm_shuffle_epi8(s1, b1)), _mm_shuffle_epi8(s2, b2));
+		__m128i g = _mm_or_si128(_mm_or_si128(_mm_shuffle_epi8(s0, g0),
+				_mm_shuffle_epi8(s1, g1)), _mm_shuffle_epi8(s2, g2));
+		__m128i r = _mm_or_si128(_mm_or_si128(_mm_shuffle_epi8(s0, r0),
+				_mm_shuffle_epi8(s1, r1)), _mm_shuffle_epi8(s2, r2));
+
+		b = _mm_adds_epu8(b, rbDither);
+		g = _mm_adds_epu8(g, gDither);
+		r = _mm_adds_epu8(r, rbDither);
+
+		// Low byte is GGGBBBBB, high byte is RRRRRGGG
+		__m128i low = _mm_or_si128(
+				_mm_and_si128(_mm_slli_epi16(g, 3), gLowMask),
+				_mm_and_si128(_mm_srli_epi16(b, 3), lowMask));
+		__m128i high = _mm_or_si128(
+				_mm_and_si128(r, rMask),
+				_mm_and_si128(_mm_srli_epi16(g, 5), gHighMask));
+
+		_mm_storeu_si128((__m128i*) (destination + x),
+				_mm_unpacklo_epi8(low, high));
+		_mm_storeu_si128((__m128i*) (destination + x + 8),
+				_mm_unpackhi_epi8(low, high));
+	}
+
+	// Remaining pixels
+	genericConvertBgr24(source, destination + x, width - x, ditherRb, ditherG);
+}
+#endif
+
+/**
+ * Selects the conversion kernel for the CPU.
+ */
+static ConvertKernel selectKernel()
+{
+	ConvertKernel kernel = genericConvertBgr24;
+
+#ifdef __ARM_NEON__
+	// Get the CPU family
+	AndroidCpuFamily cpuFamily = android_getCpuFamily();
+
+	// Get the CPU features
+	uint64_t cpuFeatures = android_getCpuFeatures();
+
+	// Use NEON optimized kernel only on ARM CPUs with NEON support
+	if ((ANDROID_CPU_FAMILY_ARM == cpuFamily)
+			&& ((ANDROID_CPU_ARM_FEATURE_NEON & cpuFeatures) != 0))
+	{
+		kernel = neonConvertBgr24;
+	}
+#endif
+
+#ifdef __SSSE3__
+	kernel = sseConvertBgr24;
+#endif
+
+	return kernel;
+}
+
+/**
+ * Checks if the stream handler or the format compression
+ * is the given FOURCC.
+ */
+static bool isFourcc(
+		avi_t* avi,
+		const char* fourcc)
+{
+	const alBITMAPINFOHEADER* header = avi->bitmap_info_header;
+	const char* compressor = AVI_video_compressor(avi);
+
+	return ((0 != compressor) && (0 == strncmp(compressor, fourcc, 4)))
+			|| ((0 != header)
+					&& (0 == memcmp(&header->bi_compression, fourcc, 4)));
+}
+
+bool getFrameFormat(
+		avi_t* avi,
+		FrameFormatInfo* info)
+{
+	const alBITMAPINFOHEADER* header = avi->bitmap_info_header;
+	int width = AVI_video_width(avi);
+	int height = AVI_video_height(avi);
+
+	info->format = FRAME_FORMAT_UNSUPPORTED;
+	info->isBottomUp = false;
+	info->rowSize = 0;
+
+	// SD video is BT.601, HD video is BT.709
+	info->matrix = (720 > height) ? COLOR_MATRIX_BT601 : COLOR_MATRIX_BT709;
+
+	// Motion JPEG is full range YCbCr
+	if (isFourcc(avi, "MJPG"))
+	{
+		info->format = FRAME_FORMAT_MJPEG;
+		info->matrix = COLOR_MATRIX_JFIF;
+		info->rowSize = width * 2;
+		goto exit;
+	}
+
+	// YUV needs whole chroma samples
+	if ((0 == (width % 2)) && (0 == (height % 2)))
+	{
+		if (isFourcc(avi, "YUY2") || isFourcc(avi, "YUYV"))
+		{
+			info->format = FRAME_FORMAT_YUY2;
+			info->rowSize = width * 2;
+			goto exit;
+		}
+
+		if (isFourcc(avi, "I420") || isFourcc(avi, "IYUV"))
+		{
+			info->format = FRAME_FORMAT_I420;
+			info->rowSize = width;
+			goto exit;
+		}
+
+		if (isFourcc(avi, "NV12"))
+		{
+			info->format = FRAME_FORMAT_NV12;
+			info->rowSize = width;
+			goto exit;
+		}
+	}
+
+	// Without a format header frames are taken as raw RGB565
+	if (0 == header)
+	{
+		info->format = FRAME_FORMAT_RGB565;
+		info->rowSize = width * 2;
+	}
+	else if (BI_RGB == header->bi_compression)
+	{
+		switch (header->bi_bit_count)
+		{
+		case 8:
+			// Padded and bottom-up like BGR24
+			if (readPalette(avi, &info->palette))
+			{
+				info->format = FRAME_FORMAT_PAL8;
+				info->isBottomUp = (0 < header->bi_height);
+				info->rowSize = (width + 3) & ~3;
+			}
+			break;
+
+		case 16:
+			// Rendered as is, like before
+			info->format = FRAME_FORMAT_RGB565;
+			info->rowSize = width * 2;
+			break;
+
+		case 24:
+			// DIB rows are padded to 4 bytes, bottom-up unless height is negative
+			info->format = FRAME_FORMAT_BGR24;
+			info->isBottomUp = (0 < header->bi_height);
+			info->rowSize = ((width * 3) + 3) & ~3;
+			break;
+		}
+	}
+
+exit:
+	return (FRAME_FORMAT_UNSUPPORTED != info->format);
+}
+
+long getStoredSize(
+		const FrameFormatInfo& info,
+		int rows)
+{
+	long size = info.rowSize * rows;
+
+	// Quarter size chroma planes
+	if ((FRAME_FORMAT_I420 == info.format)
+			|| (FRAME_FORMAT_NV12 == info.format))
+	{
+		size += size / 2;
+	}
+
+	return size;
+}
+
+void convertBgr24Row(
+		const unsigned char* source,
+		unsigned short* destination,
+		int width,
+		int y,
+		bool isDithered)
+{
+	ConvertKernel kernel = selectKernel();
+
+	unsigned char ditherRb[16] = { 0 };
+	unsigned char ditherG[16] = { 0 };
+
+	// Threshold offsets for the 3 and 2 dropped bits
+	if (isDithered)
+	{
+		for (int i = 0; i < 16; i++)
+		{
+			ditherRb[i] = BAYER_MATRIX[y & 3][i & 3] >> 1;
+			ditherG[i] = BAYER_MATRIX[y & 3][i & 3] >> 2;
+		}
+	}
+
+	kernel(source, destination, width, ditherRb, ditherG);
+}
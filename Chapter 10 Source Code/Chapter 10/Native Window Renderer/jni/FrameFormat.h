@@ -0,0 +1,87 @@
+#pragma once
+
+extern "C" {
+#include <avilib.h>
+}
+
+#include "Palette.h"
+
+/**
+ * Frame formats of the AVI video stream that the players
+ * can render. Frames are always rendered as RGB565.
+ */
+enum FrameFormat
+{
+	FRAME_FORMAT_UNSUPPORTED = 0,
+	FRAME_FORMAT_RGB565 = 1,
+	FRAME_FORMAT_BGR24 = 2,
+	FRAME_FORMAT_YUY2 = 3,
+	FRAME_FORMAT_I420 = 4,
+	FRAME_FORMAT_NV12 = 5,
+	FRAME_FORMAT_PAL8 = 6,
+	FRAME_FORMAT_MJPEG = 7
+};
+
+/**
+ * Frame format of an AVI video stream.
+ */
+struct FrameFormatInfo
+{
+	int format;
+
+	// Rows are stored bottom row first
+	bool isBottomUp;
+
+	// Stored row size in bytes, including the padding,
+	// only the luma row for planar YUV, and the decoded
+	// RGB565 row for Motion JPEG
+	long rowSize;
+
+	// Color matrix for YUV
+	int matrix;
+
+	// Palette for 8-bit frames
+	Palette palette;
+};
+
+/**
+ * Detects the frame format from the bit depth and the
+ * compression of the video stream format header.
+ *
+ * @param avi AVI file.
+ * @param info frame format info. [OUT]
+ * @return true if the frame format is supported.
+ */
+bool getFrameFormat(
+		avi_t* avi,
+		FrameFormatInfo* info);
+
+/**
+ * Gets the stored size of the given number of rows. Planar
+ * YUV rows come with their share of the chroma planes.
+ *
+ * @param info frame format info.
+ * @param rows number of rows, even for planar YUV.
+ * @return size in bytes.
+ */
+long getStoredSize(
+		const FrameFormatInfo& info,
+		int rows);
+
+/**
+ * Converts a row of BGR24 pixels to RGB565 with an optional
+ * 4x4 ordered dither, which hides the banding of the
+ * reduced color depth.
+ *
+ * @param source BGR24 pixels.
+ * @param destination RGB565 pixels.
+ * @param width row width in pixels.
+ * @param y destination row, selects the dither row.
+ * @param isDithered apply the ordered dither.
+ */
+void convertBgr24Row(
+		const unsigned char* source,
+		unsigned short* destination,
+		int width,
+		int y,
+		bool isDithered);
@@ -0,0 +1,305 @@
+#include "FramePool.h"
+
+#include <pthread.h>
+#include <stdint.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+// Number of frame geometries kept
+#define FRAME_POOL_CLASSES 4
+
+// Number of idle buffers kept per geometry
+#define FRAME_POOL_BUFFERS 4
+
+/**
+ * Frame buffer header, right before the aligned buffer.
+ */
+struct FrameBuffer
+{
+	// Tracked memory the buffer is carved from
+	void* memory;
+
+	// Buffer size, the size class key
+	size_t size;
+
+	// Next idle buffer in the same class
+	FrameBuffer* next;
+};
+
+/**
+ * Idle buffers of the same size.
+ */
+struct FramePoolClass
+{
+	size_t size;
+	FrameBuffer* buffers;
+	int count;
+
+	// Pool clock at the last use
+	unsigned int lastUsed;
+};
+
+static FramePoolClass poolClasses[FRAME_POOL_CLASSES];
+static unsigned int poolClock = 0;
+static pthread_mutex_t poolMutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_once_t shrinkerOnce = PTHREAD_ONCE_INIT;
+
+/**
+ * Gets the size of the tracked memory behind a buffer.
+ */
+static inline size_t getAllocationSize(
+		size_t size)
+{
+	return sizeof(FrameBuffer) + FRAME_BUFFER_ALIGNMENT - 1 + size;
+}
+
+#ifdef MY_HUGE_PAGES_ENABLED
+/**
+ * Advises the kernel to back the whole pages of the given
+ * buffer with huge pages. Only buffers spanning at least a
+ * huge page benefit, such as 4K frames. It is only advice,
+ * so failures are ignored.
+ */
+static void adviseHugePages(
+		void* buffer,
+		size_t size)
+{
+#ifdef MADV_HUGEPAGE
+	uintptr_t pageSize = sysconf(_SC_PAGESIZE);
+	uintptr_t start = ((uintptr_t) buffer + pageSize - 1) & ~(pageSize - 1);
+	uintptr_t end = ((uintptr_t) buffer + size) & ~(pageSize - 1);
+
+	if (start < end)
+	{
+		madvise((void*) start, end - start, MADV_HUGEPAGE);
+	}
+#endif
+}
+#endif
+
+/**
+ * Unlinks idle buffers, least recently used geometry
+ * first, until the given size is reached. Must be called
+ * with the pool mutex held.
+ *
+ * @param size bytes to unlink.
+ * @param freed bytes unlinked. [OUT]
+ * @return unlinked buffers.
+ */
+static FrameBuffer* unlinkIdleBuffers(
+		size_t size,
+		size_t& freed)
+{
+	FrameBuffer* unlinked = 0;
+	freed = 0;
+
+	while (freed < size)
+	{
+		// Least recently used class with idle buffers
+		FramePoolClass* victim = 0;
+		for (int i = 0; i < FRAME_POOL_CLASSES; i++)
+		{
+			FramePoolClass* poolClass = &poolClasses[i];
+			if ((0 != poolClass->count)
+					&& ((0 == victim)
+							|| (poolClass->lastUsed < victim->lastUsed)))
+			{
+				victim = poolClass;
+			}
+		}
+
+		if (0 == victim)
+		{
+			break;
+		}
+
+		while ((0 != victim->buffers) && (freed < size))
+		{
+			FrameBuffer* frameBuffer = victim->buffers;
+			victim->buffers = frameBuffer->next;
+			victim->count--;
+
+			frameBuffer->next = unlinked;
+			unlinked = frameBuffer;
+
+			freed += getAllocationSize(frameBuffer->size);
+		}
+	}
+
+	return unlinked;
+}
+
+/**
+ * Frees the given list of unlinked buffers.
+ */
+static void freeFrameBuffers(
+		FrameBuffer* frameBuffer)
+{
+	while (0 != frameBuffer)
+	{
+		FrameBuffer* next = frameBuffer->next;
+		freeMemory(frameBuffer->memory);
+		frameBuffer = next;
+	}
+}
+
+/**
+ * Memory shrinker, drops idle buffers.
+ */
+static size_t shrinkFramePool(
+		void* /* context */,
+		size_t size)
+{
+	size_t freed;
+
+	pthread_mutex_lock(&poolMutex);
+	FrameBuffer* unlinked = unlinkIdleBuffers(size, freed);
+	pthread_mutex_unlock(&poolMutex);
+
+	freeFrameBuffers(unlinked);
+
+	return freed;
+}
+
+static void addFramePoolShrinker()
+{
+	addMemoryShrinker(shrinkFramePool, 0);
+}
+
+void* acquireFrameBuffer(
+		MemoryAccount* account,
+		size_t size)
+{
+	FrameBuffer* frameBuffer = 0;
+	unsigned char* buffer = 0;
+
+	// Size classes are kept aligned too
+	size = (size + FRAME_BUFFER_ALIGNMENT - 1)
+			& ~((size_t) FRAME_BUFFER_ALIGNMENT - 1);
+
+	// Take an idle buffer of the same size
+	pthread_mutex_lock(&poolMutex);
+
+	for (int i = 0; i < FRAME_POOL_CLASSES; i++)
+	{
+		FramePoolClass* poolClass = &poolClasses[i];
+		if ((size == poolClass->size) && (0 != poolClass->buffers))
+		{
+			frameBuffer = poolClass->buffers;
+			poolClass->buffers = frameBuffer->next;
+			poolClass->count--;
+			poolClass->lastUsed = ++poolClock;
+			break;
+		}
+	}
+
+	pthread_mutex_unlock(&poolMutex);
+
+	if (0 != frameBuffer)
+	{
+		// Charge it back from the caches
+		transferMemory(frameBuffer->memory, account, MEMORY_FRAMES);
+		buffer = (unsigned char*) (frameBuffer + 1);
+		goto exit;
+	}
+
+	// Idle buffers are dropped under memory pressure
+	pthread_once(&shrinkerOnce, addFramePoolShrinker);
+
+	{
+		unsigned char* memory = (unsigned char*) allocateMemory(account,
+				MEMORY_FRAMES,
+				getAllocationSize(size));
+
+		if (0 == memory)
+		{
+			goto exit;
+		}
+
+		// Align the buffer and put the header right before it
+		buffer = (unsigned char*) (((uintptr_t) memory
+				+ sizeof(FrameBuffer)
+				+ FRAME_BUFFER_ALIGNMENT - 1)
+				& ~((uintptr_t) FRAME_BUFFER_ALIGNMENT - 1));
+
+		frameBuffer = ((FrameBuffer*) buffer) - 1;
+		frameBuffer->memory = memory;
+		frameBuffer->size = size;
+		frameBuffer->next = 0;
+	}
+
+#ifdef MY_HUGE_PAGES_ENABLED
+	adviseHugePages(buffer, size);
+#endif
+
+exit:
+	return buffer;
+}
+
+void releaseFrameBuffer(
+		void* buffer)
+{
+	if (0 == buffer)
+	{
+		return;
+	}
+
+	FrameBuffer* frameBuffer = ((FrameBuffer*) buffer) - 1;
+	FrameBuffer* unlinked = 0;
+
+	// Idle buffers count as caches
+	transferMemory(frameBuffer->memory, 0, MEMORY_CACHES);
+
+	pthread_mutex_lock(&poolMutex);
+
+	// Class of the same size, or an empty or the least recently used one
+	FramePoolClass* poolClass = 0;
+	for (int i = 0; i < FRAME_POOL_CLASSES; i++)
+	{
+		FramePoolClass* candidate = &poolClasses[i];
+		if (frameBuffer->size == candidate->size)
+		{
+			poolClass = candidate;
+			break;
+		}
+
+		if ((0 == poolClass)
+				|| (0 == candidate->count)
+				|| ((0 != poolClass->count)
+						&& (candidate->lastUsed < poolClass->lastUsed)))
+		{
+			poolClass = candidate;
+		}
+	}
+
+	// Evict the previous geometry
+	if (frameBuffer->size != poolClass->size)
+	{
+		unlinked = poolClass->buffers;
+		poolClass->size = frameBuffer->size;
+		poolClass->buffers = 0;
+		poolClass->count = 0;
+	}
+
+	if (FRAME_POOL_BUFFERS > poolClass->count)
+	{
+		frameBuffer->next = poolClass->buffers;
+		poolClass->buffers = frameBuffer;
+		poolClass->count++;
+		poolClass->lastUsed = ++poolClock;
+	}
+	else
+	{
+		frameBuffer->next = unlinked;
+		unlinked = frameBuffer;
+	}
+
+	pthread_mutex_unlock(&poolMutex);
+
+	freeFrameBuffers(unlinked);
+}
+
+size_t trimFramePool()
+{
+	return shrinkFramePool(0, (size_t) -1);
+}
@@ -0,0 +1,42 @@
+#pragma once
+
+#include <stddef.h>
+
+#include "Memory.h"
+
+/**
+ * Frame buffer alignment in bytes, a cache line and wide
+ * enough for any SIMD load.
+ */
+#define FRAME_BUFFER_ALIGNMENT 64
+
+/**
+ * Acquires a frame buffer of the given size. Buffers are
+ * pooled by size, so reopening a clip or switching to one
+ * with the same geometry reuses the previous buffers
+ * without allocating.
+ *
+ * @param account memory account to charge, or 0.
+ * @param size buffer size in bytes.
+ * @return aligned frame buffer or 0 on failure.
+ */
+void* acquireFrameBuffer(
+		MemoryAccount* account,
+		size_t size);
+
+/**
+ * Releases the given frame buffer back to the pool. Idle
+ * buffers are accounted as caches and get freed when the
+ * memory budget is tight.
+ *
+ * @param buffer frame buffer, may be 0.
+ */
+void releaseFrameBuffer(
+		void* buffer);
+
+/**
+ * Frees the idle frame buffers in the pool.
+ *
+ * @return bytes freed.
+ */
+size_t trimFramePool();
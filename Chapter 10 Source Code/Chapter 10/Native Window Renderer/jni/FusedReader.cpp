@@ -0,0 +1,588 @@
+#include "FusedReader.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "MjpegDecoder.h"
+#include "PixelFormat.h"
+#include "WorkerPool.h"
+#include "YuvConverter.h"
+
+/**
+ * Row range of a frame read by one thread.
+ */
+struct FusedWorker
+{
+	FusedReader* reader;
+
+	int firstRow;
+	int lastRow;
+
+	// Staging window and the converted band
+	unsigned char* staging;
+	unsigned char* converted;
+
+	bool isFailed;
+};
+
+struct FusedReader
+{
+	int width;
+	int height;
+	long rowSize;
+
+	// Stored frame format
+	FrameFormatInfo frameFormat;
+	bool isDithered;
+
+	// Rows that fit in the staging window
+	int bandRows;
+
+	// Row ranges and the threads reading them
+	FusedWorker workers[FUSED_MAX_THREADS];
+	int workerCount;
+	WorkerPool* pool;
+
+	// Motion JPEG decoder and the compressed frame
+	MjpegDecoder* decoder;
+	unsigned char* compressed;
+	long compressedSize;
+
+	// Frame being read
+	long fileDescriptor;
+	off_t frameOffset;
+	unsigned char* pixels;
+	long stride;
+	BandFilter filter;
+	void* context;
+};
+
+/**
+ * Reads the given band of rows into the staging window.
+ * Planar YUV bands are followed by their chroma rows.
+ */
+static bool readBand(
+		const FusedReader* reader,
+		unsigned char* staging,
+		int row,
+		int rowCount)
+{
+	const FrameFormatInfo& format = reader->frameFormat;
+	off_t offset = reader->frameOffset;
+	long lumaSize = format.rowSize * reader->height;
+	long size = format.rowSize * rowCount;
+
+	if (size != pread(reader->fileDescriptor, staging, size,
+			offset + (format.rowSize * row)))
+	{
+		return false;
+	}
+
+	staging += size;
+
+	if (FRAME_FORMAT_I420 == format.format)
+	{
+		// U and V planes, half width and half height
+		long chromaRowSize = format.rowSize / 2;
+		long chromaSize = chromaRowSize * (rowCount / 2);
+		off_t chromaOffset = chromaRowSize * (row / 2);
+
+		if ((chromaSize != pread(reader->fileDescriptor, staging, chromaSize,
+				offset + lumaSize + chromaOffset))
+				|| (chromaSize != pread(reader->fileDescriptor,
+						staging + chromaSize, chromaSize,
+						offset + lumaSize + (lumaSize / 4) + chromaOffset)))
+		{
+			return false;
+		}
+	}
+	else if (FRAME_FORMAT_NV12 == format.format)
+	{
+		// Interleaved UV plane, half height
+		long chromaSize = format.rowSize * (rowCount / 2);
+
+		if (chromaSize != pread(reader->fileDescriptor, staging, chromaSize,
+				offset + lumaSize + (format.rowSize * (row / 2))))
+		{
+			return false;
+		}
+	}
+
+	return true;
+}
+
+/**
+ * Converts the staged band to RGB565.
+ */
+static void convertBand(
+		const FusedReader* reader,
+		const unsigned char* staging,
+		unsigned char* converted,
+		int y,
+		int step,
+		int rowCount)
+{
+	const FrameFormatInfo& format = reader->frameFormat;
+	const unsigned char* chroma = staging + (format.rowSize * rowCount);
+
+	for (int i = 0; i < rowCount; i++)
+	{
+		const unsigned char* source = staging + (i * format.rowSize);
+		unsigned short* destination =
+				(unsigned short*) (converted + (i * reader->rowSize));
+
+		switch (format.format)
+		{
+		case FRAME_FORMAT_BGR24:
+			convertBgr24Row(source,
+					destination,
+					reader->width,
+					y + (i * step),
+					reader->isDithered);
+			break;
+
+		case FRAME_FORMAT_PAL8:
+			expandPaletteRow(source,
+					format.palette,
+					destination,
+					reader->width);
+			break;
+
+		case FRAME_FORMAT_YUY2:
+			convertYuvRow(format.format, format.matrix,
+					source, 0, 0,
+					destination, PIXEL_FORMAT_RGB_565, reader->width);
+			break;
+
+		case FRAME_FORMAT_I420:
+			{
+				// Each chroma row serves two luma rows
+				long chromaRowSize = format.rowSize / 2;
+				const unsigned char* u = chroma + ((i / 2) * chromaRowSize);
+				const unsigned char* v = u + ((rowCount / 2) * chromaRowSize);
+
+				convertYuvRow(format.format, format.matrix,
+						source, u, v,
+						destination, PIXEL_FORMAT_RGB_565, reader->width);
+			}
+			break;
+
+		case FRAME_FORMAT_NV12:
+			convertYuvRow(format.format, format.matrix,
+					source, chroma + ((i / 2) * format.rowSize), 0,
+					destination, PIXEL_FORMAT_RGB_565, reader->width);
+			break;
+		}
+	}
+}
+
+/**
+ * Reads, converts, filters and writes out the row range
+ * of the given worker.
+ */
+static void readRows(
+		FusedWorker* worker)
+{
+	const FusedReader* reader = worker->reader;
+	const FrameFormatInfo& format = reader->frameFormat;
+
+	worker->isFailed = false;
+
+	for (int row = worker->firstRow; row < worker->lastRow; row += reader->bandRows)
+	{
+		int rowCount = worker->lastRow - row;
+		if (reader->bandRows < rowCount)
+		{
+			rowCount = reader->bandRows;
+		}
+
+		// Read the band into the staging window
+		if (!readBand(reader, worker->staging, row, rowCount))
+		{
+			worker->isFailed = true;
+			break;
+		}
+
+		// Destination row of the first and the next band row
+		int y = row;
+		int step = 1;
+		if (format.isBottomUp)
+		{
+			y = reader->height - 1 - row;
+			step = -1;
+		}
+
+		unsigned char* band = worker->staging;
+
+		// Convert to RGB565
+		if (FRAME_FORMAT_RGB565 != format.format)
+		{
+			band = worker->converted;
+			convertBand(reader, worker->staging, band, y, step, rowCount);
+		}
+
+		// Filter while the band is in cache
+		if (0 != reader->filter)
+		{
+			reader->filter(reader->context,
+					band,
+					reader->width,
+					rowCount,
+					reader->rowSize);
+		}
+
+		// Write the band out
+		for (int i = 0; i < rowCount; i++)
+		{
+			memcpy(reader->pixels + ((y + (i * step)) * reader->stride),
+					band + (i * reader->rowSize),
+					reader->rowSize);
+		}
+	}
+}
+
+/**
+ * Reads the row range with the given index.
+ */
+static void readRowsTask(
+		void* context,
+		int index)
+{
+	readRows(&((FusedReader*) context)->workers[index]);
+}
+
+/**
+ * Gets the number of reader threads for the frame size.
+ */
+static int getWorkerCount(
+		int width,
+		int height,
+		int maxThreadCount)
+{
+	int workerCount = 1;
+
+	if (FUSED_PARALLEL_PIXELS <= ((long) width * height))
+	{
+		workerCount = getCpuCount(maxThreadCount);
+	}
+
+	return workerCount;
+}
+
+FusedReader* createFusedReader(
+		int width,
+		int height,
+		const FrameFormatInfo& frameFormat,
+		bool isDithered,
+		int maxThreadCount)
+{
+	FusedReader* reader = 0;
+	int rangeRows;
+
+	// Compressed frames are decoded on all cores
+	int workerCount = (FRAME_FORMAT_MJPEG == frameFormat.format)
+			? getCpuCount(maxThreadCount)
+			: getWorkerCount(width, height, maxThreadCount);
+
+	if ((0 >= width) || (0 >= height) || (0 >= frameFormat.rowSize))
+	{
+		goto exit;
+	}
+
+	reader = (FusedReader*) calloc(1, sizeof(FusedReader));
+	if (0 == reader)
+	{
+		goto exit;
+	}
+
+	reader->width = width;
+	reader->height = height;
+	reader->rowSize = (long) width * Rgb565Format::BYTES_PER_PIXEL;
+	reader->frameFormat = frameFormat;
+	reader->isDithered = isDithered;
+
+	reader->pool = createWorkerPool(workerCount);
+	if (0 == reader->pool)
+	{
+		free(reader);
+		reader = 0;
+		goto exit;
+	}
+
+	// Compressed frames are decoded whole, without row ranges
+	if (FRAME_FORMAT_MJPEG == frameFormat.format)
+	{
+		reader->decoder = createMjpegDecoder(reader->pool);
+		if (0 == reader->decoder)
+		{
+			destroyFusedReader(reader);
+			reader = 0;
+		}
+
+		goto exit;
+	}
+
+	// At least one row even if it is wider than the window
+	reader->bandRows = FUSED_STAGING_SIZE / getStoredSize(frameFormat, 1);
+
+	// Row pairs share the chroma rows
+	reader->bandRows &= ~1;
+	if (0 == reader->bandRows)
+	{
+		reader->bandRows = 2;
+	}
+
+	// Row ranges, starting at even rows
+	rangeRows = ((height / workerCount) + 1) & ~1;
+
+	for (int i = 0; i < workerCount; i++)
+	{
+		FusedWorker* worker = &reader->workers[i];
+
+		worker->reader = reader;
+		worker->firstRow = i * rangeRows;
+		worker->lastRow = (i + 1 == workerCount)
+				? height
+				: (i + 1) * rangeRows;
+
+		worker->staging = (unsigned char*) malloc(
+				getStoredSize(frameFormat, reader->bandRows));
+
+		if (0 == worker->staging)
+		{
+			destroyFusedReader(reader);
+			reader = 0;
+			goto exit;
+		}
+
+		if (FRAME_FORMAT_RGB565 != frameFormat.format)
+		{
+			worker->converted = (unsigned char*) malloc(
+					reader->bandRows * reader->rowSize);
+
+			if (0 == worker->converted)
+			{
+				destroyFusedReader(reader);
+				reader = 0;
+				goto exit;
+			}
+		}
+
+		reader->workerCount++;
+	}
+
+exit:
+	return reader;
+}
+
+void destroyFusedReader(
+		FusedReader* reader)
+{
+	if (0 == reader)
+	{
+		return;
+	}
+
+	destroyMjpegDecoder(reader->decoder);
+	destroyWorkerPool(reader->pool);
+	free(reader->compressed);
+
+	for (int i = 0; i < FUSED_MAX_THREADS; i++)
+	{
+		free(reader->workers[i].staging);
+		free(reader->workers[i].converted);
+	}
+
+	free(reader);
+}
+
+/**
+ * Reads the whole rows of a short RGB565 frame and filters
+ * them in place. Rows are read one at a time unless the
+ * destination rows are back to back.
+ */
+static long readWholeFrame(
+		FusedReader* reader,
+		int fileDescriptor,
+		off_t offset,
+		long size,
+		void* pixels,
+		long stride,
+		BandFilter filter,
+		void* context)
+{
+	int rowCount = size / reader->rowSize;
+	long frameSize = (long) rowCount * reader->rowSize;
+	unsigned char* row = (unsigned char*) pixels;
+
+	if (0 == rowCount)
+	{
+		return -1;
+	}
+
+	if (stride == reader->rowSize)
+	{
+		if (frameSize != pread(fileDescriptor, row, frameSize, offset))
+		{
+			return -1;
+		}
+	}
+	else
+	{
+		for (int i = 0; i < rowCount; i++, row += stride)
+		{
+			if (reader->rowSize != pread(fileDescriptor, row, reader->rowSize,
+					offset + ((off_t) i * reader->rowSize)))
+			{
+				return -1;
+			}
+		}
+	}
+
+	if (0 != filter)
+	{
+		filter(context,
+				(unsigned char*) pixels,
+				reader->width,
+				rowCount,
+				stride);
+	}
+
+	return frameSize;
+}
+
+/**
+ * Reads a compressed frame, decodes it into the pixels,
+ * and filters it as a single band.
+ */
+static long readCompressedFrame(
+		FusedReader* reader,
+		int fileDescriptor,
+		off_t offset,
+		long size,
+		void* pixels,
+		long stride,
+		BandFilter filter,
+		void* context)
+{
+	long frameSize = size;
+
+	// Empty frames repeat the previous one, nothing to draw
+	if (0 == frameSize)
+	{
+		goto exit;
+	}
+
+	// Compressed frame buffer grows to the largest frame
+	if (frameSize > reader->compressedSize)
+	{
+		free(reader->compressed);
+
+		reader->compressed = (unsigned char*) malloc(frameSize);
+		reader->compressedSize = (0 == reader->compressed) ? 0 : frameSize;
+
+		if (0 == reader->compressed)
+		{
+			frameSize = -1;
+			goto exit;
+		}
+	}
+
+	if (size != pread(fileDescriptor, reader->compressed, size, offset))
+	{
+		frameSize = -1;
+		goto exit;
+	}
+
+	if (!decodeMjpegFrame(reader->decoder,
+			reader->compressed,
+			frameSize,
+			reader->frameFormat.matrix,
+			pixels,
+			reader->width,
+			reader->height,
+			stride))
+	{
+		frameSize = -1;
+		goto exit;
+	}
+
+	if (0 != filter)
+	{
+		filter(context,
+				(unsigned char*) pixels,
+				reader->width,
+				reader->height,
+				stride);
+	}
+
+exit:
+	return frameSize;
+}
+
+long readFusedFrame(
+		FusedReader* reader,
+		int fileDescriptor,
+		off_t offset,
+		long size,
+		void* pixels,
+		long stride,
+		BandFilter filter,
+		void* context)
+{
+	long frameSize = -1;
+
+	if (0 > size)
+	{
+		goto exit;
+	}
+
+	if (FRAME_FORMAT_MJPEG == reader->frameFormat.format)
+	{
+		frameSize = readCompressedFrame(reader, fileDescriptor, offset, size,
+				pixels, stride, filter, context);
+		goto exit;
+	}
+
+	// Empty frames repeat the previous one, nothing to draw
+	if (0 == size)
+	{
+		frameSize = 0;
+		goto exit;
+	}
+
+	// Only raw frames can be split into rows, padding after
+	// the rows is left out
+	frameSize = getStoredSize(reader->frameFormat, reader->height);
+	if (frameSize > size)
+	{
+		frameSize = (FRAME_FORMAT_RGB565 == reader->frameFormat.format)
+				? readWholeFrame(reader, fileDescriptor, offset, size,
+						pixels, stride, filter, context)
+				: -1;
+		goto exit;
+	}
+
+	reader->fileDescriptor = fileDescriptor;
+	reader->frameOffset = offset;
+	reader->pixels = (unsigned char*) pixels;
+	reader->stride = stride;
+	reader->filter = filter;
+	reader->context = context;
+
+	// Read the row ranges on the pool threads
+	runWorkerTasks(reader->pool, readRowsTask, reader, reader->workerCount);
+
+	for (int i = 0; i < reader->workerCount; i++)
+	{
+		if (reader->workers[i].isFailed)
+		{
+			frameSize = -1;
+			goto exit;
+		}
+	}
+
+exit:
+	return frameSize;
+}
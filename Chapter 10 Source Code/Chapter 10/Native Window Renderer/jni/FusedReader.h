@@ -0,0 +1,106 @@
+#pragma once
+
+#include <sys/types.h>
+
+#include "FrameFormat.h"
+
+/**
+ * Staging window size in bytes. Small enough to stay in
+ * L2 while a band of rows is filtered.
+ */
+#define FUSED_STAGING_SIZE (64 * 1024)
+
+/**
+ * Frames of at least this many pixels are read in row
+ * bands on several threads.
+ */
+#define FUSED_PARALLEL_PIXELS (1280 * 720)
+
+/**
+ * Maximum number of threads reading a frame.
+ */
+#define FUSED_MAX_THREADS 4
+
+/**
+ * Band filter. Gets called on each band of rows while it
+ * is in the staging window, before it is written out.
+ * Large frames are filtered on several threads at once.
+ *
+ * @param context filter context.
+ * @param rows band pixels.
+ * @param width band width in pixels.
+ * @param rowCount number of rows in the band.
+ * @param stride band row stride in bytes.
+ */
+typedef void (*BandFilter)(
+		void* context,
+		unsigned char* rows,
+		int width,
+		int rowCount,
+		long stride);
+
+/**
+ * Fused reader state, holds the staging windows, the
+ * converted RGB565 bands, and the reader threads.
+ */
+struct FusedReader;
+
+/**
+ * Creates a new fused reader for frames of the given size
+ * and format. Frames are written out as RGB565.
+ *
+ * @param width frame width in pixels.
+ * @param height frame height in pixels.
+ * @param frameFormat stored frame format.
+ * @param isDithered dither when reducing the color depth.
+ * @param maxThreadCount maximum number of reader threads,
+ * 1 to read on the calling thread only.
+ * @return fused reader or 0 on failure.
+ */
+FusedReader* createFusedReader(
+		int width,
+		int height,
+		const FrameFormatInfo& frameFormat,
+		bool isDithered,
+		int maxThreadCount);
+
+/**
+ * Destroys the given fused reader.
+ *
+ * @param reader fused reader.
+ */
+void destroyFusedReader(
+		FusedReader* reader);
+
+/**
+ * Reads the given frame a band of rows at a time into the
+ * staging window, converts it to RGB565, applies the band
+ * filter, and writes the band to the destination top row
+ * first. Each pixel crosses memory once, instead of once
+ * for the read and again for each filter pass. Large
+ * frames are split into row ranges that are read on
+ * several threads. RGB565 frames that are not stored as
+ * raw rows are read whole and filtered in place. Motion
+ * JPEG frames are decoded whole and then filtered as one
+ * band. The frame is located by the caller, so that the
+ * reader does not depend on how the file is indexed.
+ *
+ * @param reader fused reader.
+ * @param fileDescriptor AVI file descriptor.
+ * @param offset frame data offset in the file.
+ * @param size frame data size in bytes.
+ * @param pixels destination pixels.
+ * @param stride destination row stride in bytes.
+ * @param filter band filter, may be 0.
+ * @param context band filter context.
+ * @return frame size, or -1 on failure.
+ */
+long readFusedFrame(
+		FusedReader* reader,
+		int fileDescriptor,
+		off_t offset,
+		long size,
+		void* pixels,
+		long stride,
+		BandFilter filter,
+		void* context);
@@ -0,0 +1,371 @@
+#include "Idct.h"
+
+#ifdef __ARM_NEON__
+
+#include <cpu-features.h>
+
+#include <arm_neon.h>
+
+#endif
+
+#ifdef __SSE2__
+
+#include <emmintrin.h>
+
+#endif
+
+/**
+ * AAN scale factors, cos(k * pi / 16) * sqrt(2) with the
+ * first one 1.
+ */
+static const float AAN_SCALE_FACTORS[8] =
+{
+	1.0f, 1.387039845f, 1.306562965f, 1.175875602f,
+	1.0f, 0.785694958f, 0.541196100f, 0.275899379f
+};
+
+/**
+ * Block IDCT kernel.
+ */
+typedef void (*IdctKernel)(
+		const short* coefficients,
+		const float* table,
+		unsigned char* output,
+		long stride);
+
+/**
+ * Arithmetic for the 1-D IDCT, on single values or on
+ * vectors of four.
+ */
+static inline float add(float a, float b) { return a + b; }
+static inline float sub(float a, float b) { return a - b; }
+static inline float mul(float a, float b) { return a * b; }
+static inline float splat(float, float value) { return value; }
+
+#ifdef __ARM_NEON__
+static inline float32x4_t add(float32x4_t a, float32x4_t b) { return vaddq_f32(a, b); }
+static inline float32x4_t sub(float32x4_t a, float32x4_t b) { return vsubq_f32(a, b); }
+static inline float32x4_t mul(float32x4_t a, float32x4_t b) { return vmulq_f32(a, b); }
+static inline float32x4_t splat(float32x4_t, float value) { return vdupq_n_f32(value); }
+#endif
+
+#ifdef __SSE2__
+static inline __m128 add(__m128 a, __m128 b) { return _mm_add_ps(a, b); }
+static inline __m128 sub(__m128 a, __m128 b) { return _mm_sub_ps(a, b); }
+static inline __m128 mul(__m128 a, __m128 b) { return _mm_mul_ps(a, b); }
+static inline __m128 splat(__m128, float value) { return _mm_set1_ps(value); }
+#endif
+
+/**
+ * 1-D AAN float IDCT of eight values, in place. The
+ * inputs are already scaled by the AAN factors.
+ */
+template <typename T>
+static inline void idct8(
+		T* d)
+{
+	// Even part
+	T tmp10 = add(d[0], d[4]);
+	T tmp11 = sub(d[0], d[4]);
+	T tmp13 = add(d[2], d[6]);
+	T tmp12 = sub(mul(sub(d[2], d[6]), splat(d[0], 1.414213562f)), tmp13);
+
+	T tmp0 = add(tmp10, tmp13);
+	T tmp3 = sub(tmp10, tmp13);
+	T tmp1 = add(tmp11, tmp12);
+	T tmp2 = sub(tmp11, tmp12);
+
+	// Odd part
+	T z13 = add(d[5], d[3]);
+	T z10 = sub(d[5], d[3]);
+	T z11 = add(d[1], d[7]);
+	T z12 = sub(d[1], d[7]);
+
+	T tmp7 = add(z11, z13);
+	tmp11 = mul(sub(z11, z13), splat(d[0], 1.414213562f));
+
+	T z5 = mul(add(z10, z12), splat(d[0], 1.847759065f));
+	tmp10 = sub(mul(z12, splat(d[0], 1.082392200f)), z5);
+	tmp12 = sub(z5, mul(z10, splat(d[0], 2.613125930f)));
+
+	T tmp6 = sub(tmp12, tmp7);
+	T tmp5 = sub(tmp11, tmp6);
+	T tmp4 = add(tmp10, tmp5);
+
+	d[0] = add(tmp0, tmp7);
+	d[7] = sub(tmp0, tmp7);
+	d[1] = add(tmp1, tmp6);
+	d[6] = sub(tmp1, tmp6);
+	d[2] = add(tmp2, tmp5);
+	d[5] = sub(tmp2, tmp5);
+	d[4] = add(tmp3, tmp4);
+	d[3] = sub(tmp3, tmp4);
+}
+
+/**
+ * Level shifts, rounds and clamps a sample.
+ */
+static inline unsigned char toSample(
+		float value)
+{
+	int sample = (int) (value + 128.5f);
+
+	return (sample < 0) ? 0 : ((sample > 255) ? 255 : sample);
+}
+
+/**
+ * Generic IDCT kernel, columns then rows.
+ */
+static void genericIdct(
+		const short* coefficients,
+		const float* table,
+		unsigned char* output,
+		long stride)
+{
+	float workspace[IDCT_BLOCK_SIZE];
+	float d[8];
+
+	for (int x = 0; x < 8; x++)
+	{
+		for (int i = 0; i < 8; i++)
+		{
+			d[i] = coefficients[(i * 8) + x] * table[(i * 8) + x];
+		}
+
+		idct8(d);
+
+		for (int i = 0; i < 8; i++)
+		{
+			workspace[(i * 8) + x] = d[i];
+		}
+	}
+
+	for (int y = 0; y < 8; y++, output += stride)
+	{
+		idct8(workspace + (y * 8));
+
+		for (int i = 0; i < 8; i++)
+		{
+			output[i] = toSample(workspace[(y * 8) + i]);
+		}
+	}
+}
+
+#ifdef __ARM_NEON__
+/**
+ * Transposes a 4x4 block of the 8x8 block held as halves
+ * of rows.
+ */
+static inline void neonTranspose(
+		float32x4_t& r0,
+		float32x4_t& r1,
+		float32x4_t& r2,
+		float32x4_t& r3)
+{
+	float32x4x2_t t01 = vtrnq_f32(r0, r1);
+	float32x4x2_t t23 = vtrnq_f32(r2, r3);
+
+	r0 = vcombine_f32(vget_low_f32(t01.val[0]), vget_low_f32(t23.val[0]));
+	r1 = vcombine_f32(vget_low_f32(t01.val[1]), vget_low_f32(t23.val[1]));
+	r2 = vcombine_f32(vget_high_f32(t01.val[0]), vget_high_f32(t23.val[0]));
+	r3 = vcombine_f32(vget_high_f32(t01.val[1]), vget_high_f32(t23.val[1]));
+}
+
+/**
+ * Transposes the 8x8 block held as left and right halves
+ * of the rows.
+ */
+static inline void neonTranspose8(
+		float32x4_t* left,
+		float32x4_t* right)
+{
+	neonTranspose(left[0], left[1], left[2], left[3]);
+	neonTranspose(left[4], left[5], left[6], left[7]);
+	neonTranspose(right[0], right[1], right[2], right[3]);
+	neonTranspose(right[4], right[5], right[6], right[7]);
+
+	// Swap the off diagonal quarters
+	for (int i = 0; i < 4; i++)
+	{
+		float32x4_t quarter = right[i];
+		right[i] = left[i + 4];
+		left[i + 4] = quarter;
+	}
+}
+
+/**
+ * NEON IDCT kernel, four columns or rows at a time.
+ */
+static void neonIdct(
+		const short* coefficients,
+		const float* table,
+		unsigned char* output,
+		long stride)
+{
+	float32x4_t left[8];
+	float32x4_t right[8];
+
+	for (int i = 0; i < 8; i++)
+	{
+		int16x8_t row = vld1q_s16(coefficients + (i * 8));
+
+		left[i] = vmulq_f32(vcvtq_f32_s32(vmovl_s16(vget_low_s16(row))),
+				vld1q_f32(table + (i * 8)));
+		right[i] = vmulq_f32(vcvtq_f32_s32(vmovl_s16(vget_high_s16(row))),
+				vld1q_f32(table + (i * 8) + 4));
+	}
+
+	// Columns
+	idct8(left);
+	idct8(right);
+
+	// Rows, as columns of the transposed block
+	neonTranspose8(left, right);
+	idct8(left);
+	idct8(right);
+	neonTranspose8(left, right);
+
+	float32x4_t level = vdupq_n_f32(128.5f);
+
+	for (int i = 0; i < 8; i++, output += stride)
+	{
+		// Truncation rounds, negative values clamp to 0 anyway
+		int16x8_t samples = vcombine_s16(
+				vqmovn_s32(vcvtq_s32_f32(vaddq_f32(left[i], level))),
+				vqmovn_s32(vcvtq_s32_f32(vaddq_f32(right[i], level))));
+
+		vst1_u8(output, vqmovun_s16(samples));
+	}
+}
+#endif
+
+#ifdef __SSE2__
+/**
+ * Transposes the 8x8 block held as left and right halves
+ * of the rows.
+ */
+static inline void sseTranspose8(
+		__m128* left,
+		__m128* right)
+{
+	_MM_TRANSPOSE4_PS(left[0], left[1], left[2], left[3]);
+	_MM_TRANSPOSE4_PS(left[4], left[5], left[6], left[7]);
+	_MM_TRANSPOSE4_PS(right[0], right[1], right[2], right[3]);
+	_MM_TRANSPOSE4_PS(right[4], right[5], right[6], right[7]);
+
+	// Swap the off diagonal quarters
+	for (int i = 0; i < 4; i++)
+	{
+		__m128 quarter = right[i];
+		right[i] = left[i + 4];
+		left[i + 4] = quarter;
+	}
+}
+
+/**
+ * SSE IDCT kernel, four columns or rows at a time.
+ */
+static void sseIdct(
+		const short* coefficients,
+		const float* table,
+		unsigned char* output,
+		long stride)
+{
+	__m128 left[8];
+	__m128 right[8];
+
+	for (int i = 0; i < 8; i++)
+	{
+		__m128i row = _mm_loadu_si128((const __m128i*) (coefficients + (i * 8)));
+
+		// Sign extend to 32-bit
+		__m128i low = _mm_srai_epi32(_mm_unpacklo_epi16(row, row), 16);
+		__m128i high = _mm_srai_epi32(_mm_unpackhi_epi16(row, row), 16);
+
+		left[i] = _mm_mul_ps(_mm_cvtepi32_ps(low), _mm_loadu_ps(table + (i * 8)));
+		right[i] = _mm_mul_ps(_mm_cvtepi32_ps(high), _mm_loadu_ps(table + (i * 8) + 4));
+	}
+
+	// Columns
+	idct8(left);
+	idct8(right);
+
+	// Rows, as columns of the transposed block
+	sseTranspose8(left, right);
+	idct8(left);
+	idct8(right);
+	sseTranspose8(left, right);
+
+	__m128 level = _mm_set1_ps(128.0f);
+
+	for (int i = 0; i < 8; i++, output += stride)
+	{
+		__m128i samples = _mm_packs_epi32(
+				_mm_cvtps_epi32(_mm_add_ps(left[i], level)),
+				_mm_cvtps_epi32(_mm_add_ps(right[i], level)));
+
+		_mm_storel_epi64((__m128i*) output, _mm_packus_epi16(samples, samples));
+	}
+}
+#endif
+
+/**
+ * Selects the IDCT kernel for the CPU.
+ */
+static IdctKernel selectKernel()
+{
+	IdctKernel kernel = genericIdct;
+
+#ifdef __ARM_NEON__
+	// Get the CPU family
+	AndroidCpuFamily cpuFamily = android_getCpuFamily();
+
+	// Get the CPU features
+	uint64_t cpuFeatures = android_getCpuFeatures();
+
+	// Use NEON optimized kernel only on ARM CPUs with NEON support
+	if ((ANDROID_CPU_FAMILY_ARM == cpuFamily)
+			&& ((ANDROID_CPU_ARM_FEATURE_NEON & cpuFeatures) != 0))
+	{
+		kernel = neonIdct;
+	}
+#endif
+
+#ifdef __SSE2__
+	kernel = sseIdct;
+#endif
+
+	return kernel;
+}
+
+void buildIdctTable(
+		const unsigned short* quantization,
+		float* table)
+{
+	for (int y = 0; y < 8; y++)
+	{
+		for (int x = 0; x < 8; x++)
+		{
+			table[(y * 8) + x] = quantization[(y * 8) + x]
+					* AAN_SCALE_FACTORS[y]
+					* AAN_SCALE_FACTORS[x]
+					/ 8.0f;
+		}
+	}
+}
+
+void idctBlock(
+		const short* coefficients,
+		const float* table,
+		unsigned char* output,
+		long stride)
+{
+	// Selected once, the IDCT runs for every block
+	static IdctKernel kernel = 0;
+	if (0 == kernel)
+	{
+		kernel = selectKernel();
+	}
+
+	kernel(coefficients, table, output, stride);
+}
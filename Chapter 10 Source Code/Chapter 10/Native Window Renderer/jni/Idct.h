@@ -0,0 +1,33 @@
+#pragma once
+
+/**
+ * Coefficients in an 8x8 block.
+ */
+#define IDCT_BLOCK_SIZE 64
+
+/**
+ * Builds the IDCT multiplier table from a quantization
+ * table. The AAN scale factors and the final divide by 8
+ * are folded into the multipliers.
+ *
+ * @param quantization quantization table in natural order.
+ * @param table multiplier table. [OUT]
+ */
+void buildIdctTable(
+		const unsigned short* quantization,
+		float* table);
+
+/**
+ * Dequantizes and inverse transforms an 8x8 block into
+ * 8-bit samples, level shifted and clamped.
+ *
+ * @param coefficients coefficients in natural order.
+ * @param table multiplier table.
+ * @param output output samples.
+ * @param stride output row stride in bytes.
+ */
+void idctBlock(
+		const short* coefficients,
+		const float* table,
+		unsigned char* output,
+		long stride);
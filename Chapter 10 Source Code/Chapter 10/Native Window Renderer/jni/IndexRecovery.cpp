@@ -0,0 +1,808 @@
+#include "IndexRecovery.h"
+
+#include <fcntl.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "Riff.h"
+#include "WorkerPool.h"
+
+// List header is the chunk header and the list type
+#define RIFF_LIST_HEADER_SIZE 12
+
+// Offsets of the RIFF size and the list size in the header
+#define RIFF_SIZE_OFFSET 4
+#define LIST_SIZE_OFFSET 4
+
+// idx1 entry is the chunk id, flags, offset and size
+#define IDX1_ENTRY_SIZE 16
+
+// Chunk lists grow by this many entries at least
+#define CHUNK_LIST_GROWTH 1024
+
+/**
+ * Chunk found in the movi list.
+ */
+struct ChunkEntry
+{
+	// Chunk header offset
+	off_t offset;
+	unsigned long size;
+	char id[4];
+};
+
+struct IndexScanner;
+
+/**
+ * Byte range of the movi list scanned by one thread.
+ */
+struct ScanRange
+{
+	const IndexScanner* scanner;
+
+	off_t start;
+	off_t end;
+
+	// Chunks whose headers are in the range
+	ChunkEntry* chunks;
+	long chunkCount;
+	long capacity;
+
+	// First chunk that is on the chain from the list start
+	long firstChunk;
+
+	// Where the chain leaves the range, and if it was in sync
+	off_t exitOffset;
+	bool isExitSynced;
+
+	// Block of chunk headers
+	unsigned char* block;
+	off_t blockOffset;
+	long blockSize;
+
+	bool isFailed;
+};
+
+struct IndexScanner
+{
+	int fileDescriptor;
+
+	// First chunk offset and the end of the list
+	off_t moviStart;
+	off_t moviEnd;
+
+	ScanRange ranges[RECOVERY_MAX_THREADS];
+	int rangeCount;
+};
+
+/**
+ * Finds the movi list, and checks if it is followed by
+ * the idx1 index, walking the top level chunk headers.
+ * Unfinished recordings never get their movi size set,
+ * so a movi list without a valid size extends to the end
+ * of the file.
+ */
+static bool findMoviList(
+		int fileDescriptor,
+		off_t fileSize,
+		off_t* moviStart,
+		off_t* moviEnd,
+		bool* hasIndex)
+{
+	bool isFound = false;
+	unsigned char header[RIFF_LIST_HEADER_SIZE];
+	off_t offset = RIFF_LIST_HEADER_SIZE;
+
+	*hasIndex = false;
+
+	// RIFF AVI header
+	if ((sizeof(header) != pread(fileDescriptor, header, sizeof(header), 0))
+			|| (0 != memcmp(header, "RIFF", 4))
+			|| (0 != memcmp(header + 8, "AVI ", 4)))
+	{
+		goto exit;
+	}
+
+	while (offset + RIFF_CHUNK_HEADER_SIZE <= fileSize)
+	{
+		long length = pread(fileDescriptor, header, sizeof(header), offset);
+		if (RIFF_CHUNK_HEADER_SIZE > length)
+		{
+			break;
+		}
+
+		off_t size = readRiffLong(header + 4);
+
+		if ((RIFF_LIST_HEADER_SIZE == length)
+				&& (0 == memcmp(header, "LIST", 4))
+				&& (0 == memcmp(header + 8, "movi", 4)))
+		{
+			*moviStart = offset + RIFF_LIST_HEADER_SIZE;
+			*moviEnd = offset + RIFF_CHUNK_HEADER_SIZE + size;
+			isFound = true;
+
+			if ((4 > size) || (*moviEnd > fileSize))
+			{
+				*moviEnd = fileSize;
+				break;
+			}
+
+			// Index can only follow the movi list
+			offset = *moviEnd + (size & 1);
+			*hasIndex = (RIFF_CHUNK_HEADER_SIZE == pread(fileDescriptor,
+							header, RIFF_CHUNK_HEADER_SIZE, offset))
+					&& (0 == memcmp(header, "idx1", 4));
+			break;
+		}
+		else if (0 == memcmp(header, "idx1", 4))
+		{
+			*hasIndex = true;
+			break;
+		}
+
+		// Chunks are padded to even sizes
+		offset += RIFF_CHUNK_HEADER_SIZE + size + (size & 1);
+	}
+
+exit:
+	return isFound;
+}
+
+bool isAviIndexMissing(
+		const char* fileName)
+{
+	bool isMissing = false;
+	struct stat fileStat;
+	off_t moviStart = 0;
+	off_t moviEnd = 0;
+	bool hasIndex = false;
+
+	int fileDescriptor = open(fileName, O_RDONLY);
+	if (0 > fileDescriptor)
+	{
+		goto exit;
+	}
+
+	if (0 == fstat(fileDescriptor, &fileStat))
+	{
+		isMissing = findMoviList(fileDescriptor, fileStat.st_size,
+				&moviStart, &moviEnd, &hasIndex)
+				&& !hasIndex;
+	}
+
+	close(fileDescriptor);
+
+exit:
+	return isMissing;
+}
+
+static inline bool isDigit(
+		char c)
+{
+	return ('0' <= c) && ('9' >= c);
+}
+
+static inline bool isLower(
+		char c)
+{
+	return ('a' <= c) && ('z' >= c);
+}
+
+/**
+ * Checks if the given id is a stream chunk id, a stream
+ * number and a two letter type such as 00dc or 01wb.
+ */
+static bool isStreamChunkId(
+		const char* id)
+{
+	return isDigit(id[0]) && isDigit(id[1]) && isLower(id[2]) && isLower(id[3]);
+}
+
+/**
+ * Checks if the given header is a plausible chunk header
+ * of the movi list, one that fits in the list.
+ */
+static bool isChunkHeader(
+		const unsigned char* header,
+		off_t offset,
+		off_t moviEnd)
+{
+	const char* id = (const char*) header;
+	unsigned long size = readRiffLong(header + 4);
+
+	if ((off_t) size > moviEnd - offset - RIFF_CHUNK_HEADER_SIZE)
+	{
+		return false;
+	}
+
+	return isStreamChunkId(id)
+			|| (0 == memcmp(id, "JUNK", 4))
+			|| ((0 == memcmp(id, "ix", 2)) && isDigit(id[2]) && isDigit(id[3]))
+			|| ((0 == memcmp(id, "LIST", 4))
+					&& (4 <= size)
+					&& (0 == memcmp(header + RIFF_CHUNK_HEADER_SIZE, "rec ", 4)));
+}
+
+/**
+ * Gets the offset of the chunk that follows the given one.
+ * Record lists are descended into.
+ */
+static off_t getNextChunkOffset(
+		const unsigned char* header,
+		off_t offset)
+{
+	unsigned long size = readRiffLong(header + 4);
+
+	if (0 == memcmp(header, "LIST", 4))
+	{
+		return offset + RIFF_LIST_HEADER_SIZE;
+	}
+
+	return offset + RIFF_CHUNK_HEADER_SIZE + size + (size & 1);
+}
+
+/**
+ * Reads the chunk header at the given offset from the
+ * header block, reading a new block if needed.
+ */
+static bool readScanHeader(
+		ScanRange* range,
+		off_t offset,
+		unsigned char* header)
+{
+	const IndexScanner* scanner = range->scanner;
+	long needed = RIFF_LIST_HEADER_SIZE;
+
+	if (scanner->moviEnd - offset < needed)
+	{
+		needed = scanner->moviEnd - offset;
+	}
+
+	if ((offset < range->blockOffset)
+			|| (offset + needed > range->blockOffset + range->blockSize))
+	{
+		long size = RECOVERY_BLOCK_SIZE;
+		if (scanner->moviEnd - offset < size)
+		{
+			size = scanner->moviEnd - offset;
+		}
+
+		range->blockOffset = offset;
+		range->blockSize = pread(scanner->fileDescriptor, range->block, size, offset);
+
+		if (needed > range->blockSize)
+		{
+			range->blockSize = 0;
+			return false;
+		}
+	}
+
+	memcpy(header, range->block + (offset - range->blockOffset), needed);
+	return true;
+}
+
+/**
+ * Checks if the chunk chain can be picked up at the given
+ * header, that is the chunk after it is valid as well.
+ */
+static bool isSyncPoint(
+		ScanRange* range,
+		const unsigned char* header,
+		off_t offset)
+{
+	const IndexScanner* scanner = range->scanner;
+	unsigned char next[RIFF_LIST_HEADER_SIZE];
+	off_t nextOffset = getNextChunkOffset(header, offset);
+
+	// Last chunk of the list
+	if (nextOffset + RIFF_CHUNK_HEADER_SIZE > scanner->moviEnd)
+	{
+		return true;
+	}
+
+	return readScanHeader(range, nextOffset, next)
+			&& isChunkHeader(next, nextOffset, scanner->moviEnd);
+}
+
+static bool addChunk(
+		ScanRange* range,
+		const unsigned char* header,
+		off_t offset)
+{
+	if (range->chunkCount == range->capacity)
+	{
+		long capacity = range->capacity + (range->capacity / 2) + CHUNK_LIST_GROWTH;
+		ChunkEntry* chunks = (ChunkEntry*) realloc(range->chunks,
+				capacity * sizeof(ChunkEntry));
+
+		if (0 == chunks)
+		{
+			return false;
+		}
+
+		range->chunks = chunks;
+		range->capacity = capacity;
+	}
+
+	ChunkEntry* chunk = &range->chunks[range->chunkCount++];
+	chunk->offset = offset;
+	chunk->size = readRiffLong(header + 4);
+	memcpy(chunk->id, header, 4);
+
+	return true;
+}
+
+/**
+ * Follows the chunk chain from the given offset until it
+ * leaves the range. Invalid headers are skipped a word at
+ * a time until two valid chunks in a row are found.
+ */
+static void scanChunks(
+		ScanRange* range,
+		off_t offset,
+		bool isSynced)
+{
+	const IndexScanner* scanner = range->scanner;
+	unsigned char header[RIFF_LIST_HEADER_SIZE];
+
+	range->chunkCount = 0;
+	range->isFailed = false;
+
+	while ((offset < range->end)
+			&& (offset + RIFF_CHUNK_HEADER_SIZE <= scanner->moviEnd))
+	{
+		if (!readScanHeader(range, offset, header))
+		{
+			range->isFailed = true;
+			break;
+		}
+
+		if (!isChunkHeader(header, offset, scanner->moviEnd)
+				|| (!isSynced && !isSyncPoint(range, header, offset)))
+		{
+			// Chunks start on word boundaries
+			isSynced = false;
+			offset += 2;
+			continue;
+		}
+
+		if (!addChunk(range, header, offset))
+		{
+			range->isFailed = true;
+			break;
+		}
+
+		isSynced = true;
+		offset = getNextChunkOffset(header, offset);
+	}
+
+	range->exitOffset = offset;
+	range->isExitSynced = isSynced;
+}
+
+/**
+ * Scans the range with the given index, syncing to the
+ * chunk chain unless the range is at the list start.
+ */
+static void scanRangeTask(
+		void* context,
+		int index)
+{
+	ScanRange* range = &((IndexScanner*) context)->ranges[index];
+
+	scanChunks(range, range->start, (0 == index));
+}
+
+/**
+ * Finds the first chunk at or after the given offset.
+ */
+static long findChunk(
+		const ScanRange* range,
+		off_t offset)
+{
+	long low = 0;
+	long high = range->chunkCount;
+
+	while (low < high)
+	{
+		long middle = (low + high) / 2;
+
+		if (range->chunks[middle].offset < offset)
+		{
+			low = middle + 1;
+		}
+		else
+		{
+			high = middle;
+		}
+	}
+
+	return low;
+}
+
+/**
+ * Stitches the ranges together, following the chunk chain
+ * from the list start. A range that synced to a different
+ * chain is scanned again from where the chain enters it.
+ */
+static bool stitchRanges(
+		IndexScanner* scanner)
+{
+	off_t expected = scanner->moviStart;
+	bool isSynced = true;
+
+	for (int i = 0; i < scanner->rangeCount; i++)
+	{
+		ScanRange* range = &scanner->ranges[i];
+
+		if (range->isFailed)
+		{
+			return false;
+		}
+
+		// Range is inside a chunk of the previous ones
+		if (expected >= range->end)
+		{
+			range->firstChunk = range->chunkCount;
+			continue;
+		}
+
+		range->firstChunk = findChunk(range, expected);
+
+		if ((range->firstChunk == range->chunkCount)
+				|| (expected != range->chunks[range->firstChunk].offset))
+		{
+			scanChunks(range, expected, isSynced);
+			range->firstChunk = 0;
+
+			if (range->isFailed)
+			{
+				return false;
+			}
+		}
+
+		expected = range->exitOffset;
+		isSynced = range->isExitSynced;
+	}
+
+	return true;
+}
+
+/**
+ * Builds the avilib video and audio indices from the
+ * stitched chunks, the way avilib builds them from idx1.
+ */
+static bool buildIndices(
+		avi_t* avi,
+		const IndexScanner* scanner)
+{
+	long videoCount = 0;
+	long audioCounts[AVI_MAX_TRACKS] = { 0 };
+
+	for (int pass = 0; pass < 2; pass++)
+	{
+		for (int i = 0; i < scanner->rangeCount; i++)
+		{
+			const ScanRange* range = &scanner->ranges[i];
+
+			for (long j = range->firstChunk; j < range->chunkCount; j++)
+			{
+				const ChunkEntry* chunk = &range->chunks[j];
+
+				if (0 == strncasecmp(chunk->id, avi->video_tag, 3))
+				{
+					if (0 != pass)
+					{
+						video_index_entry* entry = &avi->video_index[avi->video_frames++];
+
+						entry->key = AVIIF_KEYFRAME;
+						entry->pos = chunk->offset + RIFF_CHUNK_HEADER_SIZE;
+						entry->len = chunk->size;
+					}
+
+					videoCount++;
+					continue;
+				}
+
+				for (int k = 0; k < avi->anum; k++)
+				{
+					track_t* track = &avi->track[k];
+
+					if (0 != strncasecmp(chunk->id, track->audio_tag, 4))
+					{
+						continue;
+					}
+
+					if (0 != pass)
+					{
+						audio_index_entry* entry = &track->audio_index[track->audio_chunks++];
+
+						entry->pos = chunk->offset + RIFF_CHUNK_HEADER_SIZE;
+						entry->len = chunk->size;
+						entry->tot = track->audio_bytes;
+
+						track->audio_bytes += chunk->size;
+					}
+
+					audioCounts[k]++;
+					break;
+				}
+			}
+		}
+
+		if (0 != pass)
+		{
+			break;
+		}
+
+		// Allocate with malloc, AVI_close frees the indices
+		if (0 == videoCount)
+		{
+			return false;
+		}
+
+		avi->video_index = (video_index_entry*) malloc(
+				videoCount * sizeof(video_index_entry));
+
+		if (0 == avi->video_index)
+		{
+			return false;
+		}
+
+		for (int k = 0; k < avi->anum; k++)
+		{
+			if (0 == audioCounts[k])
+			{
+				continue;
+			}
+
+			avi->track[k].audio_index = (audio_index_entry*) malloc(
+					audioCounts[k] * sizeof(audio_index_entry));
+
+			if (0 == avi->track[k].audio_index)
+			{
+				return false;
+			}
+		}
+
+		avi->video_frames = 0;
+		avi->video_pos = 0;
+
+		for (int k = 0; k < avi->anum; k++)
+		{
+			avi->track[k].audio_chunks = 0;
+			avi->track[k].audio_bytes = 0;
+			avi->track[k].audio_posc = 0;
+			avi->track[k].audio_posb = 0;
+		}
+	}
+
+	return true;
+}
+
+/**
+ * Appends the idx1 index after the last whole chunk, and
+ * updates the movi list and the RIFF sizes. The partial
+ * chunk of a truncated file is cut off.
+ */
+static bool writeRepairedIndex(
+		const IndexScanner* scanner,
+		const char* fileName)
+{
+	bool isWritten = false;
+	int fileDescriptor = -1;
+	unsigned char* index = 0;
+	unsigned char* entry = 0;
+	long entryCount = 0;
+	long indexSize = 0;
+	unsigned char size[4];
+
+	// Chunk offsets are relative to the movi list type
+	off_t listTypeOffset = scanner->moviStart - 4;
+	off_t end = scanner->moviStart;
+
+	for (int i = 0; i < scanner->rangeCount; i++)
+	{
+		const ScanRange* range = &scanner->ranges[i];
+
+		for (long j = range->firstChunk; j < range->chunkCount; j++)
+		{
+			const ChunkEntry* chunk = &range->chunks[j];
+
+			if (isStreamChunkId(chunk->id))
+			{
+				entryCount++;
+			}
+
+			if (0 != memcmp(chunk->id, "LIST", 4))
+			{
+				end = chunk->offset + RIFF_CHUNK_HEADER_SIZE
+						+ chunk->size + (chunk->size & 1);
+			}
+		}
+	}
+
+	// idx1 offsets and sizes are 32-bit
+	if (0xFFFFFFFFLL < (long long) (end - listTypeOffset)
+			+ RIFF_CHUNK_HEADER_SIZE + (entryCount * IDX1_ENTRY_SIZE))
+	{
+		goto exit;
+	}
+
+	indexSize = RIFF_CHUNK_HEADER_SIZE + (entryCount * IDX1_ENTRY_SIZE);
+	index = (unsigned char*) malloc(indexSize);
+	if (0 == index)
+	{
+		goto exit;
+	}
+
+	memcpy(index, "idx1", 4);
+	writeRiffLong(index + 4, entryCount * IDX1_ENTRY_SIZE);
+
+	entry = index + RIFF_CHUNK_HEADER_SIZE;
+	for (int i = 0; i < scanner->rangeCount; i++)
+	{
+		const ScanRange* range = &scanner->ranges[i];
+
+		for (long j = range->firstChunk; j < range->chunkCount; j++)
+		{
+			const ChunkEntry* chunk = &range->chunks[j];
+
+			if (isStreamChunkId(chunk->id))
+			{
+				memcpy(entry, chunk->id, 4);
+				writeRiffLong(entry + 4, AVIIF_KEYFRAME);
+				writeRiffLong(entry + 8, chunk->offset - listTypeOffset);
+				writeRiffLong(entry + 12, chunk->size);
+				entry += IDX1_ENTRY_SIZE;
+			}
+		}
+	}
+
+	fileDescriptor = open(fileName, O_RDWR);
+	if (0 > fileDescriptor)
+	{
+		goto exit;
+	}
+
+	// Index in one write, then the sizes that cover it
+	if (indexSize != pwrite(fileDescriptor, index, indexSize, end))
+	{
+		goto exit;
+	}
+
+	writeRiffLong(size, end - listTypeOffset);
+	if (sizeof(size) != pwrite(fileDescriptor, size, sizeof(size),
+			listTypeOffset - RIFF_CHUNK_HEADER_SIZE + LIST_SIZE_OFFSET))
+	{
+		goto exit;
+	}
+
+	writeRiffLong(size, end + indexSize - RIFF_CHUNK_HEADER_SIZE);
+	if (sizeof(size) != pwrite(fileDescriptor, size, sizeof(size),
+			RIFF_SIZE_OFFSET))
+	{
+		goto exit;
+	}
+
+	isWritten = (0 == ftruncate(fileDescriptor, end + indexSize));
+
+exit:
+	if (0 <= fileDescriptor)
+	{
+		close(fileDescriptor);
+	}
+
+	free(index);
+	return isWritten;
+}
+
+bool recoverAviIndex(
+		avi_t* avi,
+		const char* repairFileName)
+{
+	bool isRecovered = false;
+	IndexScanner scanner;
+	WorkerPool* pool = 0;
+	struct stat fileStat;
+	bool hasIndex = false;
+	off_t rangeSize;
+
+	memset(&scanner, 0, sizeof(scanner));
+	scanner.fileDescriptor = avi->fdes;
+
+	if ((0 != fstat(avi->fdes, &fileStat))
+			|| !findMoviList(avi->fdes, fileStat.st_size,
+					&scanner.moviStart, &scanner.moviEnd, &hasIndex))
+	{
+		goto exit;
+	}
+
+	// One range per thread, on word boundaries
+	scanner.rangeCount = getCpuCount(RECOVERY_MAX_THREADS);
+	if (scanner.rangeCount > (scanner.moviEnd - scanner.moviStart) / RECOVERY_MIN_RANGE_SIZE)
+	{
+		scanner.rangeCount = (scanner.moviEnd - scanner.moviStart) / RECOVERY_MIN_RANGE_SIZE;
+	}
+
+	if (1 > scanner.rangeCount)
+	{
+		scanner.rangeCount = 1;
+	}
+
+	rangeSize = ((scanner.moviEnd - scanner.moviStart) / scanner.rangeCount) & ~1;
+
+	for (int i = 0; i < scanner.rangeCount; i++)
+	{
+		ScanRange* range = &scanner.ranges[i];
+
+		range->scanner = &scanner;
+		range->start = scanner.moviStart + (i * rangeSize);
+		range->end = (i + 1 == scanner.rangeCount)
+				? scanner.moviEnd
+				: range->start + rangeSize;
+
+		range->block = (unsigned char*) malloc(RECOVERY_BLOCK_SIZE);
+		if (0 == range->block)
+		{
+			goto exit;
+		}
+	}
+
+	pool = createWorkerPool(scanner.rangeCount);
+	if (0 == pool)
+	{
+		goto exit;
+	}
+
+	// Scan the ranges on the pool threads
+	runWorkerTasks(pool, scanRangeTask, &scanner, scanner.rangeCount);
+
+	if (!stitchRanges(&scanner) || !buildIndices(avi, &scanner))
+	{
+		goto exit;
+	}
+
+	// Repair is best effort, the index is rebuilt anyway
+	if (0 != repairFileName)
+	{
+		writeRepairedIndex(&scanner, repairFileName);
+	}
+
+	isRecovered = true;
+
+exit:
+	if (!isRecovered)
+	{
+		AVI_errno = AVI_ERR_NO_IDX;
+	}
+
+	destroyWorkerPool(pool);
+
+	for (int i = 0; i < RECOVERY_MAX_THREADS; i++)
+	{
+		free(scanner.ranges[i].chunks);
+		free(scanner.ranges[i].block);
+	}
+
+	return isRecovered;
+}
+
+avi_t* openIndexedAvi(
+		const char* fileName)
+{
+	bool isIndexMissing = isAviIndexMissing(fileName);
+
+	avi_t* avi = AVI_open_input_file(fileName, isIndexMissing ? 0 : 1);
+
+	if ((0 != avi) && isIndexMissing && !recoverAviIndex(avi, 0))
+	{
+		AVI_close(avi);
+		avi = 0;
+	}
+
+	return avi;
+}
@@ -0,0 +1,65 @@
+#pragma once
+
+extern "C" {
+#include <avilib.h>
+}
+
+/**
+ * Maximum number of threads scanning the movi list.
+ */
+#define RECOVERY_MAX_THREADS 4
+
+/**
+ * Movi list is split into byte ranges of at least this
+ * size, smaller files are scanned on one thread.
+ */
+#define RECOVERY_MIN_RANGE_SIZE (4 * 1024 * 1024)
+
+/**
+ * Chunk headers are read in blocks of this size, so that
+ * runs of small chunks are read sequentially while large
+ * chunks are skipped over.
+ */
+#define RECOVERY_BLOCK_SIZE (256 * 1024)
+
+/**
+ * Checks if the given AVI file has no idx1 index, such as
+ * a recording that was cut off before it was finalized.
+ * Only the top level chunk headers are read.
+ *
+ * @param fileName file name.
+ * @return true if the movi list is found but the index
+ * is missing.
+ */
+bool isAviIndexMissing(
+		const char* fileName);
+
+/**
+ * Rebuilds the video and audio indices of the given AVI
+ * file from its chunk headers. The movi list is split into
+ * byte ranges that are scanned on several threads; each
+ * range syncs to the first run of valid chunk headers,
+ * and the ranges are stitched together by following the
+ * chunk chain from the start of the list. A partial chunk
+ * at the end of a truncated file is dropped.
+ *
+ * @param avi AVI file opened without its index.
+ * @param repairFileName file to append the rebuilt idx1
+ * index to, or 0 to only rebuild it in memory.
+ * @return true on success, false with AVI_errno otherwise.
+ */
+bool recoverAviIndex(
+		avi_t* avi,
+		const char* repairFileName);
+
+/**
+ * Opens the given AVI file with the avilib index, for
+ * reading the whole file through avilib. OpenDML files
+ * are indexed by avilib, files without an index are
+ * scanned.
+ *
+ * @param fileName file name.
+ * @return AVI file or 0 with AVI_errno on failure.
+ */
+avi_t* openIndexedAvi(
+		const char* fileName);
@@ -0,0 +1,1159 @@
+#include "MjpegDecoder.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "FrameFormat.h"
+#include "Idct.h"
+#include "PixelFormat.h"
+#include "YuvConverter.h"
+
+// Components of a color frame
+#define MAX_COMPONENTS 3
+
+// Quantization and Huffman table slots
+#define MAX_TABLES 4
+
+// Codes up to this length are decoded with one lookup
+#define FAST_BITS 9
+
+// Slices per thread, so uneven slices balance out
+#define SLICES_PER_THREAD 4
+
+/**
+ * Natural order index of each zigzag order coefficient.
+ */
+static const unsigned char ZIGZAG[IDCT_BLOCK_SIZE] =
+{
+	0, 1, 8, 16, 9, 2, 3, 10,
+	17, 24, 32, 25, 18, 11, 4, 5,
+	12, 19, 26, 33, 40, 48, 41, 34,
+	27, 20, 13, 6, 7, 14, 21, 28,
+	35, 42, 49, 56, 57, 50, 43, 36,
+	29, 22, 15, 23, 30, 37, 44, 51,
+	58, 59, 52, 45, 38, 31, 39, 46,
+	53, 60, 61, 54, 47, 55, 62, 63
+};
+
+/**
+ * Standard Huffman tables from the JPEG specification,
+ * K.3. Code counts by length, followed by the values.
+ */
+static const unsigned char DC_LUMINANCE_COUNTS[16] =
+{
+	0, 1, 5, 1, 1, 1, 1, 1, 1, 0, 0, 0, 0, 0, 0, 0
+};
+
+static const unsigned char DC_CHROMINANCE_COUNTS[16] =
+{
+	0, 3, 1, 1, 1, 1, 1, 1, 1, 1, 1, 0, 0, 0, 0, 0
+};
+
+static const unsigned char DC_VALUES[12] =
+{
+	0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11
+};
+
+static const unsigned char AC_LUMINANCE_COUNTS[16] =
+{
+	0, 2, 1, 3, 3, 2, 4, 3, 5, 5, 4, 4, 0, 0, 1, 0x7D
+};
+
+static const unsigned char AC_LUMINANCE_VALUES[162] =
+{
+	0x01, 0x02, 0x03, 0x00, 0x04, 0x11, 0x05, 0x12,
+	0x21, 0x31, 0x41, 0x06, 0x13, 0x51, 0x61, 0x07,
+	0x22, 0x71, 0x14, 0x32, 0x81, 0x91, 0xA1, 0x08,
+	0x23, 0x42, 0xB1, 0xC1, 0x15, 0x52, 0xD1, 0xF0,
+	0x24, 0x33, 0x62, 0x72, 0x82, 0x09, 0x0A, 0x16,
+	0x17, 0x18, 0x19, 0x1A, 0x25, 0x26, 0x27, 0x28,
+	0x29, 0x2A, 0x34, 0x35, 0x36, 0x37, 0x38, 0x39,
+	0x3A, 0x43, 0x44, 0x45, 0x46, 0x47, 0x48, 0x49,
+	0x4A, 0x53, 0x54, 0x55, 0x56, 0x57, 0x58, 0x59,
+	0x5A, 0x63, 0x64, 0x65, 0x66, 0x67, 0x68, 0x69,
+	0x6A, 0x73, 0x74, 0x75, 0x76, 0x77, 0x78, 0x79,
+	0x7A, 0x83, 0x84, 0x85, 0x86, 0x87, 0x88, 0x89,
+	0x8A, 0x92, 0x93, 0x94, 0x95, 0x96, 0x97, 0x98,
+	0x99, 0x9A, 0xA2, 0xA3, 0xA4, 0xA5, 0xA6, 0xA7,
+	0xA8, 0xA9, 0xAA, 0xB2, 0xB3, 0xB4, 0xB5, 0xB6,
+	0xB7, 0xB8, 0xB9, 0xBA, 0xC2, 0xC3, 0xC4, 0xC5,
+	0xC6, 0xC7, 0xC8, 0xC9, 0xCA, 0xD2, 0xD3, 0xD4,
+	0xD5, 0xD6, 0xD7, 0xD8, 0xD9, 0xDA, 0xE1, 0xE2,
+	0xE3, 0xE4, 0xE5, 0xE6, 0xE7, 0xE8, 0xE9, 0xEA,
+	0xF1, 0xF2, 0xF3, 0xF4, 0xF5, 0xF6, 0xF7, 0xF8,
+	0xF9, 0xFA
+};
+
+static const unsigned char AC_CHROMINANCE_COUNTS[16] =
+{
+	0, 2, 1, 2, 4, 4, 3, 4, 7, 5, 4, 4, 0, 1, 2, 0x77
+};
+
+static const unsigned char AC_CHROMINANCE_VALUES[162] =
+{
+	0x00, 0x01, 0x02, 0x03, 0x11, 0x04, 0x05, 0x21,
+	0x31, 0x06, 0x12, 0x41, 0x51, 0x07, 0x61, 0x71,
+	0x13, 0x22, 0x32, 0x81, 0x08, 0x14, 0x42, 0x91,
+	0xA1, 0xB1, 0xC1, 0x09, 0x23, 0x33, 0x52, 0xF0,
+	0x15, 0x62, 0x72, 0xD1, 0x0A, 0x16, 0x24, 0x34,
+	0xE1, 0x25, 0xF1, 0x17, 0x18, 0x19, 0x1A, 0x26,
+	0x27, 0x28, 0x29, 0x2A, 0x35, 0x36, 0x37, 0x38,
+	0x39, 0x3A, 0x43, 0x44, 0x45, 0x46, 0x47, 0x48,
+	0x49, 0x4A, 0x53, 0x54, 0x55, 0x56, 0x57, 0x58,
+	0x59, 0x5A, 0x63, 0x64, 0x65, 0x66, 0x67, 0x68,
+	0x69, 0x6A, 0x73, 0x74, 0x75, 0x76, 0x77, 0x78,
+	0x79, 0x7A, 0x82, 0x83, 0x84, 0x85, 0x86, 0x87,
+	0x88, 0x89, 0x8A, 0x92, 0x93, 0x94, 0x95, 0x96,
+	0x97, 0x98, 0x99, 0x9A, 0xA2, 0xA3, 0xA4, 0xA5,
+	0xA6, 0xA7, 0xA8, 0xA9, 0xAA, 0xB2, 0xB3, 0xB4,
+	0xB5, 0xB6, 0xB7, 0xB8, 0xB9, 0xBA, 0xC2, 0xC3,
+	0xC4, 0xC5, 0xC6, 0xC7, 0xC8, 0xC9, 0xCA, 0xD2,
+	0xD3, 0xD4, 0xD5, 0xD6, 0xD7, 0xD8, 0xD9, 0xDA,
+	0xE2, 0xE3, 0xE4, 0xE5, 0xE6, 0xE7, 0xE8, 0xE9,
+	0xEA, 0xF2, 0xF3, 0xF4, 0xF5, 0xF6, 0xF7, 0xF8,
+	0xF9, 0xFA
+};
+
+/**
+ * Huffman decoding table.
+ */
+struct HuffmanTable
+{
+	bool isDefined;
+
+	// Short codes, length 0 if the code is longer
+	unsigned char fastLengths[1 << FAST_BITS];
+	unsigned char fastValues[1 << FAST_BITS];
+
+	// Largest code of each length, -1 if there is none
+	int maxCodes[17];
+
+	// Value index minus the code, for each length
+	int valueOffsets[17];
+
+	unsigned char values[256];
+};
+
+/**
+ * Frame component and its sample plane.
+ */
+struct Component
+{
+	int id;
+
+	// Sampling factors
+	int h;
+	int v;
+
+	int quantizationTable;
+	int dcTable;
+	int acTable;
+
+	unsigned char* plane;
+	long stride;
+};
+
+struct MjpegDecoder
+{
+	WorkerPool* pool;
+
+	// Tables of the current frame
+	HuffmanTable dcTables[MAX_TABLES];
+	HuffmanTable acTables[MAX_TABLES];
+	float idctTables[MAX_TABLES][IDCT_BLOCK_SIZE];
+	bool isQuantizationDefined[MAX_TABLES];
+
+	// Standard tables, luminance then chrominance
+	HuffmanTable standardDcTables[2];
+	HuffmanTable standardAcTables[2];
+
+	// Frame header
+	int frameWidth;
+	int frameHeight;
+	Component components[MAX_COMPONENTS];
+	int componentCount;
+	int hMax;
+	int vMax;
+	int mcusX;
+	int mcusY;
+	int restartInterval;
+
+	unsigned char* planes;
+	long planesSize;
+
+	// Entropy coded segments, one per restart interval
+	const unsigned char* scan;
+	long scanSize;
+	long* segments;
+	int segmentCount;
+	int segmentCapacity;
+	int sliceCount;
+	volatile bool isFailed;
+
+	// Destination of the color conversion
+	unsigned char* pixels;
+	int width;
+	int height;
+	long stride;
+	int matrix;
+	int bandRows;
+
+	// Half width chroma rows of each band, and gray chroma
+	unsigned char* chromaRows;
+	long chromaRowsSize;
+	int halfWidth;
+};
+
+/**
+ * Entropy coded data reader. Bits are kept left aligned,
+ * markers and the end of the data read as zeros.
+ */
+struct BitReader
+{
+	const unsigned char* data;
+	const unsigned char* end;
+	unsigned int bits;
+	int count;
+};
+
+/**
+ * Builds the decoding table from the code counts and the
+ * values.
+ *
+ * @return true if the codes are valid.
+ */
+static bool buildHuffmanTable(
+		HuffmanTable* table,
+		const unsigned char* counts,
+		const unsigned char* values)
+{
+	int code = 0;
+	int k = 0;
+
+	memset(table->fastLengths, 0, sizeof(table->fastLengths));
+
+	for (int length = 1; length <= 16; length++)
+	{
+		table->valueOffsets[length] = k - code;
+
+		for (int i = 0; i < counts[length - 1]; i++, code++, k++)
+		{
+			if (FAST_BITS >= length)
+			{
+				// All lookups starting with the code
+				int first = code << (FAST_BITS - length);
+				int last = first + (1 << (FAST_BITS - length));
+
+				for (int j = first; j < last; j++)
+				{
+					table->fastLengths[j] = length;
+					table->fastValues[j] = values[k];
+				}
+			}
+		}
+
+		table->maxCodes[length] = (0 == counts[length - 1]) ? -1 : code - 1;
+
+		// More codes than the length can hold
+		if (code > (1 << length))
+		{
+			return false;
+		}
+
+		code <<= 1;
+	}
+
+	memcpy(table->values, values, k);
+	table->isDefined = true;
+
+	return true;
+}
+
+/**
+ * Refills the bit buffer to at least 25 bits.
+ */
+static inline void fillBits(
+		BitReader* reader)
+{
+	while (24 >= reader->count)
+	{
+		unsigned int byte = 0;
+
+		if (reader->data < reader->end)
+		{
+			byte = *reader->data++;
+
+			if (0xFF == byte)
+			{
+				// Stuffed zero, or a marker that ends the data
+				if ((reader->data < reader->end) && (0 == *reader->data))
+				{
+					reader->data++;
+				}
+				else
+				{
+					reader->data = reader->end;
+					byte = 0;
+				}
+			}
+		}
+
+		reader->bits |= byte << (24 - reader->count);
+		reader->count += 8;
+	}
+}
+
+/**
+ * Drops the given number of bits.
+ */
+static inline void skipBits(
+		BitReader* reader,
+		int count)
+{
+	reader->bits <<= count;
+	reader->count -= count;
+}
+
+/**
+ * Decodes a Huffman coded value.
+ *
+ * @return value or -1 for an invalid code.
+ */
+static inline int decodeHuffman(
+		BitReader* reader,
+		const HuffmanTable* table)
+{
+	fillBits(reader);
+
+	unsigned int lookup = reader->bits >> (32 - FAST_BITS);
+	int length = table->fastLengths[lookup];
+
+	if (0 != length)
+	{
+		skipBits(reader, length);
+		return table->fastValues[lookup];
+	}
+
+	for (length = FAST_BITS + 1; length <= 16; length++)
+	{
+		int code = reader->bits >> (32 - length);
+
+		if (code <= table->maxCodes[length])
+		{
+			skipBits(reader, length);
+			return table->values[code + table->valueOffsets[length]];
+		}
+	}
+
+	return -1;
+}
+
+/**
+ * Reads a coefficient of the given bit size and extends
+ * its sign.
+ */
+static inline int receiveExtend(
+		BitReader* reader,
+		int size)
+{
+	fillBits(reader);
+
+	int value = reader->bits >> (32 - size);
+	skipBits(reader, size);
+
+	// Values with the top bit clear are negative
+	if (value < (1 << (size - 1)))
+	{
+		value += 1 - (1 << size);
+	}
+
+	return value;
+}
+
+/**
+ * Decodes the coefficients of a block.
+ *
+ * @return index of the last coefficient in zigzag order,
+ * 0 for DC only blocks, or -1 on error.
+ */
+static int decodeBlock(
+		BitReader* reader,
+		const HuffmanTable* dcTable,
+		const HuffmanTable* acTable,
+		int* predictor,
+		short* block)
+{
+	int last = 0;
+
+	memset(block, 0, IDCT_BLOCK_SIZE * sizeof(short));
+
+	// DC difference from the previous block
+	int size = decodeHuffman(reader, dcTable);
+	if ((0 > size) || (11 < size))
+	{
+		return -1;
+	}
+
+	if (0 != size)
+	{
+		*predictor += receiveExtend(reader, size);
+	}
+
+	block[0] = *predictor;
+
+	// Run length coded AC coefficients
+	for (int k = 1; k < IDCT_BLOCK_SIZE; k++)
+	{
+		int runSize = decodeHuffman(reader, acTable);
+		if (0 > runSize)
+		{
+			return -1;
+		}
+
+		int run = runSize >> 4;
+		size = runSize & 0x0F;
+
+		if (0 == size)
+		{
+			// End of block, unless it is a run of 16 zeros
+			if (15 != run)
+			{
+				break;
+			}
+
+			k += 15;
+			continue;
+		}
+
+		k += run;
+		if (IDCT_BLOCK_SIZE <= k)
+		{
+			return -1;
+		}
+
+		block[ZIGZAG[k]] = receiveExtend(reader, size);
+		last = k;
+	}
+
+	return last;
+}
+
+/**
+ * Decodes an MCU into the component planes.
+ *
+ * @return true if decoded.
+ */
+static bool decodeMcu(
+		MjpegDecoder* decoder,
+		BitReader* reader,
+		int* predictors,
+		int mcu,
+		short* block)
+{
+	int mcuX = mcu % decoder->mcusX;
+	int mcuY = mcu / decoder->mcusX;
+
+	for (int c = 0; c < decoder->componentCount; c++)
+	{
+		const Component& component = decoder->components[c];
+		const float* table = decoder->idctTables[component.quantizationTable];
+
+		for (int by = 0; by < component.v; by++)
+		{
+			for (int bx = 0; bx < component.h; bx++)
+			{
+				int last = decodeBlock(reader,
+						&decoder->dcTables[component.dcTable],
+						&decoder->acTables[component.acTable],
+						&predictors[c],
+						block);
+
+				if (0 > last)
+				{
+					return false;
+				}
+
+				unsigned char* output = component.plane
+						+ (((mcuY * component.v) + by) * 8 * component.stride)
+						+ (((mcuX * component.h) + bx) * 8);
+
+				if (0 == last)
+				{
+					// Flat block, only the DC survives the IDCT
+					int sample = (int) ((block[0] * table[0]) + 128.5f);
+					sample = (sample < 0) ? 0 : ((sample > 255) ? 255 : sample);
+
+					for (int i = 0; i < 8; i++)
+					{
+						memset(output + (i * component.stride), sample, 8);
+					}
+				}
+				else
+				{
+					idctBlock(block, table, output, component.stride);
+				}
+			}
+		}
+	}
+
+	return true;
+}
+
+/**
+ * Decodes the restart intervals of a slice. The DC
+ * predictors start over at each interval.
+ */
+static void decodeSliceTask(
+		void* context,
+		int index)
+{
+	MjpegDecoder* decoder = (MjpegDecoder*) context;
+	short block[IDCT_BLOCK_SIZE];
+
+	int mcuCount = decoder->mcusX * decoder->mcusY;
+	int first = (index * decoder->segmentCount) / decoder->sliceCount;
+	int last = ((index + 1) * decoder->segmentCount) / decoder->sliceCount;
+
+	for (int segment = first; segment < last; segment++)
+	{
+		BitReader reader;
+		reader.data = decoder->scan + decoder->segments[segment];
+		reader.end = decoder->scan + ((segment + 1 < decoder->segmentCount)
+				? decoder->segments[segment + 1]
+				: decoder->scanSize);
+		reader.bits = 0;
+		reader.count = 0;
+
+		int predictors[MAX_COMPONENTS] = { 0 };
+
+		int mcu = 0;
+		int lastMcu = mcuCount;
+
+		if (0 != decoder->restartInterval)
+		{
+			mcu = segment * decoder->restartInterval;
+			if (lastMcu > mcu + decoder->restartInterval)
+			{
+				lastMcu = mcu + decoder->restartInterval;
+			}
+		}
+
+		for (; mcu < lastMcu; mcu++)
+		{
+			if (!decodeMcu(decoder, &reader, predictors, mcu, block))
+			{
+				decoder->isFailed = true;
+				return;
+			}
+		}
+	}
+}
+
+/**
+ * Converts a band of rows to RGB565.
+ */
+static void convertBandTask(
+		void* context,
+		int index)
+{
+	MjpegDecoder* decoder = (MjpegDecoder*) context;
+	const Component& luma = decoder->components[0];
+
+	int halfWidth = decoder->halfWidth;
+	int evenWidth = decoder->width & ~1;
+
+	unsigned char* uRow = decoder->chromaRows + (2 * index * halfWidth);
+	unsigned char* vRow = uRow + halfWidth;
+	const unsigned char* grayRow = decoder->chromaRows
+			+ (2 * getWorkerThreadCount(decoder->pool) * halfWidth);
+
+	int firstRow = index * decoder->bandRows;
+	int lastRow = firstRow + decoder->bandRows;
+	if (lastRow > decoder->height)
+	{
+		lastRow = decoder->height;
+	}
+
+	for (int y = firstRow; y < lastRow; y++)
+	{
+		const unsigned char* yRow = luma.plane + (y * luma.stride);
+		const unsigned char* u = grayRow;
+		const unsigned char* v = grayRow;
+
+		if (MAX_COMPONENTS == decoder->componentCount)
+		{
+			const Component& cb = decoder->components[1];
+			const Component& cr = decoder->components[2];
+
+			int chromaY = y / decoder->vMax;
+			u = cb.plane + (chromaY * cb.stride);
+			v = cr.plane + (chromaY * cr.stride);
+
+			// Full width chroma is averaged down to pixel pairs
+			if (1 == decoder->hMax)
+			{
+				for (int i = 0; i < halfWidth; i++)
+				{
+					uRow[i] = (u[2 * i] + u[(2 * i) + 1] + 1) >> 1;
+					vRow[i] = (v[2 * i] + v[(2 * i) + 1] + 1) >> 1;
+				}
+
+				u = uRow;
+				v = vRow;
+			}
+		}
+
+		unsigned short* destination =
+				(unsigned short*) (decoder->pixels + (y * decoder->stride));
+
+		convertYuvRow(FRAME_FORMAT_I420, decoder->matrix,
+				yRow, u, v,
+				destination, PIXEL_FORMAT_RGB_565, evenWidth);
+
+		// Odd last pixel, the planes are padded to whole blocks
+		if (evenWidth != decoder->width)
+		{
+			unsigned short pair[2];
+
+			convertYuvRow(FRAME_FORMAT_I420, decoder->matrix,
+					yRow + evenWidth, u + (evenWidth / 2), v + (evenWidth / 2),
+					pair, PIXEL_FORMAT_RGB_565, 2);
+
+			destination[evenWidth] = pair[0];
+		}
+	}
+}
+
+/**
+ * Parses the quantization tables.
+ */
+static bool parseQuantization(
+		MjpegDecoder* decoder,
+		const unsigned char* data,
+		long size)
+{
+	while (0 < size)
+	{
+		int precision = data[0] >> 4;
+		int slot = data[0] & 0x0F;
+		long tableSize = 1 + (IDCT_BLOCK_SIZE * (precision + 1));
+
+		if ((MAX_TABLES <= slot) || (1 < precision) || (tableSize > size))
+		{
+			return false;
+		}
+
+		unsigned short quantization[IDCT_BLOCK_SIZE];
+
+		for (int k = 0; k < IDCT_BLOCK_SIZE; k++)
+		{
+			quantization[ZIGZAG[k]] = (0 == precision)
+					? data[1 + k]
+					: (data[1 + (2 * k)] << 8) | data[2 + (2 * k)];
+		}
+
+		buildIdctTable(quantization, decoder->idctTables[slot]);
+		decoder->isQuantizationDefined[slot] = true;
+
+		data += tableSize;
+		size -= tableSize;
+	}
+
+	return true;
+}
+
+/**
+ * Parses the Huffman tables.
+ */
+static bool parseHuffman(
+		MjpegDecoder* decoder,
+		const unsigned char* data,
+		long size)
+{
+	while (17 <= size)
+	{
+		int tableClass = data[0] >> 4;
+		int slot = data[0] & 0x0F;
+		long count = 0;
+
+		for (int i = 0; i < 16; i++)
+		{
+			count += data[1 + i];
+		}
+
+		if ((1 < tableClass)
+				|| (MAX_TABLES <= slot)
+				|| (256 < count)
+				|| (17 + count > size))
+		{
+			return false;
+		}
+
+		HuffmanTable* table = (0 == tableClass)
+				? &decoder->dcTables[slot]
+				: &decoder->acTables[slot];
+
+		if (!buildHuffmanTable(table, data + 1, data + 17))
+		{
+			return false;
+		}
+
+		data += 17 + count;
+		size -= 17 + count;
+	}
+
+	return (0 == size);
+}
+
+/**
+ * Parses the baseline frame header and lays out the
+ * component planes.
+ */
+static bool parseFrame(
+		MjpegDecoder* decoder,
+		const unsigned char* data,
+		long size)
+{
+	if ((6 > size) || (8 != data[0]))
+	{
+		return false;
+	}
+
+	decoder->frameHeight = (data[1] << 8) | data[2];
+	decoder->frameWidth = (data[3] << 8) | data[4];
+	decoder->componentCount = data[5];
+
+	if ((0 == decoder->frameWidth)
+			|| (0 == decoder->frameHeight)
+			|| ((1 != decoder->componentCount)
+					&& (MAX_COMPONENTS != decoder->componentCount))
+			|| (6 + (3 * decoder->componentCount) > size))
+	{
+		return false;
+	}
+
+	for (int c = 0; c < decoder->componentCount; c++)
+	{
+		Component& component = decoder->components[c];
+		const unsigned char* header = data + 6 + (3 * c);
+
+		component.id = header[0];
+		component.h = header[1] >> 4;
+		component.v = header[1] & 0x0F;
+		component.quantizationTable = header[2];
+
+		if (MAX_TABLES <= component.quantizationTable)
+		{
+			return false;
+		}
+
+		// Luma 1 or 2 either way, chroma not subsampled further
+		if ((0 == c)
+				? ((1 > component.h) || (2 < component.h)
+						|| (1 > component.v) || (2 < component.v))
+				: ((1 != component.h) || (1 != component.v)))
+		{
+			return false;
+		}
+	}
+
+	// Gray frames are not interleaved, one block per MCU
+	if (1 == decoder->componentCount)
+	{
+		decoder->components[0].h = 1;
+		decoder->components[0].v = 1;
+	}
+
+	decoder->hMax = decoder->components[0].h;
+	decoder->vMax = decoder->components[0].v;
+	decoder->mcusX = (decoder->frameWidth + (8 * decoder->hMax) - 1)
+			/ (8 * decoder->hMax);
+	decoder->mcusY = (decoder->frameHeight + (8 * decoder->vMax) - 1)
+			/ (8 * decoder->vMax);
+
+	// Planes padded to whole MCUs
+	long planesSize = 0;
+	for (int c = 0; c < decoder->componentCount; c++)
+	{
+		Component& component = decoder->components[c];
+
+		component.stride = decoder->mcusX * component.h * 8;
+		planesSize += component.stride * decoder->mcusY * component.v * 8;
+	}
+
+	if (planesSize > decoder->planesSize)
+	{
+		free(decoder->planes);
+
+		decoder->planes = (unsigned char*) malloc(planesSize);
+		decoder->planesSize = (0 == decoder->planes) ? 0 : planesSize;
+
+		if (0 == decoder->planes)
+		{
+			return false;
+		}
+	}
+
+	unsigned char* plane = decoder->planes;
+	for (int c = 0; c < decoder->componentCount; c++)
+	{
+		Component& component = decoder->components[c];
+
+		component.plane = plane;
+		plane += component.stride * decoder->mcusY * component.v * 8;
+	}
+
+	return true;
+}
+
+/**
+ * Parses the scan header. Only a single interleaved scan
+ * of all components is supported.
+ */
+static bool parseScan(
+		MjpegDecoder* decoder,
+		const unsigned char* data,
+		long size)
+{
+	if ((0 == decoder->componentCount)
+			|| (1 > size)
+			|| (decoder->componentCount != data[0])
+			|| (1 + (2 * data[0]) + 3 > size))
+	{
+		return false;
+	}
+
+	for (int i = 0; i < data[0]; i++)
+	{
+		const unsigned char* header = data + 1 + (2 * i);
+		Component* component = 0;
+
+		for (int c = 0; c < decoder->componentCount; c++)
+		{
+			if (header[0] == decoder->components[c].id)
+			{
+				component = &decoder->components[c];
+			}
+		}
+
+		if (0 == component)
+		{
+			return false;
+		}
+
+		component->dcTable = header[1] >> 4;
+		component->acTable = header[1] & 0x0F;
+
+		if ((MAX_TABLES <= component->dcTable)
+				|| (MAX_TABLES <= component->acTable)
+				|| !decoder->dcTables[component->dcTable].isDefined
+				|| !decoder->acTables[component->acTable].isDefined
+				|| !decoder->isQuantizationDefined[component->quantizationTable])
+		{
+			return false;
+		}
+	}
+
+	return true;
+}
+
+/**
+ * Splits the entropy coded data at the restart markers.
+ */
+static bool findSegments(
+		MjpegDecoder* decoder)
+{
+	const unsigned char* data = decoder->scan;
+	const unsigned char* end = data + decoder->scanSize;
+
+	int mcuCount = decoder->mcusX * decoder->mcusY;
+	int maxSegments = (0 == decoder->restartInterval)
+			? 1
+			: (mcuCount + decoder->restartInterval - 1) / decoder->restartInterval;
+
+	if (maxSegments > decoder->segmentCapacity)
+	{
+		long* segments = (long*) realloc(decoder->segments,
+				maxSegments * sizeof(long));
+
+		if (0 == segments)
+		{
+			return false;
+		}
+
+		decoder->segments = segments;
+		decoder->segmentCapacity = maxSegments;
+	}
+
+	decoder->segments[0] = 0;
+	decoder->segmentCount = 1;
+
+	while ((decoder->segmentCount < maxSegments) && (data + 1 < end))
+	{
+		data = (const unsigned char*) memchr(data, 0xFF, (end - 1) - data);
+		if (0 == data)
+		{
+			break;
+		}
+
+		int marker = data[1];
+
+		if ((0xD0 <= marker) && (0xD7 >= marker))
+		{
+			data += 2;
+			decoder->segments[decoder->segmentCount++] = data - decoder->scan;
+		}
+		else if ((0x00 == marker) || (0xFF == marker))
+		{
+			// Stuffed zero or fill byte
+			data++;
+		}
+		else
+		{
+			// Any other marker ends the scan
+			break;
+		}
+	}
+
+	return true;
+}
+
+/**
+ * Makes sure the chroma rows fit the destination.
+ */
+static bool prepareChromaRows(
+		MjpegDecoder* decoder)
+{
+	int threadCount = getWorkerThreadCount(decoder->pool);
+
+	decoder->halfWidth = (decoder->width + 1) / 2;
+
+	// Two rows for each band and one gray row
+	long size = ((2 * threadCount) + 1) * decoder->halfWidth;
+
+	if (size > decoder->chromaRowsSize)
+	{
+		free(decoder->chromaRows);
+
+		decoder->chromaRows = (unsigned char*) malloc(size);
+		decoder->chromaRowsSize = (0 == decoder->chromaRows) ? 0 : size;
+
+		if (0 == decoder->chromaRows)
+		{
+			return false;
+		}
+	}
+
+	memset(decoder->chromaRows + (2 * threadCount * decoder->halfWidth),
+			128, decoder->halfWidth);
+
+	return true;
+}
+
+MjpegDecoder* createMjpegDecoder(
+		WorkerPool* pool)
+{
+	MjpegDecoder* decoder = (MjpegDecoder*) calloc(1, sizeof(MjpegDecoder));
+	if (0 == decoder)
+	{
+		goto exit;
+	}
+
+	decoder->pool = pool;
+
+	buildHuffmanTable(&decoder->standardDcTables[0], DC_LUMINANCE_COUNTS, DC_VALUES);
+	buildHuffmanTable(&decoder->standardDcTables[1], DC_CHROMINANCE_COUNTS, DC_VALUES);
+	buildHuffmanTable(&decoder->standardAcTables[0], AC_LUMINANCE_COUNTS, AC_LUMINANCE_VALUES);
+	buildHuffmanTable(&decoder->standardAcTables[1], AC_CHROMINANCE_COUNTS, AC_CHROMINANCE_VALUES);
+
+exit:
+	return decoder;
+}
+
+void destroyMjpegDecoder(
+		MjpegDecoder* decoder)
+{
+	if (0 != decoder)
+	{
+		free(decoder->planes);
+		free(decoder->segments);
+		free(decoder->chromaRows);
+		free(decoder);
+	}
+}
+
+bool decodeMjpegFrame(
+		MjpegDecoder* decoder,
+		const unsigned char* data,
+		long size,
+		int matrix,
+		void* pixels,
+		int width,
+		int height,
+		long stride)
+{
+	const unsigned char* end = data + size;
+	bool isDecoded = false;
+
+	if ((4 > size) || (0xFF != data[0]) || (0xD8 != data[1]))
+	{
+		goto exit;
+	}
+
+	// Tables start over with each frame
+	for (int i = 0; i < MAX_TABLES; i++)
+	{
+		decoder->dcTables[i].isDefined = false;
+		decoder->acTables[i].isDefined = false;
+		decoder->isQuantizationDefined[i] = false;
+	}
+
+	decoder->dcTables[0] = decoder->standardDcTables[0];
+	decoder->dcTables[1] = decoder->standardDcTables[1];
+	decoder->acTables[0] = decoder->standardAcTables[0];
+	decoder->acTables[1] = decoder->standardAcTables[1];
+
+	decoder->componentCount = 0;
+	decoder->restartInterval = 0;
+
+	data += 2;
+
+	while (data < end)
+	{
+		// Markers may be padded with fill bytes
+		if (0xFF != *data++)
+		{
+			continue;
+		}
+
+		while ((data < end) && (0xFF == *data))
+		{
+			data++;
+		}
+
+		if (data + 3 > end)
+		{
+			break;
+		}
+
+		int marker = *data++;
+
+		// Markers without a segment
+		if ((0x01 == marker) || ((0xD0 <= marker) && (0xD8 >= marker)))
+		{
+			continue;
+		}
+
+		if (0xD9 == marker)
+		{
+			break;
+		}
+
+		long length = (data[0] << 8) | data[1];
+		if ((2 > length) || (data + length > end))
+		{
+			break;
+		}
+
+		const unsigned char* segment = data + 2;
+		long segmentSize = length - 2;
+		bool isParsed = true;
+
+		switch (marker)
+		{
+		case 0xDB:
+			isParsed = parseQuantization(decoder, segment, segmentSize);
+			break;
+
+		case 0xC4:
+			isParsed = parseHuffman(decoder, segment, segmentSize);
+			break;
+
+		case 0xC0:
+		case 0xC1:
+			isParsed = parseFrame(decoder, segment, segmentSize);
+			break;
+
+		case 0xDD:
+			isParsed = (2 <= segmentSize);
+			if (isParsed)
+			{
+				decoder->restartInterval = (segment[0] << 8) | segment[1];
+			}
+			break;
+
+		case 0xDA:
+			// First scan is the whole frame
+			if (!parseScan(decoder, segment, segmentSize))
+			{
+				goto exit;
+			}
+
+			decoder->scan = data + length;
+			decoder->scanSize = end - decoder->scan;
+			goto decode;
+
+		default:
+			// Progressive, lossless and arithmetic coding are not baseline
+			isParsed = (0xC0 > marker) || (0xCF < marker);
+			break;
+		}
+
+		if (!isParsed)
+		{
+			goto exit;
+		}
+
+		data += length;
+	}
+
+	goto exit;
+
+decode:
+	if (!findSegments(decoder))
+	{
+		goto exit;
+	}
+
+	// Entropy decode and transform the restart intervals
+	decoder->sliceCount = 1;
+	if (0 != decoder->restartInterval)
+	{
+		decoder->sliceCount = getWorkerThreadCount(decoder->pool) * SLICES_PER_THREAD;
+		if (decoder->sliceCount > decoder->segmentCount)
+		{
+			decoder->sliceCount = decoder->segmentCount;
+		}
+	}
+
+	decoder->isFailed = false;
+	runWorkerTasks(decoder->pool, decodeSliceTask, decoder, decoder->sliceCount);
+
+	if (decoder->isFailed)
+	{
+		goto exit;
+	}
+
+	// Convert the visible part to RGB565 in row bands
+	decoder->pixels = (unsigned char*) pixels;
+	decoder->width = (width < decoder->frameWidth) ? width : decoder->frameWidth;
+	decoder->height = (height < decoder->frameHeight) ? height : decoder->frameHeight;
+	decoder->stride = stride;
+	decoder->matrix = matrix;
+
+	if (!prepareChromaRows(decoder))
+	{
+		goto exit;
+	}
+
+	decoder->bandRows = (decoder->height + getWorkerThreadCount(decoder->pool) - 1)
+			/ getWorkerThreadCount(decoder->pool);
+
+	runWorkerTasks(decoder->pool, convertBandTask, decoder,
+			(decoder->height + decoder->bandRows - 1) / decoder->bandRows);
+
+	isDecoded = true;
+
+exit:
+	return isDecoded;
+}
@@ -0,0 +1,56 @@
+#pragma once
+
+#include "WorkerPool.h"
+
+/**
+ * Baseline JPEG decoder for Motion JPEG frames. Huffman
+ * coded 8-bit frames with one or three components are
+ * supported, with 4:4:4, 4:2:2, 4:4:0 and 4:2:0 chroma.
+ * Frames without Huffman tables use the standard tables,
+ * as AVI1 Motion JPEG leaves them out.
+ */
+struct MjpegDecoder;
+
+/**
+ * Creates a new Motion JPEG decoder.
+ *
+ * @param pool worker pool to decode on, owned by the
+ * caller.
+ * @return decoder or 0 on failure.
+ */
+MjpegDecoder* createMjpegDecoder(
+		WorkerPool* pool);
+
+/**
+ * Destroys the given decoder.
+ *
+ * @param decoder decoder.
+ */
+void destroyMjpegDecoder(
+		MjpegDecoder* decoder);
+
+/**
+ * Decodes a frame into RGB565 pixels. Restart intervals
+ * are entropy decoded in parallel, and the color
+ * conversion is done in row bands in parallel. Frames
+ * larger than the destination are cropped.
+ *
+ * @param decoder decoder.
+ * @param data JPEG data.
+ * @param size JPEG data size in bytes.
+ * @param matrix color matrix.
+ * @param pixels destination RGB565 pixels.
+ * @param width destination width in pixels.
+ * @param height destination height in pixels.
+ * @param stride destination row stride in bytes.
+ * @return true if the frame is decoded.
+ */
+bool decodeMjpegFrame(
+		MjpegDecoder* decoder,
+		const unsigned char* data,
+		long size,
+		int matrix,
+		void* pixels,
+		int width,
+		int height,
+		long stride);
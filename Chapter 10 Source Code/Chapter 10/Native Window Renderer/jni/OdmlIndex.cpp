@@ -0,0 +1,429 @@
+#include "OdmlIndex.h"
+
+#include <fcntl.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "Riff.h"
+
+// Index header fields, shared by the super and standard indices
+#define INDEX_HEADER_SIZE 24
+#define INDEX_LONGS_PER_ENTRY_OFFSET 0
+#define INDEX_TYPE_OFFSET 3
+#define INDEX_ENTRIES_OFFSET 4
+
+// Index types
+#define AVI_INDEX_OF_INDEXES 0x00
+#define AVI_INDEX_OF_CHUNKS 0x01
+
+// Super index entry is the offset, size and duration
+#define SUPER_ENTRY_SIZE 16
+
+// Standard index base offset and entries
+#define STANDARD_BASE_OFFSET 12
+#define STANDARD_HEADER_SIZE (RIFF_CHUNK_HEADER_SIZE + INDEX_HEADER_SIZE)
+#define STANDARD_ENTRY_SIZE 8
+
+// Size bit that marks the frames that are not key frames
+#define DELTA_FRAME_FLAG 0x80000000UL
+
+/**
+ * Super index entry, one per standard index.
+ */
+struct SuperEntry
+{
+	// Standard index chunk offset and size, with the header
+	off_t offset;
+	unsigned long size;
+
+	// Frames before and in the standard index
+	long firstFrame;
+	long frameCount;
+};
+
+/**
+ * Loaded standard index.
+ */
+struct StandardIndex
+{
+	// Super index entry, or -1 if nothing is loaded
+	long superEntry;
+
+	off_t baseOffset;
+	unsigned char* entries;
+	long entryCount;
+
+	// Load counter value of the last lookup
+	unsigned long lastUsed;
+};
+
+struct OdmlIndex
+{
+	int fileDescriptor;
+	MemoryAccount* account;
+
+	SuperEntry* superEntries;
+	long superCount;
+	long frameCount;
+
+	// Super index entry of the last lookup
+	long lastSuper;
+
+	StandardIndex cached[ODML_CACHED_INDICES];
+	unsigned long useCounter;
+};
+
+static inline unsigned long long readRiffLongLong(
+		const unsigned char* data)
+{
+	return readRiffLong(data)
+			| ((unsigned long long) readRiffLong(data + 4) << 32);
+}
+
+/**
+ * Finds the super index of the video stream in the
+ * header list.
+ */
+static const unsigned char* findSuperIndex(
+		const unsigned char* headerList,
+		unsigned long size,
+		unsigned long* indexSize)
+{
+	const unsigned char* superIndex = 0;
+	unsigned long listSize = 0;
+	const unsigned char* list = findVideoStreamList(headerList, size, &listSize);
+
+	if (0 != list)
+	{
+		superIndex = findRiffChunk(list, listSize, "indx", indexSize);
+	}
+
+	// Only frame super indices, not field ones
+	if ((0 != superIndex)
+			&& ((INDEX_HEADER_SIZE > *indexSize)
+			|| (4 != superIndex[INDEX_LONGS_PER_ENTRY_OFFSET])
+			|| (AVI_INDEX_OF_INDEXES != superIndex[INDEX_TYPE_OFFSET])))
+	{
+		superIndex = 0;
+	}
+
+	return superIndex;
+}
+
+/**
+ * Reads the entry count from the header of a standard
+ * index, for writers that leave the super index duration
+ * at zero.
+ */
+static long readStandardEntryCount(
+		int fileDescriptor,
+		off_t offset)
+{
+	unsigned char header[STANDARD_HEADER_SIZE];
+
+	if ((sizeof(header) != pread(fileDescriptor, header, sizeof(header), offset))
+			|| (AVI_INDEX_OF_CHUNKS
+					!= header[RIFF_CHUNK_HEADER_SIZE + INDEX_TYPE_OFFSET]))
+	{
+		return -1;
+	}
+
+	return readRiffLong(header + RIFF_CHUNK_HEADER_SIZE + INDEX_ENTRIES_OFFSET);
+}
+
+bool isOdmlFile(
+		const char* fileName)
+{
+	bool isOdml = false;
+	unsigned long size = 0;
+	unsigned long indexSize = 0;
+	unsigned char* headerList = 0;
+
+	int fileDescriptor = open(fileName, O_RDONLY);
+	if (0 > fileDescriptor)
+	{
+		goto exit;
+	}
+
+	headerList = readRiffHeaderList(fileDescriptor, &size);
+	if (0 != headerList)
+	{
+		isOdml = (0 != findSuperIndex(headerList, size, &indexSize));
+		free(headerList);
+	}
+
+	close(fileDescriptor);
+
+exit:
+	return isOdml;
+}
+
+OdmlIndex* openOdmlIndex(
+		int fileDescriptor,
+		MemoryAccount* account)
+{
+	OdmlIndex* index = 0;
+	unsigned long size = 0;
+	unsigned long indexSize = 0;
+	const unsigned char* superIndex = 0;
+	const unsigned char* entry = 0;
+	long superCount = 0;
+
+	unsigned char* headerList = readRiffHeaderList(fileDescriptor, &size);
+	if (0 == headerList)
+	{
+		goto exit;
+	}
+
+	superIndex = findSuperIndex(headerList, size, &indexSize);
+	if (0 == superIndex)
+	{
+		goto exit;
+	}
+
+	// Entries in use, as far as the chunk holds them
+	superCount = readRiffLong(superIndex + INDEX_ENTRIES_OFFSET);
+	if (superCount > (long) ((indexSize - INDEX_HEADER_SIZE) / SUPER_ENTRY_SIZE))
+	{
+		superCount = (indexSize - INDEX_HEADER_SIZE) / SUPER_ENTRY_SIZE;
+	}
+
+	if (0 >= superCount)
+	{
+		goto exit;
+	}
+
+	index = (OdmlIndex*) allocateMemory(account, MEMORY_CACHES,
+			sizeof(OdmlIndex));
+
+	if (0 == index)
+	{
+		goto exit;
+	}
+
+	memset(index, 0, sizeof(OdmlIndex));
+	index->fileDescriptor = fileDescriptor;
+	index->account = account;
+
+	for (int i = 0; i < ODML_CACHED_INDICES; i++)
+	{
+		index->cached[i].superEntry = -1;
+	}
+
+	index->superEntries = (SuperEntry*) allocateMemory(account, MEMORY_CACHES,
+			superCount * sizeof(SuperEntry));
+
+	if (0 == index->superEntries)
+	{
+		closeOdmlIndex(index);
+		index = 0;
+		goto exit;
+	}
+
+	entry = superIndex + INDEX_HEADER_SIZE;
+	for (long i = 0; i < superCount; i++, entry += SUPER_ENTRY_SIZE)
+	{
+		SuperEntry* superEntry = &index->superEntries[index->superCount];
+
+		superEntry->offset = readRiffLongLong(entry);
+		superEntry->size = readRiffLong(entry + 8);
+		superEntry->firstFrame = index->frameCount;
+		superEntry->frameCount = readRiffLong(entry + 12);
+
+		// Duration is in stream ticks, one per frame for video
+		if (0 == superEntry->frameCount)
+		{
+			superEntry->frameCount = readStandardEntryCount(fileDescriptor,
+					superEntry->offset);
+		}
+
+		// Unused slots end the index
+		if ((0 == superEntry->offset) || (0 >= superEntry->frameCount))
+		{
+			break;
+		}
+
+		index->frameCount += superEntry->frameCount;
+		index->superCount++;
+	}
+
+	if (0 == index->frameCount)
+	{
+		closeOdmlIndex(index);
+		index = 0;
+	}
+
+exit:
+	free(headerList);
+	return index;
+}
+
+void closeOdmlIndex(
+		OdmlIndex* index)
+{
+	if (0 == index)
+	{
+		return;
+	}
+
+	for (int i = 0; i < ODML_CACHED_INDICES; i++)
+	{
+		freeMemory(index->cached[i].entries);
+	}
+
+	freeMemory(index->superEntries);
+	freeMemory(index);
+}
+
+long getOdmlFrameCount(
+		const OdmlIndex* index)
+{
+	return index->frameCount;
+}
+
+/**
+ * Finds the super index entry of the given frame. Playback
+ * stays in the entry of the last lookup, and seeks start
+ * from the entry the frame would be in if all standard
+ * indices were the same size, which they nearly are.
+ */
+static long findSuperEntry(
+		OdmlIndex* index,
+		long frame)
+{
+	long i = index->lastSuper;
+	const SuperEntry* entries = index->superEntries;
+
+	if ((frame < entries[i].firstFrame)
+			|| (frame >= entries[i].firstFrame + entries[i].frameCount))
+	{
+		i = (long) (((long long) frame * index->superCount) / index->frameCount);
+	}
+
+	while (frame < entries[i].firstFrame)
+	{
+		i--;
+	}
+
+	while (frame >= entries[i].firstFrame + entries[i].frameCount)
+	{
+		i++;
+	}
+
+	index->lastSuper = i;
+	return i;
+}
+
+/**
+ * Gets the standard index of the given super index entry,
+ * loading it in place of the least recently used one.
+ */
+static StandardIndex* loadStandardIndex(
+		OdmlIndex* index,
+		long superEntry)
+{
+	StandardIndex* standard = &index->cached[0];
+	const SuperEntry* entry = &index->superEntries[superEntry];
+	unsigned char* chunk = 0;
+	long entryCount;
+
+	index->useCounter++;
+
+	for (int i = 0; i < ODML_CACHED_INDICES; i++)
+	{
+		if (superEntry == index->cached[i].superEntry)
+		{
+			index->cached[i].lastUsed = index->useCounter;
+			return &index->cached[i];
+		}
+
+		if (index->cached[i].lastUsed < standard->lastUsed)
+		{
+			standard = &index->cached[i];
+		}
+	}
+
+	// Header and entries in one read
+	if (STANDARD_HEADER_SIZE > entry->size)
+	{
+		return 0;
+	}
+
+	chunk = (unsigned char*) allocateMemory(index->account, MEMORY_CACHES,
+			entry->size);
+
+	if (0 == chunk)
+	{
+		return 0;
+	}
+
+	if (((long) entry->size != pread(index->fileDescriptor, chunk, entry->size,
+			entry->offset))
+			|| (2 != chunk[RIFF_CHUNK_HEADER_SIZE + INDEX_LONGS_PER_ENTRY_OFFSET])
+			|| (AVI_INDEX_OF_CHUNKS
+					!= chunk[RIFF_CHUNK_HEADER_SIZE + INDEX_TYPE_OFFSET]))
+	{
+		freeMemory(chunk);
+		return 0;
+	}
+
+	entryCount = readRiffLong(chunk + RIFF_CHUNK_HEADER_SIZE + INDEX_ENTRIES_OFFSET);
+	if (entryCount > (long) ((entry->size - STANDARD_HEADER_SIZE) / STANDARD_ENTRY_SIZE))
+	{
+		entryCount = (entry->size - STANDARD_HEADER_SIZE) / STANDARD_ENTRY_SIZE;
+	}
+
+	freeMemory(standard->entries);
+
+	standard->superEntry = superEntry;
+	standard->baseOffset = readRiffLongLong(chunk
+			+ RIFF_CHUNK_HEADER_SIZE + STANDARD_BASE_OFFSET);
+	standard->entries = chunk;
+	standard->entryCount = entryCount;
+	standard->lastUsed = index->useCounter;
+
+	return standard;
+}
+
+bool getOdmlFrame(
+		OdmlIndex* index,
+		long frame,
+		OdmlFrame* location)
+{
+	bool isFound = false;
+	long superEntry;
+	StandardIndex* standard;
+	const unsigned char* entry;
+	unsigned long size;
+
+	if ((0 > frame) || (index->frameCount <= frame))
+	{
+		goto exit;
+	}
+
+	superEntry = findSuperEntry(index, frame);
+
+	standard = loadStandardIndex(index, superEntry);
+	if (0 == standard)
+	{
+		goto exit;
+	}
+
+	frame -= index->superEntries[superEntry].firstFrame;
+	if (standard->entryCount <= frame)
+	{
+		goto exit;
+	}
+
+	entry = standard->entries + STANDARD_HEADER_SIZE + (frame * STANDARD_ENTRY_SIZE);
+	size = readRiffLong(entry + 4);
+
+	location->offset = standard->baseOffset + readRiffLong(entry);
+	location->size = size & ~DELTA_FRAME_FLAG;
+	location->isKeyFrame = (0 == (size & DELTA_FRAME_FLAG));
+	isFound = true;
+
+exit:
+	return isFound;
+}
@@ -0,0 +1,89 @@
+#pragma once
+
+#include <sys/types.h>
+
+#include "Memory.h"
+
+/**
+ * Standard indices kept loaded. Playback walks one at a
+ * time, the second one keeps seeking back and forth across
+ * a boundary from reloading.
+ */
+#define ODML_CACHED_INDICES 2
+
+/**
+ * OpenDML video frame index. Only the super index is read
+ * when the file is opened; the standard index that holds a
+ * frame is loaded when the frame is first looked up. The
+ * memory in use does not depend on the file size.
+ */
+struct OdmlIndex;
+
+/**
+ * Location of a video frame.
+ */
+struct OdmlFrame
+{
+	// Frame data offset in the file, past the chunk header
+	off_t offset;
+
+	// Frame data size in bytes
+	long size;
+
+	bool isKeyFrame;
+};
+
+/**
+ * Checks if the given AVI file has an OpenDML super index
+ * for its video stream. Only the header list is read.
+ *
+ * @param fileName file name.
+ * @return true if the file has an OpenDML index.
+ */
+bool isOdmlFile(
+		const char* fileName);
+
+/**
+ * Opens the OpenDML index of the given AVI file.
+ *
+ * @param fileDescriptor file descriptor, owned by the
+ * caller.
+ * @param account memory account to charge.
+ * @return index, or 0 if there is no OpenDML index or
+ * it cannot be read.
+ */
+OdmlIndex* openOdmlIndex(
+		int fileDescriptor,
+		MemoryAccount* account);
+
+/**
+ * Closes the given index.
+ *
+ * @param index index, may be 0.
+ */
+void closeOdmlIndex(
+		OdmlIndex* index);
+
+/**
+ * Gets the number of video frames in all RIFF segments.
+ *
+ * @param index index.
+ * @return frame count.
+ */
+long getOdmlFrameCount(
+		const OdmlIndex* index);
+
+/**
+ * Looks up the given video frame. The super index entry
+ * is found in constant time, and its standard index is
+ * loaded with one pread unless it is cached.
+ *
+ * @param index index.
+ * @param frame frame number.
+ * @param location frame location. [OUT]
+ * @return true if the frame is found.
+ */
+bool getOdmlFrame(
+		OdmlIndex* index,
+		long frame,
+		OdmlFrame* location);
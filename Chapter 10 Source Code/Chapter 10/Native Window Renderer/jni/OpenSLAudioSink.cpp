@@ -0,0 +1,380 @@
+#include "OpenSLAudioSink.h"
+
+#include <SLES/OpenSLES.h>
+#include <SLES/OpenSLES_Android.h>
+
+#include <stdlib.h>
+
+#define ARRAY_LEN(a) (sizeof(a) / sizeof(a[0]))
+
+/**
+ * OpenSL ES audio sink.
+ */
+struct OpenSLAudioSink
+{
+	AudioSink sink;
+
+	SLObjectItf engineObject;
+	SLEngineItf engineEngine;
+	SLObjectItf outputMixObject;
+	SLObjectItf audioPlayerObject;
+	SLAndroidSimpleBufferQueueItf audioPlayerBufferQueue;
+	SLPlayItf audioPlayerPlay;
+
+	// Buffers and the one that is filled next
+	unsigned char* buffers[OPENSL_BUFFER_COUNT];
+	long bufferSize;
+	int nextBuffer;
+};
+
+/**
+ * Fills the next buffer from the reader and enqueues it.
+ * Nothing is enqueued at the end of the audio, so the
+ * player runs dry and its position stops.
+ */
+static void enqueueBuffer(
+		OpenSLAudioSink* openSL)
+{
+	unsigned char* buffer = openSL->buffers[openSL->nextBuffer];
+
+	long size = openSL->sink.reader(openSL->sink.context,
+			buffer,
+			openSL->bufferSize);
+
+	if (0 < size)
+	{
+		(*openSL->audioPlayerBufferQueue)->Enqueue(
+				openSL->audioPlayerBufferQueue,
+				buffer,
+				size);
+
+		openSL->nextBuffer = (openSL->nextBuffer + 1) % OPENSL_BUFFER_COUNT;
+	}
+}
+
+/**
+ * Gets called when a buffer finishes playing.
+ *
+ * @param audioPlayerBufferQueue audio player buffer queue.
+ * @param context audio sink.
+ */
+static void PlayerCallback(
+		SLAndroidSimpleBufferQueueItf /* audioPlayerBufferQueue */,
+		void* context)
+{
+	enqueueBuffer((OpenSLAudioSink*) context);
+}
+
+static bool startOpenSLSink(
+		AudioSink* sink)
+{
+	OpenSLAudioSink* openSL = (OpenSLAudioSink*) sink;
+
+	// Set audio player state to playing
+	SLresult result = (*openSL->audioPlayerPlay)->SetPlayState(
+			openSL->audioPlayerPlay,
+			SL_PLAYSTATE_PLAYING);
+
+	if (SL_RESULT_SUCCESS != result)
+	{
+		return false;
+	}
+
+	// Fill the queue, the callback keeps it filled
+	for (int i = 0; i < OPENSL_BUFFER_COUNT; i++)
+	{
+		enqueueBuffer(openSL);
+	}
+
+	return true;
+}
+
+static void refillOpenSLSink(
+		AudioSink* sink)
+{
+	OpenSLAudioSink* openSL = (OpenSLAudioSink*) sink;
+	SLAndroidSimpleBufferQueueState state;
+
+	SLresult result = (*openSL->audioPlayerBufferQueue)->GetState(
+			openSL->audioPlayerBufferQueue,
+			&state);
+
+	// Callbacks stop once the queue is empty, fill it again
+	if ((SL_RESULT_SUCCESS == result) && (0 == state.count))
+	{
+		for (int i = 0; i < OPENSL_BUFFER_COUNT; i++)
+		{
+			enqueueBuffer(openSL);
+		}
+	}
+}
+
+static long long getOpenSLPlayedFrames(
+		AudioSink* sink)
+{
+	OpenSLAudioSink* openSL = (OpenSLAudioSink*) sink;
+	SLmillisecond position = 0;
+
+	(*openSL->audioPlayerPlay)->GetPosition(openSL->audioPlayerPlay, &position);
+
+	return ((long long) position * sink->format.rate) / 1000;
+}
+
+/**
+ * Destroys the given object instance.
+ *
+ * @param object object instance. [IN/OUT]
+ */
+static void DestroyObject(
+		SLObjectItf& object)
+{
+	if (0 != object)
+	{
+		(*object)->Destroy(object);
+	}
+
+	object = 0;
+}
+
+static void destroyOpenSLSink(
+		AudioSink* sink)
+{
+	OpenSLAudioSink* openSL = (OpenSLAudioSink*) sink;
+
+	// Player is destroyed first, it stops the callbacks
+	DestroyObject(openSL->audioPlayerObject);
+	DestroyObject(openSL->outputMixObject);
+	DestroyObject(openSL->engineObject);
+
+	for (int i = 0; i < OPENSL_BUFFER_COUNT; i++)
+	{
+		freeMemory(openSL->buffers[i]);
+	}
+
+	free(openSL);
+}
+
+static const AudioSinkOps openSLSinkOps = {
+	startOpenSLSink,
+	refillOpenSLSink,
+	getOpenSLPlayedFrames,
+	destroyOpenSLSink
+};
+
+/**
+ * Creates the engine, the output mix and the buffer queue
+ * audio player of the given sink.
+ */
+static SLresult createPlayer(
+		OpenSLAudioSink* openSL)
+{
+	const AudioSinkFormat& format = openSL->sink.format;
+
+	// OpenSL ES for Android is thread-safe, this is for
+	// portability
+	SLEngineOption engineOptions[] = {
+		{ (SLuint32) SL_ENGINEOPTION_THREADSAFE, (SLuint32) SL_BOOLEAN_TRUE }
+	};
+
+	// Android simple buffer queue locator for the data source
+	SLDataLocator_AndroidSimpleBufferQueue dataSourceLocator = {
+		SL_DATALOCATOR_ANDROIDSIMPLEBUFFERQUEUE, // locator type
+		OPENSL_BUFFER_COUNT                      // buffer count
+	};
+
+	// PCM data source format
+	SLDataFormat_PCM dataSourceFormat = {
+		SL_DATAFORMAT_PCM,                       // format type
+		(SLuint32) format.channels,              // channel count
+		(SLuint32) format.rate * 1000,           // samples per second in millihertz
+		(SLuint32) format.bits,                  // bits per sample
+		(SLuint32) format.bits,                  // container size
+		(SLuint32) ((2 == format.channels)       // channel mask
+				? (SL_SPEAKER_FRONT_LEFT | SL_SPEAKER_FRONT_RIGHT)
+				: SL_SPEAKER_FRONT_CENTER),
+		SL_BYTEORDER_LITTLEENDIAN                // endianness
+	};
+
+	// Data source is a simple buffer queue with PCM format
+	SLDataSource dataSource = {
+		&dataSourceLocator, // data locator
+		&dataSourceFormat   // data format
+	};
+
+	// Output mix locator for data sink
+	SLDataLocator_OutputMix dataSinkLocator = {
+		SL_DATALOCATOR_OUTPUTMIX, // locator type
+		0                         // output mix
+	};
+
+	// Data sink is an output mix
+	SLDataSink dataSink = {
+		&dataSinkLocator, // locator
+		0                 // format
+	};
+
+	// Buffer queue interface is required
+	SLInterfaceID interfaceIds[] = {
+		SL_IID_BUFFERQUEUE
+	};
+
+	SLboolean requiredInterfaces[] = {
+		SL_BOOLEAN_TRUE // for SL_IID_BUFFERQUEUE
+	};
+
+	// Create and realize the engine
+	SLresult result = slCreateEngine(
+			&openSL->engineObject,
+			ARRAY_LEN(engineOptions),
+			engineOptions,
+			0, // no interfaces
+			0, // no interfaces
+			0); // no required
+
+	if (SL_RESULT_SUCCESS != result)
+	{
+		goto exit;
+	}
+
+	result = (*openSL->engineObject)->Realize(openSL->engineObject,
+			SL_BOOLEAN_FALSE);
+
+	if (SL_RESULT_SUCCESS != result)
+	{
+		goto exit;
+	}
+
+	result = (*openSL->engineObject)->GetInterface(openSL->engineObject,
+			SL_IID_ENGINE,
+			&openSL->engineEngine);
+
+	if (SL_RESULT_SUCCESS != result)
+	{
+		goto exit;
+	}
+
+	// Create and realize the output mix
+	result = (*openSL->engineEngine)->CreateOutputMix(openSL->engineEngine,
+			&openSL->outputMixObject,
+			0, // no interfaces
+			0, // no interfaces
+			0); // no required
+
+	if (SL_RESULT_SUCCESS != result)
+	{
+		goto exit;
+	}
+
+	result = (*openSL->outputMixObject)->Realize(openSL->outputMixObject,
+			SL_BOOLEAN_FALSE);
+
+	if (SL_RESULT_SUCCESS != result)
+	{
+		goto exit;
+	}
+
+	// Create and realize the audio player
+	dataSinkLocator.outputMix = openSL->outputMixObject;
+
+	result = (*openSL->engineEngine)->CreateAudioPlayer(openSL->engineEngine,
+			&openSL->audioPlayerObject,
+			&dataSource,
+			&dataSink,
+			ARRAY_LEN(interfaceIds),
+			interfaceIds,
+			requiredInterfaces);
+
+	if (SL_RESULT_SUCCESS != result)
+	{
+		goto exit;
+	}
+
+	result = (*openSL->audioPlayerObject)->Realize(openSL->audioPlayerObject,
+			SL_BOOLEAN_FALSE);
+
+	if (SL_RESULT_SUCCESS != result)
+	{
+		goto exit;
+	}
+
+	// Buffer queue, its callback, and the play interface
+	result = (*openSL->audioPlayerObject)->GetInterface(openSL->audioPlayerObject,
+			SL_IID_BUFFERQUEUE,
+			&openSL->audioPlayerBufferQueue);
+
+	if (SL_RESULT_SUCCESS != result)
+	{
+		goto exit;
+	}
+
+	result = (*openSL->audioPlayerBufferQueue)->RegisterCallback(
+			openSL->audioPlayerBufferQueue,
+			PlayerCallback,
+			openSL);
+
+	if (SL_RESULT_SUCCESS != result)
+	{
+		goto exit;
+	}
+
+	result = (*openSL->audioPlayerObject)->GetInterface(openSL->audioPlayerObject,
+			SL_IID_PLAY,
+			&openSL->audioPlayerPlay);
+
+exit:
+	return result;
+}
+
+AudioSink* createOpenSLAudioSink(
+		const AudioSinkFormat& format,
+		AudioReader reader,
+		void* context,
+		MemoryAccount* account)
+{
+	OpenSLAudioSink* openSL = 0;
+
+	if (((1 != format.channels) && (2 != format.channels))
+			|| ((8 != format.bits) && (16 != format.bits))
+			|| (0 >= format.rate))
+	{
+		goto exit;
+	}
+
+	openSL = (OpenSLAudioSink*) calloc(1, sizeof(OpenSLAudioSink));
+	if (0 == openSL)
+	{
+		goto exit;
+	}
+
+	openSL->sink.ops = &openSLSinkOps;
+	openSL->sink.format = format;
+	openSL->sink.reader = reader;
+	openSL->sink.context = context;
+
+	// Whole frames in each buffer
+	openSL->bufferSize = ((format.rate * OPENSL_BUFFER_DURATION) / 1000)
+			* format.channels * (format.bits / 8);
+
+	// Buffers are charged to the audio budget
+	for (int i = 0; i < OPENSL_BUFFER_COUNT; i++)
+	{
+		openSL->buffers[i] = (unsigned char*) allocateMemory(account,
+				MEMORY_AUDIO, openSL->bufferSize);
+
+		if (0 == openSL->buffers[i])
+		{
+			destroyOpenSLSink(&openSL->sink);
+			openSL = 0;
+			goto exit;
+		}
+	}
+
+	if (SL_RESULT_SUCCESS != createPlayer(openSL))
+	{
+		destroyOpenSLSink(&openSL->sink);
+		openSL = 0;
+	}
+
+exit:
+	return (AudioSink*) openSL;
+}
@@ -0,0 +1,32 @@
+#pragma once
+
+#include "AudioSink.h"
+#include "Memory.h"
+
+/**
+ * Number of buffers in the OpenSL ES buffer queue. One
+ * plays while the other is filled.
+ */
+#define OPENSL_BUFFER_COUNT 2
+
+/**
+ * Duration of each buffer in milliseconds.
+ */
+#define OPENSL_BUFFER_DURATION 40
+
+/**
+ * Creates a new audio sink playing through an OpenSL ES
+ * buffer queue audio player. Buffers are filled from the
+ * reader on the OpenSL ES callback thread.
+ *
+ * @param format PCM format, 8 or 16 bits, mono or stereo.
+ * @param reader PCM data reader.
+ * @param context reader context.
+ * @param account memory account to charge the buffers to.
+ * @return audio sink or 0 on failure.
+ */
+AudioSink* createOpenSLAudioSink(
+		const AudioSinkFormat& format,
+		AudioReader reader,
+		void* context,
+		MemoryAccount* account);
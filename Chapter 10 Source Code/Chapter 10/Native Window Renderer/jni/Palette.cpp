@@ -0,0 +1,104 @@
+#include "Palette.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "Riff.h"
+
+// Bitmap info header fields
+#define BI_SIZE_OFFSET 0
+#define BI_CLR_USED_OFFSET 32
+
+// Color table entries are B, G, R and reserved
+#define RGBQUAD_SIZE 4
+
+bool readPalette(
+		avi_t* avi,
+		Palette* palette)
+{
+	bool isRead = false;
+	unsigned long size = 0;
+	unsigned char* headerList = readRiffHeaderList(avi->fdes, &size);
+
+	unsigned long listSize = 0;
+	const unsigned char* list = 0;
+
+	unsigned long formatSize = 0;
+	const unsigned char* format = 0;
+
+	if (0 == headerList)
+	{
+		goto exit;
+	}
+
+	memset(palette, 0, sizeof(Palette));
+
+	// Format header of the video stream
+	list = findVideoStreamList(headerList, size, &listSize);
+	if (0 != list)
+	{
+		format = findRiffChunk(list, listSize, "strf", &formatSize);
+	}
+
+	if ((0 != format) && (BI_CLR_USED_OFFSET + 4 <= formatSize))
+	{
+		unsigned long headerSize = readRiffLong(format + BI_SIZE_OFFSET);
+		unsigned long colorCount = readRiffLong(format + BI_CLR_USED_OFFSET);
+
+		// Zero means the full palette for 8-bit
+		if ((0 == colorCount) || (PALETTE_SIZE < colorCount))
+		{
+			colorCount = PALETTE_SIZE;
+		}
+
+		if (headerSize > formatSize)
+		{
+			colorCount = 0;
+		}
+		else if (colorCount > (formatSize - headerSize) / RGBQUAD_SIZE)
+		{
+			// Older writers store fewer entries than they claim
+			colorCount = (formatSize - headerSize) / RGBQUAD_SIZE;
+		}
+
+		const unsigned char* colors = format + headerSize;
+		for (unsigned long i = 0; i < colorCount; i++, colors += RGBQUAD_SIZE)
+		{
+			palette->colors[i] = ((colors[2] & 0xF8) << 8)
+					| ((colors[1] & 0xFC) << 3)
+					| (colors[0] >> 3);
+		}
+
+		isRead = (0 < colorCount);
+	}
+
+	free(headerList);
+
+exit:
+	return isRead;
+}
+
+void expandPaletteRow(
+		const unsigned char* source,
+		const Palette& palette,
+		unsigned short* destination,
+		int width)
+{
+	const unsigned short* colors = palette.colors;
+	int x = 0;
+
+	// Table is in L1, a lookup per pixel beats the table
+	// splitting vtbl and pshufb need for 256 entries
+	for (; x + 4 <= width; x += 4)
+	{
+		destination[x] = colors[source[x]];
+		destination[x + 1] = colors[source[x + 1]];
+		destination[x + 2] = colors[source[x + 2]];
+		destination[x + 3] = colors[source[x + 3]];
+	}
+
+	for (; x < width; x++)
+	{
+		destination[x] = colors[source[x]];
+	}
+}
@@ -0,0 +1,44 @@
+#pragma once
+
+extern "C" {
+#include <avilib.h>
+}
+
+// Entries of an 8-bit palette
+#define PALETTE_SIZE 256
+
+/**
+ * 8-bit palette, with the colors already reduced to
+ * RGB565. Unused entries are black.
+ */
+struct Palette
+{
+	unsigned short colors[PALETTE_SIZE];
+};
+
+/**
+ * Reads the palette of the video stream. avilib keeps only
+ * the bitmap info header, so the color table following it
+ * in the stream format header is read from the file.
+ *
+ * @param avi AVI file.
+ * @param palette palette. [OUT]
+ * @return true if the palette is read.
+ */
+bool readPalette(
+		avi_t* avi,
+		Palette* palette);
+
+/**
+ * Expands a row of 8-bit palette indices to RGB565.
+ *
+ * @param source palette indices.
+ * @param palette palette.
+ * @param destination RGB565 pixels.
+ * @param width row width in pixels.
+ */
+void expandPaletteRow(
+		const unsigned char* source,
+		const Palette& palette,
+		unsigned short* destination,
+		int width);
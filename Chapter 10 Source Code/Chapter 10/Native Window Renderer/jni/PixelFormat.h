@@ -0,0 +1,155 @@
+#pragma once
+
+/**
+ * Pixel formats supported by the filters. The values
+ * match the Android bitmap format constants where one
+ * exists.
+ */
+enum PixelFormat
+{
+	PIXEL_FORMAT_RGBA_8888 = 1,
+	PIXEL_FORMAT_RGB_888 = 3,
+	PIXEL_FORMAT_RGB_565 = 4
+};
+
+/**
+ * RGB565 pixel format traits. 16-bits with 5-bits red,
+ * 6-bits green, and 5-bits blue. Components are unpacked
+ * to the 8-bit range with the low bits cleared.
+ */
+struct Rgb565Format
+{
+	static const PixelFormat FORMAT = PIXEL_FORMAT_RGB_565;
+	static const int BYTES_PER_PIXEL = 2;
+
+	static const unsigned int MAX_R = 0xF8;
+	static const unsigned int MAX_G = 0xFC;
+	static const unsigned int MAX_B = 0xF8;
+
+	static inline void unpack(
+			const unsigned char* pixel,
+			unsigned int& r,
+			unsigned int& g,
+			unsigned int& b)
+	{
+		unsigned int rgb = *((const unsigned short*) pixel);
+
+		r = (rgb >> 8) & MAX_R;
+		g = (rgb >> 3) & MAX_G;
+		b = (rgb << 3) & MAX_B;
+	}
+
+	static inline void pack(
+			unsigned char* pixel,
+			unsigned int r,
+			unsigned int g,
+			unsigned int b)
+	{
+		*((unsigned short*) pixel) = ((r & MAX_R) << 8)
+				| ((g & MAX_G) << 3)
+				| ((b & MAX_B) >> 3);
+	}
+};
+
+/**
+ * RGBA8888 pixel format traits. One byte per component
+ * in R, G, B, A memory order. Alpha is left untouched.
+ */
+struct Rgba8888Format
+{
+	static const PixelFormat FORMAT = PIXEL_FORMAT_RGBA_8888;
+	static const int BYTES_PER_PIXEL = 4;
+
+	static const unsigned int MAX_R = 0xFF;
+	static const unsigned int MAX_G = 0xFF;
+	static const unsigned int MAX_B = 0xFF;
+
+	static inline void unpack(
+			const unsigned char* pixel,
+			unsigned int& r,
+			unsigned int& g,
+			unsigned int& b)
+	{
+		// Single word access, Android is little endian
+		unsigned int rgba = *((const unsigned int*) pixel);
+
+		r = rgba & 0xFF;
+		g = (rgba >> 8) & 0xFF;
+		b = (rgba >> 16) & 0xFF;
+	}
+
+	static inline void pack(
+			unsigned char* pixel,
+			unsigned int r,
+			unsigned int g,
+			unsigned int b)
+	{
+		unsigned int* rgba = (unsigned int*) pixel;
+
+		*rgba = (*rgba & 0xFF000000) | r | (g << 8) | (b << 16);
+	}
+};
+
+/**
+ * RGB888 pixel format traits. One byte per component
+ * in R, G, B memory order.
+ */
+struct Rgb888Format
+{
+	static const PixelFormat FORMAT = PIXEL_FORMAT_RGB_888;
+	static const int BYTES_PER_PIXEL = 3;
+
+	static const unsigned int MAX_R = 0xFF;
+	static const unsigned int MAX_G = 0xFF;
+	static const unsigned int MAX_B = 0xFF;
+
+	static inline void unpack(
+			const unsigned char* pixel,
+			unsigned int& r,
+			unsigned int& g,
+			unsigned int& b)
+	{
+		r = pixel[0];
+		g = pixel[1];
+		b = pixel[2];
+	}
+
+	static inline void pack(
+			unsigned char* pixel,
+			unsigned int r,
+			unsigned int g,
+			unsigned int b)
+	{
+		pixel[0] = r;
+		pixel[1] = g;
+		pixel[2] = b;
+	}
+};
+
+/**
+ * Gets the number of bytes per pixel for the given format.
+ *
+ * @param format pixel format.
+ * @return bytes per pixel, or 0 if format is unknown.
+ */
+inline int getBytesPerPixel(int format)
+{
+	int bytesPerPixel = 0;
+
+	switch (format)
+	{
+	case PIXEL_FORMAT_RGB_565:
+		bytesPerPixel = Rgb565Format::BYTES_PER_PIXEL;
+		break;
+
+	case PIXEL_FORMAT_RGBA_8888:
+		bytesPerPixel = Rgba8888Format::BYTES_PER_PIXEL;
+		break;
+
+	case PIXEL_FORMAT_RGB_888:
+		bytesPerPixel = Rgb888Format::BYTES_PER_PIXEL;
+		break;
+	}
+
+	return bytesPerPixel;
+}
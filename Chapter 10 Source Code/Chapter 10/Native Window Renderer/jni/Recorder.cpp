@@ -0,0 +1,318 @@
+extern "C" {
+#include <avilib.h>
+}
+
+#include "Recorder.h"
+
+#include <pthread.h>
+#include <semaphore.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "PixelFormat.h"
+
+// Index entries are the chunk id, flags, offset and size
+#define INDEX_ENTRY_SIZE 16
+
+struct Recorder
+{
+	avi_t* avi;
+	int width;
+	int height;
+
+	// Queue slots, written at the tail by the render thread
+	// and read at the head by the writer thread
+	unsigned short* slots[RECORDER_QUEUE_SIZE];
+	volatile unsigned int head;
+	volatile unsigned int tail;
+
+	// Frame converted for writing
+	unsigned char* frame;
+	long frameSize;
+	long rowSize;
+
+	// Posted for each queued frame and on close
+	sem_t queued;
+	pthread_t writer;
+	volatile bool isStopping;
+	volatile bool isFailed;
+
+	volatile long long writtenFrames;
+	volatile long long droppedFrames;
+	volatile unsigned int highWaterMark;
+};
+
+/**
+ * Converts the given RGB565 frame into bottom-up BGR24
+ * rows padded to 4 bytes, the way uncompressed DIB frames
+ * are stored.
+ *
+ * @param recorder recorder.
+ * @param pixels RGB565 pixels.
+ */
+static void convertFrame(
+		Recorder* recorder,
+		const unsigned short* pixels)
+{
+	for (int y = 0; y < recorder->height; y++)
+	{
+		const unsigned short* source = pixels + (y * recorder->width);
+		unsigned char* destination = recorder->frame
+				+ ((recorder->height - 1 - y) * recorder->rowSize);
+
+		for (int x = 0; x < recorder->width; x++)
+		{
+			unsigned int pixel = source[x];
+			unsigned int r = (pixel >> 11) & 0x1f;
+			unsigned int g = (pixel >> 5) & 0x3f;
+			unsigned int b = pixel & 0x1f;
+
+			// Low bits are filled from the high ones
+			*destination++ = (b << 3) | (b >> 2);
+			*destination++ = (g << 2) | (g >> 4);
+			*destination++ = (r << 3) | (r >> 2);
+		}
+	}
+}
+
+/**
+ * Writer thread. Writes the queued frames in batches,
+ * everything that is queued when it wakes up.
+ *
+ * @param data recorder.
+ * @return 0.
+ */
+static void* writeFrames(
+		void* data)
+{
+	Recorder* recorder = (Recorder*) data;
+
+	while (true)
+	{
+		sem_wait(&recorder->queued);
+
+		// Slots up to the tail are filled
+		unsigned int tail = recorder->tail;
+		__sync_synchronize();
+
+		// Frames queued before the stop are written out too
+		if ((recorder->head == tail) && recorder->isStopping)
+		{
+			break;
+		}
+
+		while (recorder->head != tail)
+		{
+			convertFrame(recorder,
+					recorder->slots[recorder->head % RECORDER_QUEUE_SIZE]);
+
+			// Slot is done with before it is handed back
+			__sync_fetch_and_add(&recorder->head, 1);
+
+			if (!recorder->isFailed)
+			{
+				if (0 == AVI_write_frame(recorder->avi,
+						(char*) recorder->frame,
+						recorder->frameSize,
+						1))
+				{
+					recorder->writtenFrames++;
+				}
+				else
+				{
+					recorder->isFailed = true;
+				}
+			}
+		}
+	}
+
+	return 0;
+}
+
+/**
+ * Reserves index space for the given number of frames, so
+ * avilib does not grow the index while writing.
+ *
+ * @param avi AVI file opened for output.
+ * @param frameCount number of frames.
+ */
+static void reserveIndex(
+		avi_t* avi,
+		long frameCount)
+{
+	if ((0 == avi->idx) && (0 < frameCount))
+	{
+		// avilib frees the index when the file is closed
+		avi->idx = (unsigned char (*)[INDEX_ENTRY_SIZE]) malloc(
+				frameCount * INDEX_ENTRY_SIZE);
+
+		if (0 != avi->idx)
+		{
+			avi->max_idx = frameCount;
+		}
+	}
+}
+
+/**
+ * Frees the given recorder, after its writer thread ends.
+ *
+ * @param recorder recorder.
+ */
+static void destroyRecorder(
+		Recorder* recorder)
+{
+	for (int i = 0; i < RECORDER_QUEUE_SIZE; i++)
+	{
+		freeMemory(recorder->slots[i]);
+	}
+
+	freeMemory(recorder->frame);
+	sem_destroy(&recorder->queued);
+
+	free(recorder);
+}
+
+Recorder* createRecorder(
+		const char* fileName,
+		int width,
+		int height,
+		double frameRate,
+		long expectedFrames,
+		MemoryAccount* account)
+{
+	Recorder* recorder = (Recorder*) calloc(1, sizeof(Recorder));
+	if (0 == recorder)
+	{
+		goto exit;
+	}
+
+	recorder->width = width;
+	recorder->height = height;
+	recorder->rowSize = ((width * 3) + 3) & ~3;
+	recorder->frameSize = recorder->rowSize * height;
+	sem_init(&recorder->queued, 0, 0);
+
+	// Queue is allocated up front, nothing is allocated per frame
+	for (int i = 0; i < RECORDER_QUEUE_SIZE; i++)
+	{
+		recorder->slots[i] = (unsigned short*) allocateMemory(account,
+				MEMORY_FRAMES,
+				width * height * Rgb565Format::BYTES_PER_PIXEL);
+
+		if (0 == recorder->slots[i])
+		{
+			goto fail;
+		}
+	}
+
+	recorder->frame = (unsigned char*) allocateMemory(account,
+			MEMORY_FRAMES,
+			recorder->frameSize);
+	if (0 == recorder->frame)
+	{
+		goto fail;
+	}
+
+	recorder->avi = AVI_open_output_file((char*) fileName);
+	if (0 == recorder->avi)
+	{
+		goto fail;
+	}
+
+	// Uncompressed DIB frames have no compressor
+	AVI_set_video(recorder->avi, width, height, frameRate, (char*) "\0\0\0\0");
+	reserveIndex(recorder->avi, expectedFrames);
+
+	if (0 != pthread_create(&recorder->writer, 0, writeFrames, recorder))
+	{
+		goto fail;
+	}
+
+	goto exit;
+
+fail:
+	if (0 != recorder->avi)
+	{
+		AVI_close(recorder->avi);
+	}
+
+	destroyRecorder(recorder);
+	recorder = 0;
+
+exit:
+	return recorder;
+}
+
+bool recordFrame(
+		Recorder* recorder,
+		const void* pixels,
+		int width,
+		int height,
+		long stride)
+{
+	bool isQueued = false;
+	unsigned int tail = recorder->tail;
+	unsigned int queuedFrames = tail - recorder->head;
+
+	// Full queue drops the frame instead of waiting
+	if ((RECORDER_QUEUE_SIZE <= queuedFrames)
+			|| (recorder->width != width)
+			|| (recorder->height != height))
+	{
+		recorder->droppedFrames++;
+		goto exit;
+	}
+
+	{
+		unsigned short* slot = recorder->slots[tail % RECORDER_QUEUE_SIZE];
+		long rowSize = recorder->width * Rgb565Format::BYTES_PER_PIXEL;
+
+		for (int y = 0; y < recorder->height; y++)
+		{
+			memcpy((char*) slot + (y * rowSize),
+					(const char*) pixels + (y * stride),
+					rowSize);
+		}
+	}
+
+	// Slot is filled before it is handed over
+	__sync_fetch_and_add(&recorder->tail, 1);
+
+	if (queuedFrames + 1 > recorder->highWaterMark)
+	{
+		recorder->highWaterMark = queuedFrames + 1;
+	}
+
+	sem_post(&recorder->queued);
+	isQueued = true;
+
+exit:
+	return isQueued;
+}
+
+void getRecorderStats(
+		const Recorder* recorder,
+		long long* values)
+{
+	values[RECORDER_QUEUED_FRAMES] = recorder->tail - recorder->head;
+	values[RECORDER_WRITTEN_FRAMES] = recorder->writtenFrames;
+	values[RECORDER_DROPPED_FRAMES] = recorder->droppedFrames;
+	values[RECORDER_HIGH_WATER_MARK] = recorder->highWaterMark;
+}
+
+bool closeRecorder(
+		Recorder* recorder)
+{
+	// Writer drains the queue and ends
+	recorder->isStopping = true;
+	sem_post(&recorder->queued);
+	pthread_join(recorder->writer, 0);
+
+	// Index and headers are written on close
+	bool isWritten = !recorder->isFailed
+			&& (0 == AVI_close(recorder->avi));
+
+	destroyRecorder(recorder);
+
+	return isWritten;
+}
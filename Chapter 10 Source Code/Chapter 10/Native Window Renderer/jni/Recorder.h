@@ -0,0 +1,94 @@
+#pragma once
+
+#include "Memory.h"
+
+/**
+ * Number of frames the recorder queue holds. Frames that
+ * come in while it is full are dropped, so the render
+ * thread never waits on the disk.
+ */
+#define RECORDER_QUEUE_SIZE 8
+
+/**
+ * Recorder statistics. The values are shared with the
+ * AbstractPlayerActivity constants.
+ */
+enum RecorderStat
+{
+	RECORDER_QUEUED_FRAMES = 0,
+	RECORDER_WRITTEN_FRAMES = 1,
+	RECORDER_DROPPED_FRAMES = 2,
+	RECORDER_HIGH_WATER_MARK = 3,
+	RECORDER_STATS = 4
+};
+
+/**
+ * AVI recorder. RGB565 frames are copied into a single
+ * producer, single consumer queue, and a writer thread
+ * writes them out through avilib as bottom-up BGR24
+ * frames.
+ */
+struct Recorder;
+
+/**
+ * Creates a new recorder writing to the given AVI file,
+ * and starts its writer thread.
+ *
+ * @param fileName AVI file name.
+ * @param width frame width in pixels.
+ * @param height frame height in pixels.
+ * @param frameRate frame rate.
+ * @param expectedFrames number of frames to reserve index
+ * space for.
+ * @param account memory account to charge the queue to.
+ * @return recorder or 0 on failure.
+ */
+Recorder* createRecorder(
+		const char* fileName,
+		int width,
+		int height,
+		double frameRate,
+		long expectedFrames,
+		MemoryAccount* account);
+
+/**
+ * Queues the given RGB565 frame. Only copies the frame
+ * and wakes up the writer thread, never waits for it.
+ * Frames of another size than the recording are dropped.
+ *
+ * @param recorder recorder.
+ * @param pixels frame pixels.
+ * @param width frame width in pixels.
+ * @param height frame height in pixels.
+ * @param stride frame row stride in bytes.
+ * @return true if queued, false if the frame is dropped.
+ */
+bool recordFrame(
+		Recorder* recorder,
+		const void* pixels,
+		int width,
+		int height,
+		long stride);
+
+/**
+ * Gets the statistics of the given recorder. The high
+ * water mark is the largest number of frames that were
+ * waiting in the queue.
+ *
+ * @param recorder recorder.
+ * @param values RECORDER_STATS values. [OUT]
+ */
+void getRecorderStats(
+		const Recorder* recorder,
+		long long* values);
+
+/**
+ * Writes out the queued frames, finishes the AVI file
+ * and destroys the given recorder.
+ *
+ * @param recorder recorder.
+ * @return true if all written frames made it to the
+ * file, false otherwise.
+ */
+bool closeRecorder(
+		Recorder* recorder);
@@ -0,0 +1,122 @@
+#include "Riff.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+// Header list size limit, hdrl is a few kilobytes
+#define MAX_HEADER_LIST_SIZE (1024 * 1024)
+
+const unsigned char* findRiffChunk(
+		const unsigned char* data,
+		unsigned long size,
+		const char* fourcc,
+		unsigned long* chunkSize)
+{
+	unsigned long offset = 0;
+
+	while (offset + RIFF_CHUNK_HEADER_SIZE <= size)
+	{
+		const unsigned char* chunk = data + offset + RIFF_CHUNK_HEADER_SIZE;
+		unsigned long length = readRiffLong(data + offset + 4);
+
+		if (length > size - offset - RIFF_CHUNK_HEADER_SIZE)
+		{
+			break;
+		}
+
+		if (0 == memcmp(data + offset, fourcc, 4))
+		{
+			*chunkSize = length;
+			return chunk;
+		}
+
+		if ((0 == memcmp(data + offset, "LIST", 4))
+				&& (4 <= length)
+				&& (0 == memcmp(chunk, fourcc, 4)))
+		{
+			*chunkSize = length - 4;
+			return chunk + 4;
+		}
+
+		// Chunks are padded to even sizes
+		offset += RIFF_CHUNK_HEADER_SIZE + length + (length & 1);
+	}
+
+	return 0;
+}
+
+unsigned char* readRiffHeaderList(
+		int fileDescriptor,
+		unsigned long* size)
+{
+	unsigned char* headerList = 0;
+	unsigned char header[24];
+
+	// RIFF AVI header followed by the hdrl list header
+	if ((sizeof(header) != pread(fileDescriptor, header, sizeof(header), 0))
+			|| (0 != memcmp(header, "RIFF", 4))
+			|| (0 != memcmp(header + 8, "AVI ", 4))
+			|| (0 != memcmp(header + 12, "LIST", 4))
+			|| (0 != memcmp(header + 20, "hdrl", 4)))
+	{
+		goto exit;
+	}
+
+	*size = readRiffLong(header + 16) - 4;
+	if (MAX_HEADER_LIST_SIZE < *size)
+	{
+		goto exit;
+	}
+
+	headerList = (unsigned char*) malloc(*size);
+	if (0 == headerList)
+	{
+		goto exit;
+	}
+
+	if ((long) *size != pread(fileDescriptor, headerList, *size, sizeof(header)))
+	{
+		free(headerList);
+		headerList = 0;
+	}
+
+exit:
+	return headerList;
+}
+
+const unsigned char* findVideoStreamList(
+		const unsigned char* headerList,
+		unsigned long size,
+		unsigned long* listSize)
+{
+	const unsigned char* streamList = headerList;
+
+	while (0 != streamList)
+	{
+		const unsigned char* list = findRiffChunk(streamList, size,
+				"strl", listSize);
+
+		if (0 == list)
+		{
+			break;
+		}
+
+		unsigned long streamHeaderSize = 0;
+		const unsigned char* streamHeader = findRiffChunk(list, *listSize,
+				"strh", &streamHeaderSize);
+
+		if ((0 != streamHeader)
+				&& (4 <= streamHeaderSize)
+				&& (0 == memcmp(streamHeader, "vids", 4)))
+		{
+			return list;
+		}
+
+		// Next stream list
+		size -= (list + *listSize) - streamList;
+		streamList = list + *listSize;
+	}
+
+	return 0;
+}
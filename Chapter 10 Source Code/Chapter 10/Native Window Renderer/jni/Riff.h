@@ -0,0 +1,91 @@
+#pragma once
+
+// RIFF chunk header size
+#define RIFF_CHUNK_HEADER_SIZE 8
+
+// Key frame flag of the index entries
+#define AVIIF_KEYFRAME 0x10
+
+/**
+ * Reads a little endian 32-bit value.
+ *
+ * @param data value bytes.
+ * @return value.
+ */
+inline unsigned long readRiffLong(
+		const unsigned char* data)
+{
+	return data[0]
+			| (data[1] << 8)
+			| (data[2] << 16)
+			| ((unsigned long) data[3] << 24);
+}
+
+/**
+ * Writes a little endian 32-bit value.
+ *
+ * @param data value bytes. [OUT]
+ * @param value value.
+ */
+inline void writeRiffLong(
+		unsigned char* data,
+		unsigned long value)
+{
+	data[0] = value;
+	data[1] = value >> 8;
+	data[2] = value >> 16;
+	data[3] = value >> 24;
+}
+
+/**
+ * Reads a little endian 16-bit value.
+ *
+ * @param data value bytes.
+ * @return value.
+ */
+inline unsigned int readRiffShort(
+		const unsigned char* data)
+{
+	return data[0] | (data[1] << 8);
+}
+
+/**
+ * Finds the chunk or the list with the given FOURCC in the
+ * given range. Lists match on their list type.
+ *
+ * @param data range start.
+ * @param size range size in bytes.
+ * @param fourcc chunk FOURCC or list type.
+ * @param chunkSize chunk data size, without the list type. [OUT]
+ * @return chunk data, or 0 if not found.
+ */
+const unsigned char* findRiffChunk(
+		const unsigned char* data,
+		unsigned long size,
+		const char* fourcc,
+		unsigned long* chunkSize);
+
+/**
+ * Reads the hdrl list of the AVI file with one pread.
+ *
+ * @param fileDescriptor file descriptor.
+ * @param size header list size. [OUT]
+ * @return header list, to be freed, or 0 on failure.
+ */
+unsigned char* readRiffHeaderList(
+		int fileDescriptor,
+		unsigned long* size);
+
+/**
+ * Finds the stream list of the first video stream in the
+ * header list.
+ *
+ * @param headerList header list.
+ * @param size header list size in bytes.
+ * @param listSize stream list size. [OUT]
+ * @return stream list, or 0 if not found.
+ */
+const unsigned char* findVideoStreamList(
+		const unsigned char* headerList,
+		unsigned long size,
+		unsigned long* listSize);
@@ -0,0 +1,193 @@
+#include "Scaler.h"
+
+#include <stdlib.h>
+
+// Weights are in 1/256 steps
+#define WEIGHT_BITS 8
+#define WEIGHT_ONE (1 << WEIGHT_BITS)
+
+/**
+ * Source position of a destination column or row, the
+ * first of the two source pixels and the weight of the
+ * second one.
+ */
+struct ScalerTap
+{
+	int first;
+	int weight;
+};
+
+struct Scaler
+{
+	int sourceWidth;
+	int sourceHeight;
+	int width;
+	int height;
+
+	ScalerTap* columns;
+	ScalerTap* rows;
+};
+
+/**
+ * Fills the taps of the given axis. Pixel centers are
+ * lined up, so the edges are not shifted.
+ *
+ * @param taps taps to fill. [OUT]
+ * @param sourceSize source size in pixels.
+ * @param size destination size in pixels.
+ */
+static void fillTaps(
+		ScalerTap* taps,
+		int sourceSize,
+		int size)
+{
+	for (int i = 0; i < size; i++)
+	{
+		// Center of the destination pixel on the source, in weight steps
+		long long position = ((((long long) i * 2 + 1) * sourceSize * WEIGHT_ONE)
+				/ (size * 2)) - (WEIGHT_ONE / 2);
+
+		if (0 > position)
+		{
+			position = 0;
+		}
+
+		taps[i].first = (int) (position >> WEIGHT_BITS);
+		taps[i].weight = (int) (position & (WEIGHT_ONE - 1));
+
+		// Last pixel blends with itself
+		if (taps[i].first >= sourceSize - 1)
+		{
+			taps[i].first = sourceSize - 1;
+			taps[i].weight = 0;
+		}
+	}
+}
+
+Scaler* createScaler(
+		int sourceWidth,
+		int sourceHeight,
+		int width,
+		int height)
+{
+	Scaler* scaler = 0;
+
+	if ((0 >= sourceWidth) || (0 >= sourceHeight)
+			|| (0 >= width) || (0 >= height))
+	{
+		goto exit;
+	}
+
+	scaler = (Scaler*) calloc(1, sizeof(Scaler));
+	if (0 == scaler)
+	{
+		goto exit;
+	}
+
+	scaler->sourceWidth = sourceWidth;
+	scaler->sourceHeight = sourceHeight;
+	scaler->width = width;
+	scaler->height = height;
+
+	scaler->columns = (ScalerTap*) malloc(width * sizeof(ScalerTap));
+	scaler->rows = (ScalerTap*) malloc(height * sizeof(ScalerTap));
+	if ((0 == scaler->columns) || (0 == scaler->rows))
+	{
+		destroyScaler(scaler);
+		scaler = 0;
+		goto exit;
+	}
+
+	fillTaps(scaler->columns, sourceWidth, width);
+	fillTaps(scaler->rows, sourceHeight, height);
+
+exit:
+	return scaler;
+}
+
+void destroyScaler(
+		Scaler* scaler)
+{
+	if (0 == scaler)
+	{
+		return;
+	}
+
+	free(scaler->columns);
+	free(scaler->rows);
+	free(scaler);
+}
+
+/**
+ * Blends two RGB565 pixels channel by channel.
+ *
+ * @param a first pixel.
+ * @param b second pixel.
+ * @param weight weight of the second pixel.
+ * @param red red channel, 5 bits plus the weight bits. [OUT]
+ * @param green green channel, 6 bits plus the weight bits. [OUT]
+ * @param blue blue channel, 5 bits plus the weight bits. [OUT]
+ */
+static inline void blendPixels(
+		unsigned int a,
+		unsigned int b,
+		int weight,
+		int* red,
+		int* green,
+		int* blue)
+{
+	int inverse = WEIGHT_ONE - weight;
+
+	*red = (((a >> 11) & 0x1f) * inverse) + (((b >> 11) & 0x1f) * weight);
+	*green = (((a >> 5) & 0x3f) * inverse) + (((b >> 5) & 0x3f) * weight);
+	*blue = ((a & 0x1f) * inverse) + ((b & 0x1f) * weight);
+}
+
+void scaleFrame(
+		const Scaler* scaler,
+		const void* source,
+		long sourceStride,
+		void* destination,
+		long stride)
+{
+	for (int y = 0; y < scaler->height; y++)
+	{
+		const ScalerTap& row = scaler->rows[y];
+		const unsigned short* top = (const unsigned short*)
+				((const char*) source + (row.first * sourceStride));
+		const unsigned short* bottom = (row.first + 1 < scaler->sourceHeight)
+				? (const unsigned short*) ((const char*) top + sourceStride)
+				: top;
+		unsigned short* pixels = (unsigned short*)
+				((char*) destination + (y * stride));
+
+		int inverse = WEIGHT_ONE - row.weight;
+
+		for (int x = 0; x < scaler->width; x++)
+		{
+			const ScalerTap& column = scaler->columns[x];
+			int next = (column.first + 1 < scaler->sourceWidth)
+					? column.first + 1
+					: column.first;
+
+			int topRed, topGreen, topBlue;
+			int bottomRed, bottomGreen, bottomBlue;
+
+			// Horizontal pass on both rows, then the vertical one
+			blendPixels(top[column.first], top[next], column.weight,
+					&topRed, &topGreen, &topBlue);
+			blendPixels(bottom[column.first], bottom[next], column.weight,
+					&bottomRed, &bottomGreen, &bottomBlue);
+
+			// Rounded back to the channel size
+			int red = ((topRed * inverse) + (bottomRed * row.weight)
+					+ (1 << (2 * WEIGHT_BITS - 1))) >> (2 * WEIGHT_BITS);
+			int green = ((topGreen * inverse) + (bottomGreen * row.weight)
+					+ (1 << (2 * WEIGHT_BITS - 1))) >> (2 * WEIGHT_BITS);
+			int blue = ((topBlue * inverse) + (bottomBlue * row.weight)
+					+ (1 << (2 * WEIGHT_BITS - 1))) >> (2 * WEIGHT_BITS);
+
+			pixels[x] = (red << 11) | (green << 5) | blue;
+		}
+	}
+}
@@ -0,0 +1,51 @@
+#pragma once
+
+/**
+ * Bilinear RGB565 scaler. Holds the source columns and
+ * weights of each destination column and row, so that
+ * frames are scaled without any divisions. The scaler is
+ * not changed while scaling, one can be shared by several
+ * threads.
+ */
+struct Scaler;
+
+/**
+ * Creates a new scaler between the given frame sizes.
+ *
+ * @param sourceWidth source width in pixels.
+ * @param sourceHeight source height in pixels.
+ * @param width destination width in pixels.
+ * @param height destination height in pixels.
+ * @return scaler or 0 on failure.
+ */
+Scaler* createScaler(
+		int sourceWidth,
+		int sourceHeight,
+		int width,
+		int height);
+
+/**
+ * Destroys the given scaler.
+ *
+ * @param scaler scaler.
+ */
+void destroyScaler(
+		Scaler* scaler);
+
+/**
+ * Scales the given RGB565 frame. Each destination pixel
+ * is blended from the four source pixels around it, with
+ * the channels unpacked.
+ *
+ * @param scaler scaler.
+ * @param source source pixels.
+ * @param sourceStride source row stride in bytes.
+ * @param destination destination pixels.
+ * @param stride destination row stride in bytes.
+ */
+void scaleFrame(
+		const Scaler* scaler,
+		const void* source,
+		long sourceStride,
+		void* destination,
+		long stride);
@@ -0,0 +1,603 @@
+#include "Session.h"
+
+#include <fcntl.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "BrightnessFilter.h"
+#include "FramePool.h"
+#include "PixelFormat.h"
+#include "Riff.h"
+
+bool setSessionTransform(
+		Session* session,
+		int transform)
+{
+	bool isSet = false;
+
+	if (!isValidTransform(transform))
+	{
+		goto exit;
+	}
+
+	// Frames are read into the pixels directly without a transform
+	if ((FRAME_TRANSFORM_NONE != transform)
+			&& (0 == session->transformBuffer))
+	{
+		session->transformBuffer = (char*) acquireFrameBuffer(
+				&session->memory,
+				AVI_video_width(session->avi)
+				* AVI_video_height(session->avi)
+				* Rgb565Format::BYTES_PER_PIXEL);
+
+		if (0 == session->transformBuffer)
+		{
+			goto exit;
+		}
+	}
+
+	session->transform = transform;
+	isSet = true;
+
+exit:
+	return isSet;
+}
+
+long getSessionFrameCount(
+		const Session* session)
+{
+	return (0 != session->odmlIndex)
+			? getOdmlFrameCount(session->odmlIndex)
+			: AVI_video_frames(session->avi);
+}
+
+bool seekSession(
+		Session* session,
+		long frame)
+{
+	bool isSet = false;
+
+	if ((0 <= frame) && (getSessionFrameCount(session) > frame))
+	{
+		// Frames are located on read, nothing else to do
+		session->avi->video_pos = frame;
+		session->shownFrame = -1;
+		session->readAheadFrame = -1;
+
+		if (0 != session->audioSink)
+		{
+			const AudioSinkFormat& format = session->audioSink->format;
+			long frameSize = format.channels * (format.bits / 8);
+			double time = frame / AVI_frame_rate(session->avi);
+
+			// Audio of the frame time, on a PCM frame boundary
+			pthread_mutex_lock(&session->audioMutex);
+			AVI_set_audio_position(session->avi,
+					(long) (time * format.rate) * frameSize);
+			session->isAudioEnded = false;
+			pthread_mutex_unlock(&session->audioMutex);
+
+			// Sink ran dry if the audio had ended before
+			if (session->isAudioStarted)
+			{
+				refillAudioSink(session->audioSink);
+			}
+
+			// Frame is due at the current audio position
+			session->avSync.clockOffset = (session->isAudioStarted
+					? getAudioSinkPosition(session->audioSink)
+					: 0)
+					- (long long) (time * 1000000);
+		}
+
+		isSet = true;
+	}
+
+	return isSet;
+}
+
+/**
+ * Locates the given frame in the OpenDML index, or in the
+ * avilib index for the other files.
+ *
+ * @param session player session.
+ * @param frame frame number.
+ * @param location frame data offset, size and key frame
+ * flag. [OUT]
+ * @return true if the frame is found.
+ */
+static bool getSessionFrame(
+		Session* session,
+		long frame,
+		OdmlFrame* location)
+{
+	bool isFound = false;
+
+	if (0 != session->odmlIndex)
+	{
+		isFound = getOdmlFrame(session->odmlIndex, frame, location);
+	}
+	else if ((0 != session->avi->video_index)
+			&& (0 <= frame)
+			&& (session->avi->video_frames > frame))
+	{
+		location->offset = session->avi->video_index[frame].pos;
+		location->size = session->avi->video_index[frame].len;
+		location->isKeyFrame = (0 != (session->avi->video_index[frame].key
+				& AVIIF_KEYFRAME));
+		isFound = true;
+	}
+
+	return isFound;
+}
+
+/**
+ * Gets the frame shown after the given one at the playback
+ * rate. Key frames are looked for starting at the target
+ * frame; if none is near, the target frame is shown.
+ *
+ * @param session player session.
+ * @param frame shown frame number.
+ * @return next frame number, or the frame count past
+ * either end.
+ */
+static long getNextSessionFrame(
+		Session* session,
+		long frame)
+{
+	long frameCount = getSessionFrameCount(session);
+	int rate = session->playbackRate;
+	long next = frame + rate;
+
+	if (((TRICK_PLAY_KEY_FRAME_RATE <= rate)
+			|| (-TRICK_PLAY_KEY_FRAME_RATE >= rate))
+			&& (0 <= next)
+			&& (frameCount > next))
+	{
+		int direction = (0 < rate) ? 1 : -1;
+		OdmlFrame location;
+
+		// Index is searched, not the frames
+		for (long i = next, distance = 0;
+				(0 <= i)
+						&& (frameCount > i)
+						&& (TRICK_PLAY_KEY_FRAME_DISTANCE > distance);
+				i += direction, distance++)
+		{
+			if (getSessionFrame(session, i, &location)
+					&& location.isKeyFrame)
+			{
+				next = i;
+				break;
+			}
+		}
+	}
+
+	return ((0 <= next) && (frameCount > next)) ? next : frameCount;
+}
+
+bool setSessionPlaybackRate(
+		Session* session,
+		int rate)
+{
+	bool isSet = false;
+
+	if ((0 != rate)
+			&& (TRICK_PLAY_MAX_RATE >= rate)
+			&& (-TRICK_PLAY_MAX_RATE <= rate))
+	{
+		session->playbackRate = rate;
+		session->readAheadFrame = -1;
+
+		// Next frame is stepped from the shown one
+		if (0 <= session->shownFrame)
+		{
+			session->avi->video_pos = getNextSessionFrame(session,
+					session->shownFrame);
+		}
+
+		// Audio picks up at the frame it is back at
+		if ((1 == rate)
+				&& (getSessionFrameCount(session) > session->avi->video_pos))
+		{
+			seekSession(session, session->avi->video_pos);
+		}
+
+		isSet = true;
+	}
+
+	return isSet;
+}
+
+bool getSessionAudioFormat(
+		const Session* session,
+		AudioSinkFormat* format)
+{
+	bool isPcm = false;
+
+	// Only uncompressed audio is played
+	if ((0 < AVI_audio_tracks(session->avi))
+			&& (WAVE_FORMAT_PCM == AVI_audio_format(session->avi))
+			&& (0 < AVI_audio_rate(session->avi)))
+	{
+		format->channels = AVI_audio_channels(session->avi);
+		format->rate = AVI_audio_rate(session->avi);
+		format->bits = AVI_audio_bits(session->avi);
+		isPcm = true;
+	}
+
+	return isPcm;
+}
+
+long readSessionAudio(
+		void* context,
+		unsigned char* buffer,
+		long size)
+{
+	Session* session = (Session*) context;
+
+	// Silence while the frames are skipped
+	if (1 != session->playbackRate)
+	{
+		memset(buffer, (8 == session->audioSink->format.bits) ? 0x80 : 0,
+				size);
+		return size;
+	}
+
+	// Audio is read with lseek and read, video with pread,
+	// so only the audio position needs guarding
+	pthread_mutex_lock(&session->audioMutex);
+	long readSize = AVI_read_audio(session->avi, (char*) buffer, size);
+
+	// Cleared by seeking, under the same lock
+	if (0 >= readSize)
+	{
+		session->isAudioEnded = true;
+		readSize = 0;
+	}
+
+	pthread_mutex_unlock(&session->audioMutex);
+
+	return readSize;
+}
+
+void setSessionAudioSink(
+		Session* session,
+		AudioSink* sink)
+{
+	session->audioSink = sink;
+	session->avSync.frameRate = AVI_frame_rate(session->avi);
+
+	// Resumed sessions start the audio at their frame
+	seekSession(session, session->avi->video_pos);
+}
+
+/**
+ * Checks if the video of the given session follows the
+ * audio clock.
+ */
+static bool isAudioClocked(
+		const Session* session)
+{
+	return (0 != session->audioSink)
+			&& session->isAudioStarted
+			&& !session->isAudioEnded
+			&& (1 == session->playbackRate);
+}
+
+bool syncSessionFrame(
+		Session* session)
+{
+	long frame;
+
+	if (0 == session->audioSink)
+	{
+		return true;
+	}
+
+	// Audio starts with the first frame
+	if (!session->isAudioStarted)
+	{
+		session->isAudioStarted = true;
+
+		if (!startAudioSink(session->audioSink))
+		{
+			destroyAudioSink(session->audioSink);
+			session->audioSink = 0;
+			return true;
+		}
+	}
+
+	// Video runs on after the audio ends, or in trick play
+	if (!isAudioClocked(session))
+	{
+		return true;
+	}
+
+	frame = syncVideoFrame(&session->avSync,
+			session->avi->video_pos,
+			getAudioSinkPosition(session->audioSink));
+
+	if (0 > frame)
+	{
+		return false;
+	}
+
+	// Dropped frames are skipped, not read
+	session->avi->video_pos = frame;
+	return true;
+}
+
+long long getSessionFrameDelay(
+		Session* session)
+{
+	long long frameTime = (long long) (1000000 / AVI_frame_rate(session->avi));
+	long long delay = frameTime;
+
+	if (isAudioClocked(session))
+	{
+		delay = getAvSyncDelay(&session->avSync,
+				session->avi->video_pos,
+				getAudioSinkPosition(session->audioSink));
+
+		if (delay > frameTime)
+		{
+			delay = frameTime;
+		}
+	}
+	else if ((1 != session->playbackRate)
+			&& (0 <= session->shownFrame)
+			&& (getSessionFrameCount(session) > session->avi->video_pos))
+	{
+		long step = session->avi->video_pos - session->shownFrame;
+		int rate = session->playbackRate;
+
+		// Skipped frames take their time at the playback rate
+		delay = (frameTime * ((0 < step) ? step : -step))
+				/ ((0 < rate) ? rate : -rate);
+	}
+
+	return delay;
+}
+
+/**
+ * Brightness band filter for the fused read.
+ *
+ * @param context player session.
+ * @param rows band pixels.
+ * @param width band width in pixels.
+ * @param rowCount number of rows in the band.
+ * @param stride band row stride in bytes.
+ */
+static void brightnessBand(
+		void* context,
+		unsigned char* rows,
+		int width,
+		int rowCount,
+		long stride)
+{
+	unsigned char brightness = ((Session*) context)->brightness;
+
+	for (int i = 0; i < rowCount; i++)
+	{
+		brightnessFilter((unsigned short*) (rows + (i * stride)),
+				width,
+				brightness);
+	}
+}
+
+/**
+ * Hints the kernel to read the next frames of reverse
+ * playback, so that they are read while the shown one is
+ * rendered. Frames already hinted are not hinted again.
+ *
+ * @param session player session.
+ * @param frame next frame number.
+ */
+static void readAheadReverse(
+		Session* session,
+		long frame)
+{
+	long frameCount = getSessionFrameCount(session);
+	OdmlFrame location;
+
+	for (int i = 0; (TRICK_PLAY_READ_AHEAD > i) && (frameCount > frame); i++)
+	{
+		if (((0 > session->readAheadFrame) || (session->readAheadFrame > frame))
+				&& getSessionFrame(session, frame, &location))
+		{
+			readahead(session->avi->fdes, location.offset, location.size);
+			session->readAheadFrame = frame;
+		}
+
+		frame = getNextSessionFrame(session, frame);
+	}
+}
+
+/**
+ * Reads the next frame into the given pixels, fused with
+ * the band filters of the session.
+ *
+ * @param session player session.
+ * @param pixels destination pixels.
+ * @param stride destination row stride in bytes.
+ * @return frame size, or 0 and less on failure.
+ */
+static long readFilteredFrame(
+		Session* session,
+		void* pixels,
+		long stride)
+{
+	long frameSize = 0;
+	OdmlFrame location;
+
+	if (!getSessionFrame(session, session->avi->video_pos, &location))
+	{
+		goto exit;
+	}
+
+	// Staging window is allocated once
+	if (0 == session->fusedReader)
+	{
+		session->fusedReader = createFusedReader(
+				AVI_video_width(session->avi),
+				AVI_video_height(session->avi),
+				session->frameFormat,
+				session->isDithered,
+				FUSED_MAX_THREADS);
+	}
+
+	if (0 == session->fusedReader)
+	{
+		// Only whole RGB565 frames can be read as is
+		if ((FRAME_FORMAT_RGB565 == session->frameFormat.format)
+				&& (location.size == getStoredSize(session->frameFormat,
+						AVI_video_height(session->avi))))
+		{
+			// Read AVI frame bytes to pixels
+			frameSize = pread(session->avi->fdes, pixels, location.size,
+					location.offset);
+		}
+	}
+	else
+	{
+		// Read, filter and write each band in one pass
+		frameSize = readFusedFrame(session->fusedReader,
+				session->avi->fdes,
+				location.offset,
+				location.size,
+				pixels,
+				stride,
+				(0 != session->brightness) ? brightnessBand : 0,
+				session);
+	}
+
+	// Advance like AVI_read_frame, or to the next frame shown
+	// at the playback rate. Frames that cannot be read are
+	// skipped, not retried.
+	session->shownFrame = session->avi->video_pos;
+	session->avi->video_pos = (1 == session->playbackRate)
+			? session->avi->video_pos + 1
+			: getNextSessionFrame(session, session->avi->video_pos);
+
+	if (0 > session->playbackRate)
+	{
+		readAheadReverse(session, session->avi->video_pos);
+	}
+
+exit:
+	return frameSize;
+}
+
+long readSessionFrame(
+		Session* session,
+		void* pixels,
+		long stride)
+{
+	long frameSize = 0;
+
+	if (FRAME_TRANSFORM_NONE == session->transform)
+	{
+		// Read AVI frame bytes to pixels
+		frameSize = readFilteredFrame(session, pixels, stride);
+	}
+	else
+	{
+		int width = AVI_video_width(session->avi);
+		int height = AVI_video_height(session->avi);
+
+		// Read AVI frame bytes to transform buffer
+		frameSize = readFilteredFrame(session,
+				session->transformBuffer,
+				width * Rgb565Format::BYTES_PER_PIXEL);
+
+		if (0 < frameSize)
+		{
+			transformFrame(session->transform,
+					PIXEL_FORMAT_RGB_565,
+					session->transformBuffer,
+					width,
+					height,
+					width * Rgb565Format::BYTES_PER_PIXEL,
+					pixels,
+					stride);
+		}
+	}
+
+	// Shown frame is queued, the disk is left to the writer
+	if ((0 < frameSize) && (0 != session->recorder))
+	{
+		int width;
+		int height;
+
+		getTransformedSize(session->transform,
+				AVI_video_width(session->avi),
+				AVI_video_height(session->avi),
+				&width,
+				&height);
+
+		recordFrame(session->recorder, pixels, width, height, stride);
+	}
+
+	return frameSize;
+}
+
+bool startSessionRecording(
+		Session* session,
+		const char* fileName)
+{
+	int width;
+	int height;
+
+	if (0 != session->recorder)
+	{
+		return false;
+	}
+
+	getTransformedSize(session->transform,
+			AVI_video_width(session->avi),
+			AVI_video_height(session->avi),
+			&width,
+			&height);
+
+	session->recorder = createRecorder(fileName,
+			width,
+			height,
+			AVI_frame_rate(session->avi),
+			getSessionFrameCount(session),
+			&session->memory);
+
+	return (0 != session->recorder);
+}
+
+bool stopSessionRecording(
+		Session* session)
+{
+	Recorder* recorder = session->recorder;
+
+	if (0 == recorder)
+	{
+		return false;
+	}
+
+	session->recorder = 0;
+	return closeRecorder(recorder);
+}
+
+void closeSession(
+		Session* session)
+{
+	// Stop the audio callbacks first
+	destroyAudioSink(session->audioSink);
+	pthread_mutex_destroy(&session->audioMutex);
+
+	// Queued frames are written out
+	stopSessionRecording(session);
+
+	releaseFrameBuffer(session->transformBuffer);
+	destroyFusedReader(session->fusedReader);
+	closeOdmlIndex(session->odmlIndex);
+
+	closeCachedAvi(session->avi, &session->cacheKey);
+	delete session;
+}
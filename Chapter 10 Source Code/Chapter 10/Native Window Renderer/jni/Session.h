@@ -0,0 +1,278 @@
+#pragma once
+
+extern "C" {
+#include <avilib.h>
+}
+
+#include <pthread.h>
+
+#include "AudioSink.h"
+#include "AvSync.h"
+#include "FrameFormat.h"
+#include "FusedReader.h"
+#include "Memory.h"
+#include "OdmlIndex.h"
+#include "Recorder.h"
+#include "SessionCache.h"
+#include "Transform.h"
+
+/**
+ * From this playback rate on, only key frames are shown.
+ * Below it the frames in between are skipped by index.
+ */
+#define TRICK_PLAY_KEY_FRAME_RATE 8
+
+/**
+ * Highest playback rate in either direction.
+ */
+#define TRICK_PLAY_MAX_RATE 64
+
+/**
+ * Key frames are looked for this many frames past the
+ * target frame, streams without key frame flags are
+ * decimated instead.
+ */
+#define TRICK_PLAY_KEY_FRAME_DISTANCE 300
+
+/**
+ * Number of frames read ahead in reverse playback. The
+ * kernel only reads ahead of forward reads.
+ */
+#define TRICK_PLAY_READ_AHEAD 4
+
+/**
+ * Player session. The Java side holds a pointer to the
+ * session as the AVI file descriptor, so the render paths
+ * can keep state across frames.
+ */
+struct Session
+{
+	avi_t* avi;
+
+	// OpenDML index, used instead of the avilib index if set
+	OdmlIndex* odmlIndex;
+
+	// Stored frame format
+	FrameFormatInfo frameFormat;
+
+	// Frame transform and the frame it is read into
+	int transform;
+	char* transformBuffer;
+
+	// Staging window for the fused read and filter
+	FusedReader* fusedReader;
+	unsigned char brightness;
+	bool isDithered;
+
+	// Memory charged to this session
+	MemoryAccount memory;
+
+	// Key to return the AVI file to the session cache
+	SessionCacheKey cacheKey;
+
+	// Audio output, the master clock of the video if set
+	AudioSink* audioSink;
+	bool isAudioStarted;
+	volatile bool isAudioEnded;
+
+	// Guards the avilib audio position
+	pthread_mutex_t audioMutex;
+
+	// Video sync to the audio clock
+	AvSync avSync;
+
+	// Playback rate, negative in reverse
+	volatile int playbackRate;
+
+	// Last frame read, and the lowest frame read ahead in
+	// reverse playback or -1
+	long shownFrame;
+	long readAheadFrame;
+
+	// Recorder of the rendered frames, if recording
+	Recorder* recorder;
+
+	Session():
+		avi(0),
+		odmlIndex(0),
+		transform(FRAME_TRANSFORM_NONE),
+		transformBuffer(0),
+		fusedReader(0),
+		brightness(0),
+		isDithered(false),
+		audioSink(0),
+		isAudioStarted(false),
+		isAudioEnded(false),
+		playbackRate(1),
+		shownFrame(-1),
+		readAheadFrame(-1),
+		recorder(0)
+	{
+		pthread_mutex_init(&audioMutex, 0);
+	}
+};
+
+/**
+ * Sets the frame transform of the given session. The
+ * transform buffer is allocated here once, not per frame.
+ *
+ * @param session player session.
+ * @param transform frame transform.
+ * @return true on success, false otherwise.
+ */
+bool setSessionTransform(
+		Session* session,
+		int transform);
+
+/**
+ * Gets the number of video frames of the given session.
+ *
+ * @param session player session.
+ * @return frame count.
+ */
+long getSessionFrameCount(
+		const Session* session);
+
+/**
+ * Sets the frame that is read next. The audio is moved
+ * to the same time.
+ *
+ * @param session player session.
+ * @param frame frame number.
+ * @return true on success, false if the frame is out of
+ * range.
+ */
+bool seekSession(
+		Session* session,
+		long frame);
+
+/**
+ * Sets the playback rate of the given session. At rates
+ * up to TRICK_PLAY_KEY_FRAME_RATE every rate-th frame is
+ * shown, above it only the key frames, and negative rates
+ * play in reverse. Frames in between are never read. The
+ * audio is silent at any rate other than 1, and follows
+ * the video again when set back to 1.
+ *
+ * @param session player session.
+ * @param rate playback rate, negative in reverse.
+ * @return true on success, false if the rate is 0 or
+ * above TRICK_PLAY_MAX_RATE.
+ */
+bool setSessionPlaybackRate(
+		Session* session,
+		int rate);
+
+/**
+ * Gets the PCM format of the first audio track of the
+ * given session.
+ *
+ * @param session player session.
+ * @param format PCM format. [OUT]
+ * @return true if the session has PCM audio.
+ */
+bool getSessionAudioFormat(
+		const Session* session,
+		AudioSinkFormat* format);
+
+/**
+ * Audio reader of the session, reads the next PCM bytes
+ * of the first audio track.
+ *
+ * @param context player session.
+ * @param buffer buffer to fill.
+ * @param size buffer size in bytes.
+ * @return bytes read, 0 at the end of the audio.
+ */
+long readSessionAudio(
+		void* context,
+		unsigned char* buffer,
+		long size);
+
+/**
+ * Sets the audio output of the given session. It starts
+ * playing with the first frame, and its position becomes
+ * the clock that the frames are shown by.
+ *
+ * @param session player session.
+ * @param sink audio sink reading with readSessionAudio,
+ * owned by the session.
+ */
+void setSessionAudioSink(
+		Session* session,
+		AudioSink* sink);
+
+/**
+ * Syncs the next frame to the audio clock. Late frames
+ * are dropped by moving past them without reading them.
+ * Sessions without audio always read the next frame.
+ *
+ * @param session player session.
+ * @return true if a frame should be read, false if the
+ * shown frame should be repeated.
+ */
+bool syncSessionFrame(
+		Session* session);
+
+/**
+ * Gets the time until the next frame is due, on the audio
+ * clock, or one frame time without audio. In trick play
+ * it is the time of the skipped frames at the playback
+ * rate.
+ *
+ * @param session player session.
+ * @return delay in microseconds.
+ */
+long long getSessionFrameDelay(
+		Session* session);
+
+/**
+ * Reads the next RGB565 frame into the given pixels. The
+ * frame is read and filtered a band of rows at a time. If
+ * the session has a frame transform, the frame is read
+ * into the transform buffer and then transformed into
+ * the pixels.
+ *
+ * @param session player session.
+ * @param pixels destination pixels.
+ * @param stride destination row stride in bytes.
+ * @return frame size, or 0 and less on failure.
+ */
+long readSessionFrame(
+		Session* session,
+		void* pixels,
+		long stride);
+
+/**
+ * Starts recording the rendered frames of the given
+ * session to an AVI file, after the frame transform.
+ * Index space is reserved for the frames of the session.
+ *
+ * @param session player session.
+ * @param fileName AVI file name.
+ * @return true on success, false if already recording or
+ * the file cannot be created.
+ */
+bool startSessionRecording(
+		Session* session,
+		const char* fileName);
+
+/**
+ * Stops recording and finishes the AVI file.
+ *
+ * @param session player session.
+ * @return true if the recording is written, false
+ * otherwise.
+ */
+bool stopSessionRecording(
+		Session* session);
+
+/**
+ * Stops the audio and the recording, frees the session
+ * state and the OpenDML index, and returns the AVI file
+ * to the session cache.
+ *
+ * @param session player session.
+ */
+void closeSession(
+		Session* session);
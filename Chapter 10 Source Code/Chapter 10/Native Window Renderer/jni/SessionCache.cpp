@@ -0,0 +1,277 @@
+#include "SessionCache.h"
+
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+
+#include "IndexRecovery.h"
+#include "OdmlIndex.h"
+
+// Number of closed handles kept
+#define SESSION_CACHE_SIZE 4
+
+// Default grace period in milliseconds
+#define SESSION_CACHE_GRACE_PERIOD 30000
+
+/**
+ * Recently closed AVI file.
+ */
+struct SessionCacheEntry
+{
+	SessionCacheKey key;
+	avi_t* avi;
+
+	// Close time in milliseconds
+	long long closeTime;
+};
+
+static SessionCacheEntry cacheEntries[SESSION_CACHE_SIZE];
+static long long gracePeriod = SESSION_CACHE_GRACE_PERIOD;
+static pthread_mutex_t cacheMutex = PTHREAD_MUTEX_INITIALIZER;
+
+// Write the rebuilt index back to unindexed files
+static bool isIndexRepaired = false;
+
+/**
+ * Gets the monotonic time in milliseconds.
+ */
+static long long getTimeMillis()
+{
+	struct timespec now;
+	clock_gettime(CLOCK_MONOTONIC, &now);
+
+	return (now.tv_sec * 1000LL) + (now.tv_nsec / 1000000);
+}
+
+static bool isSameKey(
+		const SessionCacheKey& key,
+		const SessionCacheKey& other)
+{
+	return (key.device == other.device)
+			&& (key.inode == other.inode)
+			&& (key.size == other.size)
+			&& (key.modifiedTime == other.modifiedTime)
+			&& (0 == strcmp(key.fileName, other.fileName));
+}
+
+/**
+ * Unlinks the given entry into the list of handles to be
+ * closed. Must be called with the cache mutex held.
+ */
+static void evictEntry(
+		SessionCacheEntry* entry,
+		SessionCacheEntry* evicted,
+		int& evictedCount)
+{
+	evicted[evictedCount++] = *entry;
+
+	entry->avi = 0;
+	entry->key = SessionCacheKey();
+}
+
+/**
+ * Unlinks the entries past the grace period. Must be
+ * called with the cache mutex held.
+ */
+static void evictExpired(
+		long long now,
+		SessionCacheEntry* evicted,
+		int& evictedCount)
+{
+	for (int i = 0; i < SESSION_CACHE_SIZE; i++)
+	{
+		if ((0 != cacheEntries[i].avi)
+				&& (now - cacheEntries[i].closeTime >= gracePeriod))
+		{
+			evictEntry(&cacheEntries[i], evicted, evictedCount);
+		}
+	}
+}
+
+/**
+ * Closes the evicted handles, outside the cache mutex.
+ */
+static void closeEvicted(
+		SessionCacheEntry* evicted,
+		int evictedCount)
+{
+	for (int i = 0; i < evictedCount; i++)
+	{
+		AVI_close(evicted[i].avi);
+		free(evicted[i].key.fileName);
+	}
+}
+
+avi_t* openCachedAvi(
+		const char* fileName,
+		SessionCacheKey* key)
+{
+	avi_t* avi = 0;
+	SessionCacheEntry evicted[SESSION_CACHE_SIZE];
+	int evictedCount = 0;
+	struct stat fileStat;
+
+	// File identity and modification time form the key
+	if ((0 == stat(fileName, &fileStat))
+			&& (0 != (key->fileName = strdup(fileName))))
+	{
+		key->device = fileStat.st_dev;
+		key->inode = fileStat.st_ino;
+		key->size = fileStat.st_size;
+		key->modifiedTime = fileStat.st_mtime;
+
+		pthread_mutex_lock(&cacheMutex);
+
+		evictExpired(getTimeMillis(), evicted, evictedCount);
+
+		for (int i = 0; i < SESSION_CACHE_SIZE; i++)
+		{
+			SessionCacheEntry* entry = &cacheEntries[i];
+			if ((0 != entry->avi) && isSameKey(entry->key, *key))
+			{
+				// Take the warm handle out of the cache
+				avi = entry->avi;
+				free(entry->key.fileName);
+
+				entry->avi = 0;
+				entry->key = SessionCacheKey();
+				break;
+			}
+		}
+
+		pthread_mutex_unlock(&cacheMutex);
+
+		closeEvicted(evicted, evictedCount);
+	}
+
+	// Finished clips start over
+	if ((0 != avi) && (AVI_video_frames(avi) <= avi->video_pos))
+	{
+		AVI_seek_start(avi);
+	}
+
+	// Parse the headers and the index, OpenDML indices are
+	// loaded piecewise by the session instead
+	if (0 == avi)
+	{
+		bool isOdml = isOdmlFile(fileName);
+		bool isIndexMissing = !isOdml && isAviIndexMissing(fileName);
+
+		avi = AVI_open_input_file(fileName, (isOdml || isIndexMissing) ? 0 : 1);
+
+		// Unfinished recordings are scanned for their chunks
+		if ((0 != avi)
+				&& isIndexMissing
+				&& !recoverAviIndex(avi, isIndexRepaired ? fileName : 0))
+		{
+			AVI_close(avi);
+			avi = 0;
+		}
+	}
+
+	if ((0 == avi) && (0 != key->fileName))
+	{
+		free(key->fileName);
+		key->fileName = 0;
+	}
+
+	return avi;
+}
+
+void closeCachedAvi(
+		avi_t* avi,
+		SessionCacheKey* key)
+{
+	SessionCacheEntry evicted[SESSION_CACHE_SIZE + 1];
+	int evictedCount = 0;
+	long long now = getTimeMillis();
+
+	pthread_mutex_lock(&cacheMutex);
+
+	evictExpired(now, evicted, evictedCount);
+
+	// Files that could not be keyed are closed right away
+	if ((0 == key->fileName) || (0 >= gracePeriod))
+	{
+		evicted[evictedCount].avi = avi;
+		evicted[evictedCount].key = *key;
+		evictedCount++;
+	}
+	else
+	{
+		// Free entry or the oldest one
+		SessionCacheEntry* entry = &cacheEntries[0];
+		for (int i = 0; i < SESSION_CACHE_SIZE; i++)
+		{
+			if (0 == cacheEntries[i].avi)
+			{
+				entry = &cacheEntries[i];
+				break;
+			}
+
+			if (cacheEntries[i].closeTime < entry->closeTime)
+			{
+				entry = &cacheEntries[i];
+			}
+		}
+
+		if (0 != entry->avi)
+		{
+			evictEntry(entry, evicted, evictedCount);
+		}
+
+		entry->avi = avi;
+		entry->key = *key;
+		entry->closeTime = now;
+	}
+
+	pthread_mutex_unlock(&cacheMutex);
+
+	// Key is owned by the cache now
+	key->fileName = 0;
+
+	closeEvicted(evicted, evictedCount);
+}
+
+void setSessionCacheGracePeriod(
+		long long period)
+{
+	SessionCacheEntry evicted[SESSION_CACHE_SIZE];
+	int evictedCount = 0;
+
+	pthread_mutex_lock(&cacheMutex);
+
+	gracePeriod = period;
+	evictExpired(getTimeMillis(), evicted, evictedCount);
+
+	pthread_mutex_unlock(&cacheMutex);
+
+	closeEvicted(evicted, evictedCount);
+}
+
+void setIndexRepairEnabled(
+		bool isEnabled)
+{
+	isIndexRepaired = isEnabled;
+}
+
+void trimSessionCache()
+{
+	SessionCacheEntry evicted[SESSION_CACHE_SIZE];
+	int evictedCount = 0;
+
+	pthread_mutex_lock(&cacheMutex);
+
+	for (int i = 0; i < SESSION_CACHE_SIZE; i++)
+	{
+		if (0 != cacheEntries[i].avi)
+		{
+			evictEntry(&cacheEntries[i], evicted, evictedCount);
+		}
+	}
+
+	pthread_mutex_unlock(&cacheMutex);
+
+	closeEvicted(evicted, evictedCount);
+}
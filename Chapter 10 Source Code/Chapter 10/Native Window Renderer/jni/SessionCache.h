@@ -0,0 +1,81 @@
+#pragma once
+
+extern "C" {
+#include <avilib.h>
+}
+
+#include <sys/types.h>
+#include <time.h>
+
+/**
+ * Session cache key. A cached AVI file is only reused if
+ * the file was not modified since it was opened.
+ */
+struct SessionCacheKey
+{
+	char* fileName;
+	dev_t device;
+	ino_t inode;
+	off_t size;
+	time_t modifiedTime;
+
+	SessionCacheKey():
+		fileName(0),
+		device(0),
+		inode(0),
+		size(0),
+		modifiedTime(0)
+	{
+
+	}
+};
+
+/**
+ * Opens the given AVI file. A recently closed handle of
+ * the same unmodified file is taken from the cache with
+ * its index and position, instead of parsing the headers
+ * and the index again. The avilib index is not built for
+ * OpenDML files, and it is rebuilt from the chunks of
+ * files that have no index.
+ *
+ * @param fileName file name.
+ * @param key cache key for closing. [OUT]
+ * @return AVI file, or 0 with AVI_strerror on failure.
+ */
+avi_t* openCachedAvi(
+		const char* fileName,
+		SessionCacheKey* key);
+
+/**
+ * Closes the given AVI file. The handle is kept in the
+ * cache for the grace period before it is really closed.
+ *
+ * @param avi AVI file.
+ * @param key cache key from opening, gets released.
+ */
+void closeCachedAvi(
+		avi_t* avi,
+		SessionCacheKey* key);
+
+/**
+ * Sets the session cache grace period.
+ *
+ * @param period grace period in milliseconds, 0 to
+ * close the handles right away.
+ */
+void setSessionCacheGracePeriod(
+		long long period);
+
+/**
+ * Sets whether the index rebuilt for a file without one
+ * is written back to the file.
+ *
+ * @param isEnabled true to write the index.
+ */
+void setIndexRepairEnabled(
+		bool isEnabled);
+
+/**
+ * Closes all cached handles.
+ */
+void trimSessionCache();
@@ -0,0 +1,166 @@
+#include "SimulatedAudioSink.h"
+
+#include <stdlib.h>
+
+/**
+ * Simulated audio sink.
+ */
+struct SimulatedAudioSink
+{
+	AudioSink sink;
+
+	unsigned char* buffer;
+	long bufferSize;
+
+	// Frames played, and the frames left in the current buffer
+	long long playedFrames;
+	long long bufferedFrames;
+
+	// Fraction of a frame carried between advances
+	long long remainder;
+
+	bool isStarted;
+};
+
+/**
+ * Gets the size of a PCM frame in bytes.
+ */
+static long getFrameSize(
+		const AudioSinkFormat& format)
+{
+	return format.channels * (format.bits / 8);
+}
+
+/**
+ * Pulls the next buffer from the reader.
+ */
+static void readBuffer(
+		SimulatedAudioSink* simulated)
+{
+	long size = simulated->sink.reader(simulated->sink.context,
+			simulated->buffer,
+			simulated->bufferSize);
+
+	simulated->bufferedFrames = (0 < size)
+			? size / getFrameSize(simulated->sink.format)
+			: 0;
+}
+
+static bool startSimulatedSink(
+		AudioSink* sink)
+{
+	SimulatedAudioSink* simulated = (SimulatedAudioSink*) sink;
+
+	if (!simulated->isStarted)
+	{
+		simulated->isStarted = true;
+		readBuffer(simulated);
+	}
+
+	return true;
+}
+
+static void refillSimulatedSink(
+		AudioSink* sink)
+{
+	SimulatedAudioSink* simulated = (SimulatedAudioSink*) sink;
+
+	if (simulated->isStarted && (0 == simulated->bufferedFrames))
+	{
+		readBuffer(simulated);
+	}
+}
+
+static long long getSimulatedPlayedFrames(
+		AudioSink* sink)
+{
+	return ((SimulatedAudioSink*) sink)->playedFrames;
+}
+
+static void destroySimulatedSink(
+		AudioSink* sink)
+{
+	SimulatedAudioSink* simulated = (SimulatedAudioSink*) sink;
+
+	free(simulated->buffer);
+	free(simulated);
+}
+
+static const AudioSinkOps simulatedSinkOps = {
+	startSimulatedSink,
+	refillSimulatedSink,
+	getSimulatedPlayedFrames,
+	destroySimulatedSink
+};
+
+AudioSink* createSimulatedAudioSink(
+		const AudioSinkFormat& format,
+		long bufferSize,
+		AudioReader reader,
+		void* context)
+{
+	SimulatedAudioSink* simulated = 0;
+
+	if ((0 >= format.rate) || (0 >= getFrameSize(format))
+			|| (getFrameSize(format) > bufferSize))
+	{
+		goto exit;
+	}
+
+	simulated = (SimulatedAudioSink*) calloc(1, sizeof(SimulatedAudioSink));
+	if (0 == simulated)
+	{
+		goto exit;
+	}
+
+	simulated->buffer = (unsigned char*) malloc(bufferSize);
+	if (0 == simulated->buffer)
+	{
+		free(simulated);
+		simulated = 0;
+		goto exit;
+	}
+
+	simulated->sink.ops = &simulatedSinkOps;
+	simulated->sink.format = format;
+	simulated->sink.reader = reader;
+	simulated->sink.context = context;
+	simulated->bufferSize = bufferSize;
+
+exit:
+	return (AudioSink*) simulated;
+}
+
+void advanceSimulatedAudioSink(
+		AudioSink* sink,
+		long long micros)
+{
+	SimulatedAudioSink* simulated = (SimulatedAudioSink*) sink;
+
+	if (!simulated->isStarted)
+	{
+		return;
+	}
+
+	// Frames due, keeping the fraction for the next advance
+	long long scaled = (micros * sink->format.rate) + simulated->remainder;
+	long long frames = scaled / 1000000;
+	simulated->remainder = scaled % 1000000;
+
+	while ((0 < frames) && (0 < simulated->bufferedFrames))
+	{
+		long long played = (frames < simulated->bufferedFrames)
+				? frames
+				: simulated->bufferedFrames;
+
+		simulated->playedFrames += played;
+		simulated->bufferedFrames -= played;
+		frames -= played;
+
+		// Buffer is done, queue the next one
+		if (0 == simulated->bufferedFrames)
+		{
+			readBuffer(simulated);
+		}
+	}
+}
@@ -0,0 +1,34 @@
+#pragma once
+
+#include "AudioSink.h"
+
+/**
+ * Creates a new simulated audio sink. It plays nothing;
+ * its clock only moves when it is advanced, pulling
+ * buffers from the reader as they would be played. Used
+ * to run the audio and video sync on the host, it is not
+ * part of the Android module.
+ *
+ * @param format PCM format.
+ * @param bufferSize buffer size in bytes.
+ * @param reader PCM data reader.
+ * @param context reader context.
+ * @return audio sink or 0 on failure.
+ */
+AudioSink* createSimulatedAudioSink(
+		const AudioSinkFormat& format,
+		long bufferSize,
+		AudioReader reader,
+		void* context);
+
+/**
+ * Advances the clock of the given simulated sink. The
+ * clock stops when the reader runs out of data, like an
+ * underrun of a real sink.
+ *
+ * @param sink simulated audio sink.
+ * @param micros time to advance in microseconds.
+ */
+void advanceSimulatedAudioSink(
+		AudioSink* sink,
+		long long micros);
@@ -0,0 +1,651 @@
+#include "Transform.h"
+
+#include <string.h>
+
+#include "PixelFormat.h"
+
+#ifdef __ARM_NEON__
+
+#include <cpu-features.h>
+
+#include <arm_neon.h>
+
+#endif
+
+#ifdef __SSE2__
+
+#include <emmintrin.h>
+
+#endif
+
+// Tile size in pixels, a tile of both frames fits into L1
+#define TILE_SIZE 64
+
+// Transposed block sizes for 16-bit and 32-bit pixels
+#define BLOCK_SIZE_16 8
+#define BLOCK_SIZE_32 4
+
+/**
+ * Transposes a block. Source column i is stored to the
+ * destination row at destination + i * destinationStep,
+ * reversed if requested.
+ */
+typedef void (*TransposeKernel)(
+		const unsigned char* source,
+		long sourceStride,
+		unsigned char* destination,
+		long destinationStep,
+		bool isReversed);
+
+/**
+ * Copies a row of pixels in reverse order.
+ */
+typedef void (*ReverseKernel)(
+		const unsigned char* source,
+		unsigned char* destination,
+		int width);
+
+/**
+ * Transform kernels for 16-bit and 32-bit pixels.
+ */
+struct TransformKernels
+{
+	TransposeKernel transpose16;
+	TransposeKernel transpose32;
+	ReverseKernel reverse16;
+	ReverseKernel reverse32;
+};
+
+template<typename Pixel, int BLOCK_SIZE>
+static void genericTranspose(
+		const unsigned char* source,
+		long sourceStride,
+		unsigned char* destination,
+		long destinationStep,
+		bool isReversed)
+{
+	for (int i = 0; i < BLOCK_SIZE; i++)
+	{
+		Pixel* row = (Pixel*) (destination + (i * destinationStep));
+
+		for (int j = 0; j < BLOCK_SIZE; j++)
+		{
+			int k = isReversed ? (BLOCK_SIZE - 1 - j) : j;
+			row[k] = ((const Pixel*) (source + (j * sourceStride)))[i];
+		}
+	}
+}
+
+template<typename Pixel>
+static void genericReverse(
+		const unsigned char* source,
+		unsigned char* destination,
+		int width)
+{
+	const Pixel* in = (const Pixel*) source;
+	Pixel* out = ((Pixel*) destination) + width - 1;
+
+	for (int i = 0; i < width; i++)
+	{
+		*out-- = *in++;
+	}
+}
+
+static const TransformKernels GENERIC_KERNELS =
+{
+	genericTranspose<unsigned short, BLOCK_SIZE_16>,
+	genericTranspose<unsigned int, BLOCK_SIZE_32>,
+	genericReverse<unsigned short>,
+	genericReverse<unsigned int>
+};
+
+#ifdef __ARM_NEON__
+
+static inline uint16x8_t neonReverseVector16(
+		uint16x8_t pixels)
+{
+	pixels = vrev64q_u16(pixels);
+	return vcombine_u16(vget_high_u16(pixels), vget_low_u16(pixels));
+}
+
+static inline uint32x4_t neonReverseVector32(
+		uint32x4_t pixels)
+{
+	pixels = vrev64q_u32(pixels);
+	return vcombine_u32(vget_high_u32(pixels), vget_low_u32(pixels));
+}
+
+static inline void neonStore16(
+		unsigned char* destination,
+		uint32x4_t pixels,
+		bool isReversed)
+{
+	uint16x8_t row = vreinterpretq_u16_u32(pixels);
+	vst1q_u16((unsigned short*) destination,
+			isReversed ? neonReverseVector16(row) : row);
+}
+
+static void neonTranspose16(
+		const unsigned char* source,
+		long sourceStride,
+		unsigned char* destination,
+		long destinationStep,
+		bool isReversed)
+{
+	uint16x8_t rows[BLOCK_SIZE_16];
+	for (int i = 0; i < BLOCK_SIZE_16; i++)
+	{
+		rows[i] = vld1q_u16((const unsigned short*) (source + (i * sourceStride)));
+	}
+
+	// Transpose the 16-bit pairs
+	uint16x8x2_t t01 = vtrnq_u16(rows[0], rows[1]);
+	uint16x8x2_t t23 = vtrnq_u16(rows[2], rows[3]);
+	uint16x8x2_t t45 = vtrnq_u16(rows[4], rows[5]);
+	uint16x8x2_t t67 = vtrnq_u16(rows[6], rows[7]);
+
+	// Transpose the 32-bit pairs
+	uint32x4x2_t u02 = vtrnq_u32(vreinterpretq_u32_u16(t01.val[0]),
+			vreinterpretq_u32_u16(t23.val[0]));
+	uint32x4x2_t u13 = vtrnq_u32(vreinterpretq_u32_u16(t01.val[1]),
+			vreinterpretq_u32_u16(t23.val[1]));
+	uint32x4x2_t u46 = vtrnq_u32(vreinterpretq_u32_u16(t45.val[0]),
+			vreinterpretq_u32_u16(t67.val[0]));
+	uint32x4x2_t u57 = vtrnq_u32(vreinterpretq_u32_u16(t45.val[1]),
+			vreinterpretq_u32_u16(t67.val[1]));
+
+	// Swap the 64-bit halves and store the columns
+	neonStore16(destination, vcombine_u32(
+			vget_low_u32(u02.val[0]), vget_low_u32(u46.val[0])), isReversed);
+	neonStore16(destination + destinationStep, vcombine_u32(
+			vget_low_u32(u13.val[0]), vget_low_u32(u57.val[0])), isReversed);
+	neonStore16(destination + (2 * destinationStep), vcombine_u32(
+			vget_low_u32(u02.val[1]), vget_low_u32(u46.val[1])), isReversed);
+	neonStore16(destination + (3 * destinationStep), vcombine_u32(
+			vget_low_u32(u13.val[1]), vget_low_u32(u57.val[1])), isReversed);
+	neonStore16(destination + (4 * destinationStep), vcombine_u32(
+			vget_high_u32(u02.val[0]), vget_high_u32(u46.val[0])), isReversed);
+	neonStore16(destination + (5 * destinationStep), vcombine_u32(
+			vget_high_u32(u13.val[0]), vget_high_u32(u57.val[0])), isReversed);
+	neonStore16(destination + (6 * destinationStep), vcombine_u32(
+			vget_high_u32(u02.val[1]), vget_high_u32(u46.val[1])), isReversed);
+	neonStore16(destination + (7 * destinationStep), vcombine_u32(
+			vget_high_u32(u13.val[1]), vget_high_u32(u57.val[1])), isReversed);
+}
+
+static void neonTranspose32(
+		const unsigned char* source,
+		long sourceStride,
+		unsigned char* destination,
+		long destinationStep,
+		bool isReversed)
+{
+	uint32x4x2_t t01 = vtrnq_u32(
+			vld1q_u32((const unsigned int*) source),
+			vld1q_u32((const unsigned int*) (source + sourceStride)));
+	uint32x4x2_t t23 = vtrnq_u32(
+			vld1q_u32((const unsigned int*) (source + (2 * sourceStride))),
+			vld1q_u32((const unsigned int*) (source + (3 * sourceStride))));
+
+	uint32x4_t columns[BLOCK_SIZE_32];
+	columns[0] = vcombine_u32(vget_low_u32(t01.val[0]), vget_low_u32(t23.val[0]));
+	columns[1] = vcombine_u32(vget_low_u32(t01.val[1]), vget_low_u32(t23.val[1]));
+	columns[2] = vcombine_u32(vget_high_u32(t01.val[0]), vget_high_u32(t23.val[0]));
+	columns[3] = vcombine_u32(vget_high_u32(t01.val[1]), vget_high_u32(t23.val[1]));
+
+	for (int i = 0; i < BLOCK_SIZE_32; i++)
+	{
+		vst1q_u32((unsigned int*) (destination + (i * destinationStep)),
+				isReversed ? neonReverseVector32(columns[i]) : columns[i]);
+	}
+}
+
+static void neonReverse16(
+		const unsigned char* source,
+		unsigned char* destination,
+		int width)
+{
+	const unsigned short* in = (const unsigned short*) source;
+	unsigned short* out = (unsigned short*) destination;
+
+	int i = 0;
+	for (; i + 8 <= width; i += 8)
+	{
+		vst1q_u16(&out[width - 8 - i], neonReverseVector16(vld1q_u16(&in[i])));
+	}
+
+	genericReverse<unsigned short>((const unsigned char*) &in[i],
+			destination, width - i);
+}
+
+static void neonReverse32(
+		const unsigned char* source,
+		unsigned char* destination,
+		int width)
+{
+	const unsigned int* in = (const unsigned int*) source;
+	unsigned int* out = (unsigned int*) destination;
+
+	int i = 0;
+	for (; i + 4 <= width; i += 4)
+	{
+		vst1q_u32(&out[width - 4 - i], neonReverseVector32(vld1q_u32(&in[i])));
+	}
+
+	genericReverse<unsigned int>((const unsigned char*) &in[i],
+			destination, width - i);
+}
+
+static const TransformKernels NEON_KERNELS =
+{
+	neonTranspose16,
+	neonTranspose32,
+	neonReverse16,
+	neonReverse32
+};
+
+#endif
+
+#ifdef __SSE2__
+
+static inline __m128i sseReverseVector16(
+		__m128i pixels)
+{
+	pixels = _mm_shufflelo_epi16(pixels, _MM_SHUFFLE(0, 1, 2, 3));
+	pixels = _mm_shufflehi_epi16(pixels, _MM_SHUFFLE(0, 1, 2, 3));
+	return _mm_shuffle_epi32(pixels, _MM_SHUFFLE(1, 0, 3, 2));
+}
+
+static inline __m128i sseReverseVector32(
+		__m128i pixels)
+{
+	return _mm_shuffle_epi32(pixels, _MM_SHUFFLE(0, 1, 2, 3));
+}
+
+static void sseTranspose16(
+		const unsigned char* source,
+		long sourceStride,
+		unsigned char* destination,
+		long destinationStep,
+		bool isReversed)
+{
+	__m128i a[BLOCK_SIZE_16];
+	__m128i b[BLOCK_SIZE_16];
+
+	for (int i = 0; i < BLOCK_SIZE_16; i++)
+	{
+		a[i] = _mm_loadu_si128((const __m128i*) (source + (i * sourceStride)));
+	}
+
+	// Interleave the 16-bit pairs
+	b[0] = _mm_unpacklo_epi16(a[0], a[1]);
+	b[1] = _mm_unpackhi_epi16(a[0], a[1]);
+	b[2] = _mm_unpacklo_epi16(a[2], a[3]);
+	b[3] = _mm_unpackhi_epi16(a[2], a[3]);
+	b[4] = _mm_unpacklo_epi16(a[4], a[5]);
+	b[5] = _mm_unpackhi_epi16(a[4], a[5]);
+	b[6] = _mm_unpacklo_epi16(a[6], a[7]);
+	b[7] = _mm_unpackhi_epi16(a[6], a[7]);
+
+	// Interleave the 32-bit pairs
+	a[0] = _mm_unpacklo_epi32(b[0], b[2]);
+	a[1] = _mm_unpackhi_epi32(b[0], b[2]);
+	a[2] = _mm_unpacklo_epi32(b[1], b[3]);
+	a[3] = _mm_unpackhi_epi32(b[1], b[3]);
+	a[4] = _mm_unpacklo_epi32(b[4], b[6]);
+	a[5] = _mm_unpackhi_epi32(b[4], b[6]);
+	a[6] = _mm_unpacklo_epi32(b[5], b[7]);
+	a[7] = _mm_unpackhi_epi32(b[5], b[7]);
+
+	// Interleave the 64-bit halves
+	b[0] = _mm_unpacklo_epi64(a[0], a[4]);
+	b[1] = _mm_unpackhi_epi64(a[0], a[4]);
+	b[2] = _mm_unpacklo_epi64(a[1], a[5]);
+	b[3] = _mm_unpackhi_epi64(a[1], a[5]);
+	b[4] = _mm_unpacklo_epi64(a[2], a[6]);
+	b[5] = _mm_unpackhi_epi64(a[2], a[6]);
+	b[6] = _mm_unpacklo_epi64(a[3], a[7]);
+	b[7] = _mm_unpackhi_epi64(a[3], a[7]);
+
+	for (int i = 0; i < BLOCK_SIZE_16; i++)
+	{
+		_mm_storeu_si128((__m128i*) (destination + (i * destinationStep)),
+				isReversed ? sseReverseVector16(b[i]) : b[i]);
+	}
+}
+
+static void sseTranspose32(
+		const unsigned char* source,
+		long sourceStride,
+		unsigned char* destination,
+		long destinationStep,
+		bool isReversed)
+{
+	__m128i a0 = _mm_loadu_si128((const __m128i*) source);
+	__m128i a1 = _mm_loadu_si128((const __m128i*) (source + sourceStride));
+	__m128i a2 = _mm_loadu_si128((const __m128i*) (source + (2 * sourceStride)));
+	__m128i a3 = _mm_loadu_si128((const __m128i*) (source + (3 * sourceStride)));
+
+	__m128i b0 = _mm_unpacklo_epi32(a0, a1);
+	__m128i b1 = _mm_unpackhi_epi32(a0, a1);
+	__m128i b2 = _mm_unpacklo_epi32(a2, a3);
+	__m128i b3 = _mm_unpackhi_epi32(a2, a3);
+
+	__m128i columns[BLOCK_SIZE_32];
+	columns[0] = _mm_unpacklo_epi64(b0, b2);
+	columns[1] = _mm_unpackhi_epi64(b0, b2);
+	columns[2] = _mm_unpacklo_epi64(b1, b3);
+	columns[3] = _mm_unpackhi_epi64(b1, b3);
+
+	for (int i = 0; i < BLOCK_SIZE_32; i++)
+	{
+		_mm_storeu_si128((__m128i*) (destination + (i * destinationStep)),
+				isReversed ? sseReverseVector32(columns[i]) : columns[i]);
+	}
+}
+
+static void sseReverse16(
+		const unsigned char* source,
+		unsigned char* destination,
+		int width)
+{
+	const unsigned short* in = (const unsigned short*) source;
+	unsigned short* out = (unsigned short*) destination;
+
+	int i = 0;
+	for (; i + 8 <= width; i += 8)
+	{
+		_mm_storeu_si128((__m128i*) &out[width - 8 - i],
+				sseReverseVector16(_mm_loadu_si128((const __m128i*) &in[i])));
+	}
+
+	genericReverse<unsigned short>((const unsigned char*) &in[i],
+			destination, width - i);
+}
+
+static void sseReverse32(
+		const unsigned char* source,
+		unsigned char* destination,
+		int width)
+{
+	const unsigned int* in = (const unsigned int*) source;
+	unsigned int* out = (unsigned int*) destination;
+
+	int i = 0;
+	for (; i + 4 <= width; i += 4)
+	{
+		_mm_storeu_si128((__m128i*) &out[width - 4 - i],
+				sseReverseVector32(_mm_loadu_si128((const __m128i*) &in[i])));
+	}
+
+	genericReverse<unsigned int>((const unsigned char*) &in[i],
+			destination, width - i);
+}
+
+static const TransformKernels SSE_KERNELS =
+{
+	sseTranspose16,
+	sseTranspose32,
+	sseReverse16,
+	sseReverse32
+};
+
+#endif
+
+/**
+ * Selects the kernels based on the CPU features.
+ */
+static const TransformKernels* selectKernels()
+{
+	const TransformKernels* kernels = &GENERIC_KERNELS;
+
+#ifdef __ARM_NEON__
+	// Get the CPU family
+	AndroidCpuFamily cpuFamily = android_getCpuFamily();
+
+	// Get the CPU features
+	uint64_t cpuFeatures = android_getCpuFeatures();
+
+	// Use NEON optimized kernels only on ARM CPUs with NEON support
+	if ((ANDROID_CPU_FAMILY_ARM == cpuFamily)
+			&& ((ANDROID_CPU_ARM_FEATURE_NEON & cpuFeatures) != 0))
+	{
+		kernels = &NEON_KERNELS;
+	}
+#endif
+
+#ifdef __SSE2__
+	kernels = &SSE_KERNELS;
+#endif
+
+	return kernels;
+}
+
+/**
+ * Copies a single pixel.
+ */
+static inline void copyPixel(
+		const unsigned char* source,
+		unsigned char* destination,
+		int bytesPerPixel)
+{
+	if (2 == bytesPerPixel)
+	{
+		*((unsigned short*) destination) = *((const unsigned short*) source);
+	}
+	else
+	{
+		*((unsigned int*) destination) = *((const unsigned int*) source);
+	}
+}
+
+/**
+ * Rotates the frame by 90 degrees clockwise or counter
+ * clockwise. Source pixel (x, y) goes to destination row
+ * x and column height - 1 - y when clockwise, otherwise
+ * to destination row width - 1 - x and column y.
+ */
+static void rotateFrame(
+		const TransformKernels* kernels,
+		bool isClockwise,
+		int bytesPerPixel,
+		const unsigned char* source,
+		int width,
+		int height,
+		long sourceStride,
+		unsigned char* destination,
+		long destinationStride)
+{
+	TransposeKernel transpose;
+	int blockSize;
+
+	if (2 == bytesPerPixel)
+	{
+		transpose = kernels->transpose16;
+		blockSize = BLOCK_SIZE_16;
+	}
+	else
+	{
+		transpose = kernels->transpose32;
+		blockSize = BLOCK_SIZE_32;
+	}
+
+	// Area covered by the whole blocks
+	int blockWidth = width - (width % blockSize);
+	int blockHeight = height - (height % blockSize);
+
+	// Destination row step for the consecutive source columns
+	long step = isClockwise ? destinationStride : -destinationStride;
+
+	// Walk the blocks tile by tile
+	for (int tileY = 0; tileY < blockHeight; tileY += TILE_SIZE)
+	{
+		int tileHeight = blockHeight - tileY;
+		if (tileHeight > TILE_SIZE)
+		{
+			tileHeight = TILE_SIZE;
+		}
+
+		for (int tileX = 0; tileX < blockWidth; tileX += TILE_SIZE)
+		{
+			int tileWidth = blockWidth - tileX;
+			if (tileWidth > TILE_SIZE)
+			{
+				tileWidth = TILE_SIZE;
+			}
+
+			for (int y = tileY; y < tileY + tileHeight; y += blockSize)
+			{
+				const unsigned char* in = source + (y * sourceStride)
+						+ (tileX * bytesPerPixel);
+
+				for (int x = tileX; x < tileX + tileWidth; x += blockSize)
+				{
+					unsigned char* out;
+
+					if (isClockwise)
+					{
+						out = destination + (x * destinationStride)
+								+ ((height - blockSize - y) * bytesPerPixel);
+					}
+					else
+					{
+						out = destination + ((width - 1 - x) * destinationStride)
+								+ (y * bytesPerPixel);
+					}
+
+					transpose(in, sourceStride, out, step, isClockwise);
+					in += blockSize * bytesPerPixel;
+				}
+			}
+		}
+	}
+
+	// Remaining pixels at the right and the bottom edges
+	for (int y = 0; y < height; y++)
+	{
+		const unsigned char* in = source + (y * sourceStride);
+		int x = (y < blockHeight) ? blockWidth : 0;
+
+		for (; x < width; x++)
+		{
+			unsigned char* out;
+
+			if (isClockwise)
+			{
+				out = destination + (x * destinationStride)
+						+ ((height - 1 - y) * bytesPerPixel);
+			}
+			else
+			{
+				out = destination + ((width - 1 - x) * destinationStride)
+						+ (y * bytesPerPixel);
+			}
+
+			copyPixel(in + (x * bytesPerPixel), out, bytesPerPixel);
+		}
+	}
+}
+
+bool isValidTransform(
+		int transform)
+{
+	return (FRAME_TRANSFORM_NONE <= transform)
+			&& (FRAME_TRANSFORM_MIRROR_VERTICAL >= transform);
+}
+
+void getTransformedSize(
+		int transform,
+		int width,
+		int height,
+		int* transformedWidth,
+		int* transformedHeight)
+{
+	if ((FRAME_TRANSFORM_ROTATE_90 == transform)
+			|| (FRAME_TRANSFORM_ROTATE_270 == transform))
+	{
+		*transformedWidth = height;
+		*transformedHeight = width;
+	}
+	else
+	{
+		*transformedWidth = width;
+		*transformedHeight = height;
+	}
+}
+
+void transformFrame(
+		int transform,
+		int format,
+		const void* source,
+		int width,
+		int height,
+		long sourceStride,
+		void* destination,
+		long destinationStride)
+{
+	const unsigned char* in = (const unsigned char*) source;
+	unsigned char* out = (unsigned char*) destination;
+
+	int bytesPerPixel = getBytesPerPixel(format);
+	if ((2 != bytesPerPixel) && (4 != bytesPerPixel))
+	{
+		return;
+	}
+
+	const TransformKernels* kernels = selectKernels();
+	ReverseKernel reverse = (2 == bytesPerPixel)
+			? kernels->reverse16 : kernels->reverse32;
+
+	switch (transform)
+	{
+	case FRAME_TRANSFORM_ROTATE_90:
+	case FRAME_TRANSFORM_ROTATE_270:
+		rotateFrame(kernels,
+				(FRAME_TRANSFORM_ROTATE_90 == transform),
+				bytesPerPixel,
+				in,
+				width,
+				height,
+				sourceStride,
+				out,
+				destinationStride);
+		break;
+
+	case FRAME_TRANSFORM_ROTATE_180:
+		for (int y = 0; y < height; y++)
+		{
+			reverse(in + (y * sourceStride),
+					out + ((height - 1 - y) * destinationStride),
+					width);
+		}
+		break;
+
+	case FRAME_TRANSFORM_MIRROR_HORIZONTAL:
+		for (int y = 0; y < height; y++)
+		{
+			reverse(in + (y * sourceStride),
+					out + (y * destinationStride),
+					width);
+		}
+		break;
+
+	case FRAME_TRANSFORM_MIRROR_VERTICAL:
+		for (int y = 0; y < height; y++)
+		{
+			memcpy(out + ((height - 1 - y) * destinationStride),
+					in + (y * sourceStride),
+					width * bytesPerPixel);
+		}
+		break;
+
+	default:
+		for (int y = 0; y < height; y++)
+		{
+			memcpy(out + (y * destinationStride),
+					in + (y * sourceStride),
+					width * bytesPerPixel);
+		}
+		break;
+	}
+}
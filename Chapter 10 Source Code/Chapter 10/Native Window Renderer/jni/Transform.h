@@ -0,0 +1,66 @@
+#pragma once
+
+/**
+ * Frame transforms. The values are shared with the
+ * AbstractPlayerActivity constants.
+ */
+enum FrameTransform
+{
+	FRAME_TRANSFORM_NONE = 0,
+	FRAME_TRANSFORM_ROTATE_90 = 1,
+	FRAME_TRANSFORM_ROTATE_180 = 2,
+	FRAME_TRANSFORM_ROTATE_270 = 3,
+	FRAME_TRANSFORM_MIRROR_HORIZONTAL = 4,
+	FRAME_TRANSFORM_MIRROR_VERTICAL = 5
+};
+
+/**
+ * Checks if the given value is a known frame transform.
+ *
+ * @param transform frame transform.
+ * @return true if known, false otherwise.
+ */
+bool isValidTransform(
+		int transform);
+
+/**
+ * Gets the frame size after the given transform. Rotating
+ * by 90 or 270 degrees swaps the width and the height.
+ *
+ * @param transform frame transform.
+ * @param width frame width in pixels.
+ * @param height frame height in pixels.
+ * @param transformedWidth transformed width in pixels.
+ * @param transformedHeight transformed height in pixels.
+ */
+void getTransformedSize(
+		int transform,
+		int width,
+		int height,
+		int* transformedWidth,
+		int* transformedHeight);
+
+/**
+ * Transforms the source frame into the destination frame.
+ * Rotations are done in cache sized tiles, the tiles are
+ * transposed in SIMD registers where available. The
+ * source and the destination must not overlap.
+ *
+ * @param transform frame transform.
+ * @param format pixel format, RGB565 or RGBA8888.
+ * @param source source pixels.
+ * @param width source width in pixels.
+ * @param height source height in pixels.
+ * @param sourceStride source row stride in bytes.
+ * @param destination destination pixels.
+ * @param destinationStride destination row stride in bytes.
+ */
+void transformFrame(
+		int transform,
+		int format,
+		const void* source,
+		int width,
+		int height,
+		long sourceStride,
+		void* destination,
+		long destinationStride);
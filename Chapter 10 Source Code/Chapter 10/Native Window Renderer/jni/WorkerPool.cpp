@@ -0,0 +1,206 @@
+#include "WorkerPool.h"
+
+#include <pthread.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+struct WorkerPool
+{
+	pthread_t threads[MAX_WORKER_THREADS];
+	int threadCount;
+
+	// Current run
+	WorkerTask task;
+	void* context;
+	int taskCount;
+	int nextTask;
+
+	// Worker thread signaling
+	pthread_mutex_t mutex;
+	pthread_cond_t runCondition;
+	pthread_cond_t doneCondition;
+	unsigned int runCount;
+	int busyCount;
+	bool isStopping;
+};
+
+/**
+ * Takes tasks until there are none left.
+ */
+static void runTasks(
+		WorkerPool* pool)
+{
+	while (true)
+	{
+		int index = __sync_fetch_and_add(&pool->nextTask, 1);
+		if (index >= pool->taskCount)
+		{
+			break;
+		}
+
+		pool->task(pool->context, index);
+	}
+}
+
+/**
+ * Worker thread, joins each run.
+ */
+static void* workerThread(
+		void* data)
+{
+	WorkerPool* pool = (WorkerPool*) data;
+	unsigned int runCount = 0;
+
+	pthread_mutex_lock(&pool->mutex);
+
+	while (true)
+	{
+		// Wait for the next run
+		while (!pool->isStopping && (runCount == pool->runCount))
+		{
+			pthread_cond_wait(&pool->runCondition, &pool->mutex);
+		}
+
+		if (pool->isStopping)
+		{
+			break;
+		}
+
+		runCount = pool->runCount;
+		pthread_mutex_unlock(&pool->mutex);
+
+		runTasks(pool);
+
+		pthread_mutex_lock(&pool->mutex);
+		if (0 == --pool->busyCount)
+		{
+			pthread_cond_signal(&pool->doneCondition);
+		}
+	}
+
+	pthread_mutex_unlock(&pool->mutex);
+
+	return 0;
+}
+
+int getCpuCount(
+		int maxCount)
+{
+	int count = sysconf(_SC_NPROCESSORS_ONLN);
+
+	if (maxCount < count)
+	{
+		count = maxCount;
+	}
+	else if (1 > count)
+	{
+		count = 1;
+	}
+
+	return count;
+}
+
+WorkerPool* createWorkerPool(
+		int threadCount)
+{
+	WorkerPool* pool = (WorkerPool*) calloc(1, sizeof(WorkerPool));
+	if (0 == pool)
+	{
+		goto exit;
+	}
+
+	if (MAX_WORKER_THREADS < threadCount)
+	{
+		threadCount = MAX_WORKER_THREADS;
+	}
+
+	pthread_mutex_init(&pool->mutex, 0);
+	pthread_cond_init(&pool->runCondition, 0);
+	pthread_cond_init(&pool->doneCondition, 0);
+
+	// Calling thread is the first one
+	pool->threadCount = 1;
+
+	while (pool->threadCount < threadCount)
+	{
+		if (0 != pthread_create(&pool->threads[pool->threadCount], 0,
+				workerThread, pool))
+		{
+			destroyWorkerPool(pool);
+			pool = 0;
+			goto exit;
+		}
+
+		pool->threadCount++;
+	}
+
+exit:
+	return pool;
+}
+
+void destroyWorkerPool(
+		WorkerPool* pool)
+{
+	if (0 == pool)
+	{
+		return;
+	}
+
+	// Stop the worker threads
+	pthread_mutex_lock(&pool->mutex);
+	pool->isStopping = true;
+	pthread_cond_broadcast(&pool->runCondition);
+	pthread_mutex_unlock(&pool->mutex);
+
+	for (int i = 1; i < pool->threadCount; i++)
+	{
+		pthread_join(pool->threads[i], 0);
+	}
+
+	pthread_cond_destroy(&pool->doneCondition);
+	pthread_cond_destroy(&pool->runCondition);
+	pthread_mutex_destroy(&pool->mutex);
+
+	free(pool);
+}
+
+int getWorkerThreadCount(
+		const WorkerPool* pool)
+{
+	return pool->threadCount;
+}
+
+void runWorkerTasks(
+		WorkerPool* pool,
+		WorkerTask task,
+		void* context,
+		int taskCount)
+{
+	pool->task = task;
+	pool->context = context;
+	pool->taskCount = taskCount;
+	pool->nextTask = 0;
+
+	// Single tasks are not worth waking the threads
+	if ((1 == pool->threadCount) || (1 >= taskCount))
+	{
+		runTasks(pool);
+		return;
+	}
+
+	pthread_mutex_lock(&pool->mutex);
+	pool->busyCount = pool->threadCount - 1;
+	pool->runCount++;
+	pthread_cond_broadcast(&pool->runCondition);
+	pthread_mutex_unlock(&pool->mutex);
+
+	runTasks(pool);
+
+	// Wait for the worker threads
+	pthread_mutex_lock(&pool->mutex);
+	while (0 != pool->busyCount)
+	{
+		pthread_cond_wait(&pool->doneCondition, &pool->mutex);
+	}
+	pthread_mutex_unlock(&pool->mutex);
+}
@@ -0,0 +1,78 @@
+#pragma once
+
+/**
+ * Maximum number of threads in a worker pool. Tools that
+ * run on build hosts define a higher limit.
+ */
+#ifndef MAX_WORKER_THREADS
+#define MAX_WORKER_THREADS 8
+#endif
+
+/**
+ * Worker task. Gets called once for each task index, on
+ * any of the pool threads.
+ *
+ * @param context task context.
+ * @param index task index.
+ */
+typedef void (*WorkerTask)(void* context, int index);
+
+/**
+ * Worker pool. The calling thread takes tasks too, so a
+ * pool of one thread runs everything in place.
+ */
+struct WorkerPool;
+
+/**
+ * Gets the number of online CPUs, limited to the given
+ * maximum.
+ *
+ * @param maxCount maximum count.
+ * @return CPU count, at least 1.
+ */
+int getCpuCount(
+		int maxCount);
+
+/**
+ * Creates a new worker pool.
+ *
+ * @param threadCount number of threads including the
+ * calling thread.
+ * @return worker pool or 0 on failure.
+ */
+WorkerPool* createWorkerPool(
+		int threadCount);
+
+/**
+ * Destroys the given worker pool, after its threads end.
+ *
+ * @param pool worker pool.
+ */
+void destroyWorkerPool(
+		WorkerPool* pool);
+
+/**
+ * Gets the number of threads in the pool, including the
+ * calling thread.
+ *
+ * @param pool worker pool.
+ * @return thread count.
+ */
+int getWorkerThreadCount(
+		const WorkerPool* pool);
+
+/**
+ * Runs the given number of tasks on the pool threads and
+ * waits for all of them. Tasks are taken in index order,
+ * one at a time, so uneven tasks balance out.
+ *
+ * @param pool worker pool.
+ * @param task worker task.
+ * @param context task context.
+ * @param taskCount number of tasks.
+ */
+void runWorkerTasks(
+		WorkerPool* pool,
+		WorkerTask task,
+		void* context,
+		int taskCount);
@@ -0,0 +1,507 @@
+#include "YuvConverter.h"
+
+#include "FrameFormat.h"
+#include "PixelFormat.h"
+
+#ifdef __ARM_NEON__
+
+#include <cpu-features.h>
+
+#include <arm_neon.h>
+
+#endif
+
+#ifdef __SSE2__
+
+#include <emmintrin.h>
+
+#endif
+
+// Pixel pairs converted at a time by the SIMD kernels
+#define BLOCK_PAIRS 8
+
+/**
+ * Color matrix coefficients in 10.6 fixed point. Small
+ * enough for 16-bit lanes, and more precise than RGB565.
+ */
+struct ColorCoefficients
+{
+	short yOffset;
+	short y;
+	short vr;
+	short ug;
+	short vg;
+	short ub;
+};
+
+static const ColorCoefficients COLOR_COEFFICIENTS[] =
+{
+	// BT.601
+	{ 16, 75, 102, 25, 52, 129 },
+
+	// BT.709
+	{ 16, 75, 115, 14, 34, 135 },
+
+	// JFIF, full range BT.601
+	{ 0, 64, 90, 22, 46, 113 }
+};
+
+/**
+ * Row conversion kernel. Converts the given number of
+ * pixel pairs.
+ */
+typedef void (*YuvKernel)(
+		int format,
+		const ColorCoefficients& coefficients,
+		const unsigned char* y,
+		const unsigned char* u,
+		const unsigned char* v,
+		void* destination,
+		int pixelFormat,
+		int pairs);
+
+/**
+ * Scales down and clamps a color component.
+ */
+static inline unsigned int clampColor(
+		int value)
+{
+	value >>= 6;
+
+	return (value < 0) ? 0 : ((value > 255) ? 255 : value);
+}
+
+/**
+ * Stores a pixel in the given pixel format.
+ */
+static inline void storePixel(
+		void* destination,
+		int pixelFormat,
+		int x,
+		unsigned int r,
+		unsigned int g,
+		unsigned int b)
+{
+	if (PIXEL_FORMAT_RGB_565 == pixelFormat)
+	{
+		((unsigned short*) destination)[x] =
+				((r & 0xF8) << 8) | ((g & 0xFC) << 3) | (b >> 3);
+	}
+	else
+	{
+		((unsigned int*) destination)[x] =
+				0xFF000000 | r | (g << 8) | (b << 16);
+	}
+}
+
+/**
+ * Generic YUV kernel, starting with the given pixel pair.
+ */
+static void genericConvertYuv(
+		int format,
+		const ColorCoefficients& coefficients,
+		const unsigned char* y,
+		const unsigned char* u,
+		const unsigned char* v,
+		void* destination,
+		int pixelFormat,
+		int first,
+		int pairs)
+{
+	for (int i = first; i < pairs; i++)
+	{
+		int y0, y1, cu, cv;
+
+		switch (format)
+		{
+		case FRAME_FORMAT_YUY2:
+			y0 = y[4 * i];
+			cu = y[(4 * i) + 1];
+			y1 = y[(4 * i) + 2];
+			cv = y[(4 * i) + 3];
+			break;
+
+		case FRAME_FORMAT_NV12:
+			y0 = y[2 * i];
+			y1 = y[(2 * i) + 1];
+			cu = u[2 * i];
+			cv = u[(2 * i) + 1];
+			break;
+
+		default:
+			y0 = y[2 * i];
+			y1 = y[(2 * i) + 1];
+			cu = u[i];
+			cv = v[i];
+			break;
+		}
+
+		cu -= 128;
+		cv -= 128;
+
+		// Chroma terms are shared by the pair
+		int vr = coefficients.vr * cv;
+		int uvg = (coefficients.ug * cu) + (coefficients.vg * cv);
+		int ub = coefficients.ub * cu;
+
+		int yt = ((y0 - coefficients.yOffset) * coefficients.y) + 32;
+		storePixel(destination, pixelFormat, 2 * i,
+				clampColor(yt + vr),
+				clampColor(yt - uvg),
+				clampColor(yt + ub));
+
+		yt = ((y1 - coefficients.yOffset) * coefficients.y) + 32;
+		storePixel(destination, pixelFormat, (2 * i) + 1,
+				clampColor(yt + vr),
+				clampColor(yt - uvg),
+				clampColor(yt + ub));
+	}
+}
+
+static void genericYuvKernel(
+		int format,
+		const ColorCoefficients& coefficients,
+		const unsigned char* y,
+		const unsigned char* u,
+		const unsigned char* v,
+		void* destination,
+		int pixelFormat,
+		int pairs)
+{
+	genericConvertYuv(format, coefficients, y, u, v,
+			destination, pixelFormat, 0, pairs);
+}
+
+#ifdef __ARM_NEON__
+/**
+ * Converts the even or the odd pixels of a block.
+ */
+static inline void neonYuvToRgb(
+		uint8x8_t y,
+		int16x8_t vr,
+		int16x8_t uvg,
+		int16x8_t ub,
+		const ColorCoefficients& coefficients,
+		uint8x8_t& r,
+		uint8x8_t& g,
+		uint8x8_t& b)
+{
+	int16x8_t yt = vaddq_s16(
+			vmulq_s16(vsubq_s16(vreinterpretq_s16_u16(vmovl_u8(y)),
+					vdupq_n_s16(coefficients.yOffset)),
+					vdupq_n_s16(coefficients.y)),
+			vdupq_n_s16(32));
+
+	// Saturating, blue can go over the 16-bit range
+	r = vqmovun_s16(vshrq_n_s16(vqaddq_s16(yt, vr), 6));
+	g = vqmovun_s16(vshrq_n_s16(vqsubq_s16(yt, uvg), 6));
+	b = vqmovun_s16(vshrq_n_s16(vqaddq_s16(yt, ub), 6));
+}
+
+/**
+ * NEON YUV kernel, 8 pixel pairs at a time.
+ */
+static void neonYuvKernel(
+		int format,
+		const ColorCoefficients& coefficients,
+		const unsigned char* y,
+		const unsigned char* u,
+		const unsigned char* v,
+		void* destination,
+		int pixelFormat,
+		int pairs)
+{
+	int i = 0;
+
+	for (; i + BLOCK_PAIRS <= pairs; i += BLOCK_PAIRS)
+	{
+		uint8x8_t yEven, yOdd, cu, cv;
+
+		// Split into even and odd luma and the chroma
+		if (FRAME_FORMAT_YUY2 == format)
+		{
+			uint8x8x4_t yuyv = vld4_u8(y + (4 * i));
+			yEven = yuyv.val[0];
+			cu = yuyv.val[1];
+			yOdd = yuyv.val[2];
+			cv = yuyv.val[3];
+		}
+		else
+		{
+			uint8x8x2_t luma = vld2_u8(y + (2 * i));
+			yEven = luma.val[0];
+			yOdd = luma.val[1];
+
+			if (FRAME_FORMAT_NV12 == format)
+			{
+				uint8x8x2_t chroma = vld2_u8(u + (2 * i));
+				cu = chroma.val[0];
+				cv = chroma.val[1];
+			}
+			else
+			{
+				cu = vld1_u8(u + i);
+				cv = vld1_u8(v + i);
+			}
+		}
+
+		int16x8_t u16 = vsubq_s16(vreinterpretq_s16_u16(vmovl_u8(cu)),
+				vdupq_n_s16(128));
+		int16x8_t v16 = vsubq_s16(vreinterpretq_s16_u16(vmovl_u8(cv)),
+				vdupq_n_s16(128));
+
+		int16x8_t vr = vmulq_s16(v16, vdupq_n_s16(coefficients.vr));
+		int16x8_t uvg = vaddq_s16(
+				vmulq_s16(u16, vdupq_n_s16(coefficients.ug)),
+				vmulq_s16(v16, vdupq_n_s16(coefficients.vg)));
+		int16x8_t ub = vmulq_s16(u16, vdupq_n_s16(coefficients.ub));
+
+		uint8x8_t rEven, gEven, bEven, rOdd, gOdd, bOdd;
+		neonYuvToRgb(yEven, vr, uvg, ub, coefficients, rEven, gEven, bEven);
+		neonYuvToRgb(yOdd, vr, uvg, ub, coefficients, rOdd, gOdd, bOdd);
+
+		// Back to the pixel order
+		uint8x8x2_t r = vzip_u8(rEven, rOdd);
+		uint8x8x2_t g = vzip_u8(gEven, gOdd);
+		uint8x8x2_t b = vzip_u8(bEven, bOdd);
+
+		for (int half = 0; half < 2; half++)
+		{
+			int x = (2 * i) + (8 * half);
+
+			if (PIXEL_FORMAT_RGB_565 == pixelFormat)
+			{
+				uint16x8_t rgb = vorrq_u16(
+						vorrq_u16(vshll_n_u8(vand_u8(r.val[half], vdup_n_u8(0xF8)), 8),
+								vshll_n_u8(vand_u8(g.val[half], vdup_n_u8(0xFC)), 3)),
+						vmovl_u8(vshr_n_u8(b.val[half], 3)));
+
+				vst1q_u16(((unsigned short*) destination) + x, rgb);
+			}
+			else
+			{
+				uint8x8x4_t rgba;
+				rgba.val[0] = r.val[half];
+				rgba.val[1] = g.val[half];
+				rgba.val[2] = b.val[half];
+				rgba.val[3] = vdup_n_u8(0xFF);
+
+				vst4_u8(((unsigned char*) destination) + (4 * x), rgba);
+			}
+		}
+	}
+
+	// Remaining pairs
+	genericConvertYuv(format, coefficients, y, u, v,
+			destination, pixelFormat, i, pairs);
+}
+#endif
+
+#ifdef __SSE2__
+/**
+ * Converts the even or the odd pixels of a block.
+ */
+static inline void sseYuvToRgb(
+		__m128i y,
+		__m128i vr,
+		__m128i uvg,
+		__m128i ub,
+		const ColorCoefficients& coefficients,
+		__m128i& r,
+		__m128i& g,
+		__m128i& b)
+{
+	__m128i yt = _mm_add_epi16(
+			_mm_mullo_epi16(_mm_sub_epi16(y, _mm_set1_epi16(coefficients.yOffset)),
+					_mm_set1_epi16(coefficients.y)),
+			_mm_set1_epi16(32));
+
+	// Saturating, blue can go over the 16-bit range
+	r = _mm_srai_epi16(_mm_adds_epi16(yt, vr), 6);
+	g = _mm_srai_epi16(_mm_subs_epi16(yt, uvg), 6);
+	b = _mm_srai_epi16(_mm_adds_epi16(yt, ub), 6);
+}
+
+/**
+ * Interleaves the even and odd components back to the
+ * pixel order, clamped to bytes.
+ */
+static inline __m128i sseInterleave(
+		__m128i even,
+		__m128i odd)
+{
+	return _mm_packus_epi16(_mm_unpacklo_epi16(even, odd),
+			_mm_unpackhi_epi16(even, odd));
+}
+
+/**
+ * SSE YUV kernel, 8 pixel pairs at a time.
+ */
+static void sseYuvKernel(
+		int format,
+		const ColorCoefficients& coefficients,
+		const unsigned char* y,
+		const unsigned char* u,
+		const unsigned char* v,
+		void* destination,
+		int pixelFormat,
+		int pairs)
+{
+	int i = 0;
+
+	const __m128i zero = _mm_setzero_si128();
+	const __m128i byteMask16 = _mm_set1_epi16(0xFF);
+	const __m128i byteMask32 = _mm_set1_epi32(0xFF);
+
+	for (; i + BLOCK_PAIRS <= pairs; i += BLOCK_PAIRS)
+	{
+		__m128i yEven, yOdd, cu, cv;
+
+		// Split into even and odd luma and the chroma, 16-bit each
+		if (FRAME_FORMAT_YUY2 == format)
+		{
+			__m128i low = _mm_loadu_si128((const __m128i*) (y + (4 * i)));
+			__m128i high = _mm_loadu_si128((const __m128i*) (y + (4 * i) + 16));
+
+			yEven = _mm_packs_epi32(_mm_and_si128(low, byteMask32),
+					_mm_and_si128(high, byteMask32));
+			cu = _mm_packs_epi32(_mm_and_si128(_mm_srli_epi32(low, 8), byteMask32),
+					_mm_and_si128(_mm_srli_epi32(high, 8), byteMask32));
+			yOdd = _mm_packs_epi32(_mm_and_si128(_mm_srli_epi32(low, 16), byteMask32),
+					_mm_and_si128(_mm_srli_epi32(high, 16), byteMask32));
+			cv = _mm_packs_epi32(_mm_srli_epi32(low, 24),
+					_mm_srli_epi32(high, 24));
+		}
+		else
+		{
+			__m128i luma = _mm_loadu_si128((const __m128i*) (y + (2 * i)));
+			yEven = _mm_and_si128(luma, byteMask16);
+			yOdd = _mm_srli_epi16(luma, 8);
+
+			if (FRAME_FORMAT_NV12 == format)
+			{
+				__m128i chroma = _mm_loadu_si128((const __m128i*) (u + (2 * i)));
+				cu = _mm_and_si128(chroma, byteMask16);
+				cv = _mm_srli_epi16(chroma, 8);
+			}
+			else
+			{
+				cu = _mm_unpacklo_epi8(
+						_mm_loadl_epi64((const __m128i*) (u + i)), zero);
+				cv = _mm_unpacklo_epi8(
+						_mm_loadl_epi64((const __m128i*) (v + i)), zero);
+			}
+		}
+
+		cu = _mm_sub_epi16(cu, _mm_set1_epi16(128));
+		cv = _mm_sub_epi16(cv, _mm_set1_epi16(128));
+
+		__m128i vr = _mm_mullo_epi16(cv, _mm_set1_epi16(coefficients.vr));
+		__m128i uvg = _mm_add_epi16(
+				_mm_mullo_epi16(cu, _mm_set1_epi16(coefficients.ug)),
+				_mm_mullo_epi16(cv, _mm_set1_epi16(coefficients.vg)));
+		__m128i ub = _mm_mullo_epi16(cu, _mm_set1_epi16(coefficients.ub));
+
+		__m128i rEven, gEven, bEven, rOdd, gOdd, bOdd;
+		sseYuvToRgb(yEven, vr, uvg, ub, coefficients, rEven, gEven, bEven);
+		sseYuvToRgb(yOdd, vr, uvg, ub, coefficients, rOdd, gOdd, bOdd);
+
+		// 16 pixels, one byte per component
+		__m128i r = sseInterleave(rEven, rOdd);
+		__m128i g = sseInterleave(gEven, gOdd);
+		__m128i b = sseInterleave(bEven, bOdd);
+
+		if (PIXEL_FORMAT_RGB_565 == pixelFormat)
+		{
+			// Low byte is GGGBBBBB, high byte is RRRRRGGG
+			__m128i low = _mm_or_si128(
+					_mm_and_si128(_mm_slli_epi16(g, 3), _mm_set1_epi8((char) 0xE0)),
+					_mm_and_si128(_mm_srli_epi16(b, 3), _mm_set1_epi8(0x1F)));
+			__m128i high = _mm_or_si128(
+					_mm_and_si128(r, _mm_set1_epi8((char) 0xF8)),
+					_mm_and_si128(_mm_srli_epi16(g, 5), _mm_set1_epi8(0x07)));
+
+			__m128i* pixels = (__m128i*) (((unsigned short*) destination) + (2 * i));
+			_mm_storeu_si128(pixels, _mm_unpacklo_epi8(low, high));
+			_mm_storeu_si128(pixels + 1, _mm_unpackhi_epi8(low, high));
+		}
+		else
+		{
+			__m128i alpha = _mm_set1_epi8((char) 0xFF);
+			__m128i rgLow = _mm_unpacklo_epi8(r, g);
+			__m128i rgHigh = _mm_unpackhi_epi8(r, g);
+			__m128i baLow = _mm_unpacklo_epi8(b, alpha);
+			__m128i baHigh = _mm_unpackhi_epi8(b, alpha);
+
+			__m128i* pixels = (__m128i*) (((unsigned int*) destination) + (2 * i));
+			_mm_storeu_si128(pixels, _mm_unpacklo_epi16(rgLow, baLow));
+			_mm_storeu_si128(pixels + 1, _mm_unpackhi_epi16(rgLow, baLow));
+			_mm_storeu_si128(pixels + 2, _mm_unpacklo_epi16(rgHigh, baHigh));
+			_mm_storeu_si128(pixels + 3, _mm_unpackhi_epi16(rgHigh, baHigh));
+		}
+	}
+
+	// Remaining pairs
+	genericConvertYuv(format, coefficients, y, u, v,
+			destination, pixelFormat, i, pairs);
+}
+#endif
+
+/**
+ * Selects the conversion kernel for the CPU.
+ */
+static YuvKernel selectKernel()
+{
+	YuvKernel kernel = genericYuvKernel;
+
+#ifdef __ARM_NEON__
+	// Get the CPU family
+	AndroidCpuFamily cpuFamily = android_getCpuFamily();
+
+	// Get the CPU features
+	uint64_t cpuFeatures = android_getCpuFeatures();
+
+	// Use NEON optimized kernel only on ARM CPUs with NEON support
+	if ((ANDROID_CPU_FAMILY_ARM == cpuFamily)
+			&& ((ANDROID_CPU_ARM_FEATURE_NEON & cpuFeatures) != 0))
+	{
+		kernel = neonYuvKernel;
+	}
+#endif
+
+#ifdef __SSE2__
+	kernel = sseYuvKernel;
+#endif
+
+	return kernel;
+}
+
+bool isValidColorMatrix(
+		int matrix)
+{
+	return (COLOR_MATRIX_BT601 == matrix)
+			|| (COLOR_MATRIX_BT709 == matrix)
+			|| (COLOR_MATRIX_JFIF == matrix);
+}
+
+void convertYuvRow(
+		int format,
+		int matrix,
+		const unsigned char* y,
+		const unsigned char* u,
+		const unsigned char* v,
+		void* destination,
+		int pixelFormat,
+		int width)
+{
+	YuvKernel kernel = selectKernel();
+
+	kernel(format,
+			COLOR_COEFFICIENTS[matrix],
+			y,
+			u,
+			v,
+			destination,
+			pixelFormat,
+			width / 2);
+}
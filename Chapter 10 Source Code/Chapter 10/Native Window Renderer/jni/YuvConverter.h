@@ -0,0 +1,49 @@
+#pragma once
+
+/**
+ * YUV to RGB color matrices. BT.601 and BT.709 are for
+ * limited range YUV, JFIF is the full range BT.601 of
+ * JPEG. The values are shared with the
+ * AbstractPlayerActivity constants.
+ */
+enum ColorMatrix
+{
+	COLOR_MATRIX_BT601 = 0,
+	COLOR_MATRIX_BT709 = 1,
+	COLOR_MATRIX_JFIF = 2
+};
+
+/**
+ * Checks if the given color matrix is valid.
+ *
+ * @param matrix color matrix.
+ * @return true if valid.
+ */
+bool isValidColorMatrix(
+		int matrix);
+
+/**
+ * Converts a row of YUV 4:2:x pixels to RGB565 or RGBA8888.
+ * Rows are converted a pair of pixels at a time, as the
+ * pair shares the chroma samples.
+ *
+ * @param format FRAME_FORMAT_YUY2, FRAME_FORMAT_I420 or
+ * FRAME_FORMAT_NV12.
+ * @param matrix color matrix.
+ * @param y luma row, or the packed row for YUY2.
+ * @param u U row, or the interleaved UV row for NV12.
+ * @param v V row, only for I420.
+ * @param destination destination pixels.
+ * @param pixelFormat PIXEL_FORMAT_RGB_565 or
+ * PIXEL_FORMAT_RGBA_8888.
+ * @param width row width in pixels, even.
+ */
+void convertYuvRow(
+		int format,
+		int matrix,
+		const unsigned char* y,
+		const unsigned char* u,
+		const unsigned char* v,
+		void* destination,
+		int pixelFormat,
+		int width);
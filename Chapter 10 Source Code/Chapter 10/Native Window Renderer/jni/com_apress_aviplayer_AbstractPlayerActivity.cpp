@@ -2,7 +2,17 @@ extern "C" {
 #include <avilib.h>
 }
 
+#include <stdlib.h>
+#include <string.h>
+
+#include "AudioExtractor.h"
+#include "AviProbe.h"
 #include "Common.h"
+#include "FramePool.h"
+#include "Memory.h"
+#include "OpenSLAudioSink.h"
+#include "Session.h"
+#include "YuvConverter.h"
 #include "com_apress_aviplayer_AbstractPlayerActivity.h"
 
 jlong Java_com_apress_aviplayer_AbstractPlayerActivity_open(
@@ -10,7 +20,11 @@ jlong Java_com_apress_aviplayer_AbstractPlayerActivity_open(
 		jclass clazz,
 		jstring fileName)
 {
+	Session* session = 0;
 	avi_t* avi = 0;
+	SessionCacheKey cacheKey;
+	FrameFormatInfo frameFormat;
+	AudioSinkFormat audioFormat;
 
 	// Get the file name as a C string
 	const char* cFileName = env->GetStringUTFChars(fileName, 0);
@@ -19,8 +33,8 @@ jlong Java_com_apress_aviplayer_AbstractPlayerActivity_open(
 		goto exit;
 	}
 
-	// Open the AVI file
-	avi = AVI_open_input_file(cFileName, 1);
+	// Open the AVI file, or resume a recently closed one
+	avi = openCachedAvi(cFileName, &cacheKey);
 
 	// Release the file name
 	env->ReleaseStringUTFChars(fileName, cFileName);
@@ -29,10 +43,60 @@ jlong Java_com_apress_aviplayer_AbstractPlayerActivity_open(
 	if (0 == avi)
 	{
 		ThrowException(env, "java/io/IOException", AVI_strerror());
+		goto exit;
+	}
+
+	// Check if the frames can be rendered
+	if (!getFrameFormat(avi, &frameFormat))
+	{
+		ThrowException(env, "java/io/IOException", "Unsupported frame format.");
+		closeCachedAvi(avi, &cacheKey);
+		goto exit;
+	}
+
+	// Create the player session
+	session = new Session();
+	if (0 == session)
+	{
+		ThrowException(env, "java/lang/OutOfMemoryError", "session");
+		closeCachedAvi(avi, &cacheKey);
+		goto exit;
+	}
+
+	session->avi = avi;
+	session->cacheKey = cacheKey;
+	session->frameFormat = frameFormat;
+
+	// Files without the avilib index need the OpenDML one
+	if (0 == avi->video_index)
+	{
+		session->odmlIndex = openOdmlIndex(avi->fdes, &session->memory);
+		if (0 == session->odmlIndex)
+		{
+			ThrowException(env, "java/io/IOException",
+					"Unable to read the OpenDML index.");
+			closeSession(session);
+			session = 0;
+			goto exit;
+		}
+	}
+
+	// Video follows the audio if it can be played
+	if (getSessionAudioFormat(session, &audioFormat))
+	{
+		AudioSink* audioSink = createOpenSLAudioSink(audioFormat,
+				readSessionAudio,
+				session,
+				&session->memory);
+
+		if (0 != audioSink)
+		{
+			setSessionAudioSink(session, audioSink);
+		}
 	}
 
 exit:
-	return (jlong) avi;
+	return (jlong) session;
 }
 
 jint Java_com_apress_aviplayer_AbstractPlayerActivity_getWidth(
@@ -40,7 +104,18 @@ jint Java_com_apress_aviplayer_AbstractPlayerActivity_getWidth(
 		jclass clazz,
 		jlong avi)
 {
-	return AVI_video_width((avi_t*) avi);
+	Session* session = (Session*) avi;
+	int width;
+	int height;
+
+	// Transformed frame size
+	getTransformedSize(session->transform,
+			AVI_video_width(session->avi),
+			AVI_video_height(session->avi),
+			&width,
+			&height);
+
+	return width;
 }
 
 jint Java_com_apress_aviplayer_AbstractPlayerActivity_getHeight(
@@ -48,7 +123,18 @@ jint Java_com_apress_aviplayer_AbstractPlayerActivity_getHeight(
 		jclass clazz,
 		jlong avi)
 {
-	return AVI_video_height((avi_t*) avi);
+	Session* session = (Session*) avi;
+	int width;
+	int height;
+
+	// Transformed frame size
+	getTransformedSize(session->transform,
+			AVI_video_width(session->avi),
+			AVI_video_height(session->avi),
+			&width,
+			&height);
+
+	return height;
 }
 
 jdouble Java_com_apress_aviplayer_AbstractPlayerActivity_getFrameRate(
@@ -56,7 +142,466 @@ jdouble Java_com_apress_aviplayer_AbstractPlayerActivity_getFrameRate(
 		jclass clazz,
 		jlong avi)
 {
-	return AVI_frame_rate((avi_t*) avi);
+	return AVI_frame_rate(((Session*) avi)->avi);
+}
+
+jlong Java_com_apress_aviplayer_AbstractPlayerActivity_getFrameCount(
+		JNIEnv* env,
+		jclass clazz,
+		jlong avi)
+{
+	return getSessionFrameCount((Session*) avi);
+}
+
+void Java_com_apress_aviplayer_AbstractPlayerActivity_seek(
+		JNIEnv* env,
+		jclass clazz,
+		jlong avi,
+		jlong frame)
+{
+	if (!seekSession((Session*) avi, frame))
+	{
+		ThrowException(env, "java/lang/IllegalArgumentException",
+				"Frame is out of range.");
+	}
+}
+
+void Java_com_apress_aviplayer_AbstractPlayerActivity_setPlaybackRate(
+		JNIEnv* env,
+		jclass clazz,
+		jlong avi,
+		jint rate)
+{
+	if (!setSessionPlaybackRate((Session*) avi, rate))
+	{
+		ThrowException(env, "java/lang/IllegalArgumentException",
+				"Playback rate is out of range.");
+	}
+}
+
+jlong Java_com_apress_aviplayer_AbstractPlayerActivity_getFrameDelay(
+		JNIEnv* env,
+		jclass clazz,
+		jlong avi)
+{
+	return getSessionFrameDelay((Session*) avi) / 1000;
+}
+
+void Java_com_apress_aviplayer_AbstractPlayerActivity_getSyncStats(
+		JNIEnv* env,
+		jclass clazz,
+		jlong avi,
+		jlongArray stats)
+{
+	long long values[AV_SYNC_STATS];
+	jlong javaValues[AV_SYNC_STATS];
+
+	if (AV_SYNC_STATS > env->GetArrayLength(stats))
+	{
+		ThrowException(env, "java/lang/IllegalArgumentException",
+				"Stats array is too small.");
+		goto exit;
+	}
+
+	getAvSyncStats(&((Session*) avi)->avSync, values);
+
+	for (int i = 0; i < AV_SYNC_STATS; i++)
+	{
+		javaValues[i] = values[i];
+	}
+
+	env->SetLongArrayRegion(stats, 0, AV_SYNC_STATS, javaValues);
+
+exit:
+	return;
+}
+
+void Java_com_apress_aviplayer_AbstractPlayerActivity_setTransform(
+		JNIEnv* env,
+		jclass clazz,
+		jlong avi,
+		jint transform)
+{
+	if (!setSessionTransform((Session*) avi, transform))
+	{
+		ThrowException(env, "java/lang/IllegalArgumentException",
+				"Unable to set frame transform.");
+	}
+}
+
+void Java_com_apress_aviplayer_AbstractPlayerActivity_setBrightness(
+		JNIEnv* env,
+		jclass clazz,
+		jlong avi,
+		jint brightness)
+{
+	if ((0 > brightness) || (255 < brightness))
+	{
+		ThrowException(env, "java/lang/IllegalArgumentException",
+				"Brightness is out of range.");
+	}
+	else
+	{
+		// Applied band by band as the frame is read
+		((Session*) avi)->brightness = brightness;
+	}
+}
+
+void Java_com_apress_aviplayer_AbstractPlayerActivity_setDithering(
+		JNIEnv* env,
+		jclass clazz,
+		jlong avi,
+		jboolean enabled)
+{
+	Session* session = (Session*) avi;
+
+	// Reader is created again with the new setting
+	session->isDithered = (JNI_TRUE == enabled);
+	destroyFusedReader(session->fusedReader);
+	session->fusedReader = 0;
+}
+
+void Java_com_apress_aviplayer_AbstractPlayerActivity_setColorMatrix(
+		JNIEnv* env,
+		jclass clazz,
+		jlong avi,
+		jint matrix)
+{
+	Session* session = (Session*) avi;
+
+	if (!isValidColorMatrix(matrix))
+	{
+		ThrowException(env, "java/lang/IllegalArgumentException",
+				"Unknown color matrix.");
+		goto exit;
+	}
+
+	// Reader is created again with the new matrix
+	session->frameFormat.matrix = matrix;
+	destroyFusedReader(session->fusedReader);
+	session->fusedReader = 0;
+
+exit:
+	return;
+}
+
+void Java_com_apress_aviplayer_AbstractPlayerActivity_setMemoryBudget(
+		JNIEnv* env,
+		jclass clazz,
+		jlong budget)
+{
+	if (0 > budget)
+	{
+		ThrowException(env, "java/lang/IllegalArgumentException",
+				"Memory budget is negative.");
+	}
+	else
+	{
+		setMemoryBudget(budget);
+	}
+}
+
+void Java_com_apress_aviplayer_AbstractPlayerActivity_getMemoryUsage(
+		JNIEnv* env,
+		jclass clazz,
+		jlong avi,
+		jlongArray usage)
+{
+	jlong values[MEMORY_SUBSYSTEMS];
+
+	if (MEMORY_SUBSYSTEMS > env->GetArrayLength(usage))
+	{
+		ThrowException(env, "java/lang/IllegalArgumentException",
+				"Usage array is too small.");
+		goto exit;
+	}
+
+	// Session or global usage
+	for (int i = 0; i < MEMORY_SUBSYSTEMS; i++)
+	{
+		values[i] = getMemoryUsage(
+				(0 == avi) ? 0 : &((Session*) avi)->memory,
+				i);
+	}
+
+	env->SetLongArrayRegion(usage, 0, MEMORY_SUBSYSTEMS, values);
+
+exit:
+	return;
+}
+
+void Java_com_apress_aviplayer_AbstractPlayerActivity_trimMemory(
+		JNIEnv* env,
+		jclass clazz)
+{
+	// Drop the idle frame buffers and AVI files
+	trimFramePool();
+	trimSessionCache();
+}
+
+void Java_com_apress_aviplayer_AbstractPlayerActivity_setSessionCacheGracePeriod(
+		JNIEnv* env,
+		jclass clazz,
+		jlong gracePeriod)
+{
+	setSessionCacheGracePeriod(gracePeriod);
+}
+
+void Java_com_apress_aviplayer_AbstractPlayerActivity_setIndexRepair(
+		JNIEnv* env,
+		jclass clazz,
+		jboolean enabled)
+{
+	setIndexRepairEnabled(JNI_TRUE == enabled);
+}
+
+jlong Java_com_apress_aviplayer_AbstractPlayerActivity_extractAudio(
+		JNIEnv* env,
+		jclass clazz,
+		jstring fileName,
+		jstring wavFileName)
+{
+	jlong extractedSize = -1;
+	const char* cWavFileName = 0;
+	const char* errorMessage = 0;
+
+	// Get the file names as C strings
+	const char* cFileName = env->GetStringUTFChars(fileName, 0);
+	if (0 == cFileName)
+	{
+		goto exit;
+	}
+
+	cWavFileName = env->GetStringUTFChars(wavFileName, 0);
+	if (0 == cWavFileName)
+	{
+		env->ReleaseStringUTFChars(fileName, cFileName);
+		goto exit;
+	}
+
+	// Stream the audio track into the WAV file
+	extractedSize = extractAudio(cFileName, cWavFileName, &errorMessage);
+
+	// Release the file names
+	env->ReleaseStringUTFChars(wavFileName, cWavFileName);
+	env->ReleaseStringUTFChars(fileName, cFileName);
+
+	if (0 > extractedSize)
+	{
+		ThrowException(env, "java/io/IOException", errorMessage);
+	}
+
+exit:
+	return extractedSize;
+}
+
+void Java_com_apress_aviplayer_AbstractPlayerActivity_probe(
+		JNIEnv* env,
+		jclass clazz,
+		jstring fileName,
+		jlongArray info)
+{
+	long long values[PROBE_INFO_SIZE];
+	jlong javaValues[PROBE_INFO_SIZE];
+	const char* cFileName = 0;
+	bool isProbed;
+
+	if (PROBE_INFO_SIZE > env->GetArrayLength(info))
+	{
+		ThrowException(env, "java/lang/IllegalArgumentException",
+				"Info array is too small.");
+		goto exit;
+	}
+
+	// Get the file name as a C string
+	cFileName = env->GetStringUTFChars(fileName, 0);
+	if (0 == cFileName)
+	{
+		goto exit;
+	}
+
+	// Read only the headers
+	isProbed = probeAvi(cFileName, values);
+
+	// Release the file name
+	env->ReleaseStringUTFChars(fileName, cFileName);
+
+	if (!isProbed)
+	{
+		ThrowException(env, "java/io/IOException", "Not an AVI video file.");
+		goto exit;
+	}
+
+	for (int i = 0; i < PROBE_INFO_SIZE; i++)
+	{
+		javaValues[i] = values[i];
+	}
+
+	env->SetLongArrayRegion(info, 0, PROBE_INFO_SIZE, javaValues);
+
+exit:
+	return;
+}
+
+void Java_com_apress_aviplayer_AbstractPlayerActivity_probeFiles(
+		JNIEnv* env,
+		jclass clazz,
+		jobjectArray fileNames,
+		jlongArray info)
+{
+	int count = env->GetArrayLength(fileNames);
+	int copiedCount = 0;
+	char** cFileNames = 0;
+	long long* values = 0;
+	jlong* javaValues = 0;
+
+	if ((count * PROBE_INFO_SIZE) > env->GetArrayLength(info))
+	{
+		ThrowException(env, "java/lang/IllegalArgumentException",
+				"Info array is too small.");
+		goto exit;
+	}
+
+	cFileNames = (char**) malloc(count * sizeof(char*));
+	values = (long long*) malloc(count * PROBE_INFO_SIZE * sizeof(long long));
+	javaValues = (jlong*) malloc(count * PROBE_INFO_SIZE * sizeof(jlong));
+	if ((0 == cFileNames) || (0 == values) || (0 == javaValues))
+	{
+		ThrowException(env, "java/lang/OutOfMemoryError", "probe");
+		goto exit;
+	}
+
+	// File names are copied, the worker threads cannot use
+	// the JNI environment and a directory of them would
+	// overflow the local references
+	for (; copiedCount < count; copiedCount++)
+	{
+		jstring fileName = (jstring) env->GetObjectArrayElement(fileNames,
+				copiedCount);
+
+		const char* cFileName = env->GetStringUTFChars(fileName, 0);
+		if (0 == cFileName)
+		{
+			env->DeleteLocalRef(fileName);
+			goto exit;
+		}
+
+		cFileNames[copiedCount] = strdup(cFileName);
+
+		env->ReleaseStringUTFChars(fileName, cFileName);
+		env->DeleteLocalRef(fileName);
+
+		if (0 == cFileNames[copiedCount])
+		{
+			ThrowException(env, "java/lang/OutOfMemoryError", "probe");
+			goto exit;
+		}
+	}
+
+	// Read only the headers, on several threads
+	probeAviFiles(cFileNames, count, values);
+
+	for (int i = 0; i < count * PROBE_INFO_SIZE; i++)
+	{
+		javaValues[i] = values[i];
+	}
+
+	env->SetLongArrayRegion(info, 0, count * PROBE_INFO_SIZE, javaValues);
+
+exit:
+	if (0 != cFileNames)
+	{
+		for (int i = 0; i < copiedCount; i++)
+		{
+			free(cFileNames[i]);
+		}
+
+		free(cFileNames);
+	}
+
+	free(values);
+	free(javaValues);
+}
+
+void Java_com_apress_aviplayer_AbstractPlayerActivity_startRecording(
+		JNIEnv* env,
+		jclass clazz,
+		jlong avi,
+		jstring fileName)
+{
+	bool isStarted;
+
+	// Get the file name as a C string
+	const char* cFileName = env->GetStringUTFChars(fileName, 0);
+	if (0 == cFileName)
+	{
+		goto exit;
+	}
+
+	// Create the file and start the writer thread
+	isStarted = startSessionRecording((Session*) avi, cFileName);
+
+	// Release the file name
+	env->ReleaseStringUTFChars(fileName, cFileName);
+
+	if (!isStarted)
+	{
+		ThrowException(env, "java/io/IOException",
+				"Unable to start recording.");
+	}
+
+exit:
+	return;
+}
+
+void Java_com_apress_aviplayer_AbstractPlayerActivity_getRecordingStats(
+		JNIEnv* env,
+		jclass clazz,
+		jlong avi,
+		jlongArray stats)
+{
+	Session* session = (Session*) avi;
+	long long values[RECORDER_STATS];
+	jlong javaValues[RECORDER_STATS];
+
+	if (RECORDER_STATS > env->GetArrayLength(stats))
+	{
+		ThrowException(env, "java/lang/IllegalArgumentException",
+				"Stats array is too small.");
+		goto exit;
+	}
+
+	if (0 == session->recorder)
+	{
+		ThrowException(env, "java/lang/IllegalStateException",
+				"Not recording.");
+		goto exit;
+	}
+
+	getRecorderStats(session->recorder, values);
+
+	for (int i = 0; i < RECORDER_STATS; i++)
+	{
+		javaValues[i] = values[i];
+	}
+
+	env->SetLongArrayRegion(stats, 0, RECORDER_STATS, javaValues);
+
+exit:
+	return;
+}
+
+void Java_com_apress_aviplayer_AbstractPlayerActivity_stopRecording(
+		JNIEnv* env,
+		jclass clazz,
+		jlong avi)
+{
+	// Waits for the queued frames to be written
+	if (!stopSessionRecording((Session*) avi))
+	{
+		ThrowException(env, "java/io/IOException",
+				"Unable to write the recording.");
+	}
 }
 
 void Java_com_apress_aviplayer_AbstractPlayerActivity_close(
@@ -64,5 +609,5 @@ void Java_com_apress_aviplayer_AbstractPlayerActivity_close(
 		jclass clazz,
 		jlong avi)
 {
-	AVI_close((avi_t*) avi);
+	closeSession((Session*) avi);
 }
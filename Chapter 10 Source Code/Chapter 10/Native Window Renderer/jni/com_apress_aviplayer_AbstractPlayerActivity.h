@@ -55,6 +55,80 @@ extern "C" {
 #define com_apress_aviplayer_AbstractPlayerActivity_DEFAULT_KEYS_SEARCH_LOCAL 3L
 #undef com_apress_aviplayer_AbstractPlayerActivity_DEFAULT_KEYS_SEARCH_GLOBAL
 #define com_apress_aviplayer_AbstractPlayerActivity_DEFAULT_KEYS_SEARCH_GLOBAL 4L
+#undef com_apress_aviplayer_AbstractPlayerActivity_TRANSFORM_NONE
+#define com_apress_aviplayer_AbstractPlayerActivity_TRANSFORM_NONE 0L
+#undef com_apress_aviplayer_AbstractPlayerActivity_TRANSFORM_ROTATE_90
+#define com_apress_aviplayer_AbstractPlayerActivity_TRANSFORM_ROTATE_90 1L
+#undef com_apress_aviplayer_AbstractPlayerActivity_TRANSFORM_ROTATE_180
+#define com_apress_aviplayer_AbstractPlayerActivity_TRANSFORM_ROTATE_180 2L
+#undef com_apress_aviplayer_AbstractPlayerActivity_TRANSFORM_ROTATE_270
+#define com_apress_aviplayer_AbstractPlayerActivity_TRANSFORM_ROTATE_270 3L
+#undef com_apress_aviplayer_AbstractPlayerActivity_TRANSFORM_MIRROR_HORIZONTAL
+#define com_apress_aviplayer_AbstractPlayerActivity_TRANSFORM_MIRROR_HORIZONTAL 4L
+#undef com_apress_aviplayer_AbstractPlayerActivity_TRANSFORM_MIRROR_VERTICAL
+#define com_apress_aviplayer_AbstractPlayerActivity_TRANSFORM_MIRROR_VERTICAL 5L
+#undef com_apress_aviplayer_AbstractPlayerActivity_MEMORY_FRAMES
+#define com_apress_aviplayer_AbstractPlayerActivity_MEMORY_FRAMES 0L
+#undef com_apress_aviplayer_AbstractPlayerActivity_MEMORY_CACHES
+#define com_apress_aviplayer_AbstractPlayerActivity_MEMORY_CACHES 1L
+#undef com_apress_aviplayer_AbstractPlayerActivity_MEMORY_PREFETCH
+#define com_apress_aviplayer_AbstractPlayerActivity_MEMORY_PREFETCH 2L
+#undef com_apress_aviplayer_AbstractPlayerActivity_MEMORY_AUDIO
+#define com_apress_aviplayer_AbstractPlayerActivity_MEMORY_AUDIO 3L
+#undef com_apress_aviplayer_AbstractPlayerActivity_MEMORY_OTHER
+#define com_apress_aviplayer_AbstractPlayerActivity_MEMORY_OTHER 4L
+#undef com_apress_aviplayer_AbstractPlayerActivity_MEMORY_SUBSYSTEMS
+#define com_apress_aviplayer_AbstractPlayerActivity_MEMORY_SUBSYSTEMS 5L
+#undef com_apress_aviplayer_AbstractPlayerActivity_COLOR_MATRIX_BT601
+#define com_apress_aviplayer_AbstractPlayerActivity_COLOR_MATRIX_BT601 0L
+#undef com_apress_aviplayer_AbstractPlayerActivity_COLOR_MATRIX_BT709
+#define com_apress_aviplayer_AbstractPlayerActivity_COLOR_MATRIX_BT709 1L
+#undef com_apress_aviplayer_AbstractPlayerActivity_COLOR_MATRIX_JFIF
+#define com_apress_aviplayer_AbstractPlayerActivity_COLOR_MATRIX_JFIF 2L
+#undef com_apress_aviplayer_AbstractPlayerActivity_SYNC_SHOWN_FRAMES
+#define com_apress_aviplayer_AbstractPlayerActivity_SYNC_SHOWN_FRAMES 0L
+#undef com_apress_aviplayer_AbstractPlayerActivity_SYNC_DROPPED_FRAMES
+#define com_apress_aviplayer_AbstractPlayerActivity_SYNC_DROPPED_FRAMES 1L
+#undef com_apress_aviplayer_AbstractPlayerActivity_SYNC_REPEATED_FRAMES
+#define com_apress_aviplayer_AbstractPlayerActivity_SYNC_REPEATED_FRAMES 2L
+#undef com_apress_aviplayer_AbstractPlayerActivity_SYNC_LAST_DRIFT
+#define com_apress_aviplayer_AbstractPlayerActivity_SYNC_LAST_DRIFT 3L
+#undef com_apress_aviplayer_AbstractPlayerActivity_SYNC_MAX_DRIFT
+#define com_apress_aviplayer_AbstractPlayerActivity_SYNC_MAX_DRIFT 4L
+#undef com_apress_aviplayer_AbstractPlayerActivity_SYNC_MEAN_DRIFT
+#define com_apress_aviplayer_AbstractPlayerActivity_SYNC_MEAN_DRIFT 5L
+#undef com_apress_aviplayer_AbstractPlayerActivity_SYNC_STATS
+#define com_apress_aviplayer_AbstractPlayerActivity_SYNC_STATS 6L
+#undef com_apress_aviplayer_AbstractPlayerActivity_PROBE_WIDTH
+#define com_apress_aviplayer_AbstractPlayerActivity_PROBE_WIDTH 0L
+#undef com_apress_aviplayer_AbstractPlayerActivity_PROBE_HEIGHT
+#define com_apress_aviplayer_AbstractPlayerActivity_PROBE_HEIGHT 1L
+#undef com_apress_aviplayer_AbstractPlayerActivity_PROBE_FRAME_COUNT
+#define com_apress_aviplayer_AbstractPlayerActivity_PROBE_FRAME_COUNT 2L
+#undef com_apress_aviplayer_AbstractPlayerActivity_PROBE_DURATION
+#define com_apress_aviplayer_AbstractPlayerActivity_PROBE_DURATION 3L
+#undef com_apress_aviplayer_AbstractPlayerActivity_PROBE_COMPRESSOR
+#define com_apress_aviplayer_AbstractPlayerActivity_PROBE_COMPRESSOR 4L
+#undef com_apress_aviplayer_AbstractPlayerActivity_PROBE_AUDIO_FORMAT
+#define com_apress_aviplayer_AbstractPlayerActivity_PROBE_AUDIO_FORMAT 5L
+#undef com_apress_aviplayer_AbstractPlayerActivity_PROBE_AUDIO_CHANNELS
+#define com_apress_aviplayer_AbstractPlayerActivity_PROBE_AUDIO_CHANNELS 6L
+#undef com_apress_aviplayer_AbstractPlayerActivity_PROBE_AUDIO_RATE
+#define com_apress_aviplayer_AbstractPlayerActivity_PROBE_AUDIO_RATE 7L
+#undef com_apress_aviplayer_AbstractPlayerActivity_PROBE_AUDIO_BITS
+#define com_apress_aviplayer_AbstractPlayerActivity_PROBE_AUDIO_BITS 8L
+#undef com_apress_aviplayer_AbstractPlayerActivity_PROBE_INFO_SIZE
+#define com_apress_aviplayer_AbstractPlayerActivity_PROBE_INFO_SIZE 9L
+#undef com_apress_aviplayer_AbstractPlayerActivity_RECORDING_QUEUED_FRAMES
+#define com_apress_aviplayer_AbstractPlayerActivity_RECORDING_QUEUED_FRAMES 0L
+#undef com_apress_aviplayer_AbstractPlayerActivity_RECORDING_WRITTEN_FRAMES
+#define com_apress_aviplayer_AbstractPlayerActivity_RECORDING_WRITTEN_FRAMES 1L
+#undef com_apress_aviplayer_AbstractPlayerActivity_RECORDING_DROPPED_FRAMES
+#define com_apress_aviplayer_AbstractPlayerActivity_RECORDING_DROPPED_FRAMES 2L
+#undef com_apress_aviplayer_AbstractPlayerActivity_RECORDING_HIGH_WATER_MARK
+#define com_apress_aviplayer_AbstractPlayerActivity_RECORDING_HIGH_WATER_MARK 3L
+#undef com_apress_aviplayer_AbstractPlayerActivity_RECORDING_STATS
+#define com_apress_aviplayer_AbstractPlayerActivity_RECORDING_STATS 4L
 /*
  * Class:     com_apress_aviplayer_AbstractPlayerActivity
  * Method:    open
@@ -87,6 +161,166 @@ JNIEXPORT jint JNICALL Java_com_apress_aviplayer_AbstractPlayerActivity_getHeigh
 JNIEXPORT jdouble JNICALL Java_com_apress_aviplayer_AbstractPlayerActivity_getFrameRate
   (JNIEnv *, jclass, jlong);
 
+/*
+ * Class:     com_apress_aviplayer_AbstractPlayerActivity
+ * Method:    getFrameCount
+ * Signature: (J)J
+ */
+JNIEXPORT jlong JNICALL Java_com_apress_aviplayer_AbstractPlayerActivity_getFrameCount
+  (JNIEnv *, jclass, jlong);
+
+/*
+ * Class:     com_apress_aviplayer_AbstractPlayerActivity
+ * Method:    seek
+ * Signature: (JJ)V
+ */
+JNIEXPORT void JNICALL Java_com_apress_aviplayer_AbstractPlayerActivity_seek
+  (JNIEnv *, jclass, jlong, jlong);
+
+/*
+ * Class:     com_apress_aviplayer_AbstractPlayerActivity
+ * Method:    setPlaybackRate
+ * Signature: (JI)V
+ */
+JNIEXPORT void JNICALL Java_com_apress_aviplayer_AbstractPlayerActivity_setPlaybackRate
+  (JNIEnv *, jclass, jlong, jint);
+
+/*
+ * Class:     com_apress_aviplayer_AbstractPlayerActivity
+ * Method:    getFrameDelay
+ * Signature: (J)J
+ */
+JNIEXPORT jlong JNICALL Java_com_apress_aviplayer_AbstractPlayerActivity_getFrameDelay
+  (JNIEnv *, jclass, jlong);
+
+/*
+ * Class:     com_apress_aviplayer_AbstractPlayerActivity
+ * Method:    getSyncStats
+ * Signature: (J[J)V
+ */
+JNIEXPORT void JNICALL Java_com_apress_aviplayer_AbstractPlayerActivity_getSyncStats
+  (JNIEnv *, jclass, jlong, jlongArray);
+
+/*
+ * Class:     com_apress_aviplayer_AbstractPlayerActivity
+ * Method:    setTransform
+ * Signature: (JI)V
+ */
+JNIEXPORT void JNICALL Java_com_apress_aviplayer_AbstractPlayerActivity_setTransform
+  (JNIEnv *, jclass, jlong, jint);
+
+/*
+ * Class:     com_apress_aviplayer_AbstractPlayerActivity
+ * Method:    setBrightness
+ * Signature: (JI)V
+ */
+JNIEXPORT void JNICALL Java_com_apress_aviplayer_AbstractPlayerActivity_setBrightness
+  (JNIEnv *, jclass, jlong, jint);
+
+/*
+ * Class:     com_apress_aviplayer_AbstractPlayerActivity
+ * Method:    setDithering
+ * Signature: (JZ)V
+ */
+JNIEXPORT void JNICALL Java_com_apress_aviplayer_AbstractPlayerActivity_setDithering
+  (JNIEnv *, jclass, jlong, jboolean);
+
+/*
+ * Class:     com_apress_aviplayer_AbstractPlayerActivity
+ * Method:    setColorMatrix
+ * Signature: (JI)V
+ */
+JNIEXPORT void JNICALL Java_com_apress_aviplayer_AbstractPlayerActivity_setColorMatrix
+  (JNIEnv *, jclass, jlong, jint);
+
+/*
+ * Class:     com_apress_aviplayer_AbstractPlayerActivity
+ * Method:    setMemoryBudget
+ * Signature: (J)V
+ */
+JNIEXPORT void JNICALL Java_com_apress_aviplayer_AbstractPlayerActivity_setMemoryBudget
+  (JNIEnv *, jclass, jlong);
+
+/*
+ * Class:     com_apress_aviplayer_AbstractPlayerActivity
+ * Method:    getMemoryUsage
+ * Signature: (J[J)V
+ */
+JNIEXPORT void JNICALL Java_com_apress_aviplayer_AbstractPlayerActivity_getMemoryUsage
+  (JNIEnv *, jclass, jlong, jlongArray);
+
+/*
+ * Class:     com_apress_aviplayer_AbstractPlayerActivity
+ * Method:    trimMemory
+ * Signature: ()V
+ */
+JNIEXPORT void JNICALL Java_com_apress_aviplayer_AbstractPlayerActivity_trimMemory
+  (JNIEnv *, jclass);
+
+/*
+ * Class:     com_apress_aviplayer_AbstractPlayerActivity
+ * Method:    setSessionCacheGracePeriod
+ * Signature: (J)V
+ */
+JNIEXPORT void JNICALL Java_com_apress_aviplayer_AbstractPlayerActivity_setSessionCacheGracePeriod
+  (JNIEnv *, jclass, jlong);
+
+/*
+ * Class:     com_apress_aviplayer_AbstractPlayerActivity
+ * Method:    setIndexRepair
+ * Signature: (Z)V
+ */
+JNIEXPORT void JNICALL Java_com_apress_aviplayer_AbstractPlayerActivity_setIndexRepair
+  (JNIEnv *, jclass, jboolean);
+
+/*
+ * Class:     com_apress_aviplayer_AbstractPlayerActivity
+ * Method:    extractAudio
+ * Signature: (Ljava/lang/String;Ljava/lang/String;)J
+ */
+JNIEXPORT jlong JNICALL Java_com_apress_aviplayer_AbstractPlayerActivity_extractAudio
+  (JNIEnv *, jclass, jstring, jstring);
+
+/*
+ * Class:     com_apress_aviplayer_AbstractPlayerActivity
+ * Method:    probe
+ * Signature: (Ljava/lang/String;[J)V
+ */
+JNIEXPORT void JNICALL Java_com_apress_aviplayer_AbstractPlayerActivity_probe
+  (JNIEnv *, jclass, jstring, jlongArray);
+
+/*
+ * Class:     com_apress_aviplayer_AbstractPlayerActivity
+ * Method:    probeFiles
+ * Signature: ([Ljava/lang/String;[J)V
+ */
+JNIEXPORT void JNICALL Java_com_apress_aviplayer_AbstractPlayerActivity_probeFiles
+  (JNIEnv *, jclass, jobjectArray, jlongArray);
+
+/*
+ * Class:     com_apress_aviplayer_AbstractPlayerActivity
+ * Method:    startRecording
+ * Signature: (JLjava/lang/String;)V
+ */
+JNIEXPORT void JNICALL Java_com_apress_aviplayer_AbstractPlayerActivity_startRecording
+  (JNIEnv *, jclass, jlong, jstring);
+
+/*
+ * Class:     com_apress_aviplayer_AbstractPlayerActivity
+ * Method:    getRecordingStats
+ * Signature: (J[J)V
+ */
+JNIEXPORT void JNICALL Java_com_apress_aviplayer_AbstractPlayerActivity_getRecordingStats
+  (JNIEnv *, jclass, jlong, jlongArray);
+
+/*
+ * Class:     com_apress_aviplayer_AbstractPlayerActivity
+ * Method:    stopRecording
+ * Signature: (J)V
+ */
+JNIEXPORT void JNICALL Java_com_apress_aviplayer_AbstractPlayerActivity_stopRecording
+  (JNIEnv *, jclass, jlong);
+
 /*
  * Class:     com_apress_aviplayer_AbstractPlayerActivity
  * Method:    close
@@ -5,6 +5,7 @@ extern "C" {
 #include <android/bitmap.h>
 
 #include "Common.h"
+#include "Session.h"
 #include "com_apress_aviplayer_BitmapPlayerActivity.h"
 
 jboolean Java_com_apress_aviplayer_BitmapPlayerActivity_render(
@@ -13,11 +14,27 @@ jboolean Java_com_apress_aviplayer_BitmapPlayerActivity_render(
 		jlong avi,
 		jobject bitmap)
 {
+	Session* session = (Session*) avi;
+
 	jboolean isFrameRead = JNI_FALSE;
 
+	AndroidBitmapInfo bitmapInfo;
 	char* frameBuffer = 0;
 	long frameSize = 0;
-	int keyFrame = 0;
+
+	// Early frame, the bitmap keeps the shown one
+	if (!syncSessionFrame(session))
+	{
+		isFrameRead = JNI_TRUE;
+		goto exit;
+	}
+
+	// Get the bitmap geometry
+	if (0 > AndroidBitmap_getInfo(env, bitmap, &bitmapInfo))
+	{
+		ThrowException(env, "java/io/IOException", "Unable to get bitmap info.");
+		goto exit;
+	}
 
 	// Lock bitmap and get the raw bytes
 	if (0 > AndroidBitmap_lockPixels(env, bitmap, (void**) &frameBuffer))
@@ -26,8 +43,8 @@ jboolean Java_com_apress_aviplayer_BitmapPlayerActivity_render(
 		goto exit;
 	}
 
-	// Read AVI frame bytes to bitmap
-	frameSize = AVI_read_frame((avi_t*) avi, frameBuffer, &keyFrame);
+	// Read AVI frame to bitmap
+	frameSize = readSessionFrame(session, frameBuffer, bitmapInfo.stride);
 
 	// Unlock bitmap
 	if (0 > AndroidBitmap_unlockPixels(env, bitmap))
@@ -6,6 +6,8 @@ extern "C" {
 #include <android/native_window.h>
 
 #include "Common.h"
+#include "PixelFormat.h"
+#include "Session.h"
 #include "com_apress_aviplayer_NativeWindowPlayerActivity.h"
 
 void Java_com_apress_aviplayer_NativeWindowPlayerActivity_init(
@@ -14,6 +16,10 @@ void Java_com_apress_aviplayer_NativeWindowPlayerActivity_init(
 		jlong avi,
 		jobject surface)
 {
+	Session* session = (Session*) avi;
+	int width;
+	int height;
+
 	// Get the native window from the surface
 	ANativeWindow* nativeWindow = ANativeWindow_fromSurface(env, surface);
 	if (0 == nativeWindow)
@@ -23,12 +29,19 @@ void Java_com_apress_aviplayer_NativeWindowPlayerActivity_init(
 		goto exit;
 	}
 
-	// Set the buffers geometry to AVI movie frame dimensions
+	// Transformed frame size
+	getTransformedSize(session->transform,
+			AVI_video_width(session->avi),
+			AVI_video_height(session->avi),
+			&width,
+			&height);
+
+	// Set the buffers geometry to transformed frame dimensions
 	// If these are different than the window's physical size
 	// then the buffer will be scaled to match that size.
 	if (0 > ANativeWindow_setBuffersGeometry(nativeWindow,
-			AVI_video_width((avi_t*) avi),
-			AVI_video_height((avi_t*) avi),
+			width,
+			height,
 			WINDOW_FORMAT_RGB_565))
 	{
 		ThrowException(env, "java/io/RuntimeException",
@@ -49,13 +62,22 @@ jboolean Java_com_apress_aviplayer_NativeWindowPlayerActivity_render(
 		jlong avi,
 		jobject surface)
 {
+	Session* session = (Session*) avi;
+
 	jboolean isFrameRead = JNI_FALSE;
 
 	long frameSize = 0;
-	int keyFrame = 0;
+	ANativeWindow* nativeWindow = 0;
+
+	// Early frame, the posted one stays on the window
+	if (!syncSessionFrame(session))
+	{
+		isFrameRead = JNI_TRUE;
+		goto exit;
+	}
 
 	// Get the native window from the surface
-	ANativeWindow* nativeWindow = ANativeWindow_fromSurface(env, surface);
+	nativeWindow = ANativeWindow_fromSurface(env, surface);
 	if (0 == nativeWindow)
 	{
 		ThrowException(env, "java/io/RuntimeException",
@@ -72,10 +94,10 @@ jboolean Java_com_apress_aviplayer_NativeWindowPlayerActivity_render(
 		goto release;
 	}
 
-	// Read AVI frame bytes to raw buffer
-	frameSize = AVI_read_frame((avi_t*) avi,
-			(char*) windowBuffer.bits,
-			&keyFrame);
+	// Read AVI frame to raw buffer, stride is in pixels
+	frameSize = readSessionFrame(session,
+			windowBuffer.bits,
+			windowBuffer.stride * Rgb565Format::BYTES_PER_PIXEL);
 
 	// Check if frame is successfully read
 	if (0 < frameSize)
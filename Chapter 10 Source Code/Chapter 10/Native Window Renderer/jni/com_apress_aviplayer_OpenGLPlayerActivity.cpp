@@ -5,9 +5,9 @@ extern "C" {
 #include <GLES/gl.h>
 #include <GLES/glext.h>
 
-#include <malloc.h>
-
 #include "Common.h"
+#include "FramePool.h"
+#include "Session.h"
 #include "com_apress_aviplayer_OpenGLPlayerActivity.h"
 
 struct Instance
@@ -30,7 +30,11 @@ jlong Java_com_apress_aviplayer_OpenGLPlayerActivity_init(
 {
 	Instance* instance = 0;
 
-	long frameSize = AVI_frame_size((avi_t*) avi, 0);
+	// Frames are converted to RGB565
+	long frameSize = AVI_video_width(((Session*) avi)->avi)
+			* AVI_video_height(((Session*) avi)->avi)
+			* 2;
+
 	if (0 >= frameSize)
 	{
 		ThrowException(env, "java/io/RuntimeException",
@@ -46,10 +50,14 @@ jlong Java_com_apress_aviplayer_OpenGLPlayerActivity_init(
 		goto exit;
 	}
 
-	instance->buffer = (char*) malloc(frameSize);
+	// Pooled frame buffer, charged to the session
+	instance->buffer = (char*) acquireFrameBuffer(
+			&((Session*) avi)->memory,
+			frameSize);
+
 	if (0 == instance->buffer)
 	{
-		ThrowException(env, "java/io/RuntimeException",
+		ThrowException(env, "java/lang/OutOfMemoryError",
 				"Unable to allocate buffer.");
 		delete instance;
 		instance = 0;
@@ -76,8 +84,8 @@ void Java_com_apress_aviplayer_OpenGLPlayerActivity_initSurface(
 	// Bind to generated texture
 	glBindTexture(GL_TEXTURE_2D, instance->texture);
 
-	int frameWidth = AVI_video_width((avi_t*) avi);
-	int frameHeight = AVI_video_height((avi_t*) avi);
+	int frameWidth = AVI_video_width(((Session*) avi)->avi);
+	int frameHeight = AVI_video_height(((Session*) avi)->avi);
 
 	// Crop the texture rectangle
 	GLint rect[] = {0, frameHeight, frameWidth, -frameHeight};
@@ -107,37 +115,42 @@ jboolean Java_com_apress_aviplayer_OpenGLPlayerActivity_render(
 	Instance* instance = (Instance*) inst;
 
 	jboolean isFrameRead = JNI_FALSE;
-	int keyFrame = 0;
 
-	// Read AVI frame bytes to bitmap
-	long frameSize = AVI_read_frame((avi_t*) avi,
-			instance->buffer,
-			&keyFrame);
+	long frameSize = 0;
 
-	// Check if frame read
-	if (0 >= frameSize)
+	// Early frame, the texture keeps the shown one
+	if (syncSessionFrame((Session*) avi))
 	{
-		goto exit;
+		// Read AVI frame as RGB565 rows
+		frameSize = readSessionFrame((Session*) avi,
+				instance->buffer,
+				AVI_video_width(((Session*) avi)->avi) * 2);
+
+		// Check if frame read
+		if (0 >= frameSize)
+		{
+			goto exit;
+		}
+
+		// Update the texture with the new frame
+		glTexSubImage2D(GL_TEXTURE_2D,
+				0,
+				0,
+				0,
+				AVI_video_width(((Session*) avi)->avi),
+				AVI_video_height(((Session*) avi)->avi),
+				GL_RGB,
+				GL_UNSIGNED_SHORT_5_6_5,
+				instance->buffer);
 	}
 
-	// Frame read
+	// Frame read or repeated
 	isFrameRead = JNI_TRUE;
 
-	// Update the texture with the new frame
-	glTexSubImage2D(GL_TEXTURE_2D,
-			0,
-			0,
-			0,
-			AVI_video_width((avi_t*) avi),
-			AVI_video_height((avi_t*) avi),
-			GL_RGB,
-			GL_UNSIGNED_SHORT_5_6_5,
-			instance->buffer);
-
 	// Draw texture
 	glDrawTexiOES(0, 0, 0,
-			AVI_video_width((avi_t*) avi),
-			AVI_video_height((avi_t*) avi));
+			AVI_video_width(((Session*) avi)->avi),
+			AVI_video_height(((Session*) avi)->avi));
 
 exit:
 	return isFrameRead;
@@ -152,7 +165,7 @@ void Java_com_apress_aviplayer_OpenGLPlayerActivity_free(
 
 	if (0 != instance)
 	{
-		free(instance->buffer);
+		releaseFrameBuffer(instance->buffer);
 		delete instance;
 	}
 }
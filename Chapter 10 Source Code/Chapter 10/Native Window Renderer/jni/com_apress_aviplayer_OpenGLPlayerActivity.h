@@ -55,6 +55,80 @@ extern "C" {
 #define com_apress_aviplayer_OpenGLPlayerActivity_DEFAULT_KEYS_SEARCH_LOCAL 3L
 #undef com_apress_aviplayer_OpenGLPlayerActivity_DEFAULT_KEYS_SEARCH_GLOBAL
 #define com_apress_aviplayer_OpenGLPlayerActivity_DEFAULT_KEYS_SEARCH_GLOBAL 4L
+#undef com_apress_aviplayer_OpenGLPlayerActivity_TRANSFORM_NONE
+#define com_apress_aviplayer_OpenGLPlayerActivity_TRANSFORM_NONE 0L
+#undef com_apress_aviplayer_OpenGLPlayerActivity_TRANSFORM_ROTATE_90
+#define com_apress_aviplayer_OpenGLPlayerActivity_TRANSFORM_ROTATE_90 1L
+#undef com_apress_aviplayer_OpenGLPlayerActivity_TRANSFORM_ROTATE_180
+#define com_apress_aviplayer_OpenGLPlayerActivity_TRANSFORM_ROTATE_180 2L
+#undef com_apress_aviplayer_OpenGLPlayerActivity_TRANSFORM_ROTATE_270
+#define com_apress_aviplayer_OpenGLPlayerActivity_TRANSFORM_ROTATE_270 3L
+#undef com_apress_aviplayer_OpenGLPlayerActivity_TRANSFORM_MIRROR_HORIZONTAL
+#define com_apress_aviplayer_OpenGLPlayerActivity_TRANSFORM_MIRROR_HORIZONTAL 4L
+#undef com_apress_aviplayer_OpenGLPlayerActivity_TRANSFORM_MIRROR_VERTICAL
+#define com_apress_aviplayer_OpenGLPlayerActivity_TRANSFORM_MIRROR_VERTICAL 5L
+#undef com_apress_aviplayer_OpenGLPlayerActivity_MEMORY_FRAMES
+#define com_apress_aviplayer_OpenGLPlayerActivity_MEMORY_FRAMES 0L
+#undef com_apress_aviplayer_OpenGLPlayerActivity_MEMORY_CACHES
+#define com_apress_aviplayer_OpenGLPlayerActivity_MEMORY_CACHES 1L
+#undef com_apress_aviplayer_OpenGLPlayerActivity_MEMORY_PREFETCH
+#define com_apress_aviplayer_OpenGLPlayerActivity_MEMORY_PREFETCH 2L
+#undef com_apress_aviplayer_OpenGLPlayerActivity_MEMORY_AUDIO
+#define com_apress_aviplayer_OpenGLPlayerActivity_MEMORY_AUDIO 3L
+#undef com_apress_aviplayer_OpenGLPlayerActivity_MEMORY_OTHER
+#define com_apress_aviplayer_OpenGLPlayerActivity_MEMORY_OTHER 4L
+#undef com_apress_aviplayer_OpenGLPlayerActivity_MEMORY_SUBSYSTEMS
+#define com_apress_aviplayer_OpenGLPlayerActivity_MEMORY_SUBSYSTEMS 5L
+#undef com_apress_aviplayer_OpenGLPlayerActivity_COLOR_MATRIX_BT601
+#define com_apress_aviplayer_OpenGLPlayerActivity_COLOR_MATRIX_BT601 0L
+#undef com_apress_aviplayer_OpenGLPlayerActivity_COLOR_MATRIX_BT709
+#define com_apress_aviplayer_OpenGLPlayerActivity_COLOR_MATRIX_BT709 1L
+#undef com_apress_aviplayer_OpenGLPlayerActivity_COLOR_MATRIX_JFIF
+#define com_apress_aviplayer_OpenGLPlayerActivity_COLOR_MATRIX_JFIF 2L
+#undef com_apress_aviplayer_OpenGLPlayerActivity_SYNC_SHOWN_FRAMES
+#define com_apress_aviplayer_OpenGLPlayerActivity_SYNC_SHOWN_FRAMES 0L
+#undef com_apress_aviplayer_OpenGLPlayerActivity_SYNC_DROPPED_FRAMES
+#define com_apress_aviplayer_OpenGLPlayerActivity_SYNC_DROPPED_FRAMES 1L
+#undef com_apress_aviplayer_OpenGLPlayerActivity_SYNC_REPEATED_FRAMES
+#define com_apress_aviplayer_OpenGLPlayerActivity_SYNC_REPEATED_FRAMES 2L
+#undef com_apress_aviplayer_OpenGLPlayerActivity_SYNC_LAST_DRIFT
+#define com_apress_aviplayer_OpenGLPlayerActivity_SYNC_LAST_DRIFT 3L
+#undef com_apress_aviplayer_OpenGLPlayerActivity_SYNC_MAX_DRIFT
+#define com_apress_aviplayer_OpenGLPlayerActivity_SYNC_MAX_DRIFT 4L
+#undef com_apress_aviplayer_OpenGLPlayerActivity_SYNC_MEAN_DRIFT
+#define com_apress_aviplayer_OpenGLPlayerActivity_SYNC_MEAN_DRIFT 5L
+#undef com_apress_aviplayer_OpenGLPlayerActivity_SYNC_STATS
+#define com_apress_aviplayer_OpenGLPlayerActivity_SYNC_STATS 6L
+#undef com_apress_aviplayer_OpenGLPlayerActivity_PROBE_WIDTH
+#define com_apress_aviplayer_OpenGLPlayerActivity_PROBE_WIDTH 0L
+#undef com_apress_aviplayer_OpenGLPlayerActivity_PROBE_HEIGHT
+#define com_apress_aviplayer_OpenGLPlayerActivity_PROBE_HEIGHT 1L
+#undef com_apress_aviplayer_OpenGLPlayerActivity_PROBE_FRAME_COUNT
+#define com_apress_aviplayer_OpenGLPlayerActivity_PROBE_FRAME_COUNT 2L
+#undef com_apress_aviplayer_OpenGLPlayerActivity_PROBE_DURATION
+#define com_apress_aviplayer_OpenGLPlayerActivity_PROBE_DURATION 3L
+#undef com_apress_aviplayer_OpenGLPlayerActivity_PROBE_COMPRESSOR
+#define com_apress_aviplayer_OpenGLPlayerActivity_PROBE_COMPRESSOR 4L
+#undef com_apress_aviplayer_OpenGLPlayerActivity_PROBE_AUDIO_FORMAT
+#define com_apress_aviplayer_OpenGLPlayerActivity_PROBE_AUDIO_FORMAT 5L
+#undef com_apress_aviplayer_OpenGLPlayerActivity_PROBE_AUDIO_CHANNELS
+#define com_apress_aviplayer_OpenGLPlayerActivity_PROBE_AUDIO_CHANNELS 6L
+#undef com_apress_aviplayer_OpenGLPlayerActivity_PROBE_AUDIO_RATE
+#define com_apress_aviplayer_OpenGLPlayerActivity_PROBE_AUDIO_RATE 7L
+#undef com_apress_aviplayer_OpenGLPlayerActivity_PROBE_AUDIO_BITS
+#define com_apress_aviplayer_OpenGLPlayerActivity_PROBE_AUDIO_BITS 8L
+#undef com_apress_aviplayer_OpenGLPlayerActivity_PROBE_INFO_SIZE
+#define com_apress_aviplayer_OpenGLPlayerActivity_PROBE_INFO_SIZE 9L
+#undef com_apress_aviplayer_OpenGLPlayerActivity_RECORDING_QUEUED_FRAMES
+#define com_apress_aviplayer_OpenGLPlayerActivity_RECORDING_QUEUED_FRAMES 0L
+#undef com_apress_aviplayer_OpenGLPlayerActivity_RECORDING_WRITTEN_FRAMES
+#define com_apress_aviplayer_OpenGLPlayerActivity_RECORDING_WRITTEN_FRAMES 1L
+#undef com_apress_aviplayer_OpenGLPlayerActivity_RECORDING_DROPPED_FRAMES
+#define com_apress_aviplayer_OpenGLPlayerActivity_RECORDING_DROPPED_FRAMES 2L
+#undef com_apress_aviplayer_OpenGLPlayerActivity_RECORDING_HIGH_WATER_MARK
+#define com_apress_aviplayer_OpenGLPlayerActivity_RECORDING_HIGH_WATER_MARK 3L
+#undef com_apress_aviplayer_OpenGLPlayerActivity_RECORDING_STATS
+#define com_apress_aviplayer_OpenGLPlayerActivity_RECORDING_STATS 4L
 /*
  * Class:     com_apress_aviplayer_OpenGLPlayerActivity
  * Method:    init
@@ -15,18 +15,196 @@ public abstract class AbstractPlayerActivity extends Activity {
 	public static final String EXTRA_FILE_NAME = 
 			"com.apress.aviplayer.EXTRA_FILE_NAME";
 	
+	/** Frame transform extra. */
+	public static final String EXTRA_TRANSFORM = 
+			"com.apress.aviplayer.EXTRA_TRANSFORM";
+	
+	/** Brightness increment extra. */
+	public static final String EXTRA_BRIGHTNESS = 
+			"com.apress.aviplayer.EXTRA_BRIGHTNESS";
+	
+	/** Ordered dithering extra. */
+	public static final String EXTRA_DITHERING = 
+			"com.apress.aviplayer.EXTRA_DITHERING";
+	
+	/** YUV color matrix extra. */
+	public static final String EXTRA_COLOR_MATRIX = 
+			"com.apress.aviplayer.EXTRA_COLOR_MATRIX";
+	
+	/** Memory budget extra, in bytes. */
+	public static final String EXTRA_MEMORY_BUDGET = 
+			"com.apress.aviplayer.EXTRA_MEMORY_BUDGET";
+	
+	/** Session cache grace period extra, in milliseconds. */
+	public static final String EXTRA_SESSION_CACHE_GRACE_PERIOD = 
+			"com.apress.aviplayer.EXTRA_SESSION_CACHE_GRACE_PERIOD";
+	
+	/** Write the rebuilt index back to unindexed files extra. */
+	public static final String EXTRA_REPAIR_INDEX = 
+			"com.apress.aviplayer.EXTRA_REPAIR_INDEX";
+	
+	/** Record the rendered frames to this AVI file extra. */
+	public static final String EXTRA_RECORD_FILE_NAME = 
+			"com.apress.aviplayer.EXTRA_RECORD_FILE_NAME";
+	
+	/** Playback rate extra, negative in reverse. */
+	public static final String EXTRA_PLAYBACK_RATE = 
+			"com.apress.aviplayer.EXTRA_PLAYBACK_RATE";
+	
+	/** No frame transform. */
+	public static final int TRANSFORM_NONE = 0;
+	
+	/** Rotate frames 90 degrees clockwise. */
+	public static final int TRANSFORM_ROTATE_90 = 1;
+	
+	/** Rotate frames 180 degrees. */
+	public static final int TRANSFORM_ROTATE_180 = 2;
+	
+	/** Rotate frames 270 degrees clockwise. */
+	public static final int TRANSFORM_ROTATE_270 = 3;
+	
+	/** Mirror frames horizontally. */
+	public static final int TRANSFORM_MIRROR_HORIZONTAL = 4;
+	
+	/** Mirror frames vertically. */
+	public static final int TRANSFORM_MIRROR_VERTICAL = 5;
+	
+	/** Frame buffer memory usage index. */
+	public static final int MEMORY_FRAMES = 0;
+	
+	/** Cache memory usage index. */
+	public static final int MEMORY_CACHES = 1;
+	
+	/** Prefetch memory usage index. */
+	public static final int MEMORY_PREFETCH = 2;
+	
+	/** Audio memory usage index. */
+	public static final int MEMORY_AUDIO = 3;
+	
+	/** Other memory usage index. */
+	public static final int MEMORY_OTHER = 4;
+	
+	/** Memory usage array size. */
+	public static final int MEMORY_SUBSYSTEMS = 5;
+	
+	/** ITU-R BT.601 YUV color matrix, standard definition. */
+	public static final int COLOR_MATRIX_BT601 = 0;
+	
+	/** ITU-R BT.709 YUV color matrix, high definition. */
+	public static final int COLOR_MATRIX_BT709 = 1;
+	
+	/** Full range BT.601 color matrix of JPEG. */
+	public static final int COLOR_MATRIX_JFIF = 2;
+	
+	/** Shown frames sync statistics index. */
+	public static final int SYNC_SHOWN_FRAMES = 0;
+	
+	/** Dropped frames sync statistics index. */
+	public static final int SYNC_DROPPED_FRAMES = 1;
+	
+	/** Repeated frames sync statistics index. */
+	public static final int SYNC_REPEATED_FRAMES = 2;
+	
+	/** Last drift sync statistics index, in microseconds. */
+	public static final int SYNC_LAST_DRIFT = 3;
+	
+	/** Largest drift sync statistics index, in microseconds. */
+	public static final int SYNC_MAX_DRIFT = 4;
+	
+	/** Mean drift sync statistics index, in microseconds. */
+	public static final int SYNC_MEAN_DRIFT = 5;
+	
+	/** Sync statistics array size. */
+	public static final int SYNC_STATS = 6;
+	
+	/** Video width probe information index. */
+	public static final int PROBE_WIDTH = 0;
+	
+	/** Video height probe information index. */
+	public static final int PROBE_HEIGHT = 1;
+	
+	/** Frame count probe information index. */
+	public static final int PROBE_FRAME_COUNT = 2;
+	
+	/** Duration probe information index, in milliseconds. */
+	public static final int PROBE_DURATION = 3;
+	
+	/** Video compressor FOURCC probe information index, 0 if uncompressed. */
+	public static final int PROBE_COMPRESSOR = 4;
+	
+	/** Audio format tag probe information index, 0 without audio. */
+	public static final int PROBE_AUDIO_FORMAT = 5;
+	
+	/** Audio channel count probe information index. */
+	public static final int PROBE_AUDIO_CHANNELS = 6;
+	
+	/** Audio sample rate probe information index. */
+	public static final int PROBE_AUDIO_RATE = 7;
+	
+	/** Audio bits per sample probe information index. */
+	public static final int PROBE_AUDIO_BITS = 8;
+	
+	/** Probe information array size. */
+	public static final int PROBE_INFO_SIZE = 9;
+	
+	/** Queued frames recording statistics index. */
+	public static final int RECORDING_QUEUED_FRAMES = 0;
+	
+	/** Written frames recording statistics index. */
+	public static final int RECORDING_WRITTEN_FRAMES = 1;
+	
+	/** Dropped frames recording statistics index. */
+	public static final int RECORDING_DROPPED_FRAMES = 2;
+	
+	/** Most queued frames recording statistics index. */
+	public static final int RECORDING_HIGH_WATER_MARK = 3;
+	
+	/** Recording statistics array size. */
+	public static final int RECORDING_STATS = 4;
+	
 	/** AVI video file descriptor. */
 	protected long avi = 0;
 	
+	/** Rendered frames are recorded. */
+	private volatile boolean isRecording = false;
+	
 	/**
 	 * On start.
 	 */
 	protected void onStart() {
 		super.onStart();
 		
+		// Apply the memory budget if given
+		long memoryBudget = getIntent().getLongExtra(EXTRA_MEMORY_BUDGET, -1);
+		if (0 <= memoryBudget) {
+			setMemoryBudget(memoryBudget);
+		}
+		
+		// Apply the session cache grace period if given
+		long gracePeriod = getIntent().getLongExtra(
+				EXTRA_SESSION_CACHE_GRACE_PERIOD, -1);
+		if (0 <= gracePeriod) {
+			setSessionCacheGracePeriod(gracePeriod);
+		}
+		
+		// Recordings without an index are scanned on open
+		setIndexRepair(getIntent().getBooleanExtra(EXTRA_REPAIR_INDEX, false));
+		
 		// Open the AVI file
 		try {
 			avi = open(getFileName());
+			
+			// Apply the playback rate if given, invalid rates
+			// are reported and playback stays at 1x
+			int playbackRate = getIntent().getIntExtra(
+					EXTRA_PLAYBACK_RATE, 1);
+			if (1 != playbackRate) {
+				try {
+					setPlaybackRate(avi, playbackRate);
+				} catch (IllegalArgumentException e) {
+					showError(e);
+				}
+			}
 		} catch (IOException e) {
 			new AlertDialog.Builder(this)
 					.setTitle(R.string.error_alert_title)
@@ -43,12 +221,80 @@ public abstract class AbstractPlayerActivity extends Activity {
 		
 		// If the AVI video is open
 		if (0 != avi) {
+			// Finish the recording while the session is alive
+			stopRequestedRecording();
+			
 			// Close the file descriptor
 			close(avi);
 			avi = 0;
 		}
 	}
 
+	/**
+	 * Starts recording the rendered frames if requested.
+	 * Gets called once the frame transform is set. The
+	 * request is used up, so a new surface does not start
+	 * over and overwrite the recording.
+	 */
+	protected void startRequestedRecording() {
+		String fileName = getIntent().getStringExtra(EXTRA_RECORD_FILE_NAME);
+		
+		if ((0 != avi) && (null != fileName)) {
+			getIntent().removeExtra(EXTRA_RECORD_FILE_NAME);
+			
+			try {
+				startRecording(avi, fileName);
+				isRecording = true;
+			} catch (IOException e) {
+				showError(e);
+			}
+		}
+	}
+	
+	/**
+	 * Stops recording, after the queued frames are written.
+	 * Gets called on the UI thread once rendering is over.
+	 */
+	protected void stopRequestedRecording() {
+		if ((0 != avi) && isRecording) {
+			isRecording = false;
+			
+			try {
+				stopRecording(avi);
+			} catch (IOException e) {
+				showError(e);
+			}
+		}
+	}
+	
+	/**
+	 * Shows the given error on the UI thread.
+	 * 
+	 * @param e error.
+	 */
+	private void showError(final Exception e) {
+		runOnUiThread(new Runnable() {
+			public void run() {
+				new AlertDialog.Builder(AbstractPlayerActivity.this)
+						.setTitle(R.string.error_alert_title)
+						.setMessage(e.getMessage())
+						.show();
+			}
+		});
+	}
+
+	/**
+	 * On trim memory.
+	 * 
+	 * @param level trim level.
+	 */
+	public void onTrimMemory(int level) {
+		super.onTrimMemory(level);
+		
+		// Release the idle native buffers
+		trimMemory();
+	}
+
 	/**
 	 * Gets the AVI video file name.
 	 * 
@@ -91,6 +337,204 @@ public abstract class AbstractPlayerActivity extends Activity {
 	 */
 	protected native static double getFrameRate(long avi);
 
+	/**
+	 * Gets the number of video frames.
+	 * 
+	 * @param avi file descriptor.
+	 * @return frame count.
+	 */
+	protected native static long getFrameCount(long avi);
+
+	/**
+	 * Sets the frame that is rendered next. OpenDML files
+	 * load only the part of the index around the frame.
+	 * 
+	 * @param avi file descriptor.
+	 * @param frame frame number.
+	 * @throws IllegalArgumentException
+	 */
+	protected native static void seek(long avi, long frame);
+
+	/**
+	 * Sets the playback rate. Up to 8x every rate-th frame
+	 * is rendered, from 8x on only the key frames, and
+	 * negative rates play in reverse. The skipped frames
+	 * are not read, and the audio is silent at any rate
+	 * other than 1.
+	 * 
+	 * @param avi file descriptor.
+	 * @param rate playback rate, up to 64 either way.
+	 * @throws IllegalArgumentException
+	 */
+	protected native static void setPlaybackRate(long avi, int rate);
+
+	/**
+	 * Gets the time until the next frame is due. With PCM
+	 * audio the frames follow the audio playback position,
+	 * otherwise the frame rate.
+	 * 
+	 * @param avi file descriptor.
+	 * @return delay in milliseconds.
+	 */
+	protected native static long getFrameDelay(long avi);
+
+	/**
+	 * Gets the audio and video sync statistics. Drifts are
+	 * positive when the video is ahead of the audio.
+	 * 
+	 * @param avi file descriptor.
+	 * @param stats stats array of SYNC_STATS size.
+	 * @throws IllegalArgumentException
+	 */
+	protected native static void getSyncStats(long avi, long[] stats);
+
+	/**
+	 * Sets the frame transform. The video width and height
+	 * are reported after the transform.
+	 * 
+	 * @param avi file descriptor.
+	 * @param transform frame transform.
+	 */
+	protected native static void setTransform(long avi, int transform);
+
+	/**
+	 * Sets the brightness increment. It is applied to each
+	 * band of rows as the frame is read, so the frame is
+	 * not walked again.
+	 * 
+	 * @param avi file descriptor.
+	 * @param brightness brightness increment, 0 to disable.
+	 */
+	protected native static void setBrightness(long avi, int brightness);
+
+	/**
+	 * Enables ordered dithering when frames are reduced to
+	 * RGB565 from a deeper color format.
+	 * 
+	 * @param avi file descriptor.
+	 * @param enabled dithering enabled.
+	 */
+	protected native static void setDithering(long avi, boolean enabled);
+
+	/**
+	 * Sets the color matrix for YUV frames. By default it
+	 * is picked by the frame height.
+	 * 
+	 * @param avi file descriptor.
+	 * @param matrix color matrix.
+	 * @throws IllegalArgumentException
+	 */
+	protected native static void setColorMatrix(long avi, int matrix);
+
+	/**
+	 * Sets the global memory budget. Caches shrink to stay
+	 * within the budget, allocations fail beyond it.
+	 * 
+	 * @param budget budget in bytes, 0 for no limit.
+	 */
+	protected native static void setMemoryBudget(long budget);
+
+	/**
+	 * Gets the memory usage in bytes for each subsystem,
+	 * indexed by the MEMORY constants.
+	 * 
+	 * @param avi file descriptor, or 0 for global usage.
+	 * @param usage usage array of MEMORY_SUBSYSTEMS size.
+	 */
+	protected native static void getMemoryUsage(long avi, long[] usage);
+
+	/**
+	 * Frees the idle native frame buffers and closes the
+	 * cached AVI files.
+	 */
+	protected native static void trimMemory();
+
+	/**
+	 * Sets how long closed AVI files are kept open, so that
+	 * stopping and starting the activity resumes without
+	 * parsing the file again.
+	 * 
+	 * @param gracePeriod grace period in milliseconds, 0 to
+	 *        close right away.
+	 */
+	protected native static void setSessionCacheGracePeriod(long gracePeriod);
+
+	/**
+	 * Sets whether the index rebuilt for a file without
+	 * one, such as a recording that was cut off, is written
+	 * back to the file.
+	 * 
+	 * @param enabled true to write the index.
+	 */
+	protected native static void setIndexRepair(boolean enabled);
+
+	/**
+	 * Extracts the PCM audio track of the given AVI file
+	 * into a WAV file.
+	 * 
+	 * @param fileName AVI file name.
+	 * @param wavFileName WAV file name.
+	 * @return extracted audio size in bytes.
+	 * @throws IOException
+	 */
+	protected native static long extractAudio(String fileName,
+			String wavFileName) throws IOException;
+
+	/**
+	 * Probes the given AVI file by reading only its
+	 * headers, without opening it for playback.
+	 * 
+	 * @param fileName file name.
+	 * @param info info array of PROBE_INFO_SIZE size.
+	 * @throws IOException
+	 */
+	protected native static void probe(String fileName, long[] info)
+			throws IOException;
+
+	/**
+	 * Probes the given AVI files on several threads. The
+	 * info of the files that cannot be probed is set to -1.
+	 * 
+	 * @param fileNames file names.
+	 * @param info info array of PROBE_INFO_SIZE size for
+	 *        each file, one after the other.
+	 * @throws IllegalArgumentException
+	 */
+	protected native static void probeFiles(String[] fileNames,
+			long[] info);
+
+	/**
+	 * Starts recording the rendered frames to the given AVI
+	 * file. Frames are queued and written on a writer
+	 * thread; when the queue is full they are dropped, so
+	 * rendering never waits on the disk.
+	 * 
+	 * @param avi file descriptor.
+	 * @param fileName AVI file name.
+	 * @throws IOException
+	 */
+	protected native static void startRecording(long avi, String fileName)
+			throws IOException;
+
+	/**
+	 * Gets the recording statistics.
+	 * 
+	 * @param avi file descriptor.
+	 * @param stats stats array of RECORDING_STATS size.
+	 * @throws IllegalArgumentException
+	 * @throws IllegalStateException
+	 */
+	protected native static void getRecordingStats(long avi, long[] stats);
+
+	/**
+	 * Stops recording, writes out the queued frames and
+	 * finishes the AVI file.
+	 * 
+	 * @param avi file descriptor.
+	 * @throws IOException
+	 */
+	protected native static void stopRecording(long avi) throws IOException;
+
 	/**
 	 * Closes the given AVI file based on given file descriptor.
 	 * 
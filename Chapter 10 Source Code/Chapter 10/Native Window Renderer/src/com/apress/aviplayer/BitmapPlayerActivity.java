@@ -21,6 +21,9 @@ public class BitmapPlayerActivity extends AbstractPlayerActivity {
 	/** Surface holder. */
 	private SurfaceHolder surfaceHolder;
 	
+	/** Render thread. */
+	private Thread renderThread;
+	
 	/**
 	 * On create.
 	 * 
@@ -49,12 +52,20 @@ public class BitmapPlayerActivity extends AbstractPlayerActivity {
 			isPlaying.set(true);
 			
 			// Start renderer on a separate thread
-			new Thread(renderer).start();
+			renderThread = new Thread(renderer);
+			renderThread.start();
 		}
 
 		public void surfaceDestroyed(SurfaceHolder holder) {
 			// Stop playing since surface is destroyed
 			isPlaying.set(false);
+			
+			// Wait for the renderer, the session is closed next
+			try {
+				renderThread.join();
+			} catch (InterruptedException e) {
+				Thread.currentThread().interrupt();
+			}
 		}
 	};
 	
@@ -64,15 +75,33 @@ public class BitmapPlayerActivity extends AbstractPlayerActivity {
 	 */
 	private final Runnable renderer = new Runnable() {
 		public void run() {
+			// Set the requested frame transform
+			setTransform(avi, getIntent().getIntExtra(
+					EXTRA_TRANSFORM, TRANSFORM_NONE));
+			
+			// Set the requested brightness
+			setBrightness(avi, getIntent().getIntExtra(
+					EXTRA_BRIGHTNESS, 0));
+			
+			// Set the requested dithering
+			setDithering(avi, getIntent().getBooleanExtra(
+					EXTRA_DITHERING, false));
+			
+			// Set the requested color matrix, if any
+			int colorMatrix = getIntent().getIntExtra(EXTRA_COLOR_MATRIX, -1);
+			if (colorMatrix >= 0) {
+				setColorMatrix(avi, colorMatrix);
+			}
+			
+			// Record the rendered frames if requested
+			startRequestedRecording();
+			
 			// Create a new bitmap to hold the frames
 			Bitmap bitmap = Bitmap.createBitmap(
 					getWidth(avi), 
 					getHeight(avi), 
 					Bitmap.Config.RGB_565);
 			
-			// Calculate the delay using the frame rate
-			long frameDelay = (long) (1000 / getFrameRate(avi));
-			
 			// Start rendering while playing
 			while (isPlaying.get()) {
 				// Render the frame to the bitmap
@@ -87,9 +116,9 @@ public class BitmapPlayerActivity extends AbstractPlayerActivity {
 				// Post the canvas for displaying
 				surfaceHolder.unlockCanvasAndPost(canvas);
 				
-				// Wait for the next frame
+				// Wait for the next frame, on the audio clock if any
 				try {
-					Thread.sleep(frameDelay);
+					Thread.sleep(getFrameDelay(avi));
 				} catch (InterruptedException e) {
 					break;
 				}
@@ -1,15 +1,21 @@
 package com.apress.aviplayer;
 
 import java.io.File;
+import java.io.FilenameFilter;
 
 import android.app.Activity;
 import android.content.Intent;
+import android.os.AsyncTask;
 import android.os.Bundle;
 import android.os.Environment;
 import android.view.View;
 import android.view.View.OnClickListener;
+import android.widget.AdapterView;
+import android.widget.AdapterView.OnItemClickListener;
+import android.widget.ArrayAdapter;
 import android.widget.Button;
 import android.widget.EditText;
+import android.widget.ListView;
 import android.widget.RadioGroup;
 
 /**
@@ -17,7 +23,8 @@ import android.widget.RadioGroup;
  * 
  * @author Onur Cinar
  */
-public class MainActivity extends Activity implements OnClickListener {
+public class MainActivity extends Activity implements OnClickListener,
+		OnItemClickListener {
 	/** AVI file name edit. */
 	private EditText fileNameEdit;
 
@@ -27,6 +34,12 @@ public class MainActivity extends Activity implements OnClickListener {
 	/** Play button. */
 	private Button playButton;
 
+	/** AVI file list. */
+	private ListView fileList;
+
+	/** AVI file names in the list. */
+	private String[] fileNames = new String[0];
+
 	/**
 	 * On create.
 	 * 
@@ -42,6 +55,12 @@ public class MainActivity extends Activity implements OnClickListener {
 
 		playButton = (Button) findViewById(R.id.play_button);
 		playButton.setOnClickListener(this);
+
+		fileList = (ListView) findViewById(R.id.file_list);
+		fileList.setOnItemClickListener(this);
+
+		// List the AVI files with their headers
+		new ProbeTask().execute(Environment.getExternalStorageDirectory());
 	}
 
 	/**
@@ -57,6 +76,19 @@ public class MainActivity extends Activity implements OnClickListener {
 		}
 	}
 
+	/**
+	 * On file list item click event handler.
+	 * 
+	 * @param parent list view.
+	 * @param view item view.
+	 * @param position item position.
+	 * @param id item id.
+	 */
+	public void onItemClick(AdapterView<?> parent, View view, int position,
+			long id) {
+		fileNameEdit.setText(fileNames[position]);
+	}
+
 	/**
 	 * On play button click event handler.
 	 */
@@ -95,4 +127,102 @@ public class MainActivity extends Activity implements OnClickListener {
 		// Start the player activity
 		startActivity(intent);
 	}
+
+	/**
+	 * Probe task, lists the AVI files of a directory with
+	 * the information from their headers.
+	 */
+	private class ProbeTask extends AsyncTask<File, Void, String[]> {
+		/** AVI file names. */
+		private String[] names;
+
+		/**
+		 * Background task.
+		 * 
+		 * @param directory directory to list.
+		 * @return list items.
+		 */
+		protected String[] doInBackground(File... directory) {
+			// Only the AVI files
+			names = directory[0].list(new FilenameFilter() {
+				public boolean accept(File dir, String name) {
+					return name.toLowerCase().endsWith(".avi");
+				}
+			});
+
+			if (null == names) {
+				names = new String[0];
+			}
+
+			String[] paths = new String[names.length];
+			for (int i = 0; i < names.length; i++) {
+				paths[i] = new File(directory[0], names[i]).getAbsolutePath();
+			}
+
+			// Headers of all files at once
+			long[] info = new long[
+					names.length * AbstractPlayerActivity.PROBE_INFO_SIZE];
+			AbstractPlayerActivity.probeFiles(paths, info);
+
+			String[] items = new String[names.length];
+			for (int i = 0; i < names.length; i++) {
+				items[i] = getFileInfo(names[i], info,
+						i * AbstractPlayerActivity.PROBE_INFO_SIZE);
+			}
+
+			return items;
+		}
+
+		/**
+		 * Shows the list items.
+		 * 
+		 * @param items list items.
+		 */
+		protected void onPostExecute(String[] items) {
+			fileNames = names;
+			fileList.setAdapter(new ArrayAdapter<String>(MainActivity.this,
+					android.R.layout.simple_list_item_1, items));
+		}
+	}
+
+	/**
+	 * Formats the probe information of the given file.
+	 * 
+	 * @param name file name.
+	 * @param info probe information.
+	 * @param offset offset of the file in the information.
+	 * @return list item text.
+	 */
+	private String getFileInfo(String name, long[] info, int offset) {
+		// File could not be probed
+		if (0 > info[offset + AbstractPlayerActivity.PROBE_WIDTH]) {
+			return name;
+		}
+
+		// Compressor FOURCC, little endian
+		long fourcc = info[offset + AbstractPlayerActivity.PROBE_COMPRESSOR];
+		String compressor = (0 == fourcc) ? "RGB" : new String(new char[] {
+				(char) (fourcc & 0xff),
+				(char) ((fourcc >> 8) & 0xff),
+				(char) ((fourcc >> 16) & 0xff),
+				(char) ((fourcc >> 24) & 0xff) }).trim();
+
+		String audio = (0 == info[offset
+				+ AbstractPlayerActivity.PROBE_AUDIO_FORMAT])
+				? getString(R.string.no_audio)
+				: getString(R.string.audio_info,
+						info[offset + AbstractPlayerActivity.PROBE_AUDIO_RATE],
+						info[offset + AbstractPlayerActivity.PROBE_AUDIO_CHANNELS]);
+
+		long seconds = info[offset + AbstractPlayerActivity.PROBE_DURATION] / 1000;
+
+		return getString(R.string.file_info,
+				name,
+				info[offset + AbstractPlayerActivity.PROBE_WIDTH],
+				info[offset + AbstractPlayerActivity.PROBE_HEIGHT],
+				compressor,
+				seconds / 60,
+				seconds % 60,
+				audio);
+	}
 }
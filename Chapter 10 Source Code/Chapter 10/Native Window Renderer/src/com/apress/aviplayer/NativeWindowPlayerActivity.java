@@ -20,6 +20,9 @@ public class NativeWindowPlayerActivity extends AbstractPlayerActivity {
 	/** Surface holder. */
 	private SurfaceHolder surfaceHolder;
 	
+	/** Render thread. */
+	private Thread renderThread;
+	
 	/**
 	 * On create.
 	 * 
@@ -48,12 +51,20 @@ public class NativeWindowPlayerActivity extends AbstractPlayerActivity {
 			isPlaying.set(true);
 			
 			// Start renderer on a separate thread
-			new Thread(renderer).start();
+			renderThread = new Thread(renderer);
+			renderThread.start();
 		}
 
 		public void surfaceDestroyed(SurfaceHolder holder) {
 			// Stop playing since surface is destroyed
 			isPlaying.set(false);
+			
+			// Wait for the renderer, the session is closed next
+			try {
+				renderThread.join();
+			} catch (InterruptedException e) {
+				Thread.currentThread().interrupt();
+			}
 		}
 	};
 	
@@ -63,23 +74,41 @@ public class NativeWindowPlayerActivity extends AbstractPlayerActivity {
 	 */
 	private final Runnable renderer = new Runnable() {
 		public void run() {
+			// Set the requested frame transform
+			setTransform(avi, getIntent().getIntExtra(
+					EXTRA_TRANSFORM, TRANSFORM_NONE));
+			
+			// Set the requested brightness
+			setBrightness(avi, getIntent().getIntExtra(
+					EXTRA_BRIGHTNESS, 0));
+			
+			// Set the requested dithering
+			setDithering(avi, getIntent().getBooleanExtra(
+					EXTRA_DITHERING, false));
+			
+			// Set the requested color matrix, if any
+			int colorMatrix = getIntent().getIntExtra(EXTRA_COLOR_MATRIX, -1);
+			if (colorMatrix >= 0) {
+				setColorMatrix(avi, colorMatrix);
+			}
+			
+			// Record the rendered frames if requested
+			startRequestedRecording();
+			
 			// Get the surface instance
 			Surface surface = surfaceHolder.getSurface();
 			
 			// Initialize the native window
 			init(avi, surface);
 			
-			// Calculate the delay using the frame rate
-			long frameDelay = (long) (1000 / getFrameRate(avi));
-			
 			// Start rendering while playing
 			while (isPlaying.get()) {
 				// Render the frame to the surface
 				render(avi, surface);
 				
-				// Wait for the next frame
+				// Wait for the next frame, on the audio clock if any
 				try {
-					Thread.sleep(frameDelay);
+					Thread.sleep(getFrameDelay(avi));
 				} catch (InterruptedException e) {
 					break;
 				}
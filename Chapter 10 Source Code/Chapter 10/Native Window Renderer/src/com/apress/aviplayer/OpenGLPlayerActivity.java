@@ -50,6 +50,19 @@ public class OpenGLPlayerActivity extends AbstractPlayerActivity {
 		
 		// Initializes the native renderer
 		instance = init(avi);
+		
+		// Set the requested dithering
+		setDithering(avi, getIntent().getBooleanExtra(
+				EXTRA_DITHERING, false));
+		
+		// Set the requested color matrix, if any
+		int colorMatrix = getIntent().getIntExtra(EXTRA_COLOR_MATRIX, -1);
+		if (colorMatrix >= 0) {
+			setColorMatrix(avi, colorMatrix);
+		}
+		
+		// Record the rendered frames if requested
+		startRequestedRecording();
 	}
 
 	/**
@@ -76,11 +89,14 @@ public class OpenGLPlayerActivity extends AbstractPlayerActivity {
 	 * On stop.
 	 */
 	protected void onStop() {
-		super.onStop();
+		// Rendering is paused, finish the recording
+		stopRequestedRecording();
 		
-		// Free the native renderer
+		// Free the native renderer before the session is closed
 		free(instance);
 		instance = 0;
+		
+		super.onStop();
 	}
 
 	/**
@@ -88,17 +104,14 @@ public class OpenGLPlayerActivity extends AbstractPlayerActivity {
 	 */
 	private final Runnable player = new Runnable() {
 		public void run() {
-			// Calculate the delay using the frame rate
-			long frameDelay = (long) (1000 / getFrameRate(avi));
-			
 			// Start rendering while playing
 			while (isPlaying.get()) {
 				// Request rendering
 				glSurfaceView.requestRender();
 				
-				// Wait for the next frame
+				// Wait for the next frame, on the audio clock if any
 				try {
-					Thread.sleep(frameDelay);
+					Thread.sleep(getFrameDelay(avi));
 				} catch (InterruptedException e) {
 					break;
 				}
@@ -3,7 +3,9 @@ LOCAL_PATH := $(call my-dir)
 include $(CLEAR_VARS)
 
 LOCAL_MODULE    := WAVPlayer
-LOCAL_SRC_FILES := WAVPlayer.cpp
+LOCAL_SRC_FILES := \
+	Memory.cpp \
+	WAVPlayer.cpp
 
 # Use WAVLib static library
 LOCAL_STATIC_LIBRARIES += wavlib_static
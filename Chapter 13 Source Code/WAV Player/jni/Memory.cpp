@@ -0,0 +1,225 @@
+#include "Memory.h"
+
+#include <pthread.h>
+#include <stdlib.h>
+
+// Maximum number of shrinkers
+#define MAX_SHRINKERS 8
+
+/**
+ * Allocation header, keeps the memory after it 16 byte
+ * aligned for SIMD access.
+ */
+union MemoryHeader
+{
+	struct
+	{
+		MemoryAccount* account;
+		size_t size;
+		int subsystem;
+	} allocation;
+
+	long double alignment[2];
+};
+
+struct ShrinkerEntry
+{
+	MemoryShrinker shrinker;
+	void* context;
+};
+
+// Global account and total
+static MemoryAccount globalAccount;
+static volatile long globalUsed = 0;
+
+// Global budget, 0 for no limit
+static volatile long memoryBudget = 0;
+
+// Shrinkers, guarded by the mutex
+static ShrinkerEntry shrinkers[MAX_SHRINKERS];
+static int shrinkerCount = 0;
+static pthread_mutex_t shrinkerMutex = PTHREAD_MUTEX_INITIALIZER;
+
+/**
+ * Reserves the given size from the budget.
+ */
+static bool reserveMemory(
+		size_t size)
+{
+	long used = __sync_add_and_fetch(&globalUsed, (long) size);
+	long budget = memoryBudget;
+
+	if ((0 != budget) && (used > budget))
+	{
+		__sync_sub_and_fetch(&globalUsed, (long) size);
+		return false;
+	}
+
+	return true;
+}
+
+/**
+ * Asks the shrinkers to free the given size. Shrinkers run
+ * one at a time, and only until enough is freed.
+ */
+static void shrinkMemory(
+		size_t size)
+{
+	pthread_mutex_lock(&shrinkerMutex);
+
+	size_t freed = 0;
+	for (int i = 0; (i < shrinkerCount) && (freed < size); i++)
+	{
+		freed += shrinkers[i].shrinker(shrinkers[i].context, size - freed);
+	}
+
+	pthread_mutex_unlock(&shrinkerMutex);
+}
+
+static void chargeMemory(
+		MemoryAccount* account,
+		int subsystem,
+		long size)
+{
+	__sync_add_and_fetch(&globalAccount.used[subsystem], size);
+
+	if (0 != account)
+	{
+		__sync_add_and_fetch(&account->used[subsystem], size);
+	}
+}
+
+void* allocateMemory(
+		MemoryAccount* account,
+		int subsystem,
+		size_t size)
+{
+	MemoryHeader* header = 0;
+
+	if ((0 > subsystem) || (MEMORY_SUBSYSTEMS <= subsystem))
+	{
+		goto exit;
+	}
+
+	// Shrink the caches under pressure instead of failing
+	if (!reserveMemory(size))
+	{
+		shrinkMemory(size);
+
+		if (!reserveMemory(size))
+		{
+			goto exit;
+		}
+	}
+
+	header = (MemoryHeader*) malloc(sizeof(MemoryHeader) + size);
+	if (0 == header)
+	{
+		__sync_sub_and_fetch(&globalUsed, (long) size);
+		goto exit;
+	}
+
+	header->allocation.account = account;
+	header->allocation.size = size;
+	header->allocation.subsystem = subsystem;
+
+	chargeMemory(account, subsystem, size);
+
+	// Memory starts after the header
+	header++;
+
+exit:
+	return header;
+}
+
+void freeMemory(
+		void* memory)
+{
+	if (0 == memory)
+	{
+		return;
+	}
+
+	MemoryHeader* header = ((MemoryHeader*) memory) - 1;
+	long size = header->allocation.size;
+
+	chargeMemory(header->allocation.account,
+			header->allocation.subsystem,
+			-size);
+
+	__sync_sub_and_fetch(&globalUsed, size);
+
+	free(header);
+}
+
+void setMemoryBudget(
+		size_t budget)
+{
+	memoryBudget = budget;
+
+	// Bring the caches within the new budget
+	long used = globalUsed;
+	if ((0 != budget) && (used > (long) budget))
+	{
+		shrinkMemory(used - budget);
+	}
+}
+
+long getMemoryUsage(
+		const MemoryAccount* account,
+		int subsystem)
+{
+	if (0 == account)
+	{
+		account = &globalAccount;
+	}
+
+	return account->used[subsystem];
+}
+
+bool addMemoryShrinker(
+		MemoryShrinker shrinker,
+		void* context)
+{
+	bool isAdded = false;
+
+	pthread_mutex_lock(&shrinkerMutex);
+
+	if (MAX_SHRINKERS > shrinkerCount)
+	{
+		shrinkers[shrinkerCount].shrinker = shrinker;
+		shrinkers[shrinkerCount].context = context;
+		shrinkerCount++;
+
+		isAdded = true;
+	}
+
+	pthread_mutex_unlock(&shrinkerMutex);
+
+	return isAdded;
+}
+
+void removeMemoryShrinker(
+		MemoryShrinker shrinker,
+		void* context)
+{
+	pthread_mutex_lock(&shrinkerMutex);
+
+	for (int i = 0; i < shrinkerCount; i++)
+	{
+		if ((shrinker == shrinkers[i].shrinker)
+				&& (context == shrinkers[i].context))
+		{
+			// Keep the order
+			for (int j = i + 1; j < shrinkerCount; j++)
+			{
+				shrinkers[j - 1] = shrinkers[j];
+			}
+
+			shrinkerCount--;
+			break;
+		}
+	}
+
+	pthread_mutex_unlock(&shrinkerMutex);
+}
@@ -0,0 +1,111 @@
+#pragma once
+
+#include <stddef.h>
+
+/**
+ * Memory subsystems that are accounted separately. The
+ * values are shared with the AbstractPlayerActivity
+ * constants.
+ */
+enum MemorySubsystem
+{
+	MEMORY_FRAMES = 0,
+	MEMORY_CACHES = 1,
+	MEMORY_PREFETCH = 2,
+	MEMORY_AUDIO = 3,
+	MEMORY_OTHER = 4,
+	MEMORY_SUBSYSTEMS = 5
+};
+
+/**
+ * Memory account, bytes in use for each subsystem.
+ */
+struct MemoryAccount
+{
+	volatile long used[MEMORY_SUBSYSTEMS];
+
+	MemoryAccount()
+	{
+		for (int i = 0; i < MEMORY_SUBSYSTEMS; i++)
+		{
+			used[i] = 0;
+		}
+	}
+};
+
+/**
+ * Memory shrinker. Gets called when an allocation would go
+ * over the budget, frees memory it can do without, such as
+ * cached or prefetched data. Must not allocate.
+ *
+ * @param context shrinker context.
+ * @param size bytes that are needed.
+ * @return bytes freed.
+ */
+typedef size_t (*MemoryShrinker)(
+		void* context,
+		size_t size);
+
+/**
+ * Allocates memory charged to the given account and
+ * subsystem, and to the global account. If the allocation
+ * would go over the budget, the shrinkers are asked to
+ * free memory first.
+ *
+ * @param account memory account, or 0 for global only.
+ * @param subsystem memory subsystem.
+ * @param size size in bytes.
+ * @return memory or 0 if over budget or out of memory.
+ */
+void* allocateMemory(
+		MemoryAccount* account,
+		int subsystem,
+		size_t size);
+
+/**
+ * Frees memory from allocateMemory and credits its account.
+ *
+ * @param memory memory, may be 0.
+ */
+void freeMemory(
+		void* memory);
+
+/**
+ * Sets the global memory budget.
+ *
+ * @param budget budget in bytes, 0 for no limit.
+ */
+void setMemoryBudget(
+		size_t budget);
+
+/**
+ * Gets the bytes in use for the given subsystem.
+ *
+ * @param account memory account, or 0 for global.
+ * @param subsystem memory subsystem.
+ * @return bytes in use.
+ */
+long getMemoryUsage(
+		const MemoryAccount* account,
+		int subsystem);
+
+/**
+ * Adds a memory shrinker.
+ *
+ * @param shrinker memory shrinker.
+ * @param context shrinker context.
+ * @return true on success, false if there are too many.
+ */
+bool addMemoryShrinker(
+		MemoryShrinker shrinker,
+		void* context);
+
+/**
+ * Removes the given memory shrinker.
+ *
+ * @param shrinker memory shrinker.
+ * @param context shrinker context.
+ */
+void removeMemoryShrinker(
+		MemoryShrinker shrinker,
+		void* context);
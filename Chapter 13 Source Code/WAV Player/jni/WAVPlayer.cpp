@@ -7,6 +7,8 @@ extern "C" {
 #include <wavlib.h>
 }
 
+#include "Memory.h"
+
 static const char* JAVA_LANG_IOEXCEPTION = "java/lang/IOException";
 static const char* JAVA_LANG_OUTOFMEMORYERROR = "java/lang/OutOfMemoryError";
 
@@ -357,7 +359,7 @@ static void FreePlayerBuffer(unsigned char*& buffers)
 {
 	if (0 != buffers)
 	{
-		delete buffers;
+		freeMemory(buffers);
 		buffers = 0;
 	}
 }
@@ -379,8 +381,8 @@ static void InitPlayerBuffer(
 	// Calculate the buffer size
 	bufferSize = wav_get_channels(wav) * wav_get_rate(wav) * wav_get_bits(wav);
 
-	// Initialize buffer
-	buffer = new unsigned char[bufferSize];
+	// Initialize buffer, charged to the audio budget
+	buffer = (unsigned char*) allocateMemory(0, MEMORY_AUDIO, bufferSize);
 	if (0 == buffer)
 	{
 		ThrowException(env,
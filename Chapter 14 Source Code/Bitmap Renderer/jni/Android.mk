@@ -6,49 +6,70 @@ LOCAL_MODULE    := AVIPlayer
 LOCAL_SRC_FILES := \
 	Common.cpp \
 	com_apress_aviplayer_AbstractPlayerActivity.cpp \
-	com_apress_aviplayer_BitmapPlayerActivity.cpp
+	com_apress_aviplayer_BitmapPlayerActivity.cpp \
+	FusedReader.cpp \
+	PerfCounters.cpp \
+	Statistics.cpp \
+	Trace.cpp
 
 # Add NEON optimized version on armeabi-v7a
 ifeq ($(TARGET_ARCH_ABI),armeabi-v7a)
-	LOCAL_SRC_FILES += BrightnessFilter.cpp.neon
+	LOCAL_SRC_FILES += \
+		AutoExposure.cpp.neon \
+		BrightnessFilter.cpp.neon \
+		Compositor.cpp.neon \
+		ConvolutionFilter.cpp.neon \
+		TemporalFilter.cpp.neon
 	LOCAL_STATIC_LIBRARIES += cpufeatures
 else
-	LOCAL_SRC_FILES += BrightnessFilter.cpp
+	LOCAL_SRC_FILES += \
+		AutoExposure.cpp \
+		BrightnessFilter.cpp \
+		Compositor.cpp \
+		ConvolutionFilter.cpp \
+		TemporalFilter.cpp
 endif
 
 # Use AVILib static library 
 LOCAL_STATIC_LIBRARIES += avilib_static
 
-# Android NDK Profiler enabled
-MY_ANDROID_NDK_PROFILER_ENABLED := true
+# Tracing enabled
+MY_TRACE_ENABLED := true
 
-# If Android NDK Profiler is enabled
-ifeq ($(MY_ANDROID_NDK_PROFILER_ENABLED),true)
+# If tracing is enabled
+ifeq ($(MY_TRACE_ENABLED),true)
 
 # Show message
-$(info GNU Profiler is enabled)
+$(info Tracing is enabled)
 
-# Enable the monitor functions
-LOCAL_CFLAGS += -DMY_ANDROID_NDK_PROFILER_ENABLED
+# Enable the trace events
+LOCAL_CFLAGS += -DMY_TRACE_ENABLED
+endif
+
+# Hardware counters enabled
+MY_PERF_COUNTERS_ENABLED := false
+
+# If hardware counters are enabled
+ifeq ($(MY_PERF_COUNTERS_ENABLED),true)
+
+# Show message
+$(info Hardware counters are enabled)
 
-# Use Android NDK Profiler static library
-LOCAL_STATIC_LIBRARIES += andprof
+# Enable the perf scopes
+LOCAL_CFLAGS += -DMY_PERF_COUNTERS_ENABLED
 endif
 
 # Link with JNI graphics
 LOCAL_LDLIBS += -ljnigraphics
 
+# Link with Android log
+LOCAL_LDLIBS += -llog
+
 include $(BUILD_SHARED_LIBRARY)
 
 # Import AVILib library module
 $(call import-module, transcode-1.1.5/avilib)
 
-# If Android NDK Profiler is enabled
-ifdef MY_ANDROID_NDK_PROFILER_ENABLED
-# Import Android NDK Profiler library module
-$(call import-module, android-ndk-profiler/jni)
-endif
-
 # Add CPU features on armeabi-v7a
 ifeq ($(TARGET_ARCH_ABI),armeabi-v7a)
 # Import Android CPU features
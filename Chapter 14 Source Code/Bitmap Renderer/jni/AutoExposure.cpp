@@ -0,0 +1,261 @@
+#include "AutoExposure.h"
+#include "Common.h"
+
+#include <string.h>
+
+#ifdef __ARM_NEON__
+
+#include <cpu-features.h>
+
+#include <arm_neon.h>
+
+#endif
+
+#ifdef __SSE2__
+
+#include <emmintrin.h>
+
+#endif
+
+// Sample every 4th row and every 4th group of 8 pixels
+static const int SAMPLE_STEP = 4;
+
+// Mean luma the exposure is steered towards
+static const unsigned int TARGET_LUMA = 118;
+
+// Highlights are kept below this luma
+static const unsigned int MAX_HIGHLIGHT = 248;
+
+// Brightness increment limit
+static const unsigned int MAX_BRIGHTNESS = 64;
+
+// Smoothing shift, level moves 1/8 of the way per frame
+static const int SMOOTHING_SHIFT = 3;
+
+// Histogram cost is reported once per this many frames
+static const long REPORT_FRAMES = 100;
+
+/**
+ * Luma of 8 consecutive RGB565 pixels.
+ */
+typedef void (*LumaKernel)(const unsigned short* pixels, unsigned char* luma);
+
+static void genericLuma8(
+		const unsigned short* pixels,
+		unsigned char* luma)
+{
+	for (int i = 0; i < 8; i++)
+	{
+		unsigned int r = (pixels[i] >> 8) & 0xF8;
+		unsigned int g = (pixels[i] >> 3) & 0xFC;
+		unsigned int b = (pixels[i] << 3) & 0xF8;
+
+		// BT.601 luma in 8-bit fixed point
+		luma[i] = (r * 77 + g * 150 + b * 29) >> 8;
+	}
+}
+
+#ifdef __ARM_NEON__
+
+static void neonLuma8(
+		const unsigned short* pixels,
+		unsigned char* luma)
+{
+	uint16x8_t rgb = vld1q_u16(pixels);
+
+	uint16x8_t r = vandq_u16(vshrq_n_u16(rgb, 8), vdupq_n_u16(0xF8));
+	uint16x8_t g = vandq_u16(vshrq_n_u16(rgb, 3), vdupq_n_u16(0xFC));
+	uint16x8_t b = vandq_u16(vshlq_n_u16(rgb, 3), vdupq_n_u16(0xF8));
+
+	uint16x8_t l = vmulq_n_u16(r, 77);
+	l = vmlaq_n_u16(l, g, 150);
+	l = vmlaq_n_u16(l, b, 29);
+
+	// Narrowing shift gives the 8-bit luma
+	vst1_u8(luma, vshrn_n_u16(l, 8));
+}
+
+#endif
+
+#ifdef __SSE2__
+
+static void sseLuma8(
+		const unsigned short* pixels,
+		unsigned char* luma)
+{
+	__m128i rgb = _mm_loadu_si128((const __m128i*) pixels);
+
+	__m128i r = _mm_and_si128(_mm_srli_epi16(rgb, 8), _mm_set1_epi16(0xF8));
+	__m128i g = _mm_and_si128(_mm_srli_epi16(rgb, 3), _mm_set1_epi16(0xFC));
+	__m128i b = _mm_and_si128(_mm_slli_epi16(rgb, 3), _mm_set1_epi16(0xF8));
+
+	__m128i l = _mm_mullo_epi16(r, _mm_set1_epi16(77));
+	l = _mm_add_epi16(l, _mm_mullo_epi16(g, _mm_set1_epi16(150)));
+	l = _mm_add_epi16(l, _mm_mullo_epi16(b, _mm_set1_epi16(29)));
+	l = _mm_srli_epi16(l, 8);
+
+	_mm_storel_epi64((__m128i*) luma, _mm_packus_epi16(l, l));
+}
+
+#endif
+
+/**
+ * Selects the luma kernel based on the CPU features.
+ */
+static LumaKernel selectLumaKernel()
+{
+	LumaKernel kernel = genericLuma8;
+
+#ifdef __ARM_NEON__
+	// Get the CPU family
+	AndroidCpuFamily cpuFamily = android_getCpuFamily();
+
+	// Get the CPU features
+	uint64_t cpuFeatures = android_getCpuFeatures();
+
+	// Use NEON optimized kernel only on ARM CPUs with NEON support
+	if ((ANDROID_CPU_FAMILY_ARM == cpuFamily)
+			&& ((ANDROID_CPU_ARM_FEATURE_NEON & cpuFeatures) != 0))
+	{
+		kernel = neonLuma8;
+	}
+#endif
+
+#ifdef __SSE2__
+	kernel = sseLuma8;
+#endif
+
+	return kernel;
+}
+
+unsigned int lumaHistogram(
+		const unsigned short* pixels,
+		int width,
+		int height,
+		long stride,
+		int step,
+		unsigned int* histogram)
+{
+	static const LumaKernel luma8 = selectLumaKernel();
+
+	unsigned char luma[8];
+	unsigned int samples = 0;
+
+	memset(histogram, 0,
+			LUMA_HISTOGRAM_LANES * LUMA_HISTOGRAM_SIZE * sizeof(unsigned int));
+
+	for (int y = 0; y < height; y += step)
+	{
+		const unsigned short* row = (const unsigned short*)
+				(((const unsigned char*) pixels) + (y * stride));
+
+		for (int x = 0; x + 8 <= width; x += 8 * step)
+		{
+			luma8(row + x, luma);
+
+			// Scatter into interleaved lanes
+			for (int i = 0; i < 8; i++)
+			{
+				histogram[((i & (LUMA_HISTOGRAM_LANES - 1))
+						* LUMA_HISTOGRAM_SIZE) + luma[i]]++;
+			}
+
+			samples += 8;
+		}
+	}
+
+	// Merge the lanes into the first one
+	for (int lane = 1; lane < LUMA_HISTOGRAM_LANES; lane++)
+	{
+		for (int i = 0; i < LUMA_HISTOGRAM_SIZE; i++)
+		{
+			histogram[i] += histogram[(lane * LUMA_HISTOGRAM_SIZE) + i];
+		}
+	}
+
+	return samples;
+}
+
+/**
+ * Gets the target brightness increment from the histogram.
+ */
+static unsigned int getTargetBrightness(
+		const unsigned int* histogram,
+		unsigned int samples)
+{
+	// Mean and 95th percentile luma
+	unsigned long long sum = 0;
+	unsigned int highlight = 0;
+	unsigned int count = 0;
+
+	for (unsigned int i = 0; i < LUMA_HISTOGRAM_SIZE; i++)
+	{
+		sum += (unsigned long long) i * histogram[i];
+
+		count += histogram[i];
+		if ((count * 20) < (samples * 19))
+		{
+			highlight = i + 1;
+		}
+	}
+
+	unsigned int mean = sum / samples;
+
+	// Lift dark frames towards the target without clipping highlights
+	unsigned int target = (mean < TARGET_LUMA) ? (TARGET_LUMA - mean) : 0;
+
+	unsigned int headroom = (highlight < MAX_HIGHLIGHT)
+			? (MAX_HIGHLIGHT - highlight) : 0;
+
+	target = (target > headroom) ? headroom : target;
+	target = (target > MAX_BRIGHTNESS) ? MAX_BRIGHTNESS : target;
+
+	return target;
+}
+
+/**
+ * Moves the level towards the target by exponential smoothing.
+ */
+static unsigned int smoothLevel(
+		unsigned int level,
+		unsigned int target)
+{
+	int delta = (int) (target << 8) - (int) level;
+
+	return level + (delta / (1 << SMOOTHING_SHIFT));
+}
+
+unsigned char updateAutoExposure(
+		AutoExposure* autoExposure,
+		const unsigned short* pixels,
+		int width,
+		int height,
+		long stride)
+{
+	long long startTime = GetTimeNanos();
+
+	unsigned int samples = lumaHistogram(pixels, width, height, stride,
+			SAMPLE_STEP, autoExposure->histogram);
+
+	autoExposure->histogramTime += GetTimeNanos() - startTime;
+	autoExposure->histogramFrames++;
+
+	// Report the histogram cost
+	if (REPORT_FRAMES == autoExposure->histogramFrames)
+	{
+		LOGI("Luma histogram %lld ns per frame",
+				autoExposure->histogramTime / autoExposure->histogramFrames);
+
+		autoExposure->histogramTime = 0;
+		autoExposure->histogramFrames = 0;
+	}
+
+	// Keep the current level if nothing is sampled
+	if (0 < samples)
+	{
+		autoExposure->level = smoothLevel(autoExposure->level,
+				getTargetBrightness(autoExposure->histogram, samples));
+	}
+
+	return (autoExposure->level + 128) >> 8;
+}
@@ -0,0 +1,73 @@
+#pragma once
+
+// Number of luma histogram bins
+#define LUMA_HISTOGRAM_SIZE 256
+
+// Number of interleaved sub-histograms, avoids back to back
+// increments of the same bin
+#define LUMA_HISTOGRAM_LANES 4
+
+/**
+ * Auto exposure state. Tracks the brightness level that is
+ * fed to the brightness filter, smoothed across frames.
+ */
+struct AutoExposure
+{
+	// Smoothed brightness level in 8.8 fixed point
+	unsigned int level;
+
+	// Histogram cost accumulated since the last report
+	long long histogramTime;
+	long histogramFrames;
+
+	unsigned int histogram[LUMA_HISTOGRAM_LANES * LUMA_HISTOGRAM_SIZE];
+
+	AutoExposure():
+		level(0),
+		histogramTime(0),
+		histogramFrames(0)
+	{
+
+	}
+};
+
+/**
+ * Computes the luma histogram of the given RGB565 frame on a
+ * subsampled grid. Every step-th row is sampled, and on those
+ * rows one group of 8 pixels out of every step groups.
+ *
+ * @param pixels RGB565 pixels.
+ * @param width frame width in pixels.
+ * @param height frame height in pixels.
+ * @param stride row stride in bytes.
+ * @param step subsampling step.
+ * @param histogram histogram with LUMA_HISTOGRAM_LANES *
+ *        LUMA_HISTOGRAM_SIZE bins. [OUT] The merged result
+ *        is in the first LUMA_HISTOGRAM_SIZE bins.
+ * @return number of samples.
+ */
+unsigned int lumaHistogram(
+		const unsigned short* pixels,
+		int width,
+		int height,
+		long stride,
+		int step,
+		unsigned int* histogram);
+
+/**
+ * Updates the auto exposure from the given RGB565 frame and
+ * returns the brightness for the brightness filter.
+ *
+ * @param autoExposure auto exposure state.
+ * @param pixels RGB565 pixels.
+ * @param width frame width in pixels.
+ * @param height frame height in pixels.
+ * @param stride row stride in bytes.
+ * @return brightness increment.
+ */
+unsigned char updateAutoExposure(
+		AutoExposure* autoExposure,
+		const unsigned short* pixels,
+		int width,
+		int height,
+		long stride);
@@ -0,0 +1,221 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "BrightnessFilter.h"
+
+// Benchmark frame, 720p repeated for a number of runs
+#define BENCHMARK_WIDTH 1280
+#define BENCHMARK_HEIGHT 720
+#define BENCHMARK_RUNS 200
+
+/**
+ * RGB565 brightness filter as it was before the pixel format
+ * traits, kept as the reference for timing and output.
+ */
+static void genericBrightnessFilter(
+		unsigned short* pixels,
+		long count,
+		unsigned char brightness)
+{
+	const unsigned char MAX_RB = 0xF8;
+	const unsigned char MAX_G = 0xFC;
+
+	unsigned short r, g, b;
+
+	for (long i = 0; i < count; i++)
+	{
+		// Decompose colors
+		r = (pixels[i] >> 8) & MAX_RB;
+		g = (pixels[i] >> 3) & MAX_G;
+		b = (pixels[i] << 3) & MAX_RB;
+
+		// Brightness increment
+		r += brightness;
+		g += brightness;
+		b += brightness;
+
+		// Make sure that components are in range
+		r = (r > MAX_RB) ? MAX_RB : r;
+		g = (g > MAX_G) ? MAX_G : g;
+		b = (b > MAX_RB) ? MAX_RB : b;
+
+		// Set pixel
+		pixels[i] = (r << 8);
+		pixels[i] |= (g << 3);
+		pixels[i] |= (b >> 3);
+	}
+}
+
+/**
+ * Brightness filter entry point under test.
+ */
+typedef void (*BenchmarkFilter)(
+		unsigned char* pixels,
+		long count,
+		unsigned char brightness);
+
+static void referenceFilter(
+		unsigned char* pixels,
+		long count,
+		unsigned char brightness)
+{
+	genericBrightnessFilter((unsigned short*) pixels, count, brightness);
+}
+
+static void entryPointFilter(
+		unsigned char* pixels,
+		long count,
+		unsigned char brightness)
+{
+	brightnessFilter((unsigned short*) pixels, count, brightness);
+}
+
+/**
+ * Gets the monotonic clock time.
+ *
+ * @return time in nanoseconds.
+ */
+static long long getTimeNanos()
+{
+	struct timespec now;
+	clock_gettime(CLOCK_MONOTONIC, &now);
+
+	return (now.tv_sec * 1000000000LL) + now.tv_nsec;
+}
+
+/**
+ * Fills the frame with a repeatable pattern.
+ */
+static void fillFrame(
+		unsigned char* pixels,
+		long size)
+{
+	unsigned int seed = 1;
+
+	for (long i = 0; i < size; i++)
+	{
+		seed = (seed * 1103515245) + 12345;
+		pixels[i] = seed >> 16;
+	}
+}
+
+/**
+ * Times the filter over the benchmark frame and prints the
+ * mean time per frame.
+ *
+ * @return mean time per frame in nanoseconds.
+ */
+static long long runBenchmark(
+		const char* name,
+		BenchmarkFilter filter,
+		int bytesPerPixel)
+{
+	long count = BENCHMARK_WIDTH * BENCHMARK_HEIGHT;
+	long size = count * bytesPerPixel;
+	unsigned char* pixels = (unsigned char*) malloc(size);
+
+	fillFrame(pixels, size);
+
+	// Warm up the caches, not timed
+	filter(pixels, count, 8);
+
+	long long start = getTimeNanos();
+	for (int i = 0; i < BENCHMARK_RUNS; i++)
+	{
+		// Refill now and then so that the frame does not saturate
+		if (0 == (i % 16))
+		{
+			fillFrame(pixels, size);
+		}
+
+		filter(pixels, count, (unsigned char) (i & 0x1F));
+	}
+	long long time = (getTimeNanos() - start) / BENCHMARK_RUNS;
+
+	printf("%-16s %8lld us per %dx%d frame\n",
+			name,
+			time / 1000,
+			BENCHMARK_WIDTH,
+			BENCHMARK_HEIGHT);
+
+	free(pixels);
+
+	return time;
+}
+
+/**
+ * Compares the RGB565 template against the old kernel. They
+ * must match for multiples of 8, and increments below the
+ * component precision must leave the frame unchanged.
+ *
+ * @return number of failed checks.
+ */
+static int checkOutput()
+{
+	int failures = 0;
+
+	long count = BENCHMARK_WIDTH * 16;
+	long size = count * 2;
+	unsigned char* original = (unsigned char*) malloc(size);
+	unsigned char* reference = (unsigned char*) malloc(size);
+	unsigned char* pixels = (unsigned char*) malloc(size);
+
+	fillFrame(original, size);
+
+	for (int brightness = 0; brightness < 256; brightness += 8)
+	{
+		memcpy(reference, original, size);
+		memcpy(pixels, original, size);
+
+		genericBrightnessFilter((unsigned short*) reference, count,
+				brightness);
+		brightnessFilter<Rgb565Format>(pixels, count, brightness);
+
+		if (0 != memcmp(reference, pixels, size))
+		{
+			printf("brightness %d: output differs from the old kernel\n",
+					brightness);
+			failures++;
+		}
+	}
+
+	memcpy(pixels, original, size);
+	brightnessFilter<Rgb565Format>(pixels, count, 1);
+
+	if (0 != memcmp(original, pixels, size))
+	{
+		printf("brightness 1: frame changed\n");
+		failures++;
+	}
+
+	free(pixels);
+	free(reference);
+	free(original);
+
+	return failures;
+}
+
+int main()
+{
+	int failures = checkOutput();
+
+	long long reference = runBenchmark("rgb565 old", referenceFilter, 2);
+	long long rgb565 = runBenchmark("rgb565 template",
+			brightnessFilter<Rgb565Format>, 2);
+
+	// NEON kernel on armeabi-v7a, the template elsewhere
+	runBenchmark("rgb565 entry", entryPointFilter, 2);
+
+	runBenchmark("rgba8888 template",
+			brightnessFilter<Rgba8888Format>, 4);
+	runBenchmark("rgb888 template",
+			brightnessFilter<Rgb888Format>, 3);
+
+	printf("rgb565 template runs at %lld%% of the old kernel time, %s\n",
+			(rgb565 * 100) / reference,
+			(0 == failures) ? "ok" : "FAILED");
+
+	return (0 == failures) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
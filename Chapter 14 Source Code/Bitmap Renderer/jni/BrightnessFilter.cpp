@@ -72,40 +72,79 @@ static void neonBrightnessFilter(
 
 #endif
 
-static void genericBrightnessFilter(
-		unsigned short* pixels,
+// Pixels per iteration, the inner loop is fully unrolled
+static const long UNROLL = 8;
+
+/**
+ * Clamps the value to the given maximum without a branch.
+ */
+static inline unsigned int saturate(
+		unsigned int value,
+		unsigned int max)
+{
+	return (value > max) ? max : value;
+}
+
+/**
+ * Applies the brightness increment to a single pixel.
+ */
+template<typename Format>
+static inline void brightnessPixel(
+		unsigned char* pixel,
+		unsigned int brightness)
+{
+	unsigned int r, g, b;
+
+	// Decompose colors
+	Format::unpack(pixel, r, g, b);
+
+	// Brightness increment, make sure that components are in range
+	r = saturate(r + brightness, Format::MAX_R);
+	g = saturate(g + brightness, Format::MAX_G);
+	b = saturate(b + brightness, Format::MAX_B);
+
+	// Set pixel
+	Format::pack(pixel, r, g, b);
+}
+
+template<typename Format>
+void brightnessFilter(
+		unsigned char* pixels,
 		long count,
 		unsigned char brightness)
 {
-	const unsigned char MAX_RB = 0xF8;
-	const unsigned char MAX_G = 0xFC;
+	long i = 0;
 
-	unsigned short r, g, b;
+	// Component layout and limits are compile time constants
+	for (; i + UNROLL <= count; i += UNROLL)
+	{
+		unsigned char* block = pixels + (i * Format::BYTES_PER_PIXEL);
+
+		for (long j = 0; j < UNROLL; j++)
+		{
+			brightnessPixel<Format>(
+					block + (j * Format::BYTES_PER_PIXEL),
+					brightness);
+		}
+	}
 
-	for (long i = 0; i < count; i++)
+	// Remaining pixels
+	for (; i < count; i++)
 	{
-		// Decompose colors
-		r = (pixels[i] >> 8) & MAX_RB;
-		g = (pixels[i] >> 3) & MAX_G;
-		b = (pixels[i] << 3) & MAX_RB;
-
-		// Brightness increment
-		r += brightness;
-		g += brightness;
-		b += brightness;
-
-		// Make sure that components are in range
-		r = (r > MAX_RB) ? MAX_RB : r;
-		g = (g > MAX_G) ? MAX_G : g;
-		b = (b > MAX_RB) ? MAX_RB : b;
-
-		// Set pixel
-		pixels[i] = (r << 8);
-		pixels[i] |= (g << 3);
-		pixels[i] |= (b >> 3);
+		brightnessPixel<Format>(
+				pixels + (i * Format::BYTES_PER_PIXEL),
+				brightness);
 	}
 }
 
+// Explicit instantiations for the supported pixel formats
+template void brightnessFilter<Rgb565Format>(
+		unsigned char*, long, unsigned char);
+template void brightnessFilter<Rgba8888Format>(
+		unsigned char*, long, unsigned char);
+template void brightnessFilter<Rgb888Format>(
+		unsigned char*, long, unsigned char);
+
 void brightnessFilter(
 		unsigned short* pixels,
 		long count,
@@ -130,7 +169,10 @@ void brightnessFilter(
 	{
 #endif
 		// Invoke the generic brightness filter
-		genericBrightnessFilter(pixels, count, brightness);
+		brightnessFilter<Rgb565Format>(
+				(unsigned char*) pixels,
+				count,
+				brightness);
 #ifdef __ARM_NEON__
 	}
 #endif
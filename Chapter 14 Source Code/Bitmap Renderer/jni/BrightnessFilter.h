@@ -1,5 +1,7 @@
 #pragma once
 
+#include "PixelFormat.h"
+
 /**
  * Extract the interleaved components. RGB565 color
  * space has a total of 16-bits with 5-bits red,
@@ -9,3 +11,19 @@ void brightnessFilter(
 		unsigned short* pixels,
 		long count,
 		unsigned char brightness);
+
+/**
+ * Brightness filter for the given pixel format traits. The
+ * component layout is resolved at compile time, and it is
+ * explicitly instantiated for Rgb565Format, Rgba8888Format
+ * and Rgb888Format.
+ *
+ * @param pixels pixels in the given format.
+ * @param count number of pixels.
+ * @param brightness brightness increment.
+ */
+template<typename Format>
+void brightnessFilter(
+		unsigned char* pixels,
+		long count,
+		unsigned char brightness);
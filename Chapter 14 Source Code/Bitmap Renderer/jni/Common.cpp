@@ -1,5 +1,7 @@
 #include "Common.h"
 
+#include <time.h>
+
 void ThrowException(
 		JNIEnv* env,
 		const char* className,
@@ -18,3 +20,12 @@ void ThrowException(
 		env->DeleteLocalRef(clazz);
 	}
 }
+
+long long GetTimeNanos()
+{
+	struct timespec now;
+
+	clock_gettime(CLOCK_MONOTONIC, &now);
+
+	return (now.tv_sec * 1000000000LL) + now.tv_nsec;
+}
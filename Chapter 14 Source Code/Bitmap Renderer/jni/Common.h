@@ -2,6 +2,16 @@
 
 #include <jni.h>
 
+#include <android/log.h>
+
+// Log tag
+#define LOG_TAG "AVIPlayer"
+
+// Log macros
+#define LOGI(...) __android_log_print(ANDROID_LOG_INFO, LOG_TAG, __VA_ARGS__)
+#define LOGW(...) __android_log_print(ANDROID_LOG_WARN, LOG_TAG, __VA_ARGS__)
+#define LOGE(...) __android_log_print(ANDROID_LOG_ERROR, LOG_TAG, __VA_ARGS__)
+
 /**
  * Throws a new exception using the given exception class
  * and exception message.
@@ -15,3 +25,10 @@ void ThrowException(
 		const char* className,
 		const char* message);
 
+/**
+ * Gets the monotonic clock time.
+ *
+ * @return time in nanoseconds.
+ */
+long long GetTimeNanos();
+
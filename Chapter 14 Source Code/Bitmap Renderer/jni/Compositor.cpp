@@ -0,0 +1,762 @@
+#include "Compositor.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "PixelFormat.h"
+
+#ifdef __ARM_NEON__
+
+#include <cpu-features.h>
+
+#include <arm_neon.h>
+
+#endif
+
+#ifdef __SSE2__
+
+#include <emmintrin.h>
+
+#endif
+
+// Overlay tile size in pixels
+#define TILE_SIZE 16
+
+/**
+ * Overlay tile classes.
+ */
+enum TileClass
+{
+	TILE_TRANSPARENT = 0,
+	TILE_OPAQUE = 1,
+	TILE_BLENDED = 2
+};
+
+/**
+ * Chroma key color components and tolerance.
+ */
+struct ChromaKey
+{
+	unsigned char r;
+	unsigned char g;
+	unsigned char b;
+	unsigned char tolerance;
+};
+
+/**
+ * Row kernel, composites count overlay pixels onto the
+ * RGB565 pixels.
+ */
+typedef void (*CompositeKernel)(
+		unsigned short* pixels,
+		const unsigned char* overlay,
+		int count,
+		const ChromaKey* key);
+
+/**
+ * Compositor kernels.
+ */
+struct CompositorKernels
+{
+	// Blends the overlay using its alpha
+	CompositeKernel blend;
+
+	// Replaces the pixels with the opaque overlay
+	CompositeKernel copy;
+
+	// Blends the overlay onto the key colored pixels
+	CompositeKernel key;
+};
+
+struct Compositor
+{
+	// Overlay geometry
+	int width;
+	int height;
+	int left;
+	int top;
+
+	// RGBA8888 overlay pixels
+	unsigned char* overlay;
+
+	// Tile classes
+	int tileColumns;
+	int tileRows;
+	unsigned char* tiles;
+
+	bool isChromaKeyed;
+	ChromaKey key;
+
+	CompositorKernels kernels;
+
+	Compositor():
+		width(0),
+		height(0),
+		left(0),
+		top(0),
+		overlay(0),
+		tileColumns(0),
+		tileRows(0),
+		tiles(0),
+		isChromaKeyed(false)
+	{
+
+	}
+};
+
+static inline unsigned int blendComponent(
+		unsigned int source,
+		unsigned int destination,
+		unsigned int inverseAlpha)
+{
+	unsigned int c = source + ((destination * inverseAlpha) >> 8);
+	return (c > 0xFF) ? 0xFF : c;
+}
+
+static inline void genericBlendPixel(
+		unsigned short* pixel,
+		const unsigned char* overlay)
+{
+	unsigned int r, g, b;
+	Rgb565Format::unpack((const unsigned char*) pixel, r, g, b);
+
+	// Overlay is premultiplied, so only the frame is scaled
+	unsigned int inverseAlpha = 256 - overlay[3];
+
+	Rgb565Format::pack((unsigned char*) pixel,
+			blendComponent(overlay[0], r, inverseAlpha),
+			blendComponent(overlay[1], g, inverseAlpha),
+			blendComponent(overlay[2], b, inverseAlpha));
+}
+
+static inline bool isKeyColor(
+		const unsigned short* pixel,
+		const ChromaKey* key)
+{
+	unsigned int r, g, b;
+	Rgb565Format::unpack((const unsigned char*) pixel, r, g, b);
+
+	return (abs((int) r - key->r) < key->tolerance)
+			&& (abs((int) g - key->g) < key->tolerance)
+			&& (abs((int) b - key->b) < key->tolerance);
+}
+
+static void genericBlend(
+		unsigned short* pixels,
+		const unsigned char* overlay,
+		int count,
+		const ChromaKey* /* key */)
+{
+	for (int i = 0; i < count; i++, overlay += 4)
+	{
+		genericBlendPixel(&pixels[i], overlay);
+	}
+}
+
+static void genericCopy(
+		unsigned short* pixels,
+		const unsigned char* overlay,
+		int count,
+		const ChromaKey* /* key */)
+{
+	for (int i = 0; i < count; i++, overlay += 4)
+	{
+		Rgb565Format::pack((unsigned char*) &pixels[i],
+				overlay[0], overlay[1], overlay[2]);
+	}
+}
+
+static void genericKey(
+		unsigned short* pixels,
+		const unsigned char* overlay,
+		int count,
+		const ChromaKey* key)
+{
+	for (int i = 0; i < count; i++, overlay += 4)
+	{
+		if (isKeyColor(&pixels[i], key))
+		{
+			genericBlendPixel(&pixels[i], overlay);
+		}
+	}
+}
+
+static const CompositorKernels GENERIC_KERNELS =
+{
+	genericBlend,
+	genericCopy,
+	genericKey
+};
+
+#ifdef __ARM_NEON__
+
+static inline void neonUnpack(
+		uint16x8_t rgb,
+		uint8x8_t& r,
+		uint8x8_t& g,
+		uint8x8_t& b)
+{
+	r = vand_u8(vshrn_n_u16(rgb, 8), vdup_n_u8(Rgb565Format::MAX_R));
+	g = vand_u8(vshrn_n_u16(rgb, 3), vdup_n_u8(Rgb565Format::MAX_G));
+	b = vand_u8(vshl_n_u8(vmovn_u16(rgb), 3), vdup_n_u8(Rgb565Format::MAX_B));
+}
+
+static inline uint16x8_t neonPack(
+		uint8x8_t r,
+		uint8x8_t g,
+		uint8x8_t b)
+{
+	uint16x8_t rgb = vshll_n_u8(r, 8);
+	rgb = vsriq_n_u16(rgb, vshll_n_u8(g, 8), 5);
+	return vsriq_n_u16(rgb, vshll_n_u8(b, 8), 11);
+}
+
+static inline uint8x8_t neonBlendComponent(
+		uint8x8_t source,
+		uint8x8_t destination,
+		uint16x8_t inverseAlpha)
+{
+	uint16x8_t scaled = vmulq_u16(vmovl_u8(destination), inverseAlpha);
+	return vqadd_u8(source, vshrn_n_u16(scaled, 8));
+}
+
+/**
+ * Blends 8 overlay pixels onto the frame pixels, and
+ * selects the blended pixels where the mask is set.
+ */
+static inline uint16x8_t neonBlend(
+		uint16x8_t rgb,
+		const unsigned char* overlay,
+		const ChromaKey* key)
+{
+	uint8x8_t r, g, b;
+	neonUnpack(rgb, r, g, b);
+
+	// Deinterleave the overlay components
+	uint8x8x4_t rgba = vld4_u8(overlay);
+	uint16x8_t inverseAlpha = vsubq_u16(vdupq_n_u16(256), vmovl_u8(rgba.val[3]));
+
+	uint8x8_t br = neonBlendComponent(rgba.val[0], r, inverseAlpha);
+	uint8x8_t bg = neonBlendComponent(rgba.val[1], g, inverseAlpha);
+	uint8x8_t bb = neonBlendComponent(rgba.val[2], b, inverseAlpha);
+
+	if (0 != key)
+	{
+		uint8x8_t tolerance = vdup_n_u8(key->tolerance);
+
+		// Keep the pixels that are not key colored
+		uint8x8_t isKey = vand_u8(
+				vclt_u8(vabd_u8(r, vdup_n_u8(key->r)), tolerance),
+				vand_u8(vclt_u8(vabd_u8(g, vdup_n_u8(key->g)), tolerance),
+						vclt_u8(vabd_u8(b, vdup_n_u8(key->b)), tolerance)));
+
+		br = vbsl_u8(isKey, br, r);
+		bg = vbsl_u8(isKey, bg, g);
+		bb = vbsl_u8(isKey, bb, b);
+	}
+
+	return neonPack(br, bg, bb);
+}
+
+static void neonBlend(
+		unsigned short* pixels,
+		const unsigned char* overlay,
+		int count,
+		const ChromaKey* key)
+{
+	int i = 0;
+	for (; i + 8 <= count; i += 8, overlay += 32)
+	{
+		vst1q_u16(&pixels[i], neonBlend(vld1q_u16(&pixels[i]), overlay, 0));
+	}
+
+	genericBlend(&pixels[i], overlay, count - i, key);
+}
+
+static void neonCopy(
+		unsigned short* pixels,
+		const unsigned char* overlay,
+		int count,
+		const ChromaKey* key)
+{
+	int i = 0;
+	for (; i + 8 <= count; i += 8, overlay += 32)
+	{
+		uint8x8x4_t rgba = vld4_u8(overlay);
+		vst1q_u16(&pixels[i], neonPack(rgba.val[0], rgba.val[1], rgba.val[2]));
+	}
+
+	genericCopy(&pixels[i], overlay, count - i, key);
+}
+
+static void neonKey(
+		unsigned short* pixels,
+		const unsigned char* overlay,
+		int count,
+		const ChromaKey* key)
+{
+	int i = 0;
+	for (; i + 8 <= count; i += 8, overlay += 32)
+	{
+		vst1q_u16(&pixels[i], neonBlend(vld1q_u16(&pixels[i]), overlay, key));
+	}
+
+	genericKey(&pixels[i], overlay, count - i, key);
+}
+
+static const CompositorKernels NEON_KERNELS =
+{
+	neonBlend,
+	neonCopy,
+	neonKey
+};
+
+#endif
+
+#ifdef __SSE2__
+
+static inline void sseUnpack(
+		__m128i rgb,
+		__m128i& r,
+		__m128i& g,
+		__m128i& b)
+{
+	r = _mm_and_si128(_mm_srli_epi16(rgb, 8), _mm_set1_epi16(Rgb565Format::MAX_R));
+	g = _mm_and_si128(_mm_srli_epi16(rgb, 3), _mm_set1_epi16(Rgb565Format::MAX_G));
+	b = _mm_and_si128(_mm_slli_epi16(rgb, 3), _mm_set1_epi16(Rgb565Format::MAX_B));
+}
+
+static inline __m128i ssePack(
+		__m128i r,
+		__m128i g,
+		__m128i b)
+{
+	__m128i rgb = _mm_slli_epi16(_mm_and_si128(r, _mm_set1_epi16(Rgb565Format::MAX_R)), 8);
+	rgb = _mm_or_si128(rgb, _mm_slli_epi16(_mm_and_si128(g, _mm_set1_epi16(Rgb565Format::MAX_G)), 3));
+	return _mm_or_si128(rgb, _mm_srli_epi16(_mm_and_si128(b, _mm_set1_epi16(Rgb565Format::MAX_B)), 3));
+}
+
+/**
+ * Deinterleaves 8 RGBA8888 overlay pixels into 16-bit lanes.
+ */
+static inline void sseUnpackOverlay(
+		const unsigned char* overlay,
+		__m128i& r,
+		__m128i& g,
+		__m128i& b,
+		__m128i& a)
+{
+	__m128i mask = _mm_set1_epi32(0xFF);
+	__m128i lo = _mm_loadu_si128((const __m128i*) overlay);
+	__m128i hi = _mm_loadu_si128((const __m128i*) (overlay + 16));
+
+	r = _mm_packs_epi32(_mm_and_si128(lo, mask), _mm_and_si128(hi, mask));
+	g = _mm_packs_epi32(_mm_and_si128(_mm_srli_epi32(lo, 8), mask),
+			_mm_and_si128(_mm_srli_epi32(hi, 8), mask));
+	b = _mm_packs_epi32(_mm_and_si128(_mm_srli_epi32(lo, 16), mask),
+			_mm_and_si128(_mm_srli_epi32(hi, 16), mask));
+	a = _mm_packs_epi32(_mm_srli_epi32(lo, 24), _mm_srli_epi32(hi, 24));
+}
+
+static inline __m128i sseBlendComponent(
+		__m128i source,
+		__m128i destination,
+		__m128i inverseAlpha)
+{
+	__m128i scaled = _mm_srli_epi16(_mm_mullo_epi16(destination, inverseAlpha), 8);
+	return _mm_min_epi16(_mm_add_epi16(source, scaled), _mm_set1_epi16(0xFF));
+}
+
+static inline __m128i sseAbsDiff(
+		__m128i a,
+		__m128i b)
+{
+	return _mm_or_si128(_mm_subs_epu16(a, b), _mm_subs_epu16(b, a));
+}
+
+static inline __m128i sseSelect(
+		__m128i mask,
+		__m128i a,
+		__m128i b)
+{
+	return _mm_or_si128(_mm_and_si128(mask, a), _mm_andnot_si128(mask, b));
+}
+
+/**
+ * Blends 8 overlay pixels onto the frame pixels, only onto
+ * the key colored ones if a key is given.
+ */
+static inline __m128i sseBlend(
+		__m128i rgb,
+		const unsigned char* overlay,
+		const ChromaKey* key)
+{
+	__m128i r, g, b;
+	sseUnpack(rgb, r, g, b);
+
+	__m128i sr, sg, sb, sa;
+	sseUnpackOverlay(overlay, sr, sg, sb, sa);
+
+	__m128i inverseAlpha = _mm_sub_epi16(_mm_set1_epi16(256), sa);
+
+	sr = sseBlendComponent(sr, r, inverseAlpha);
+	sg = sseBlendComponent(sg, g, inverseAlpha);
+	sb = sseBlendComponent(sb, b, inverseAlpha);
+
+	if (0 != key)
+	{
+		__m128i tolerance = _mm_set1_epi16(key->tolerance);
+
+		// Keep the pixels that are not key colored
+		__m128i isKey = _mm_and_si128(
+				_mm_cmplt_epi16(sseAbsDiff(r, _mm_set1_epi16(key->r)), tolerance),
+				_mm_and_si128(
+						_mm_cmplt_epi16(sseAbsDiff(g, _mm_set1_epi16(key->g)), tolerance),
+						_mm_cmplt_epi16(sseAbsDiff(b, _mm_set1_epi16(key->b)), tolerance)));
+
+		sr = sseSelect(isKey, sr, r);
+		sg = sseSelect(isKey, sg, g);
+		sb = sseSelect(isKey, sb, b);
+	}
+
+	return ssePack(sr, sg, sb);
+}
+
+static void sseBlend(
+		unsigned short* pixels,
+		const unsigned char* overlay,
+		int count,
+		const ChromaKey* key)
+{
+	int i = 0;
+	for (; i + 8 <= count; i += 8, overlay += 32)
+	{
+		__m128i rgb = _mm_loadu_si128((const __m128i*) &pixels[i]);
+		_mm_storeu_si128((__m128i*) &pixels[i], sseBlend(rgb, overlay, 0));
+	}
+
+	genericBlend(&pixels[i], overlay, count - i, key);
+}
+
+static void sseCopy(
+		unsigned short* pixels,
+		const unsigned char* overlay,
+		int count,
+		const ChromaKey* key)
+{
+	int i = 0;
+	for (; i + 8 <= count; i += 8, overlay += 32)
+	{
+		__m128i r, g, b, a;
+		sseUnpackOverlay(overlay, r, g, b, a);
+		_mm_storeu_si128((__m128i*) &pixels[i], ssePack(r, g, b));
+	}
+
+	genericCopy(&pixels[i], overlay, count - i, key);
+}
+
+static void sseKey(
+		unsigned short* pixels,
+		const unsigned char* overlay,
+		int count,
+		const ChromaKey* key)
+{
+	int i = 0;
+	for (; i + 8 <= count; i += 8, overlay += 32)
+	{
+		__m128i rgb = _mm_loadu_si128((const __m128i*) &pixels[i]);
+		_mm_storeu_si128((__m128i*) &pixels[i], sseBlend(rgb, overlay, key));
+	}
+
+	genericKey(&pixels[i], overlay, count - i, key);
+}
+
+static const CompositorKernels SSE_KERNELS =
+{
+	sseBlend,
+	sseCopy,
+	sseKey
+};
+
+#endif
+
+/**
+ * Selects the kernels based on the CPU features.
+ */
+static CompositorKernels selectKernels()
+{
+	CompositorKernels kernels = GENERIC_KERNELS;
+
+#ifdef __ARM_NEON__
+	// Get the CPU family
+	AndroidCpuFamily cpuFamily = android_getCpuFamily();
+
+	// Get the CPU features
+	uint64_t cpuFeatures = android_getCpuFeatures();
+
+	// Use NEON optimized kernels only on ARM CPUs with NEON support
+	if ((ANDROID_CPU_FAMILY_ARM == cpuFamily)
+			&& ((ANDROID_CPU_ARM_FEATURE_NEON & cpuFeatures) != 0))
+	{
+		kernels = NEON_KERNELS;
+	}
+#endif
+
+#ifdef __SSE2__
+	kernels = SSE_KERNELS;
+#endif
+
+	return kernels;
+}
+
+/**
+ * Classifies the overlay tile by its alpha values.
+ */
+static unsigned char classifyTile(
+		const unsigned char* overlay,
+		long stride,
+		int width,
+		int height)
+{
+	bool isTransparent = true;
+	bool isOpaque = true;
+
+	for (int y = 0; y < height; y++)
+	{
+		const unsigned char* alpha = overlay + (y * stride) + 3;
+
+		for (int x = 0; x < width; x++, alpha += 4)
+		{
+			isTransparent = isTransparent && (0x00 == *alpha);
+			isOpaque = isOpaque && (0xFF == *alpha);
+		}
+	}
+
+	unsigned char tileClass = TILE_BLENDED;
+	if (isTransparent)
+	{
+		tileClass = TILE_TRANSPARENT;
+	}
+	else if (isOpaque)
+	{
+		tileClass = TILE_OPAQUE;
+	}
+
+	return tileClass;
+}
+
+Compositor* createCompositor(
+		int width,
+		int height)
+{
+	Compositor* compositor = 0;
+
+	if ((0 >= width) || (0 >= height))
+	{
+		goto exit;
+	}
+
+	compositor = new Compositor();
+	if (0 == compositor)
+	{
+		goto exit;
+	}
+
+	compositor->width = width;
+	compositor->height = height;
+	compositor->tileColumns = (width + TILE_SIZE - 1) / TILE_SIZE;
+	compositor->tileRows = (height + TILE_SIZE - 1) / TILE_SIZE;
+	compositor->kernels = selectKernels();
+
+	compositor->overlay = (unsigned char*) malloc(
+			(long) width * height * Rgba8888Format::BYTES_PER_PIXEL);
+	compositor->tiles = (unsigned char*) malloc(
+			compositor->tileColumns * compositor->tileRows);
+
+	if ((0 == compositor->overlay) || (0 == compositor->tiles))
+	{
+		destroyCompositor(compositor);
+		compositor = 0;
+		goto exit;
+	}
+
+	// Nothing to composite until an overlay is set
+	memset(compositor->tiles, TILE_TRANSPARENT,
+			compositor->tileColumns * compositor->tileRows);
+
+exit:
+	return compositor;
+}
+
+void destroyCompositor(
+		Compositor* compositor)
+{
+	if (0 != compositor)
+	{
+		free(compositor->overlay);
+		free(compositor->tiles);
+		delete compositor;
+	}
+}
+
+bool isCompositorSize(
+		const Compositor* compositor,
+		int width,
+		int height)
+{
+	return (0 != compositor)
+			&& (width == compositor->width)
+			&& (height == compositor->height);
+}
+
+void setCompositorOverlay(
+		Compositor* compositor,
+		const void* overlay,
+		long stride,
+		int left,
+		int top,
+		unsigned int keyColor,
+		int keyTolerance)
+{
+	long rowSize = (long) compositor->width * Rgba8888Format::BYTES_PER_PIXEL;
+
+	// Copy the overlay rows
+	for (int y = 0; y < compositor->height; y++)
+	{
+		memcpy(compositor->overlay + (y * rowSize),
+				((const unsigned char*) overlay) + (y * stride),
+				rowSize);
+	}
+
+	// Classify the tiles
+	for (int row = 0; row < compositor->tileRows; row++)
+	{
+		int y = row * TILE_SIZE;
+		int height = compositor->height - y;
+		if (height > TILE_SIZE)
+		{
+			height = TILE_SIZE;
+		}
+
+		for (int column = 0; column < compositor->tileColumns; column++)
+		{
+			int x = column * TILE_SIZE;
+			int width = compositor->width - x;
+			if (width > TILE_SIZE)
+			{
+				width = TILE_SIZE;
+			}
+
+			compositor->tiles[(row * compositor->tileColumns) + column] =
+					classifyTile(compositor->overlay + (y * rowSize)
+							+ (x * Rgba8888Format::BYTES_PER_PIXEL),
+							rowSize,
+							width,
+							height);
+		}
+	}
+
+	compositor->left = left;
+	compositor->top = top;
+
+	// Key components, 0xAARRGGBB
+	compositor->isChromaKeyed = (0 < keyTolerance);
+	compositor->key.r = (keyColor >> 16) & 0xFF;
+	compositor->key.g = (keyColor >> 8) & 0xFF;
+	compositor->key.b = keyColor & 0xFF;
+	compositor->key.tolerance = (keyTolerance > 0xFF) ? 0xFF : keyTolerance;
+}
+
+void composite(
+		Compositor* compositor,
+		unsigned short* pixels,
+		int width,
+		int height,
+		long stride)
+{
+	long rowSize = (long) compositor->width * Rgba8888Format::BYTES_PER_PIXEL;
+	const ChromaKey* key = &compositor->key;
+
+	// Overlay area visible on the frame, in overlay coordinates
+	int startX = (compositor->left < 0) ? -compositor->left : 0;
+	int startY = (compositor->top < 0) ? -compositor->top : 0;
+	int endX = width - compositor->left;
+	int endY = height - compositor->top;
+
+	if (endX > compositor->width)
+	{
+		endX = compositor->width;
+	}
+
+	if (endY > compositor->height)
+	{
+		endY = compositor->height;
+	}
+
+	for (int row = startY / TILE_SIZE; row * TILE_SIZE < endY; row++)
+	{
+		int tileStartY = row * TILE_SIZE;
+		int tileEndY = tileStartY + TILE_SIZE;
+
+		if (tileStartY < startY)
+		{
+			tileStartY = startY;
+		}
+
+		if (tileEndY > endY)
+		{
+			tileEndY = endY;
+		}
+
+		for (int column = startX / TILE_SIZE; column * TILE_SIZE < endX; column++)
+		{
+			unsigned char tileClass =
+					compositor->tiles[(row * compositor->tileColumns) + column];
+
+			// Nothing to do for the transparent tiles
+			if (TILE_TRANSPARENT == tileClass)
+			{
+				continue;
+			}
+
+			CompositeKernel kernel;
+			if (compositor->isChromaKeyed)
+			{
+				kernel = compositor->kernels.key;
+			}
+			else if (TILE_OPAQUE == tileClass)
+			{
+				kernel = compositor->kernels.copy;
+			}
+			else
+			{
+				kernel = compositor->kernels.blend;
+			}
+
+			int tileStartX = column * TILE_SIZE;
+			int tileEndX = tileStartX + TILE_SIZE;
+
+			if (tileStartX < startX)
+			{
+				tileStartX = startX;
+			}
+
+			if (tileEndX > endX)
+			{
+				tileEndX = endX;
+			}
+
+			for (int y = tileStartY; y < tileEndY; y++)
+			{
+				unsigned short* frameRow = (unsigned short*) (((unsigned char*) pixels)
+						+ ((y + compositor->top) * stride));
+
+				kernel(frameRow + tileStartX + compositor->left,
+						compositor->overlay + (y * rowSize)
+								+ (tileStartX * Rgba8888Format::BYTES_PER_PIXEL),
+						tileEndX - tileStartX,
+						key);
+			}
+		}
+	}
+}
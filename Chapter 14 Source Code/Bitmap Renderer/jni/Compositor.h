@@ -0,0 +1,83 @@
+#pragma once
+
+/**
+ * Overlay compositor state. Holds a copy of the RGBA8888
+ * overlay and the transparency class of each overlay tile.
+ */
+struct Compositor;
+
+/**
+ * Creates a new compositor for overlays of the given size.
+ *
+ * @param width overlay width in pixels.
+ * @param height overlay height in pixels.
+ * @return compositor or 0 on failure.
+ */
+Compositor* createCompositor(
+		int width,
+		int height);
+
+/**
+ * Destroys the given compositor.
+ *
+ * @param compositor compositor.
+ */
+void destroyCompositor(
+		Compositor* compositor);
+
+/**
+ * Checks if the compositor can hold an overlay of the
+ * given size without reallocating.
+ *
+ * @param compositor compositor.
+ * @param width overlay width in pixels.
+ * @param height overlay height in pixels.
+ * @return true if the size matches, false otherwise.
+ */
+bool isCompositorSize(
+		const Compositor* compositor,
+		int width,
+		int height);
+
+/**
+ * Copies the overlay into the compositor and classifies
+ * its tiles as transparent, opaque or blended.
+ *
+ * If the key tolerance is zero, the overlay is alpha blended
+ * onto the frames. Otherwise the overlay is only blended onto
+ * the frame pixels that are within the tolerance of the key
+ * color on every component, like a green screen.
+ *
+ * @param compositor compositor.
+ * @param overlay premultiplied RGBA8888 overlay pixels.
+ * @param stride overlay row stride in bytes.
+ * @param left overlay position on the frame.
+ * @param top overlay position on the frame.
+ * @param keyColor key color as 0xAARRGGBB.
+ * @param keyTolerance key tolerance, zero disables keying.
+ */
+void setCompositorOverlay(
+		Compositor* compositor,
+		const void* overlay,
+		long stride,
+		int left,
+		int top,
+		unsigned int keyColor,
+		int keyTolerance);
+
+/**
+ * Composites the overlay in place onto the given RGB565
+ * frame. Fully transparent overlay tiles are skipped.
+ *
+ * @param compositor compositor.
+ * @param pixels RGB565 pixels.
+ * @param width frame width in pixels.
+ * @param height frame height in pixels.
+ * @param stride row stride in bytes.
+ */
+void composite(
+		Compositor* compositor,
+		unsigned short* pixels,
+		int width,
+		int height,
+		long stride);
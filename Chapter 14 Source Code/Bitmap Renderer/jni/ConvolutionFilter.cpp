@@ -0,0 +1,1104 @@
+#include "ConvolutionFilter.h"
+#include "PixelFormat.h"
+
+#include <stdlib.h>
+
+#ifdef __ARM_NEON__
+
+#include <cpu-features.h>
+
+#include <arm_neon.h>
+
+#endif
+
+#ifdef __SSE2__
+
+#include <emmintrin.h>
+
+#endif
+
+// Kernel radius, all kernels are at most 5 taps wide
+static const int RADIUS = 2;
+
+// Number of horizontally filtered rows kept in the ring
+static const int RING_SIZE = 2 * RADIUS + 1;
+
+// Number of planes per row
+static const int PLANES = 3;
+
+// Padding around each plane for the sliding window
+static const int PADDING = 16;
+
+// Component masks for RGB565
+static const unsigned char MAX_RB = Rgb565Format::MAX_R;
+static const unsigned char MAX_G = Rgb565Format::MAX_G;
+
+// Box filter normalization, (sum * BOX_SCALE) >> 16 = sum / 25
+static const short BOX_SCALE = 2622;
+
+/**
+ * Row kernels. The horizontal and vertical kernels process
+ * the count rounded up to 8 pixels, the padding makes this
+ * safe. The unpack and pack kernels process exact count
+ * since they touch the frame memory, the SIMD versions are
+ * specific to RGB565.
+ */
+struct ConvolutionKernels
+{
+	void (*unpack)(const unsigned char* pixels,
+			short* r, short* g, short* b, long count);
+	void (*unpackLuma)(const unsigned char* pixels,
+			short* l, long count);
+	void (*pack)(const short* r, const short* g, const short* b,
+			unsigned char* pixels, long count);
+	void (*packLuma)(const short* l,
+			unsigned char* pixels, long count);
+	void (*horizontalBox)(const short* in,
+			short* out, long count);
+	void (*horizontalGaussian)(const short* in,
+			short* out, long count);
+	void (*horizontalSobel)(const short* in,
+			short* smooth, short* diff, long count);
+	void (*verticalBox)(const short* const* rows,
+			short* out, long count);
+	void (*verticalGaussian)(const short* const* rows,
+			short* out, long count);
+	void (*verticalSobel)(const short* const* smooth,
+			const short* const* diff, short* out, long count);
+	void (*sharpen)(const short* source, const short* blur,
+			short* out, long count);
+};
+
+struct ConvolutionFilter
+{
+	int type;
+	int format;
+	int width;
+	long rowStride;
+	short* buffer;
+	short* row;
+	short* source;
+	short* output;
+	short* ring;
+	ConvolutionKernels kernels;
+
+	ConvolutionFilter():
+		type(CONVOLUTION_FILTER_NONE),
+		format(PIXEL_FORMAT_RGB_565),
+		width(0),
+		rowStride(0),
+		buffer(0),
+		row(0),
+		source(0),
+		output(0),
+		ring(0)
+	{
+
+	}
+};
+
+template<typename Format>
+static void genericUnpack(
+		const unsigned char* pixels,
+		short* r,
+		short* g,
+		short* b,
+		long count)
+{
+	unsigned int cr, cg, cb;
+
+	for (long i = 0; i < count; i++)
+	{
+		Format::unpack(pixels + (i * Format::BYTES_PER_PIXEL), cr, cg, cb);
+
+		r[i] = cr;
+		g[i] = cg;
+		b[i] = cb;
+	}
+}
+
+template<typename Format>
+static void genericUnpackLuma(
+		const unsigned char* pixels,
+		short* l,
+		long count)
+{
+	unsigned int r, g, b;
+
+	for (long i = 0; i < count; i++)
+	{
+		Format::unpack(pixels + (i * Format::BYTES_PER_PIXEL), r, g, b);
+
+		// BT.601 luma in 8-bit fixed point
+		l[i] = (r * 77 + g * 150 + b * 29) >> 8;
+	}
+}
+
+template<typename Format>
+static void genericPack(
+		const short* r,
+		const short* g,
+		const short* b,
+		unsigned char* pixels,
+		long count)
+{
+	for (long i = 0; i < count; i++)
+	{
+		Format::pack(pixels + (i * Format::BYTES_PER_PIXEL), r[i], g[i], b[i]);
+	}
+}
+
+template<typename Format>
+static void genericPackLuma(
+		const short* l,
+		unsigned char* pixels,
+		long count)
+{
+	genericPack<Format>(l, l, l, pixels, count);
+}
+
+static void genericHorizontalBox(
+		const short* in,
+		short* out,
+		long count)
+{
+	for (long i = 0; i < count; i++)
+	{
+		out[i] = in[i - 2] + in[i - 1] + in[i] + in[i + 1] + in[i + 2];
+	}
+}
+
+static void genericHorizontalGaussian(
+		const short* in,
+		short* out,
+		long count)
+{
+	for (long i = 0; i < count; i++)
+	{
+		// 1 4 6 4 1 kernel normalized by 16
+		out[i] = (in[i - 2] + 4 * in[i - 1] + 6 * in[i]
+				+ 4 * in[i + 1] + in[i + 2] + 8) >> 4;
+	}
+}
+
+static void genericHorizontalSobel(
+		const short* in,
+		short* smooth,
+		short* diff,
+		long count)
+{
+	for (long i = 0; i < count; i++)
+	{
+		smooth[i] = in[i - 1] + 2 * in[i] + in[i + 1];
+		diff[i] = in[i + 1] - in[i - 1];
+	}
+}
+
+static void genericVerticalBox(
+		const short* const* rows,
+		short* out,
+		long count)
+{
+	for (long i = 0; i < count; i++)
+	{
+		int sum = rows[0][i] + rows[1][i] + rows[2][i]
+				+ rows[3][i] + rows[4][i];
+
+		out[i] = (sum * BOX_SCALE) >> 16;
+	}
+}
+
+static void genericVerticalGaussian(
+		const short* const* rows,
+		short* out,
+		long count)
+{
+	for (long i = 0; i < count; i++)
+	{
+		out[i] = (rows[0][i] + 4 * rows[1][i] + 6 * rows[2][i]
+				+ 4 * rows[3][i] + rows[4][i] + 8) >> 4;
+	}
+}
+
+static void genericVerticalSobel(
+		const short* const* smooth,
+		const short* const* diff,
+		short* out,
+		long count)
+{
+	for (long i = 0; i < count; i++)
+	{
+		int gx = diff[0][i] + 2 * diff[1][i] + diff[2][i];
+		int gy = smooth[2][i] - smooth[0][i];
+
+		int magnitude = ((gx < 0 ? -gx : gx) + (gy < 0 ? -gy : gy)) >> 2;
+		out[i] = (magnitude > 255) ? 255 : magnitude;
+	}
+}
+
+static void genericSharpen(
+		const short* source,
+		const short* blur,
+		short* out,
+		long count)
+{
+	for (long i = 0; i < count; i++)
+	{
+		int value = 2 * source[i] - blur[i];
+
+		out[i] = (value < 0) ? 0 : ((value > 255) ? 255 : value);
+	}
+}
+
+static const ConvolutionKernels GENERIC_KERNELS = {
+	genericUnpack<Rgb565Format>,
+	genericUnpackLuma<Rgb565Format>,
+	genericPack<Rgb565Format>,
+	genericPackLuma<Rgb565Format>,
+	genericHorizontalBox,
+	genericHorizontalGaussian,
+	genericHorizontalSobel,
+	genericVerticalBox,
+	genericVerticalGaussian,
+	genericVerticalSobel,
+	genericSharpen
+};
+
+#ifdef __ARM_NEON__
+
+static void neonUnpack(
+		const unsigned char* frame,
+		short* r,
+		short* g,
+		short* b,
+		long count)
+{
+	const unsigned short* pixels = (const unsigned short*) frame;
+
+	uint16x8_t maxRb = vdupq_n_u16(MAX_RB);
+	uint16x8_t maxG = vdupq_n_u16(MAX_G);
+
+	long i = 0;
+	for (; i + 8 <= count; i += 8)
+	{
+		// Load 8 16-bit pixels
+		uint16x8_t rgb = vld1q_u16(&pixels[i]);
+
+		// r = (pixels[i] >> 8) & MAX_RB;
+		uint16x8_t r16 = vandq_u16(vshrq_n_u16(rgb, 8), maxRb);
+
+		// g = (pixels[i] >> 3) & MAX_G;
+		uint16x8_t g16 = vandq_u16(vshrq_n_u16(rgb, 3), maxG);
+
+		// b = (pixels[i] << 3) & MAX_RB;
+		uint16x8_t b16 = vandq_u16(vshlq_n_u16(rgb, 3), maxRb);
+
+		vst1q_s16(&r[i], vreinterpretq_s16_u16(r16));
+		vst1q_s16(&g[i], vreinterpretq_s16_u16(g16));
+		vst1q_s16(&b[i], vreinterpretq_s16_u16(b16));
+	}
+
+	// Remaining pixels
+	genericUnpack<Rgb565Format>(
+			(const unsigned char*) &pixels[i], &r[i], &g[i], &b[i], count - i);
+}
+
+static void neonUnpackLuma(
+		const unsigned char* frame,
+		short* l,
+		long count)
+{
+	const unsigned short* pixels = (const unsigned short*) frame;
+
+	uint16x8_t maxRb = vdupq_n_u16(MAX_RB);
+	uint16x8_t maxG = vdupq_n_u16(MAX_G);
+
+	long i = 0;
+	for (; i + 8 <= count; i += 8)
+	{
+		uint16x8_t rgb = vld1q_u16(&pixels[i]);
+
+		uint16x8_t r16 = vandq_u16(vshrq_n_u16(rgb, 8), maxRb);
+		uint16x8_t g16 = vandq_u16(vshrq_n_u16(rgb, 3), maxG);
+		uint16x8_t b16 = vandq_u16(vshlq_n_u16(rgb, 3), maxRb);
+
+		// l = (r * 77 + g * 150 + b * 29) >> 8;
+		uint16x8_t l16 = vmulq_n_u16(r16, 77);
+		l16 = vmlaq_n_u16(l16, g16, 150);
+		l16 = vmlaq_n_u16(l16, b16, 29);
+		l16 = vshrq_n_u16(l16, 8);
+
+		vst1q_s16(&l[i], vreinterpretq_s16_u16(l16));
+	}
+
+	genericUnpackLuma<Rgb565Format>(
+			(const unsigned char*) &pixels[i], &l[i], count - i);
+}
+
+static void neonPack(
+		const short* r,
+		const short* g,
+		const short* b,
+		unsigned char* frame,
+		long count)
+{
+	unsigned short* pixels = (unsigned short*) frame;
+
+	long i = 0;
+	for (; i + 8 <= count; i += 8)
+	{
+		// Narrow components to 8-bits
+		uint8x8_t r8 = vqmovun_s16(vld1q_s16(&r[i]));
+		uint8x8_t g8 = vqmovun_s16(vld1q_s16(&g[i]));
+		uint8x8_t b8 = vqmovun_s16(vld1q_s16(&b[i]));
+
+		// pixels[i] = (r << 8);
+		uint16x8_t rgb = vshll_n_u8(r8, 8);
+
+		// pixels[i] |= (g << 3);
+		rgb = vsriq_n_u16(rgb, vshll_n_u8(g8, 8), 5);
+
+		// pixels[i] |= (b >> 3);
+		rgb = vsriq_n_u16(rgb, vshll_n_u8(b8, 8), 11);
+
+		vst1q_u16(&pixels[i], rgb);
+	}
+
+	genericPack<Rgb565Format>(
+			&r[i], &g[i], &b[i], (unsigned char*) &pixels[i], count - i);
+}
+
+static void neonPackLuma(
+		const short* l,
+		unsigned char* frame,
+		long count)
+{
+	neonPack(l, l, l, frame, count);
+}
+
+static void neonHorizontalBox(
+		const short* in,
+		short* out,
+		long count)
+{
+	for (long i = 0; i < count; i += 8)
+	{
+		// Sliding window over the unaligned neighbours
+		int16x8_t sum = vaddq_s16(vld1q_s16(&in[i - 2]), vld1q_s16(&in[i - 1]));
+		sum = vaddq_s16(sum, vld1q_s16(&in[i]));
+		sum = vaddq_s16(sum, vld1q_s16(&in[i + 1]));
+		sum = vaddq_s16(sum, vld1q_s16(&in[i + 2]));
+
+		vst1q_s16(&out[i], sum);
+	}
+}
+
+static void neonHorizontalGaussian(
+		const short* in,
+		short* out,
+		long count)
+{
+	for (long i = 0; i < count; i += 8)
+	{
+		int16x8_t sum = vaddq_s16(vld1q_s16(&in[i - 2]), vld1q_s16(&in[i + 2]));
+		sum = vmlaq_n_s16(sum,
+				vaddq_s16(vld1q_s16(&in[i - 1]), vld1q_s16(&in[i + 1])), 4);
+		sum = vmlaq_n_s16(sum, vld1q_s16(&in[i]), 6);
+
+		// Rounding shift normalizes by 16
+		vst1q_s16(&out[i], vrshrq_n_s16(sum, 4));
+	}
+}
+
+static void neonHorizontalSobel(
+		const short* in,
+		short* smooth,
+		short* diff,
+		long count)
+{
+	for (long i = 0; i < count; i += 8)
+	{
+		int16x8_t left = vld1q_s16(&in[i - 1]);
+		int16x8_t center = vld1q_s16(&in[i]);
+		int16x8_t right = vld1q_s16(&in[i + 1]);
+
+		int16x8_t sum = vaddq_s16(left, right);
+		vst1q_s16(&smooth[i], vaddq_s16(sum, vshlq_n_s16(center, 1)));
+		vst1q_s16(&diff[i], vsubq_s16(right, left));
+	}
+}
+
+static void neonVerticalBox(
+		const short* const* rows,
+		short* out,
+		long count)
+{
+	for (long i = 0; i < count; i += 8)
+	{
+		int16x8_t sum = vaddq_s16(vld1q_s16(&rows[0][i]), vld1q_s16(&rows[1][i]));
+		sum = vaddq_s16(sum, vld1q_s16(&rows[2][i]));
+		sum = vaddq_s16(sum, vld1q_s16(&rows[3][i]));
+		sum = vaddq_s16(sum, vld1q_s16(&rows[4][i]));
+
+		// Doubling multiply high gives (sum * BOX_SCALE) >> 16
+		vst1q_s16(&out[i], vqdmulhq_n_s16(sum, BOX_SCALE / 2));
+	}
+}
+
+static void neonVerticalGaussian(
+		const short* const* rows,
+		short* out,
+		long count)
+{
+	for (long i = 0; i < count; i += 8)
+	{
+		int16x8_t sum = vaddq_s16(vld1q_s16(&rows[0][i]), vld1q_s16(&rows[4][i]));
+		sum = vmlaq_n_s16(sum,
+				vaddq_s16(vld1q_s16(&rows[1][i]), vld1q_s16(&rows[3][i])), 4);
+		sum = vmlaq_n_s16(sum, vld1q_s16(&rows[2][i]), 6);
+
+		vst1q_s16(&out[i], vrshrq_n_s16(sum, 4));
+	}
+}
+
+static void neonVerticalSobel(
+		const short* const* smooth,
+		const short* const* diff,
+		short* out,
+		long count)
+{
+	int16x8_t maxValue = vdupq_n_s16(255);
+
+	for (long i = 0; i < count; i += 8)
+	{
+		int16x8_t gx = vaddq_s16(vld1q_s16(&diff[0][i]), vld1q_s16(&diff[2][i]));
+		gx = vaddq_s16(gx, vshlq_n_s16(vld1q_s16(&diff[1][i]), 1));
+
+		int16x8_t gy = vsubq_s16(vld1q_s16(&smooth[2][i]), vld1q_s16(&smooth[0][i]));
+
+		int16x8_t magnitude = vaddq_s16(vabsq_s16(gx), vabsq_s16(gy));
+		magnitude = vminq_s16(vshrq_n_s16(magnitude, 2), maxValue);
+
+		vst1q_s16(&out[i], magnitude);
+	}
+}
+
+static void neonSharpen(
+		const short* source,
+		const short* blur,
+		short* out,
+		long count)
+{
+	int16x8_t minValue = vdupq_n_s16(0);
+	int16x8_t maxValue = vdupq_n_s16(255);
+
+	for (long i = 0; i < count; i += 8)
+	{
+		int16x8_t value = vsubq_s16(
+				vshlq_n_s16(vld1q_s16(&source[i]), 1),
+				vld1q_s16(&blur[i]));
+
+		value = vminq_s16(vmaxq_s16(value, minValue), maxValue);
+
+		vst1q_s16(&out[i], value);
+	}
+}
+
+static const ConvolutionKernels NEON_KERNELS = {
+	neonUnpack,
+	neonUnpackLuma,
+	neonPack,
+	neonPackLuma,
+	neonHorizontalBox,
+	neonHorizontalGaussian,
+	neonHorizontalSobel,
+	neonVerticalBox,
+	neonVerticalGaussian,
+	neonVerticalSobel,
+	neonSharpen
+};
+
+#endif
+
+#ifdef __SSE2__
+
+static void sseUnpack(
+		const unsigned char* frame,
+		short* r,
+		short* g,
+		short* b,
+		long count)
+{
+	const unsigned short* pixels = (const unsigned short*) frame;
+
+	__m128i maxRb = _mm_set1_epi16(MAX_RB);
+	__m128i maxG = _mm_set1_epi16(MAX_G);
+
+	long i = 0;
+	for (; i + 8 <= count; i += 8)
+	{
+		__m128i rgb = _mm_loadu_si128((const __m128i*) &pixels[i]);
+
+		_mm_storeu_si128((__m128i*) &r[i],
+				_mm_and_si128(_mm_srli_epi16(rgb, 8), maxRb));
+		_mm_storeu_si128((__m128i*) &g[i],
+				_mm_and_si128(_mm_srli_epi16(rgb, 3), maxG));
+		_mm_storeu_si128((__m128i*) &b[i],
+				_mm_and_si128(_mm_slli_epi16(rgb, 3), maxRb));
+	}
+
+	genericUnpack<Rgb565Format>(
+			(const unsigned char*) &pixels[i], &r[i], &g[i], &b[i], count - i);
+}
+
+static void sseUnpackLuma(
+		const unsigned char* frame,
+		short* l,
+		long count)
+{
+	const unsigned short* pixels = (const unsigned short*) frame;
+
+	__m128i maxRb = _mm_set1_epi16(MAX_RB);
+	__m128i maxG = _mm_set1_epi16(MAX_G);
+
+	long i = 0;
+	for (; i + 8 <= count; i += 8)
+	{
+		__m128i rgb = _mm_loadu_si128((const __m128i*) &pixels[i]);
+
+		__m128i r16 = _mm_and_si128(_mm_srli_epi16(rgb, 8), maxRb);
+		__m128i g16 = _mm_and_si128(_mm_srli_epi16(rgb, 3), maxG);
+		__m128i b16 = _mm_and_si128(_mm_slli_epi16(rgb, 3), maxRb);
+
+		// Products wrap in 16-bits, the logical shift restores them
+		__m128i l16 = _mm_mullo_epi16(r16, _mm_set1_epi16(77));
+		l16 = _mm_add_epi16(l16, _mm_mullo_epi16(g16, _mm_set1_epi16(150)));
+		l16 = _mm_add_epi16(l16, _mm_mullo_epi16(b16, _mm_set1_epi16(29)));
+
+		_mm_storeu_si128((__m128i*) &l[i], _mm_srli_epi16(l16, 8));
+	}
+
+	genericUnpackLuma<Rgb565Format>(
+			(const unsigned char*) &pixels[i], &l[i], count - i);
+}
+
+static void ssePack(
+		const short* r,
+		const short* g,
+		const short* b,
+		unsigned char* frame,
+		long count)
+{
+	unsigned short* pixels = (unsigned short*) frame;
+
+	__m128i maxRb = _mm_set1_epi16(MAX_RB);
+	__m128i maxG = _mm_set1_epi16(MAX_G);
+
+	long i = 0;
+	for (; i + 8 <= count; i += 8)
+	{
+		__m128i r16 = _mm_loadu_si128((const __m128i*) &r[i]);
+		__m128i g16 = _mm_loadu_si128((const __m128i*) &g[i]);
+		__m128i b16 = _mm_loadu_si128((const __m128i*) &b[i]);
+
+		__m128i rgb = _mm_slli_epi16(_mm_and_si128(r16, maxRb), 8);
+		rgb = _mm_or_si128(rgb, _mm_slli_epi16(_mm_and_si128(g16, maxG), 3));
+		rgb = _mm_or_si128(rgb, _mm_srli_epi16(_mm_and_si128(b16, maxRb), 3));
+
+		_mm_storeu_si128((__m128i*) &pixels[i], rgb);
+	}
+
+	genericPack<Rgb565Format>(
+			&r[i], &g[i], &b[i], (unsigned char*) &pixels[i], count - i);
+}
+
+static void ssePackLuma(
+		const short* l,
+		unsigned char* frame,
+		long count)
+{
+	ssePack(l, l, l, frame, count);
+}
+
+static inline __m128i sseLoad(const short* p)
+{
+	return _mm_loadu_si128((const __m128i*) p);
+}
+
+static void sseHorizontalBox(
+		const short* in,
+		short* out,
+		long count)
+{
+	for (long i = 0; i < count; i += 8)
+	{
+		__m128i sum = _mm_add_epi16(sseLoad(&in[i - 2]), sseLoad(&in[i - 1]));
+		sum = _mm_add_epi16(sum, sseLoad(&in[i]));
+		sum = _mm_add_epi16(sum, sseLoad(&in[i + 1]));
+		sum = _mm_add_epi16(sum, sseLoad(&in[i + 2]));
+
+		_mm_storeu_si128((__m128i*) &out[i], sum);
+	}
+}
+
+static void sseHorizontalGaussian(
+		const short* in,
+		short* out,
+		long count)
+{
+	__m128i six = _mm_set1_epi16(6);
+	__m128i round = _mm_set1_epi16(8);
+
+	for (long i = 0; i < count; i += 8)
+	{
+		__m128i sum = _mm_add_epi16(sseLoad(&in[i - 2]), sseLoad(&in[i + 2]));
+		sum = _mm_add_epi16(sum, _mm_slli_epi16(
+				_mm_add_epi16(sseLoad(&in[i - 1]), sseLoad(&in[i + 1])), 2));
+		sum = _mm_add_epi16(sum, _mm_mullo_epi16(sseLoad(&in[i]), six));
+
+		_mm_storeu_si128((__m128i*) &out[i],
+				_mm_srai_epi16(_mm_add_epi16(sum, round), 4));
+	}
+}
+
+static void sseHorizontalSobel(
+		const short* in,
+		short* smooth,
+		short* diff,
+		long count)
+{
+	for (long i = 0; i < count; i += 8)
+	{
+		__m128i left = sseLoad(&in[i - 1]);
+		__m128i center = sseLoad(&in[i]);
+		__m128i right = sseLoad(&in[i + 1]);
+
+		__m128i sum = _mm_add_epi16(left, right);
+		_mm_storeu_si128((__m128i*) &smooth[i],
+				_mm_add_epi16(sum, _mm_slli_epi16(center, 1)));
+		_mm_storeu_si128((__m128i*) &diff[i],
+				_mm_sub_epi16(right, left));
+	}
+}
+
+static void sseVerticalBox(
+		const short* const* rows,
+		short* out,
+		long count)
+{
+	__m128i scale = _mm_set1_epi16(BOX_SCALE);
+
+	for (long i = 0; i < count; i += 8)
+	{
+		__m128i sum = _mm_add_epi16(sseLoad(&rows[0][i]), sseLoad(&rows[1][i]));
+		sum = _mm_add_epi16(sum, sseLoad(&rows[2][i]));
+		sum = _mm_add_epi16(sum, sseLoad(&rows[3][i]));
+		sum = _mm_add_epi16(sum, sseLoad(&rows[4][i]));
+
+		_mm_storeu_si128((__m128i*) &out[i], _mm_mulhi_epi16(sum, scale));
+	}
+}
+
+static void sseVerticalGaussian(
+		const short* const* rows,
+		short* out,
+		long count)
+{
+	__m128i six = _mm_set1_epi16(6);
+	__m128i round = _mm_set1_epi16(8);
+
+	for (long i = 0; i < count; i += 8)
+	{
+		__m128i sum = _mm_add_epi16(sseLoad(&rows[0][i]), sseLoad(&rows[4][i]));
+		sum = _mm_add_epi16(sum, _mm_slli_epi16(
+				_mm_add_epi16(sseLoad(&rows[1][i]), sseLoad(&rows[3][i])), 2));
+		sum = _mm_add_epi16(sum, _mm_mullo_epi16(sseLoad(&rows[2][i]), six));
+
+		_mm_storeu_si128((__m128i*) &out[i],
+				_mm_srai_epi16(_mm_add_epi16(sum, round), 4));
+	}
+}
+
+static void sseVerticalSobel(
+		const short* const* smooth,
+		const short* const* diff,
+		short* out,
+		long count)
+{
+	__m128i zero = _mm_setzero_si128();
+	__m128i maxValue = _mm_set1_epi16(255);
+
+	for (long i = 0; i < count; i += 8)
+	{
+		__m128i gx = _mm_add_epi16(sseLoad(&diff[0][i]), sseLoad(&diff[2][i]));
+		gx = _mm_add_epi16(gx, _mm_slli_epi16(sseLoad(&diff[1][i]), 1));
+
+		__m128i gy = _mm_sub_epi16(sseLoad(&smooth[2][i]), sseLoad(&smooth[0][i]));
+
+		// SSE2 has no 16-bit absolute value, use max(x, -x)
+		gx = _mm_max_epi16(gx, _mm_sub_epi16(zero, gx));
+		gy = _mm_max_epi16(gy, _mm_sub_epi16(zero, gy));
+
+		__m128i magnitude = _mm_srai_epi16(_mm_add_epi16(gx, gy), 2);
+		_mm_storeu_si128((__m128i*) &out[i], _mm_min_epi16(magnitude, maxValue));
+	}
+}
+
+static void sseSharpen(
+		const short* source,
+		const short* blur,
+		short* out,
+		long count)
+{
+	__m128i zero = _mm_setzero_si128();
+	__m128i maxValue = _mm_set1_epi16(255);
+
+	for (long i = 0; i < count; i += 8)
+	{
+		__m128i value = _mm_sub_epi16(
+				_mm_slli_epi16(sseLoad(&source[i]), 1),
+				sseLoad(&blur[i]));
+
+		value = _mm_min_epi16(_mm_max_epi16(value, zero), maxValue);
+
+		_mm_storeu_si128((__m128i*) &out[i], value);
+	}
+}
+
+static const ConvolutionKernels SSE_KERNELS = {
+	sseUnpack,
+	sseUnpackLuma,
+	ssePack,
+	ssePackLuma,
+	sseHorizontalBox,
+	sseHorizontalGaussian,
+	sseHorizontalSobel,
+	sseVerticalBox,
+	sseVerticalGaussian,
+	sseVerticalSobel,
+	sseSharpen
+};
+
+#endif
+
+/**
+ * Selects the row kernels based on the CPU features.
+ *
+ * @return row kernels.
+ */
+static const ConvolutionKernels* selectKernels()
+{
+	const ConvolutionKernels* kernels = &GENERIC_KERNELS;
+
+#ifdef __ARM_NEON__
+	// Get the CPU family
+	AndroidCpuFamily cpuFamily = android_getCpuFamily();
+
+	// Get the CPU features
+	uint64_t cpuFeatures = android_getCpuFeatures();
+
+	// Use NEON optimized kernels only on ARM CPUs with NEON support
+	if ((ANDROID_CPU_FAMILY_ARM == cpuFamily)
+			&& ((ANDROID_CPU_ARM_FEATURE_NEON & cpuFeatures) != 0))
+	{
+		kernels = &NEON_KERNELS;
+	}
+#endif
+
+#ifdef __SSE2__
+	// SSE2 is part of the x86 ABI
+	kernels = &SSE_KERNELS;
+#endif
+
+	return kernels;
+}
+
+/**
+ * Gets the given plane of the given row buffer.
+ */
+static inline short* getPlane(
+		const ConvolutionFilter* filter,
+		short* row,
+		int plane)
+{
+	return row + (plane * filter->rowStride) + PADDING;
+}
+
+/**
+ * Gets the given ring slot.
+ */
+static inline short* getSlot(
+		const ConvolutionFilter* filter,
+		int y)
+{
+	return filter->ring + ((y % RING_SIZE) * PLANES * filter->rowStride);
+}
+
+/**
+ * Replicates the edge pixels into the padding.
+ */
+static void padPlane(
+		short* plane,
+		int width)
+{
+	for (int i = 1; i <= PADDING; i++)
+	{
+		plane[-i] = plane[0];
+		plane[width - 1 + i] = plane[width - 1];
+	}
+}
+
+/**
+ * Horizontal pass of the given source row into its ring slot.
+ */
+static void horizontalPass(
+		ConvolutionFilter* filter,
+		const unsigned char* pixels,
+		int width,
+		long count,
+		int y)
+{
+	const ConvolutionKernels* kernels = &filter->kernels;
+	short* slot = getSlot(filter, y);
+
+	if (CONVOLUTION_FILTER_SOBEL_EDGE == filter->type)
+	{
+		short* l = getPlane(filter, filter->row, 0);
+
+		kernels->unpackLuma(pixels, l, width);
+		padPlane(l, width);
+
+		kernels->horizontalSobel(l,
+				getPlane(filter, slot, 0),
+				getPlane(filter, slot, 1),
+				count);
+	}
+	else
+	{
+		kernels->unpack(pixels,
+				getPlane(filter, filter->row, 0),
+				getPlane(filter, filter->row, 1),
+				getPlane(filter, filter->row, 2),
+				width);
+
+		for (int plane = 0; plane < PLANES; plane++)
+		{
+			short* in = getPlane(filter, filter->row, plane);
+			short* out = getPlane(filter, slot, plane);
+
+			padPlane(in, width);
+
+			if (CONVOLUTION_FILTER_BOX_BLUR == filter->type)
+			{
+				kernels->horizontalBox(in, out, count);
+			}
+			else
+			{
+				kernels->horizontalGaussian(in, out, count);
+			}
+		}
+	}
+}
+
+/**
+ * Vertical pass over the ring window into the given frame row.
+ */
+static void verticalPass(
+		ConvolutionFilter* filter,
+		short* const* window,
+		unsigned char* pixels,
+		int width,
+		long count)
+{
+	const ConvolutionKernels* kernels = &filter->kernels;
+	const short* rows[RING_SIZE];
+
+	if (CONVOLUTION_FILTER_SOBEL_EDGE == filter->type)
+	{
+		// Sobel uses the three center rows only
+		const short* smooth[3];
+		const short* diff[3];
+
+		for (int i = 0; i < 3; i++)
+		{
+			smooth[i] = getPlane(filter, window[RADIUS - 1 + i], 0);
+			diff[i] = getPlane(filter, window[RADIUS - 1 + i], 1);
+		}
+
+		short* l = getPlane(filter, filter->output, 0);
+		kernels->verticalSobel(smooth, diff, l, count);
+		kernels->packLuma(l, pixels, width);
+		return;
+	}
+
+	// Unsharp mask needs the original row, not overwritten yet
+	if (CONVOLUTION_FILTER_UNSHARP_MASK == filter->type)
+	{
+		kernels->unpack(pixels,
+				getPlane(filter, filter->source, 0),
+				getPlane(filter, filter->source, 1),
+				getPlane(filter, filter->source, 2),
+				width);
+	}
+
+	for (int plane = 0; plane < PLANES; plane++)
+	{
+		for (int i = 0; i < RING_SIZE; i++)
+		{
+			rows[i] = getPlane(filter, window[i], plane);
+		}
+
+		short* out = getPlane(filter, filter->output, plane);
+
+		switch (filter->type)
+		{
+		case CONVOLUTION_FILTER_BOX_BLUR:
+			kernels->verticalBox(rows, out, count);
+			break;
+
+		case CONVOLUTION_FILTER_GAUSSIAN_BLUR:
+			kernels->verticalGaussian(rows, out, count);
+			break;
+
+		case CONVOLUTION_FILTER_UNSHARP_MASK:
+			kernels->verticalGaussian(rows, out, count);
+			kernels->sharpen(getPlane(filter, filter->source, plane),
+					out, out, count);
+			break;
+		}
+	}
+
+	kernels->pack(getPlane(filter, filter->output, 0),
+			getPlane(filter, filter->output, 1),
+			getPlane(filter, filter->output, 2),
+			pixels,
+			width);
+}
+
+/**
+ * Sets the unpack and pack kernels for the given format. The
+ * SIMD kernels cover RGB565, other formats use the generic
+ * kernels specialized for their layout.
+ */
+template<typename Format>
+static void setFormatKernels(
+		ConvolutionKernels& kernels)
+{
+	kernels.unpack = genericUnpack<Format>;
+	kernels.unpackLuma = genericUnpackLuma<Format>;
+	kernels.pack = genericPack<Format>;
+	kernels.packLuma = genericPackLuma<Format>;
+}
+
+ConvolutionFilter* createConvolutionFilter(
+		int type,
+		int width,
+		int format)
+{
+	ConvolutionFilter* filter = 0;
+
+	if ((CONVOLUTION_FILTER_BOX_BLUR > type)
+			|| (CONVOLUTION_FILTER_SOBEL_EDGE < type)
+			|| (0 >= width)
+			|| (0 == getBytesPerPixel(format)))
+	{
+		goto exit;
+	}
+
+	filter = new ConvolutionFilter();
+	if (0 == filter)
+	{
+		goto exit;
+	}
+
+	filter->type = type;
+	filter->format = format;
+	filter->width = width;
+	filter->kernels = *selectKernels();
+
+	switch (format)
+	{
+	case PIXEL_FORMAT_RGBA_8888:
+		setFormatKernels<Rgba8888Format>(filter->kernels);
+		break;
+
+	case PIXEL_FORMAT_RGB_888:
+		setFormatKernels<Rgb888Format>(filter->kernels);
+		break;
+	}
+
+	// Rows are rounded up to 8 pixels and padded on both sides
+	filter->rowStride = ((width + 7) & ~7) + (2 * PADDING);
+
+	// Source row, unsharp row, output row and the ring
+	filter->buffer = (short*) malloc(
+			(3 + RING_SIZE) * PLANES * filter->rowStride * sizeof(short));
+	if (0 == filter->buffer)
+	{
+		delete filter;
+		filter = 0;
+		goto exit;
+	}
+
+	filter->row = filter->buffer;
+	filter->source = filter->row + (PLANES * filter->rowStride);
+	filter->output = filter->source + (PLANES * filter->rowStride);
+	filter->ring = filter->output + (PLANES * filter->rowStride);
+
+exit:
+	return filter;
+}
+
+void destroyConvolutionFilter(
+		ConvolutionFilter* filter)
+{
+	if (0 != filter)
+	{
+		free(filter->buffer);
+		delete filter;
+	}
+}
+
+void convolutionFilter(
+		ConvolutionFilter* filter,
+		void* pixels,
+		int width,
+		int height,
+		long stride)
+{
+	unsigned char* frame = (unsigned char*) pixels;
+
+	if ((0 == filter) || (width > filter->width) || (0 >= height))
+	{
+		return;
+	}
+
+	// Row kernels work on groups of 8 pixels
+	long count = (width + 7) & ~7;
+
+	// Next source row to be filtered horizontally
+	int next = 0;
+
+	for (int y = 0; y < height; y++)
+	{
+		// Bring the rows entering the window into the ring. Source
+		// rows ahead of y are not overwritten yet.
+		int last = (y + RADIUS < height) ? (y + RADIUS) : (height - 1);
+		for (; next <= last; next++)
+		{
+			horizontalPass(filter, frame + (next * stride), width, count, next);
+		}
+
+		// Window rows are clamped at the frame edges
+		short* window[RING_SIZE];
+		for (int i = 0; i < RING_SIZE; i++)
+		{
+			int row = y + i - RADIUS;
+			row = (row < 0) ? 0 : ((row >= height) ? (height - 1) : row);
+
+			window[i] = getSlot(filter, row);
+		}
+
+		verticalPass(filter, window, frame + (y * stride), width, count);
+	}
+}
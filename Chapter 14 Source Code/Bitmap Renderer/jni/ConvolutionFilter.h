@@ -0,0 +1,61 @@
+#pragma once
+
+/**
+ * Convolution filter types. The values are shared with
+ * the BitmapPlayerActivity constants.
+ */
+enum ConvolutionFilterType
+{
+	CONVOLUTION_FILTER_NONE = 0,
+	CONVOLUTION_FILTER_BOX_BLUR = 1,
+	CONVOLUTION_FILTER_GAUSSIAN_BLUR = 2,
+	CONVOLUTION_FILTER_UNSHARP_MASK = 3,
+	CONVOLUTION_FILTER_SOBEL_EDGE = 4
+};
+
+/**
+ * Convolution filter state. Holds the unpacked source row
+ * and the ring of horizontally filtered rows, so that the
+ * vertical pass does not need a full frame temporary.
+ */
+struct ConvolutionFilter;
+
+/**
+ * Creates a new convolution filter for frames up to the
+ * given width.
+ *
+ * @param type filter type.
+ * @param width maximum frame width in pixels.
+ * @param format pixel format.
+ * @return convolution filter or 0 on failure.
+ */
+ConvolutionFilter* createConvolutionFilter(
+		int type,
+		int width,
+		int format);
+
+/**
+ * Destroys the given convolution filter.
+ *
+ * @param filter convolution filter.
+ */
+void destroyConvolutionFilter(
+		ConvolutionFilter* filter);
+
+/**
+ * Applies the convolution filter in place to the given
+ * frame. Horizontal and vertical passes are done
+ * separately over the unpacked color channels.
+ *
+ * @param filter convolution filter.
+ * @param pixels pixels in the filter's pixel format.
+ * @param width frame width in pixels.
+ * @param height frame height in pixels.
+ * @param stride row stride in bytes.
+ */
+void convolutionFilter(
+		ConvolutionFilter* filter,
+		void* pixels,
+		int width,
+		int height,
+		long stride);
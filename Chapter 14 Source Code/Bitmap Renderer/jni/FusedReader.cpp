@@ -0,0 +1,168 @@
+#include "FusedReader.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+struct FusedReader
+{
+	int width;
+	long rowSize;
+
+	// Rows that fit in the staging window
+	int bandRows;
+	unsigned char* staging;
+};
+
+FusedReader* createFusedReader(
+		int width,
+		int bytesPerPixel)
+{
+	FusedReader* reader = 0;
+	long rowSize = (long) width * bytesPerPixel;
+
+	if ((0 >= width) || (0 >= bytesPerPixel))
+	{
+		goto exit;
+	}
+
+	reader = (FusedReader*) malloc(sizeof(FusedReader));
+	if (0 == reader)
+	{
+		goto exit;
+	}
+
+	reader->width = width;
+	reader->rowSize = rowSize;
+
+	// At least one row even if it is wider than the window
+	reader->bandRows = FUSED_STAGING_SIZE / rowSize;
+	if (0 == reader->bandRows)
+	{
+		reader->bandRows = 1;
+	}
+
+	reader->staging = (unsigned char*) malloc(reader->bandRows * rowSize);
+	if (0 == reader->staging)
+	{
+		free(reader);
+		reader = 0;
+	}
+
+exit:
+	return reader;
+}
+
+void destroyFusedReader(
+		FusedReader* reader)
+{
+	if (0 != reader)
+	{
+		free(reader->staging);
+		free(reader);
+	}
+}
+
+/**
+ * Reads the frame as a whole and filters it in place.
+ */
+static long readWholeFrame(
+		FusedReader* reader,
+		avi_t* avi,
+		void* pixels,
+		BandFilter filter,
+		void* context)
+{
+	int keyFrame = 0;
+
+	long frameSize = AVI_read_frame(avi, (char*) pixels, &keyFrame);
+
+	if ((0 < frameSize) && (0 != filter))
+	{
+		filter(context,
+				(unsigned char*) pixels,
+				reader->width,
+				frameSize / reader->rowSize,
+				reader->rowSize);
+	}
+
+	return frameSize;
+}
+
+long readFusedFrame(
+		FusedReader* reader,
+		avi_t* avi,
+		void* pixels,
+		int height,
+		long stride,
+		BandFilter filter,
+		void* context)
+{
+	long frameSize = -1;
+	long frame = avi->video_pos;
+	off_t offset = 0;
+	unsigned char* destination = (unsigned char*) pixels;
+
+	if ((0 == avi->video_index)
+			|| (0 > frame)
+			|| (avi->video_frames <= frame))
+	{
+		frameSize = readWholeFrame(reader, avi, pixels, filter, context);
+		goto exit;
+	}
+
+	offset = avi->video_index[frame].pos;
+	frameSize = avi->video_index[frame].len;
+
+	// Only raw frames can be split into rows
+	if (frameSize != height * reader->rowSize)
+	{
+		frameSize = readWholeFrame(reader, avi, pixels, filter, context);
+		goto exit;
+	}
+
+	for (int row = 0; row < height; row += reader->bandRows)
+	{
+		int rowCount = height - row;
+		if (reader->bandRows < rowCount)
+		{
+			rowCount = reader->bandRows;
+		}
+
+		// Read the band into the staging window
+		long bandSize = rowCount * reader->rowSize;
+		if (bandSize != pread(avi->fdes, reader->staging, bandSize, offset))
+		{
+			frameSize = -1;
+			goto exit;
+		}
+
+		offset += bandSize;
+
+		// Filter while the band is in cache
+		if (0 != filter)
+		{
+			filter(context,
+					reader->staging,
+					reader->width,
+					rowCount,
+					reader->rowSize);
+		}
+
+		// Write the band out
+		for (int i = 0; i < rowCount; i++)
+		{
+			memcpy(destination,
+					reader->staging + (i * reader->rowSize),
+					reader->rowSize);
+
+			destination += stride;
+		}
+	}
+
+	// Advance like AVI_read_frame
+	avi->video_pos++;
+
+exit:
+	return frameSize;
+}
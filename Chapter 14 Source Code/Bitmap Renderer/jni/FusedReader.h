@@ -0,0 +1,78 @@
+#pragma once
+
+extern "C" {
+#include <avilib.h>
+}
+
+/**
+ * Staging window size in bytes. Small enough to stay in
+ * L2 while a band of rows is filtered.
+ */
+#define FUSED_STAGING_SIZE (64 * 1024)
+
+/**
+ * Band filter. Gets called on each band of rows while it
+ * is in the staging window, before it is written out.
+ *
+ * @param context filter context.
+ * @param rows band pixels.
+ * @param width band width in pixels.
+ * @param rowCount number of rows in the band.
+ * @param stride band row stride in bytes.
+ */
+typedef void (*BandFilter)(
+		void* context,
+		unsigned char* rows,
+		int width,
+		int rowCount,
+		long stride);
+
+/**
+ * Fused reader state, holds the staging window.
+ */
+struct FusedReader;
+
+/**
+ * Creates a new fused reader for frames of the given width.
+ *
+ * @param width frame width in pixels.
+ * @param bytesPerPixel bytes per pixel.
+ * @return fused reader or 0 on failure.
+ */
+FusedReader* createFusedReader(
+		int width,
+		int bytesPerPixel);
+
+/**
+ * Destroys the given fused reader.
+ *
+ * @param reader fused reader.
+ */
+void destroyFusedReader(
+		FusedReader* reader);
+
+/**
+ * Reads the next frame a band of rows at a time into the
+ * staging window, applies the band filter, and writes the
+ * band to the destination. Each pixel crosses memory once,
+ * instead of once for the read and again for each filter
+ * pass. Frames that are not stored as raw rows are read
+ * with AVI_read_frame and filtered in place.
+ *
+ * @param reader fused reader.
+ * @param avi AVI file.
+ * @param pixels destination pixels.
+ * @param height frame height in pixels.
+ * @param stride destination row stride in bytes.
+ * @param filter band filter, may be 0.
+ * @param context band filter context.
+ * @return frame size, or -1 on failure.
+ */
+long readFusedFrame(
+		FusedReader* reader,
+		avi_t* avi,
+		void* pixels,
+		int height,
+		long stride,
+		BandFilter filter,
+		void* context);
@@ -0,0 +1,223 @@
+#include "PerfCounters.h"
+
+#include <linux/perf_event.h>
+#include <string.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+struct PerfCounters
+{
+	// Attached thread, zero if none
+	int threadId;
+
+	// Group leader and its members
+	int fds[PERF_COUNTERS];
+
+	// Position of each counter in the group read, -1 if unavailable
+	int positions[PERF_COUNTERS];
+	int count;
+
+	long long samples[PERF_STAGES];
+	long long totals[PERF_STAGES][PERF_COUNTERS];
+
+	PerfCounters():
+		threadId(0),
+		count(0)
+	{
+		for (int i = 0; i < PERF_COUNTERS; i++)
+		{
+			fds[i] = -1;
+			positions[i] = -1;
+		}
+
+		memset(samples, 0, sizeof(samples));
+		memset(totals, 0, sizeof(totals));
+	}
+};
+
+// Hardware event for each counter
+static const unsigned long long PERF_CONFIGS[PERF_COUNTERS] =
+{
+	PERF_COUNT_HW_CPU_CYCLES,
+	PERF_COUNT_HW_INSTRUCTIONS,
+	PERF_COUNT_HW_CACHE_MISSES,
+	PERF_COUNT_HW_BRANCH_MISSES
+};
+
+static const char* const PERF_STAGE_NAMES[PERF_STAGES] =
+{
+	"lock",
+	"read",
+	"composite",
+	"temporal",
+	"convolution",
+	"exposure",
+	"brightness",
+	"unlock"
+};
+
+/**
+ * Opens a user space hardware counter for the calling
+ * thread on any CPU.
+ */
+static int openCounter(
+		unsigned long long config,
+		int groupFd)
+{
+	struct perf_event_attr attr;
+	memset(&attr, 0, sizeof(attr));
+
+	attr.size = sizeof(attr);
+	attr.type = PERF_TYPE_HARDWARE;
+	attr.config = config;
+	attr.read_format = PERF_FORMAT_GROUP;
+	attr.exclude_kernel = 1;
+	attr.exclude_hv = 1;
+
+	return syscall(__NR_perf_event_open, &attr, 0, -1, groupFd, 0);
+}
+
+static void closeCounters(
+		PerfCounters* counters)
+{
+	for (int i = 0; i < PERF_COUNTERS; i++)
+	{
+		if (0 <= counters->fds[i])
+		{
+			close(counters->fds[i]);
+		}
+
+		counters->fds[i] = -1;
+		counters->positions[i] = -1;
+	}
+
+	counters->count = 0;
+}
+
+PerfCounters* createPerfCounters()
+{
+	return new PerfCounters();
+}
+
+void destroyPerfCounters(
+		PerfCounters* counters)
+{
+	if (0 != counters)
+	{
+		closeCounters(counters);
+		delete counters;
+	}
+}
+
+void attachPerfCounters(
+		PerfCounters* counters)
+{
+	int threadId = syscall(__NR_gettid);
+	if (threadId == counters->threadId)
+	{
+		return;
+	}
+
+	closeCounters(counters);
+	counters->threadId = threadId;
+
+	// First counter that opens leads the group
+	int leaderFd = -1;
+
+	for (int i = 0; i < PERF_COUNTERS; i++)
+	{
+		int fd = openCounter(PERF_CONFIGS[i], leaderFd);
+		if (0 > fd)
+		{
+			continue;
+		}
+
+		if (0 > leaderFd)
+		{
+			leaderFd = fd;
+		}
+
+		counters->fds[i] = fd;
+		counters->positions[i] = counters->count++;
+	}
+}
+
+void readPerfCounters(
+		const PerfCounters* counters,
+		long long* values)
+{
+	// Number of values followed by the values
+	unsigned long long group[1 + PERF_COUNTERS];
+
+	for (int i = 0; i < PERF_COUNTERS; i++)
+	{
+		values[i] = 0;
+	}
+
+	if ((0 == counters) || (0 == counters->count))
+	{
+		return;
+	}
+
+	int leaderFd = -1;
+	for (int i = 0; (i < PERF_COUNTERS) && (0 > leaderFd); i++)
+	{
+		leaderFd = counters->fds[i];
+	}
+
+	// Group is smaller when some counters are unavailable
+	ssize_t size = read(leaderFd, group, sizeof(group));
+	if ((ssize_t) ((1 + counters->count) * sizeof(group[0])) > size)
+	{
+		return;
+	}
+
+	for (int i = 0; i < PERF_COUNTERS; i++)
+	{
+		if (0 <= counters->positions[i])
+		{
+			values[i] = group[1 + counters->positions[i]];
+		}
+	}
+}
+
+void addPerfStage(
+		PerfCounters* counters,
+		int stage,
+		const long long* startValues)
+{
+	if (0 == counters)
+	{
+		return;
+	}
+
+	long long values[PERF_COUNTERS];
+	readPerfCounters(counters, values);
+
+	counters->samples[stage]++;
+
+	for (int i = 0; i < PERF_COUNTERS; i++)
+	{
+		counters->totals[stage][i] += values[i] - startValues[i];
+	}
+}
+
+long long getPerfStage(
+		const PerfCounters* counters,
+		int stage,
+		long long* values)
+{
+	for (int i = 0; i < PERF_COUNTERS; i++)
+	{
+		values[i] = (0 <= counters->positions[i])
+				? counters->totals[stage][i] : -1;
+	}
+
+	return counters->samples[stage];
+}
+
+const char* getPerfStageName(
+		int stage)
+{
+	return PERF_STAGE_NAMES[stage];
+}
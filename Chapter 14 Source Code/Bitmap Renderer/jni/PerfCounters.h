@@ -0,0 +1,148 @@
+#pragma once
+
+/**
+ * Pipeline stages that the hardware counters are
+ * attributed to.
+ */
+enum PerfStage
+{
+	PERF_STAGE_LOCK = 0,
+	PERF_STAGE_READ = 1,
+	PERF_STAGE_COMPOSITE = 2,
+	PERF_STAGE_TEMPORAL = 3,
+	PERF_STAGE_CONVOLUTION = 4,
+	PERF_STAGE_EXPOSURE = 5,
+	PERF_STAGE_BRIGHTNESS = 6,
+	PERF_STAGE_UNLOCK = 7,
+	PERF_STAGES = 8
+};
+
+/**
+ * Hardware counters.
+ */
+enum PerfCounter
+{
+	PERF_COUNTER_CYCLES = 0,
+	PERF_COUNTER_INSTRUCTIONS = 1,
+	PERF_COUNTER_CACHE_MISSES = 2,
+	PERF_COUNTER_BRANCH_MISSES = 3,
+	PERF_COUNTERS = 4
+};
+
+/**
+ * Hardware counters of a thread through perf_event_open,
+ * with the counter totals for each pipeline stage. Works
+ * the same on Android and on a Linux host; counters that
+ * the kernel refuses are reported as unavailable.
+ */
+struct PerfCounters;
+
+/**
+ * Creates new perf counters. No counters are open until
+ * a thread attaches.
+ *
+ * @return perf counters or 0 on failure.
+ */
+PerfCounters* createPerfCounters();
+
+/**
+ * Destroys the given perf counters.
+ *
+ * @param counters perf counters.
+ */
+void destroyPerfCounters(
+		PerfCounters* counters);
+
+/**
+ * Opens the counters for the calling thread, if they are
+ * not already open for it. The stage totals are kept.
+ *
+ * @param counters perf counters.
+ */
+void attachPerfCounters(
+		PerfCounters* counters);
+
+/**
+ * Reads the counters at the start of a stage.
+ *
+ * @param counters perf counters.
+ * @param values PERF_COUNTERS values.
+ */
+void readPerfCounters(
+		const PerfCounters* counters,
+		long long* values);
+
+/**
+ * Adds the counter deltas since the given start values
+ * to the given stage.
+ *
+ * @param counters perf counters.
+ * @param stage pipeline stage.
+ * @param startValues PERF_COUNTERS values at stage start.
+ */
+void addPerfStage(
+		PerfCounters* counters,
+		int stage,
+		const long long* startValues);
+
+/**
+ * Gets the counter totals of the given stage.
+ *
+ * @param counters perf counters.
+ * @param stage pipeline stage.
+ * @param values PERF_COUNTERS totals, -1 if unavailable.
+ * @return number of times the stage ran.
+ */
+long long getPerfStage(
+		const PerfCounters* counters,
+		int stage,
+		long long* values);
+
+/**
+ * Gets the name of the given stage.
+ *
+ * @param stage pipeline stage.
+ * @return stage name.
+ */
+const char* getPerfStageName(
+		int stage);
+
+#ifdef MY_PERF_COUNTERS_ENABLED
+
+/**
+ * Attributes the counter deltas to a stage for the
+ * lifetime of the scope.
+ */
+class PerfScope
+{
+public:
+	PerfScope(PerfCounters* counters, int stage):
+		counters(counters),
+		stage(stage)
+	{
+		readPerfCounters(counters, startValues);
+	}
+
+	~PerfScope()
+	{
+		addPerfStage(counters, stage, startValues);
+	}
+
+private:
+	PerfCounters* counters;
+	int stage;
+	long long startValues[PERF_COUNTERS];
+};
+
+#define PERF_CONCAT_(a, b) a##b
+#define PERF_CONCAT(a, b) PERF_CONCAT_(a, b)
+
+// Attributes the enclosing scope to the given stage
+#define PERF_SCOPE(counters, stage) \
+	PerfScope PERF_CONCAT(perfScope, __LINE__)(counters, stage)
+
+#else
+
+#define PERF_SCOPE(counters, stage)
+
+#endif
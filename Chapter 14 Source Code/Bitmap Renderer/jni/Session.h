@@ -0,0 +1,45 @@
+#pragma once
+
+extern "C" {
+#include <avilib.h>
+}
+
+#include "AutoExposure.h"
+#include "Compositor.h"
+#include "ConvolutionFilter.h"
+#include "FusedReader.h"
+#include "PerfCounters.h"
+#include "Statistics.h"
+#include "TemporalFilter.h"
+
+/**
+ * Player session. The Java side holds a pointer to the
+ * session as the AVI file descriptor, so the render paths
+ * can keep state across frames.
+ */
+struct Session
+{
+	avi_t* avi;
+	ConvolutionFilter* convolutionFilter;
+	TemporalFilter* temporalFilter;
+	Compositor* compositor;
+	FusedReader* fusedReader;
+
+	bool isAutoExposureEnabled;
+	AutoExposure autoExposure;
+
+	Statistics statistics;
+	PerfCounters* perfCounters;
+
+	Session():
+		avi(0),
+		convolutionFilter(0),
+		temporalFilter(0),
+		compositor(0),
+		fusedReader(0),
+		isAutoExposureEnabled(false),
+		perfCounters(0)
+	{
+
+	}
+};
@@ -0,0 +1,202 @@
+#include "Statistics.h"
+
+#include <string.h>
+
+// Largest recorded latency
+static const unsigned long long MAX_LATENCY =
+		(1ULL << (LATENCY_MAGNITUDES + LATENCY_SUB_BUCKET_BITS)) - 1;
+
+Statistics::Statistics()
+{
+	memset(this, 0, sizeof(Statistics));
+}
+
+/**
+ * Gets the bucket index for the given value.
+ */
+static int getBucket(
+		unsigned long long value)
+{
+	if (value > MAX_LATENCY)
+	{
+		value = MAX_LATENCY;
+	}
+
+	// Magnitude is zero for the first two linear ranges
+	int magnitude = 0;
+	if (value >= LATENCY_SUB_BUCKETS)
+	{
+		magnitude = (63 - __builtin_clzll(value)) - LATENCY_SUB_BUCKET_BITS;
+	}
+
+	return (magnitude * LATENCY_SUB_BUCKETS) + (int) (value >> magnitude);
+}
+
+/**
+ * Gets the largest value that falls into the given bucket.
+ */
+static long long getBucketValue(
+		int bucket)
+{
+	int magnitude = 0;
+	int subBucket = bucket;
+
+	if (bucket >= 2 * LATENCY_SUB_BUCKETS)
+	{
+		magnitude = (bucket / LATENCY_SUB_BUCKETS) - 1;
+		subBucket = bucket - (magnitude * LATENCY_SUB_BUCKETS);
+	}
+
+	return (((long long) subBucket + 1) << magnitude) - 1;
+}
+
+static void recordLatency(
+		LatencyHistogram* histogram,
+		long long latency)
+{
+	if (latency < 0)
+	{
+		latency = 0;
+	}
+
+	histogram->counts[getBucket(latency)]++;
+
+	if (latency > histogram->max)
+	{
+		histogram->max = latency;
+	}
+}
+
+/**
+ * Gets the value at the given percentile.
+ */
+static long long getPercentile(
+		const LatencyHistogram* histogram,
+		int percentile)
+{
+	unsigned long long total = 0;
+	for (int i = 0; i < LATENCY_BUCKETS; i++)
+	{
+		total += histogram->counts[i];
+	}
+
+	long long value = 0;
+
+	if (0 < total)
+	{
+		// Rank of the value, rounded up
+		unsigned long long rank = ((total * percentile) + 99) / 100;
+		unsigned long long count = 0;
+
+		for (int i = 0; i < LATENCY_BUCKETS; i++)
+		{
+			count += histogram->counts[i];
+			if (count >= rank)
+			{
+				value = getBucketValue(i);
+				break;
+			}
+		}
+
+		// Bucket bound may be above the actual maximum
+		if (value > histogram->max)
+		{
+			value = histogram->max;
+		}
+	}
+
+	return value;
+}
+
+static void getLatencies(
+		const LatencyHistogram* histogram,
+		long long* values)
+{
+	values[0] = getPercentile(histogram, 50);
+	values[1] = getPercentile(histogram, 90);
+	values[2] = getPercentile(histogram, 99);
+	values[3] = histogram->max;
+}
+
+/**
+ * Marks the start of an update, readers retry meanwhile.
+ */
+static inline void beginUpdate(
+		Statistics* statistics)
+{
+	statistics->sequence++;
+	__sync_synchronize();
+}
+
+static inline void endUpdate(
+		Statistics* statistics)
+{
+	__sync_synchronize();
+	statistics->sequence++;
+}
+
+void recordRead(
+		Statistics* statistics,
+		long frameSize,
+		long long latency)
+{
+	beginUpdate(statistics);
+
+	if (0 < frameSize)
+	{
+		statistics->framesRead++;
+		statistics->bytesRead += frameSize;
+	}
+
+	recordLatency(&statistics->readLatency, latency);
+
+	endUpdate(statistics);
+}
+
+void recordFilter(
+		Statistics* statistics,
+		long long latency)
+{
+	beginUpdate(statistics);
+	recordLatency(&statistics->filterLatency, latency);
+	endUpdate(statistics);
+}
+
+void recordPresent(
+		Statistics* statistics,
+		long long latency)
+{
+	beginUpdate(statistics);
+
+	statistics->framesPresented++;
+	recordLatency(&statistics->presentLatency, latency);
+
+	endUpdate(statistics);
+}
+
+void getStatistics(
+		const Statistics* statistics,
+		long long* values)
+{
+	Statistics snapshot;
+	unsigned int sequence;
+
+	// Copy until no update overlaps the copy
+	do
+	{
+		sequence = statistics->sequence;
+		__sync_synchronize();
+
+		memcpy(&snapshot, (const void*) statistics, sizeof(Statistics));
+
+		__sync_synchronize();
+	} while ((0 != (sequence & 1)) || (sequence != statistics->sequence));
+
+	values[STATS_FRAMES_READ] = snapshot.framesRead;
+	values[STATS_FRAMES_PRESENTED] = snapshot.framesPresented;
+	values[STATS_BYTES_READ] = snapshot.bytesRead;
+
+	getLatencies(&snapshot.readLatency, &values[STATS_READ_P50]);
+	getLatencies(&snapshot.filterLatency, &values[STATS_FILTER_P50]);
+	getLatencies(&snapshot.presentLatency, &values[STATS_PRESENT_P50]);
+}
@@ -0,0 +1,106 @@
+#pragma once
+
+// Latency histogram, 16 linear sub buckets per power of two
+#define LATENCY_SUB_BUCKET_BITS 4
+#define LATENCY_SUB_BUCKETS (1 << LATENCY_SUB_BUCKET_BITS)
+#define LATENCY_MAGNITUDES 36
+#define LATENCY_BUCKETS ((LATENCY_MAGNITUDES + 1) * LATENCY_SUB_BUCKETS)
+
+/**
+ * Statistics values. The indexes are shared with the
+ * AbstractPlayerActivity constants.
+ */
+enum StatisticsIndex
+{
+	STATS_FRAMES_READ = 0,
+	STATS_FRAMES_PRESENTED = 1,
+	STATS_BYTES_READ = 2,
+	STATS_READ_P50 = 3,
+	STATS_READ_P90 = 4,
+	STATS_READ_P99 = 5,
+	STATS_READ_MAX = 6,
+	STATS_FILTER_P50 = 7,
+	STATS_FILTER_P90 = 8,
+	STATS_FILTER_P99 = 9,
+	STATS_FILTER_MAX = 10,
+	STATS_PRESENT_P50 = 11,
+	STATS_PRESENT_P90 = 12,
+	STATS_PRESENT_P99 = 13,
+	STATS_PRESENT_MAX = 14,
+	STATS_SIZE = 15
+};
+
+/**
+ * HDR style latency histogram in nanoseconds. Buckets are
+ * linear within each power of two, so the relative error
+ * is below 1/16 from nanoseconds up to a minute.
+ */
+struct LatencyHistogram
+{
+	unsigned int counts[LATENCY_BUCKETS];
+	long long max;
+};
+
+/**
+ * Playback statistics. Written by the render thread only,
+ * read by any thread without locking through a sequence
+ * counter.
+ */
+struct Statistics
+{
+	// Odd while an update is in progress
+	volatile unsigned int sequence;
+
+	long long framesRead;
+	long long framesPresented;
+	long long bytesRead;
+
+	LatencyHistogram readLatency;
+	LatencyHistogram filterLatency;
+	LatencyHistogram presentLatency;
+
+	Statistics();
+};
+
+/**
+ * Records a frame read.
+ *
+ * @param statistics statistics.
+ * @param frameSize frame size in bytes.
+ * @param latency read latency in nanoseconds.
+ */
+void recordRead(
+		Statistics* statistics,
+		long frameSize,
+		long long latency);
+
+/**
+ * Records a frame filtering.
+ *
+ * @param statistics statistics.
+ * @param latency filter latency in nanoseconds.
+ */
+void recordFilter(
+		Statistics* statistics,
+		long long latency);
+
+/**
+ * Records a frame present.
+ *
+ * @param statistics statistics.
+ * @param latency present latency in nanoseconds.
+ */
+void recordPresent(
+		Statistics* statistics,
+		long long latency);
+
+/**
+ * Takes a consistent snapshot of the statistics, may be
+ * called from any thread.
+ *
+ * @param statistics statistics.
+ * @param values STATS_SIZE values, percentiles in nanoseconds.
+ */
+void getStatistics(
+		const Statistics* statistics,
+		long long* values);
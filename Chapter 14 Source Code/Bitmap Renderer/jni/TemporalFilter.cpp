@@ -0,0 +1,377 @@
+#include "TemporalFilter.h"
+
+#include <stdlib.h>
+
+#ifdef __ARM_NEON__
+
+#include <cpu-features.h>
+
+#include <arm_neon.h>
+
+#endif
+
+#ifdef __SSE2__
+
+#include <emmintrin.h>
+
+#endif
+
+// Component masks for RGB565
+static const unsigned char MAX_RB = 0xF8;
+static const unsigned char MAX_G = 0xFC;
+
+/**
+ * Row kernel, blends count pixels with the history planes.
+ */
+typedef void (*TemporalKernel)(
+		unsigned short* pixels,
+		unsigned char* r,
+		unsigned char* g,
+		unsigned char* b,
+		long count,
+		unsigned char threshold);
+
+struct TemporalFilter
+{
+	int width;
+	int height;
+	unsigned char threshold;
+	bool isPrimed;
+
+	// History planes
+	unsigned char* history;
+	unsigned char* r;
+	unsigned char* g;
+	unsigned char* b;
+
+	TemporalKernel kernel;
+
+	TemporalFilter():
+		width(0),
+		height(0),
+		threshold(0),
+		isPrimed(false),
+		history(0),
+		r(0),
+		g(0),
+		b(0),
+		kernel(0)
+	{
+
+	}
+};
+
+static inline unsigned char absDiff(
+		unsigned char a,
+		unsigned char b)
+{
+	return (a > b) ? (a - b) : (b - a);
+}
+
+static inline unsigned char average(
+		unsigned char a,
+		unsigned char b)
+{
+	return (a + b + 1) >> 1;
+}
+
+static void genericTemporalKernel(
+		unsigned short* pixels,
+		unsigned char* r,
+		unsigned char* g,
+		unsigned char* b,
+		long count,
+		unsigned char threshold)
+{
+	for (long i = 0; i < count; i++)
+	{
+		// Decompose colors
+		unsigned char cr = (pixels[i] >> 8) & MAX_RB;
+		unsigned char cg = (pixels[i] >> 3) & MAX_G;
+		unsigned char cb = (pixels[i] << 3) & MAX_RB;
+
+		// Largest component difference is the motion estimate
+		unsigned char motion = absDiff(cr, r[i]);
+		unsigned char dg = absDiff(cg, g[i]);
+		unsigned char db = absDiff(cb, b[i]);
+		motion = (dg > motion) ? dg : motion;
+		motion = (db > motion) ? db : motion;
+
+		// Static pixels move a quarter of the way to the new value
+		if (motion < threshold)
+		{
+			cr = average(r[i], average(r[i], cr));
+			cg = average(g[i], average(g[i], cg));
+			cb = average(b[i], average(b[i], cb));
+		}
+
+		r[i] = cr;
+		g[i] = cg;
+		b[i] = cb;
+
+		// Set pixel
+		pixels[i] = ((cr & MAX_RB) << 8)
+				| ((cg & MAX_G) << 3)
+				| ((cb & MAX_RB) >> 3);
+	}
+}
+
+#ifdef __ARM_NEON__
+
+static void neonTemporalKernel(
+		unsigned short* pixels,
+		unsigned char* r,
+		unsigned char* g,
+		unsigned char* b,
+		long count,
+		unsigned char threshold)
+{
+	uint8x8_t maxRb = vdup_n_u8(MAX_RB);
+	uint8x8_t maxG = vdup_n_u8(MAX_G);
+	uint8x8_t limit = vdup_n_u8(threshold);
+
+	long i = 0;
+	for (; i + 8 <= count; i += 8)
+	{
+		// Load 8 16-bit pixels
+		uint16x8_t rgb = vld1q_u16(&pixels[i]);
+
+		// Unpack the components to 8-bits
+		uint8x8_t cr = vand_u8(vshrn_n_u16(rgb, 8), maxRb);
+		uint8x8_t cg = vand_u8(vshrn_n_u16(rgb, 3), maxG);
+		uint8x8_t cb = vand_u8(vshl_n_u8(vmovn_u16(rgb), 3), maxRb);
+
+		// Load the history
+		uint8x8_t hr = vld1_u8(&r[i]);
+		uint8x8_t hg = vld1_u8(&g[i]);
+		uint8x8_t hb = vld1_u8(&b[i]);
+
+		// Largest component difference is the motion estimate
+		uint8x8_t motion = vmax_u8(vabd_u8(cr, hr),
+				vmax_u8(vabd_u8(cg, hg), vabd_u8(cb, hb)));
+		uint8x8_t isStatic = vclt_u8(motion, limit);
+
+		// Static pixels move a quarter of the way to the new value
+		cr = vbsl_u8(isStatic, vrhadd_u8(hr, vrhadd_u8(hr, cr)), cr);
+		cg = vbsl_u8(isStatic, vrhadd_u8(hg, vrhadd_u8(hg, cg)), cg);
+		cb = vbsl_u8(isStatic, vrhadd_u8(hb, vrhadd_u8(hb, cb)), cb);
+
+		// Store the history
+		vst1_u8(&r[i], cr);
+		vst1_u8(&g[i], cg);
+		vst1_u8(&b[i], cb);
+
+		// Pack the pixels back
+		rgb = vshll_n_u8(cr, 8);
+		rgb = vsriq_n_u16(rgb, vshll_n_u8(cg, 8), 5);
+		rgb = vsriq_n_u16(rgb, vshll_n_u8(cb, 8), 11);
+
+		// Store 8 16-bit pixels
+		vst1q_u16(&pixels[i], rgb);
+	}
+
+	// Remaining pixels
+	genericTemporalKernel(&pixels[i], &r[i], &g[i], &b[i], count - i, threshold);
+}
+
+#endif
+
+#ifdef __SSE2__
+
+/**
+ * Blends one component of 8 pixels in 16-bit lanes.
+ */
+static inline __m128i sseTemporalBlend(
+		__m128i current,
+		__m128i history,
+		__m128i isStatic)
+{
+	__m128i blend = _mm_avg_epu16(history, _mm_avg_epu16(history, current));
+
+	return _mm_or_si128(_mm_and_si128(isStatic, blend),
+			_mm_andnot_si128(isStatic, current));
+}
+
+static inline __m128i sseAbsDiff(
+		__m128i a,
+		__m128i b)
+{
+	return _mm_or_si128(_mm_subs_epu16(a, b), _mm_subs_epu16(b, a));
+}
+
+static inline __m128i sseLoadHistory(
+		const unsigned char* history)
+{
+	return _mm_unpacklo_epi8(
+			_mm_loadl_epi64((const __m128i*) history),
+			_mm_setzero_si128());
+}
+
+static inline void sseStoreHistory(
+		unsigned char* history,
+		__m128i component)
+{
+	_mm_storel_epi64((__m128i*) history, _mm_packus_epi16(component, component));
+}
+
+static void sseTemporalKernel(
+		unsigned short* pixels,
+		unsigned char* r,
+		unsigned char* g,
+		unsigned char* b,
+		long count,
+		unsigned char threshold)
+{
+	__m128i maxRb = _mm_set1_epi16(MAX_RB);
+	__m128i maxG = _mm_set1_epi16(MAX_G);
+	__m128i limit = _mm_set1_epi16(threshold);
+
+	long i = 0;
+	for (; i + 8 <= count; i += 8)
+	{
+		__m128i rgb = _mm_loadu_si128((const __m128i*) &pixels[i]);
+
+		__m128i cr = _mm_and_si128(_mm_srli_epi16(rgb, 8), maxRb);
+		__m128i cg = _mm_and_si128(_mm_srli_epi16(rgb, 3), maxG);
+		__m128i cb = _mm_and_si128(_mm_slli_epi16(rgb, 3), maxRb);
+
+		__m128i hr = sseLoadHistory(&r[i]);
+		__m128i hg = sseLoadHistory(&g[i]);
+		__m128i hb = sseLoadHistory(&b[i]);
+
+		__m128i motion = _mm_max_epi16(sseAbsDiff(cr, hr),
+				_mm_max_epi16(sseAbsDiff(cg, hg), sseAbsDiff(cb, hb)));
+		__m128i isStatic = _mm_cmplt_epi16(motion, limit);
+
+		cr = sseTemporalBlend(cr, hr, isStatic);
+		cg = sseTemporalBlend(cg, hg, isStatic);
+		cb = sseTemporalBlend(cb, hb, isStatic);
+
+		sseStoreHistory(&r[i], cr);
+		sseStoreHistory(&g[i], cg);
+		sseStoreHistory(&b[i], cb);
+
+		rgb = _mm_slli_epi16(_mm_and_si128(cr, maxRb), 8);
+		rgb = _mm_or_si128(rgb, _mm_slli_epi16(_mm_and_si128(cg, maxG), 3));
+		rgb = _mm_or_si128(rgb, _mm_srli_epi16(_mm_and_si128(cb, maxRb), 3));
+
+		_mm_storeu_si128((__m128i*) &pixels[i], rgb);
+	}
+
+	genericTemporalKernel(&pixels[i], &r[i], &g[i], &b[i], count - i, threshold);
+}
+
+#endif
+
+/**
+ * Selects the row kernel based on the CPU features.
+ */
+static TemporalKernel selectKernel()
+{
+	TemporalKernel kernel = genericTemporalKernel;
+
+#ifdef __ARM_NEON__
+	// Get the CPU family
+	AndroidCpuFamily cpuFamily = android_getCpuFamily();
+
+	// Get the CPU features
+	uint64_t cpuFeatures = android_getCpuFeatures();
+
+	// Use NEON optimized kernel only on ARM CPUs with NEON support
+	if ((ANDROID_CPU_FAMILY_ARM == cpuFamily)
+			&& ((ANDROID_CPU_ARM_FEATURE_NEON & cpuFeatures) != 0))
+	{
+		kernel = neonTemporalKernel;
+	}
+#endif
+
+#ifdef __SSE2__
+	kernel = sseTemporalKernel;
+#endif
+
+	return kernel;
+}
+
+TemporalFilter* createTemporalFilter(
+		int width,
+		int height,
+		int threshold)
+{
+	TemporalFilter* filter = 0;
+	long planeSize = 0;
+
+	if ((0 >= width) || (0 >= height) || (0 >= threshold))
+	{
+		goto exit;
+	}
+
+	filter = new TemporalFilter();
+	if (0 == filter)
+	{
+		goto exit;
+	}
+
+	filter->width = width;
+	filter->height = height;
+	filter->threshold = (threshold > 255) ? 255 : threshold;
+	filter->kernel = selectKernel();
+
+	// Allocate the history planes up front
+	planeSize = (long) width * height;
+	filter->history = (unsigned char*) malloc(3 * planeSize);
+	if (0 == filter->history)
+	{
+		delete filter;
+		filter = 0;
+		goto exit;
+	}
+
+	filter->r = filter->history;
+	filter->g = filter->r + planeSize;
+	filter->b = filter->g + planeSize;
+
+exit:
+	return filter;
+}
+
+void destroyTemporalFilter(
+		TemporalFilter* filter)
+{
+	if (0 != filter)
+	{
+		free(filter->history);
+		delete filter;
+	}
+}
+
+void temporalFilter(
+		TemporalFilter* filter,
+		unsigned short* pixels,
+		int width,
+		int height,
+		long stride)
+{
+	if ((0 == filter) || (width != filter->width) || (height != filter->height))
+	{
+		return;
+	}
+
+	// A threshold of zero passes every pixel through and
+	// initializes the history with the first frame
+	unsigned char threshold = filter->isPrimed ? filter->threshold : 0;
+
+	for (int y = 0; y < height; y++)
+	{
+		long offset = (long) y * width;
+
+		filter->kernel(
+				(unsigned short*) (((unsigned char*) pixels) + (y * stride)),
+				filter->r + offset,
+				filter->g + offset,
+				filter->b + offset,
+				width,
+				threshold);
+	}
+
+	filter->isPrimed = true;
+}
@@ -0,0 +1,46 @@
+#pragma once
+
+/**
+ * Temporal denoise filter state. Holds the history frame as
+ * unpacked 8-bit color planes, allocated once per session.
+ */
+struct TemporalFilter;
+
+/**
+ * Creates a new temporal filter for the given frame size.
+ *
+ * @param width frame width in pixels.
+ * @param height frame height in pixels.
+ * @param threshold motion threshold. Pixels that differ from
+ *        the history more than this are taken as is.
+ * @return temporal filter or 0 on failure.
+ */
+TemporalFilter* createTemporalFilter(
+		int width,
+		int height,
+		int threshold);
+
+/**
+ * Destroys the given temporal filter.
+ *
+ * @param filter temporal filter.
+ */
+void destroyTemporalFilter(
+		TemporalFilter* filter);
+
+/**
+ * Blends the given RGB565 frame in place with the history
+ * and updates the history. No memory is allocated.
+ *
+ * @param filter temporal filter.
+ * @param pixels RGB565 pixels.
+ * @param width frame width in pixels.
+ * @param height frame height in pixels.
+ * @param stride row stride in bytes.
+ */
+void temporalFilter(
+		TemporalFilter* filter,
+		unsigned short* pixels,
+		int width,
+		int height,
+		long stride);
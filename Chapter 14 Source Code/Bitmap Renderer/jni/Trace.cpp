@@ -0,0 +1,211 @@
+#include "Trace.h"
+
+#ifdef MY_TRACE_ENABLED
+
+#include <limits.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <unistd.h>
+#include <sys/syscall.h>
+
+// Events per thread, must be a power of two
+#define TRACE_BUFFER_SIZE 16384
+#define TRACE_BUFFER_MASK (TRACE_BUFFER_SIZE - 1)
+
+struct TraceEvent
+{
+	const char* name;
+	long long start;
+	long long duration;
+	int threadId;
+};
+
+/**
+ * Single writer ring buffer. Only the owner thread writes
+ * the events and the count, readers look at the events
+ * below the count.
+ */
+struct TraceBuffer
+{
+	// Claimed by a live thread
+	volatile int isInUse;
+	int threadId;
+
+	// Events written and already written to a file
+	volatile unsigned int count;
+	unsigned int writtenCount;
+
+	TraceBuffer* next;
+	TraceEvent events[TRACE_BUFFER_SIZE];
+};
+
+// All trace buffers, never freed, reused by the new threads
+static TraceBuffer* volatile traceBuffers = 0;
+
+// Trace files written by the process
+static volatile int traceFileCount = 0;
+
+// Thread's trace buffer
+static pthread_key_t traceBufferKey;
+static pthread_once_t traceBufferKeyOnce = PTHREAD_ONCE_INIT;
+
+/**
+ * Releases the trace buffer when its thread exits. The
+ * events stay for the next write.
+ */
+static void releaseTraceBuffer(
+		void* buffer)
+{
+	((TraceBuffer*) buffer)->isInUse = 0;
+}
+
+static void createTraceBufferKey()
+{
+	pthread_key_create(&traceBufferKey, releaseTraceBuffer);
+}
+
+/**
+ * Gets the calling thread's trace buffer, claims a released
+ * one or allocates a new one on first use.
+ */
+static TraceBuffer* getTraceBuffer()
+{
+	pthread_once(&traceBufferKeyOnce, createTraceBufferKey);
+
+	TraceBuffer* buffer = (TraceBuffer*) pthread_getspecific(traceBufferKey);
+	if (0 != buffer)
+	{
+		goto exit;
+	}
+
+	// Claim a buffer released by an exited thread
+	for (buffer = traceBuffers; 0 != buffer; buffer = buffer->next)
+	{
+		if (__sync_bool_compare_and_swap(&buffer->isInUse, 0, 1))
+		{
+			break;
+		}
+	}
+
+	if (0 == buffer)
+	{
+		buffer = new TraceBuffer();
+		if (0 == buffer)
+		{
+			goto exit;
+		}
+
+		buffer->isInUse = 1;
+		buffer->count = 0;
+		buffer->writtenCount = 0;
+
+		// Push to the buffer list
+		do
+		{
+			buffer->next = traceBuffers;
+		} while (!__sync_bool_compare_and_swap(&traceBuffers,
+				buffer->next, buffer));
+	}
+
+	buffer->threadId = syscall(__NR_gettid);
+	pthread_setspecific(traceBufferKey, buffer);
+
+exit:
+	return buffer;
+}
+
+void addTraceEvent(
+		const char* name,
+		long long start,
+		long long end)
+{
+	TraceBuffer* buffer = getTraceBuffer();
+	if (0 == buffer)
+	{
+		return;
+	}
+
+	unsigned int count = buffer->count;
+	TraceEvent* event = &buffer->events[count & TRACE_BUFFER_MASK];
+
+	event->name = name;
+	event->start = start;
+	event->duration = end - start;
+	event->threadId = buffer->threadId;
+
+	// Publish the event
+	__sync_synchronize();
+	buffer->count = count + 1;
+}
+
+bool writeTrace(
+		const char* filePrefix)
+{
+	bool isWritten = false;
+	bool isFirst = true;
+	int processId = getpid();
+	char fileName[PATH_MAX];
+
+	// Sessions may close at the same time
+	snprintf(fileName, sizeof(fileName), "%s-%d-%d.json",
+			filePrefix,
+			processId,
+			__sync_add_and_fetch(&traceFileCount, 1));
+
+	FILE* file = fopen(fileName, "w");
+	if (0 == file)
+	{
+		LOGE("Unable to open %s", fileName);
+		goto exit;
+	}
+
+	fprintf(file, "{\"traceEvents\":[");
+
+	for (TraceBuffer* buffer = traceBuffers; 0 != buffer; buffer = buffer->next)
+	{
+		unsigned int count = buffer->count;
+		__sync_synchronize();
+
+		// Older events are overwritten by the ring
+		unsigned int i = buffer->writtenCount;
+		if (count - i > TRACE_BUFFER_SIZE)
+		{
+			i = count - TRACE_BUFFER_SIZE;
+		}
+
+		for (; i != count; i++)
+		{
+			const TraceEvent* event = &buffer->events[i & TRACE_BUFFER_MASK];
+
+			// Timestamps are in microseconds
+			fprintf(file,
+					"%s\n{\"name\":\"%s\",\"cat\":\"AVIPlayer\",\"ph\":\"X\","
+					"\"ts\":%lld.%03lld,\"dur\":%lld.%03lld,\"pid\":%d,\"tid\":%d}",
+					isFirst ? "" : ",",
+					event->name,
+					event->start / 1000, event->start % 1000,
+					event->duration / 1000, event->duration % 1000,
+					processId,
+					event->threadId);
+
+			isFirst = false;
+		}
+
+		buffer->writtenCount = count;
+	}
+
+	fprintf(file, "\n],\"displayTimeUnit\":\"ns\"}\n");
+
+	isWritten = (0 == ferror(file));
+	fclose(file);
+
+	if (isWritten)
+	{
+		LOGI("Trace written to %s", fileName);
+	}
+
+exit:
+	return isWritten;
+}
+
+#endif
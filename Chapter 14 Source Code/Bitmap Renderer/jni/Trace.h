@@ -0,0 +1,77 @@
+#pragma once
+
+/**
+ * Hot path tracing. Trace events are recorded into per
+ * thread lock-free ring buffers with nanosecond timestamps
+ * and written as Chrome trace_event JSON. Everything here
+ * compiles to nothing unless MY_TRACE_ENABLED is defined.
+ */
+#ifdef MY_TRACE_ENABLED
+
+#include "Common.h"
+
+// Trace file prefix, like gmon.out it goes to the external
+// storage, one file per session
+#ifndef MY_TRACE_FILE_PREFIX
+#define MY_TRACE_FILE_PREFIX "/sdcard/trace"
+#endif
+
+/**
+ * Adds a complete trace event to the calling thread's ring
+ * buffer. The name must be a string literal.
+ *
+ * @param name event name.
+ * @param start start time in nanoseconds.
+ * @param end end time in nanoseconds.
+ */
+void addTraceEvent(
+		const char* name,
+		long long start,
+		long long end);
+
+/**
+ * Writes the trace events recorded since the last write
+ * as Chrome trace_event JSON. Each write goes to a new
+ * file, the prefix followed by the process id and the
+ * write count, so earlier sessions are kept.
+ *
+ * @param filePrefix file name prefix.
+ * @return true on success, false otherwise.
+ */
+bool writeTrace(
+		const char* filePrefix);
+
+/**
+ * Records a trace event for the lifetime of the scope.
+ */
+class TraceScope
+{
+public:
+	TraceScope(const char* name):
+		name(name),
+		start(GetTimeNanos())
+	{
+
+	}
+
+	~TraceScope()
+	{
+		addTraceEvent(name, start, GetTimeNanos());
+	}
+
+private:
+	const char* name;
+	long long start;
+};
+
+#define TRACE_CONCAT_(a, b) a##b
+#define TRACE_CONCAT(a, b) TRACE_CONCAT_(a, b)
+
+// Traces the enclosing scope
+#define TRACE_SCOPE(name) TraceScope TRACE_CONCAT(traceScope, __LINE__)(name)
+
+#else
+
+#define TRACE_SCOPE(name)
+
+#endif
@@ -2,11 +2,11 @@ extern "C" {
 #include <avilib.h>
 }
 
-#ifdef MY_ANDROID_NDK_PROFILER_ENABLED
-#include <prof.h>
-#endif
-
 #include "Common.h"
+#include "PerfCounters.h"
+#include "Session.h"
+#include "Statistics.h"
+#include "Trace.h"
 #include "com_apress_aviplayer_AbstractPlayerActivity.h"
 
 jlong Java_com_apress_aviplayer_AbstractPlayerActivity_open(
@@ -14,13 +14,9 @@ jlong Java_com_apress_aviplayer_AbstractPlayerActivity_open(
 		jclass clazz,
 		jstring fileName)
 {
+	Session* session = 0;
 	avi_t* avi = 0;
 
-#ifdef MY_ANDROID_NDK_PROFILER_ENABLED
-	// Start collecting the samples
-	monstartup("libAVIPlayer.so");
-#endif
-
 	// Get the file name as a C string
 	const char* cFileName = env->GetStringUTFChars(fileName, 0);
 	if (0 == cFileName)
@@ -38,10 +34,22 @@ jlong Java_com_apress_aviplayer_AbstractPlayerActivity_open(
 	if (0 == avi)
 	{
 		ThrowException(env, "java/io/IOException", AVI_strerror());
+		goto exit;
 	}
 
+	// Create the player session
+	session = new Session();
+	if (0 == session)
+	{
+		ThrowException(env, "java/lang/OutOfMemoryError", "session");
+		AVI_close(avi);
+		goto exit;
+	}
+
+	session->avi = avi;
+
 exit:
-	return (jlong) avi;
+	return (jlong) session;
 }
 
 jint Java_com_apress_aviplayer_AbstractPlayerActivity_getWidth(
@@ -49,7 +57,7 @@ jint Java_com_apress_aviplayer_AbstractPlayerActivity_getWidth(
 		jclass clazz,
 		jlong avi)
 {
-	return AVI_video_width((avi_t*) avi);
+	return AVI_video_width(((Session*) avi)->avi);
 }
 
 jint Java_com_apress_aviplayer_AbstractPlayerActivity_getHeight(
@@ -57,7 +65,7 @@ jint Java_com_apress_aviplayer_AbstractPlayerActivity_getHeight(
 		jclass clazz,
 		jlong avi)
 {
-	return AVI_video_height((avi_t*) avi);
+	return AVI_video_height(((Session*) avi)->avi);
 }
 
 jdouble Java_com_apress_aviplayer_AbstractPlayerActivity_getFrameRate(
@@ -65,18 +73,108 @@ jdouble Java_com_apress_aviplayer_AbstractPlayerActivity_getFrameRate(
 		jclass clazz,
 		jlong avi)
 {
-	return AVI_frame_rate((avi_t*) avi);
+	return AVI_frame_rate(((Session*) avi)->avi);
+}
+
+void Java_com_apress_aviplayer_AbstractPlayerActivity_getStats(
+		JNIEnv* env,
+		jclass clazz,
+		jlong avi,
+		jlongArray stats)
+{
+	long long values[STATS_SIZE];
+	jlong javaValues[STATS_SIZE];
+
+	if (STATS_SIZE > env->GetArrayLength(stats))
+	{
+		ThrowException(env, "java/lang/IllegalArgumentException",
+				"Stats array is too small.");
+		goto exit;
+	}
+
+	// Snapshot of the render thread's statistics
+	getStatistics(&((Session*) avi)->statistics, values);
+
+	for (int i = 0; i < STATS_SIZE; i++)
+	{
+		javaValues[i] = values[i];
+	}
+
+	env->SetLongArrayRegion(stats, 0, STATS_SIZE, javaValues);
+
+exit:
+	return;
+}
+
+#ifdef MY_PERF_COUNTERS_ENABLED
+/**
+ * Logs the per frame averages of the hardware counters
+ * for each pipeline stage.
+ *
+ * @param counters perf counters.
+ */
+static void logPerfCounters(
+		const PerfCounters* counters)
+{
+	long long values[PERF_COUNTERS];
+
+	for (int stage = 0; stage < PERF_STAGES; stage++)
+	{
+		long long samples = getPerfStage(counters, stage, values);
+		if (0 == samples)
+		{
+			continue;
+		}
+
+		// Unavailable counters stay negative
+		for (int i = 0; i < PERF_COUNTERS; i++)
+		{
+			if (0 <= values[i])
+			{
+				values[i] /= samples;
+			}
+		}
+
+		LOGI("%s: %lld runs, %lld cycles, %lld instructions, "
+				"%lld cache misses, %lld branch misses per run",
+				getPerfStageName(stage),
+				samples,
+				values[PERF_COUNTER_CYCLES],
+				values[PERF_COUNTER_INSTRUCTIONS],
+				values[PERF_COUNTER_CACHE_MISSES],
+				values[PERF_COUNTER_BRANCH_MISSES]);
+	}
 }
+#endif
 
 void Java_com_apress_aviplayer_AbstractPlayerActivity_close(
 		JNIEnv* env,
 		jclass clazz,
 		jlong avi)
 {
-	AVI_close((avi_t*) avi);
+	Session* session = (Session*) avi;
+
+	// Free the render state
+	destroyConvolutionFilter(session->convolutionFilter);
+	destroyTemporalFilter(session->temporalFilter);
+	destroyCompositor(session->compositor);
+	destroyFusedReader(session->fusedReader);
+
+#ifdef MY_PERF_COUNTERS_ENABLED
+	// Summarize the run
+	if (0 != session->perfCounters)
+	{
+		logPerfCounters(session->perfCounters);
+	}
+#endif
+
+	destroyPerfCounters(session->perfCounters);
+
+	AVI_close(session->avi);
+	delete session;
 
-#ifdef MY_ANDROID_NDK_PROFILER_ENABLED
-	// Store the collected data
-	moncleanup();
+#ifdef MY_TRACE_ENABLED
+	// Store the collected trace events
+	writeTrace(MY_TRACE_FILE_PREFIX);
 #endif
 }
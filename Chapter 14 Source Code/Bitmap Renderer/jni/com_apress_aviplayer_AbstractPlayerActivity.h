@@ -55,6 +55,38 @@ extern "C" {
 #define com_apress_aviplayer_AbstractPlayerActivity_DEFAULT_KEYS_SEARCH_LOCAL 3L
 #undef com_apress_aviplayer_AbstractPlayerActivity_DEFAULT_KEYS_SEARCH_GLOBAL
 #define com_apress_aviplayer_AbstractPlayerActivity_DEFAULT_KEYS_SEARCH_GLOBAL 4L
+#undef com_apress_aviplayer_AbstractPlayerActivity_STATS_FRAMES_READ
+#define com_apress_aviplayer_AbstractPlayerActivity_STATS_FRAMES_READ 0L
+#undef com_apress_aviplayer_AbstractPlayerActivity_STATS_FRAMES_PRESENTED
+#define com_apress_aviplayer_AbstractPlayerActivity_STATS_FRAMES_PRESENTED 1L
+#undef com_apress_aviplayer_AbstractPlayerActivity_STATS_BYTES_READ
+#define com_apress_aviplayer_AbstractPlayerActivity_STATS_BYTES_READ 2L
+#undef com_apress_aviplayer_AbstractPlayerActivity_STATS_READ_P50
+#define com_apress_aviplayer_AbstractPlayerActivity_STATS_READ_P50 3L
+#undef com_apress_aviplayer_AbstractPlayerActivity_STATS_READ_P90
+#define com_apress_aviplayer_AbstractPlayerActivity_STATS_READ_P90 4L
+#undef com_apress_aviplayer_AbstractPlayerActivity_STATS_READ_P99
+#define com_apress_aviplayer_AbstractPlayerActivity_STATS_READ_P99 5L
+#undef com_apress_aviplayer_AbstractPlayerActivity_STATS_READ_MAX
+#define com_apress_aviplayer_AbstractPlayerActivity_STATS_READ_MAX 6L
+#undef com_apress_aviplayer_AbstractPlayerActivity_STATS_FILTER_P50
+#define com_apress_aviplayer_AbstractPlayerActivity_STATS_FILTER_P50 7L
+#undef com_apress_aviplayer_AbstractPlayerActivity_STATS_FILTER_P90
+#define com_apress_aviplayer_AbstractPlayerActivity_STATS_FILTER_P90 8L
+#undef com_apress_aviplayer_AbstractPlayerActivity_STATS_FILTER_P99
+#define com_apress_aviplayer_AbstractPlayerActivity_STATS_FILTER_P99 9L
+#undef com_apress_aviplayer_AbstractPlayerActivity_STATS_FILTER_MAX
+#define com_apress_aviplayer_AbstractPlayerActivity_STATS_FILTER_MAX 10L
+#undef com_apress_aviplayer_AbstractPlayerActivity_STATS_PRESENT_P50
+#define com_apress_aviplayer_AbstractPlayerActivity_STATS_PRESENT_P50 11L
+#undef com_apress_aviplayer_AbstractPlayerActivity_STATS_PRESENT_P90
+#define com_apress_aviplayer_AbstractPlayerActivity_STATS_PRESENT_P90 12L
+#undef com_apress_aviplayer_AbstractPlayerActivity_STATS_PRESENT_P99
+#define com_apress_aviplayer_AbstractPlayerActivity_STATS_PRESENT_P99 13L
+#undef com_apress_aviplayer_AbstractPlayerActivity_STATS_PRESENT_MAX
+#define com_apress_aviplayer_AbstractPlayerActivity_STATS_PRESENT_MAX 14L
+#undef com_apress_aviplayer_AbstractPlayerActivity_STATS_SIZE
+#define com_apress_aviplayer_AbstractPlayerActivity_STATS_SIZE 15L
 /*
  * Class:     com_apress_aviplayer_AbstractPlayerActivity
  * Method:    open
@@ -87,6 +119,14 @@ JNIEXPORT jint JNICALL Java_com_apress_aviplayer_AbstractPlayerActivity_getHeigh
 JNIEXPORT jdouble JNICALL Java_com_apress_aviplayer_AbstractPlayerActivity_getFrameRate
   (JNIEnv *, jclass, jlong);
 
+/*
+ * Class:     com_apress_aviplayer_AbstractPlayerActivity
+ * Method:    getStats
+ * Signature: (J[J)V
+ */
+JNIEXPORT void JNICALL Java_com_apress_aviplayer_AbstractPlayerActivity_getStats
+  (JNIEnv *, jclass, jlong, jlongArray);
+
 /*
  * Class:     com_apress_aviplayer_AbstractPlayerActivity
  * Method:    close
@@ -4,37 +4,440 @@ extern "C" {
 
 #include <android/bitmap.h>
 
+#include "AutoExposure.h"
 #include "BrightnessFilter.h"
+#include "Compositor.h"
+#include "ConvolutionFilter.h"
+#include "FusedReader.h"
+#include "PerfCounters.h"
 #include "Common.h"
+#include "PixelFormat.h"
+#include "Session.h"
+#include "Statistics.h"
+#include "TemporalFilter.h"
+#include "Trace.h"
 #include "com_apress_aviplayer_BitmapPlayerActivity.h"
 
+void Java_com_apress_aviplayer_BitmapPlayerActivity_setConvolutionFilter(
+		JNIEnv* env,
+		jclass clazz,
+		jlong avi,
+		jint type)
+{
+	Session* session = (Session*) avi;
+
+	// Release the previous filter
+	destroyConvolutionFilter(session->convolutionFilter);
+	session->convolutionFilter = 0;
+
+	if (CONVOLUTION_FILTER_NONE == type)
+	{
+		goto exit;
+	}
+
+	// Ring buffers are sized for the AVI frame width
+	session->convolutionFilter = createConvolutionFilter(type,
+			AVI_video_width(session->avi),
+			PIXEL_FORMAT_RGB_565);
+
+	if (0 == session->convolutionFilter)
+	{
+		ThrowException(env, "java/lang/IllegalArgumentException",
+				"Unable to create convolution filter.");
+	}
+
+exit:
+	return;
+}
+
+void Java_com_apress_aviplayer_BitmapPlayerActivity_setAutoExposure(
+		JNIEnv* env,
+		jclass clazz,
+		jlong avi,
+		jboolean enabled)
+{
+	Session* session = (Session*) avi;
+
+	// Start from the neutral level
+	session->autoExposure = AutoExposure();
+	session->isAutoExposureEnabled = (JNI_TRUE == enabled);
+}
+
+void Java_com_apress_aviplayer_BitmapPlayerActivity_setTemporalDenoise(
+		JNIEnv* env,
+		jclass clazz,
+		jlong avi,
+		jint threshold)
+{
+	Session* session = (Session*) avi;
+
+	// Release the previous filter and its history
+	destroyTemporalFilter(session->temporalFilter);
+	session->temporalFilter = 0;
+
+	if (0 == threshold)
+	{
+		goto exit;
+	}
+
+	// History is allocated once for the AVI frame size
+	session->temporalFilter = createTemporalFilter(
+			AVI_video_width(session->avi),
+			AVI_video_height(session->avi),
+			threshold);
+
+	if (0 == session->temporalFilter)
+	{
+		ThrowException(env, "java/lang/IllegalArgumentException",
+				"Unable to create temporal filter.");
+	}
+
+exit:
+	return;
+}
+
+void Java_com_apress_aviplayer_BitmapPlayerActivity_setOverlay(
+		JNIEnv* env,
+		jclass clazz,
+		jlong avi,
+		jobject overlay,
+		jint left,
+		jint top,
+		jint keyColor,
+		jint keyTolerance)
+{
+	Session* session = (Session*) avi;
+
+	AndroidBitmapInfo overlayInfo;
+	void* overlayPixels = 0;
+
+	// Remove the overlay
+	if (0 == overlay)
+	{
+		destroyCompositor(session->compositor);
+		session->compositor = 0;
+		goto exit;
+	}
+
+	// Get the overlay geometry
+	if (0 > AndroidBitmap_getInfo(env, overlay, &overlayInfo))
+	{
+		ThrowException(env, "java/io/IOException", "Unable to get overlay info.");
+		goto exit;
+	}
+
+	if (ANDROID_BITMAP_FORMAT_RGBA_8888 != overlayInfo.format)
+	{
+		ThrowException(env, "java/lang/IllegalArgumentException",
+				"Overlay must be ARGB_8888.");
+		goto exit;
+	}
+
+	// Reuse the compositor if the overlay size is the same
+	if (!isCompositorSize(session->compositor,
+			overlayInfo.width, overlayInfo.height))
+	{
+		destroyCompositor(session->compositor);
+		session->compositor = createCompositor(overlayInfo.width,
+				overlayInfo.height);
+
+		if (0 == session->compositor)
+		{
+			ThrowException(env, "java/lang/IllegalArgumentException",
+					"Unable to create compositor.");
+			goto exit;
+		}
+	}
+
+	// Lock overlay and get the raw bytes
+	if (0 > AndroidBitmap_lockPixels(env, overlay, &overlayPixels))
+	{
+		ThrowException(env, "java/io/IOException", "Unable to lock overlay.");
+		goto exit;
+	}
+
+	// Copy the overlay
+	setCompositorOverlay(session->compositor,
+			overlayPixels,
+			overlayInfo.stride,
+			left,
+			top,
+			keyColor,
+			keyTolerance);
+
+	// Unlock overlay
+	if (0 > AndroidBitmap_unlockPixels(env, overlay))
+	{
+		ThrowException(env, "java/io/IOException", "Unable to unlock overlay.");
+	}
+
+exit:
+	return;
+}
+
+/**
+ * Applies the session filters in place to the given frame.
+ *
+ * @param session player session.
+ * @param frameBuffer frame pixels.
+ * @param frameSize frame size in bytes.
+ * @param bitmapInfo bitmap geometry.
+ */
+static void filterFrame(
+		Session* session,
+		char* frameBuffer,
+		long frameSize,
+		const AndroidBitmapInfo& bitmapInfo)
+{
+	TRACE_SCOPE("filter");
+
+	unsigned char brightness = 1;
+
+	// Composite the overlay onto the frame
+	if (0 != session->compositor)
+	{
+		TRACE_SCOPE("composite");
+		PERF_SCOPE(session->perfCounters, PERF_STAGE_COMPOSITE);
+		composite(session->compositor,
+				(unsigned short*) frameBuffer,
+				bitmapInfo.width,
+				bitmapInfo.height,
+				bitmapInfo.stride);
+	}
+
+	// Blend the frame with the history
+	if (0 != session->temporalFilter)
+	{
+		TRACE_SCOPE("temporal");
+		PERF_SCOPE(session->perfCounters, PERF_STAGE_TEMPORAL);
+		temporalFilter(session->temporalFilter,
+				(unsigned short*) frameBuffer,
+				bitmapInfo.width,
+				bitmapInfo.height,
+				bitmapInfo.stride);
+	}
+
+	// Apply the convolution filter
+	if (0 != session->convolutionFilter)
+	{
+		TRACE_SCOPE("convolution");
+		PERF_SCOPE(session->perfCounters, PERF_STAGE_CONVOLUTION);
+		convolutionFilter(session->convolutionFilter,
+				frameBuffer,
+				bitmapInfo.width,
+				bitmapInfo.height,
+				bitmapInfo.stride);
+	}
+
+	// Derive the brightness from the frame luma histogram
+	if (session->isAutoExposureEnabled)
+	{
+		TRACE_SCOPE("exposure");
+		PERF_SCOPE(session->perfCounters, PERF_STAGE_EXPOSURE);
+		brightness = updateAutoExposure(&session->autoExposure,
+				(unsigned short*) frameBuffer,
+				bitmapInfo.width,
+				bitmapInfo.height,
+				bitmapInfo.stride);
+	}
+
+	// Apply the brigthness filter
+	{
+		TRACE_SCOPE("brightness");
+		PERF_SCOPE(session->perfCounters, PERF_STAGE_BRIGHTNESS);
+		brightnessFilter((unsigned short*) frameBuffer, frameSize/2, brightness);
+	}
+}
+
+/**
+ * Brightness band filter context. The filter time is
+ * summed over the bands, so that it can be recorded apart
+ * from the read time.
+ */
+struct BrightnessBand
+{
+	unsigned char brightness;
+	long long filterTime;
+};
+
+/**
+ * Brightness band filter for the fused read.
+ *
+ * @param context brightness band context.
+ * @param rows band pixels.
+ * @param width band width in pixels.
+ * @param rowCount number of rows in the band.
+ * @param stride band row stride in bytes.
+ */
+static void brightnessBand(
+		void* context,
+		unsigned char* rows,
+		int width,
+		int rowCount,
+		long stride)
+{
+	BrightnessBand* band = (BrightnessBand*) context;
+	long long startTime = GetTimeNanos();
+
+	for (int i = 0; i < rowCount; i++)
+	{
+		brightnessFilter((unsigned short*) (rows + (i * stride)),
+				width,
+				band->brightness);
+	}
+
+	band->filterTime += GetTimeNanos() - startTime;
+}
+
+/**
+ * Checks if only per pixel filters are active, so the
+ * frame can be filtered band by band as it is read.
+ *
+ * @param session player session.
+ * @return true if the frame can be read fused.
+ */
+static bool isFusedReadable(
+		const Session* session)
+{
+	return (0 == session->compositor)
+			&& (0 == session->temporalFilter)
+			&& (0 == session->convolutionFilter)
+			&& !session->isAutoExposureEnabled;
+}
+
+void Java_com_apress_aviplayer_BitmapPlayerActivity_reportPresent(
+		JNIEnv* env,
+		jclass clazz,
+		jlong avi,
+		jlong startTime,
+		jlong endTime)
+{
+	Session* session = (Session*) avi;
+
+	recordPresent(&session->statistics, endTime - startTime);
+
+#ifdef MY_TRACE_ENABLED
+	addTraceEvent("present", startTime, endTime);
+#endif
+}
+
 jboolean Java_com_apress_aviplayer_BitmapPlayerActivity_render(
 		JNIEnv* env,
 		jclass clazz,
 		jlong avi,
 		jobject bitmap)
 {
+	Session* session = (Session*) avi;
+
 	jboolean isFrameRead = JNI_FALSE;
 
+	AndroidBitmapInfo bitmapInfo;
 	char* frameBuffer = 0;
 	long frameSize = 0;
 	int keyFrame = 0;
+	int result = 0;
+	long long startTime = 0;
+	unsigned char brightness = 1;
+	BrightnessBand band;
+
+#ifdef MY_PERF_COUNTERS_ENABLED
+	// Count the render thread
+	if (0 == session->perfCounters)
+	{
+		session->perfCounters = createPerfCounters();
+	}
+
+	if (0 != session->perfCounters)
+	{
+		attachPerfCounters(session->perfCounters);
+	}
+#endif
+
+	// Get the bitmap geometry
+	if (0 > AndroidBitmap_getInfo(env, bitmap, &bitmapInfo))
+	{
+		ThrowException(env, "java/io/IOException", "Unable to get bitmap info.");
+		goto exit;
+	}
 
 	// Lock bitmap and get the raw bytes
-	if (0 > AndroidBitmap_lockPixels(env, bitmap, (void**) &frameBuffer))
+	{
+		TRACE_SCOPE("lock");
+		PERF_SCOPE(session->perfCounters, PERF_STAGE_LOCK);
+		result = AndroidBitmap_lockPixels(env, bitmap, (void**) &frameBuffer);
+	}
+
+	if (0 > result)
 	{
 		ThrowException(env, "java/io/IOException", "Unable to lock pixels.");
 		goto exit;
 	}
 
+	// Staging window for the fused read
+	if (0 == session->fusedReader)
+	{
+		session->fusedReader = createFusedReader(
+				AVI_video_width(session->avi),
+				Rgb565Format::BYTES_PER_PIXEL);
+	}
+
+	// Read, filter and write each band in one pass
+	if ((0 != session->fusedReader) && isFusedReadable(session))
+	{
+		band.brightness = brightness;
+		band.filterTime = 0;
+
+		startTime = GetTimeNanos();
+		{
+			TRACE_SCOPE("fused read");
+			PERF_SCOPE(session->perfCounters, PERF_STAGE_READ);
+			frameSize = readFusedFrame(session->fusedReader,
+					session->avi,
+					frameBuffer,
+					bitmapInfo.height,
+					bitmapInfo.stride,
+					brightnessBand,
+					&band);
+		}
+
+		// Band filter time is taken out of the read time
+		recordRead(&session->statistics, frameSize,
+				GetTimeNanos() - startTime - band.filterTime);
+
+		if (0 < frameSize)
+		{
+			recordFilter(&session->statistics, band.filterTime);
+		}
+
+		goto unlock;
+	}
+
 	// Read AVI frame bytes to bitmap
-	frameSize = AVI_read_frame((avi_t*) avi, frameBuffer, &keyFrame);
+	startTime = GetTimeNanos();
+	{
+		TRACE_SCOPE("read");
+		PERF_SCOPE(session->perfCounters, PERF_STAGE_READ);
+		frameSize = AVI_read_frame(session->avi, frameBuffer, &keyFrame);
+	}
+	recordRead(&session->statistics, frameSize, GetTimeNanos() - startTime);
 
-	// Apply the brigthness filter
-	brightnessFilter((unsigned short*) frameBuffer, frameSize/2, 1);
+	// Filter the frame
+	if (0 < frameSize)
+	{
+		startTime = GetTimeNanos();
+		filterFrame(session, frameBuffer, frameSize, bitmapInfo);
+		recordFilter(&session->statistics, GetTimeNanos() - startTime);
+	}
 
+unlock:
 	// Unlock bitmap
-	if (0 > AndroidBitmap_unlockPixels(env, bitmap))
+	{
+		TRACE_SCOPE("unlock");
+		PERF_SCOPE(session->perfCounters, PERF_STAGE_UNLOCK);
+		result = AndroidBitmap_unlockPixels(env, bitmap);
+	}
+
+	if (0 > result)
 	{
 		ThrowException(env, "java/io/IOException", "Unable to unlock pixels.");
 		goto exit;
@@ -49,4 +452,3 @@ jboolean Java_com_apress_aviplayer_BitmapPlayerActivity_render(
 exit:
 	return isFrameRead;
 }
-
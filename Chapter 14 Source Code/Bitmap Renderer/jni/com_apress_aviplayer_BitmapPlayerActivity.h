@@ -55,6 +55,88 @@ extern "C" {
 #define com_apress_aviplayer_BitmapPlayerActivity_DEFAULT_KEYS_SEARCH_LOCAL 3L
 #undef com_apress_aviplayer_BitmapPlayerActivity_DEFAULT_KEYS_SEARCH_GLOBAL
 #define com_apress_aviplayer_BitmapPlayerActivity_DEFAULT_KEYS_SEARCH_GLOBAL 4L
+#undef com_apress_aviplayer_BitmapPlayerActivity_STATS_FRAMES_READ
+#define com_apress_aviplayer_BitmapPlayerActivity_STATS_FRAMES_READ 0L
+#undef com_apress_aviplayer_BitmapPlayerActivity_STATS_FRAMES_PRESENTED
+#define com_apress_aviplayer_BitmapPlayerActivity_STATS_FRAMES_PRESENTED 1L
+#undef com_apress_aviplayer_BitmapPlayerActivity_STATS_BYTES_READ
+#define com_apress_aviplayer_BitmapPlayerActivity_STATS_BYTES_READ 2L
+#undef com_apress_aviplayer_BitmapPlayerActivity_STATS_READ_P50
+#define com_apress_aviplayer_BitmapPlayerActivity_STATS_READ_P50 3L
+#undef com_apress_aviplayer_BitmapPlayerActivity_STATS_READ_P90
+#define com_apress_aviplayer_BitmapPlayerActivity_STATS_READ_P90 4L
+#undef com_apress_aviplayer_BitmapPlayerActivity_STATS_READ_P99
+#define com_apress_aviplayer_BitmapPlayerActivity_STATS_READ_P99 5L
+#undef com_apress_aviplayer_BitmapPlayerActivity_STATS_READ_MAX
+#define com_apress_aviplayer_BitmapPlayerActivity_STATS_READ_MAX 6L
+#undef com_apress_aviplayer_BitmapPlayerActivity_STATS_FILTER_P50
+#define com_apress_aviplayer_BitmapPlayerActivity_STATS_FILTER_P50 7L
+#undef com_apress_aviplayer_BitmapPlayerActivity_STATS_FILTER_P90
+#define com_apress_aviplayer_BitmapPlayerActivity_STATS_FILTER_P90 8L
+#undef com_apress_aviplayer_BitmapPlayerActivity_STATS_FILTER_P99
+#define com_apress_aviplayer_BitmapPlayerActivity_STATS_FILTER_P99 9L
+#undef com_apress_aviplayer_BitmapPlayerActivity_STATS_FILTER_MAX
+#define com_apress_aviplayer_BitmapPlayerActivity_STATS_FILTER_MAX 10L
+#undef com_apress_aviplayer_BitmapPlayerActivity_STATS_PRESENT_P50
+#define com_apress_aviplayer_BitmapPlayerActivity_STATS_PRESENT_P50 11L
+#undef com_apress_aviplayer_BitmapPlayerActivity_STATS_PRESENT_P90
+#define com_apress_aviplayer_BitmapPlayerActivity_STATS_PRESENT_P90 12L
+#undef com_apress_aviplayer_BitmapPlayerActivity_STATS_PRESENT_P99
+#define com_apress_aviplayer_BitmapPlayerActivity_STATS_PRESENT_P99 13L
+#undef com_apress_aviplayer_BitmapPlayerActivity_STATS_PRESENT_MAX
+#define com_apress_aviplayer_BitmapPlayerActivity_STATS_PRESENT_MAX 14L
+#undef com_apress_aviplayer_BitmapPlayerActivity_STATS_SIZE
+#define com_apress_aviplayer_BitmapPlayerActivity_STATS_SIZE 15L
+#undef com_apress_aviplayer_BitmapPlayerActivity_CONVOLUTION_FILTER_NONE
+#define com_apress_aviplayer_BitmapPlayerActivity_CONVOLUTION_FILTER_NONE 0L
+#undef com_apress_aviplayer_BitmapPlayerActivity_CONVOLUTION_FILTER_BOX_BLUR
+#define com_apress_aviplayer_BitmapPlayerActivity_CONVOLUTION_FILTER_BOX_BLUR 1L
+#undef com_apress_aviplayer_BitmapPlayerActivity_CONVOLUTION_FILTER_GAUSSIAN_BLUR
+#define com_apress_aviplayer_BitmapPlayerActivity_CONVOLUTION_FILTER_GAUSSIAN_BLUR 2L
+#undef com_apress_aviplayer_BitmapPlayerActivity_CONVOLUTION_FILTER_UNSHARP_MASK
+#define com_apress_aviplayer_BitmapPlayerActivity_CONVOLUTION_FILTER_UNSHARP_MASK 3L
+#undef com_apress_aviplayer_BitmapPlayerActivity_CONVOLUTION_FILTER_SOBEL_EDGE
+#define com_apress_aviplayer_BitmapPlayerActivity_CONVOLUTION_FILTER_SOBEL_EDGE 4L
+/*
+ * Class:     com_apress_aviplayer_BitmapPlayerActivity
+ * Method:    setConvolutionFilter
+ * Signature: (JI)V
+ */
+JNIEXPORT void JNICALL Java_com_apress_aviplayer_BitmapPlayerActivity_setConvolutionFilter
+  (JNIEnv *, jclass, jlong, jint);
+
+/*
+ * Class:     com_apress_aviplayer_BitmapPlayerActivity
+ * Method:    setAutoExposure
+ * Signature: (JZ)V
+ */
+JNIEXPORT void JNICALL Java_com_apress_aviplayer_BitmapPlayerActivity_setAutoExposure
+  (JNIEnv *, jclass, jlong, jboolean);
+
+/*
+ * Class:     com_apress_aviplayer_BitmapPlayerActivity
+ * Method:    setTemporalDenoise
+ * Signature: (JI)V
+ */
+JNIEXPORT void JNICALL Java_com_apress_aviplayer_BitmapPlayerActivity_setTemporalDenoise
+  (JNIEnv *, jclass, jlong, jint);
+
+/*
+ * Class:     com_apress_aviplayer_BitmapPlayerActivity
+ * Method:    setOverlay
+ * Signature: (JLandroid/graphics/Bitmap;IIII)V
+ */
+JNIEXPORT void JNICALL Java_com_apress_aviplayer_BitmapPlayerActivity_setOverlay
+  (JNIEnv *, jclass, jlong, jobject, jint, jint, jint, jint);
+
+/*
+ * Class:     com_apress_aviplayer_BitmapPlayerActivity
+ * Method:    reportPresent
+ * Signature: (JJJ)V
+ */
+JNIEXPORT void JNICALL Java_com_apress_aviplayer_BitmapPlayerActivity_reportPresent
+  (JNIEnv *, jclass, jlong, jlong, jlong);
+
 /*
  * Class:     com_apress_aviplayer_BitmapPlayerActivity
  * Method:    render
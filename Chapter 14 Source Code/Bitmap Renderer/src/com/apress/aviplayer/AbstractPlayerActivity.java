@@ -15,6 +15,54 @@ public abstract class AbstractPlayerActivity extends Activity {
 	public static final String EXTRA_FILE_NAME = 
 			"com.apress.aviplayer.EXTRA_FILE_NAME";
 	
+	/** Frames read. */
+	public static final int STATS_FRAMES_READ = 0;
+	
+	/** Frames presented. */
+	public static final int STATS_FRAMES_PRESENTED = 1;
+	
+	/** Bytes read. */
+	public static final int STATS_BYTES_READ = 2;
+	
+	/** Read latency median in nanoseconds. */
+	public static final int STATS_READ_P50 = 3;
+	
+	/** Read latency 90th percentile in nanoseconds. */
+	public static final int STATS_READ_P90 = 4;
+	
+	/** Read latency 99th percentile in nanoseconds. */
+	public static final int STATS_READ_P99 = 5;
+	
+	/** Read latency maximum in nanoseconds. */
+	public static final int STATS_READ_MAX = 6;
+	
+	/** Filter latency median in nanoseconds. */
+	public static final int STATS_FILTER_P50 = 7;
+	
+	/** Filter latency 90th percentile in nanoseconds. */
+	public static final int STATS_FILTER_P90 = 8;
+	
+	/** Filter latency 99th percentile in nanoseconds. */
+	public static final int STATS_FILTER_P99 = 9;
+	
+	/** Filter latency maximum in nanoseconds. */
+	public static final int STATS_FILTER_MAX = 10;
+	
+	/** Present latency median in nanoseconds. */
+	public static final int STATS_PRESENT_P50 = 11;
+	
+	/** Present latency 90th percentile in nanoseconds. */
+	public static final int STATS_PRESENT_P90 = 12;
+	
+	/** Present latency 99th percentile in nanoseconds. */
+	public static final int STATS_PRESENT_P99 = 13;
+	
+	/** Present latency maximum in nanoseconds. */
+	public static final int STATS_PRESENT_MAX = 14;
+	
+	/** Number of stats values. */
+	public static final int STATS_SIZE = 15;
+	
 	/** AVI video file descriptor. */
 	protected long avi = 0;
 	
@@ -91,6 +139,16 @@ public abstract class AbstractPlayerActivity extends Activity {
 	 */
 	protected native static double getFrameRate(long avi);
 
+	/**
+	 * Gets the playback statistics. Does not block the
+	 * renderer, may be polled from any thread while the
+	 * file is open.
+	 * 
+	 * @param avi file descriptor.
+	 * @param stats array of at least STATS_SIZE values.
+	 */
+	protected native static void getStats(long avi, long[] stats);
+
 	/**
 	 * Closes the given AVI file based on given file descriptor.
 	 * 
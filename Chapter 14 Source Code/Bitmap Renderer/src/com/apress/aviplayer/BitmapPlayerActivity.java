@@ -1,6 +1,7 @@
 package com.apress.aviplayer;
 
 import java.util.concurrent.atomic.AtomicBoolean;
+import java.util.concurrent.atomic.AtomicReference;
 
 import android.graphics.Bitmap;
 import android.graphics.Canvas;
@@ -15,12 +16,75 @@ import android.view.SurfaceView;
  * @author Onur Cinar
  */
 public class BitmapPlayerActivity extends AbstractPlayerActivity {
+	/** Convolution filter extra. */
+	public static final String EXTRA_CONVOLUTION_FILTER =
+			"com.apress.aviplayer.EXTRA_CONVOLUTION_FILTER";
+
+	/** Auto exposure extra. */
+	public static final String EXTRA_AUTO_EXPOSURE =
+			"com.apress.aviplayer.EXTRA_AUTO_EXPOSURE";
+
+	/** Temporal denoise threshold extra, zero disables. */
+	public static final String EXTRA_TEMPORAL_DENOISE =
+			"com.apress.aviplayer.EXTRA_TEMPORAL_DENOISE";
+
+	/** No convolution filter. */
+	public static final int CONVOLUTION_FILTER_NONE = 0;
+
+	/** Box blur convolution filter. */
+	public static final int CONVOLUTION_FILTER_BOX_BLUR = 1;
+
+	/** Gaussian blur convolution filter. */
+	public static final int CONVOLUTION_FILTER_GAUSSIAN_BLUR = 2;
+
+	/** Unsharp mask convolution filter. */
+	public static final int CONVOLUTION_FILTER_UNSHARP_MASK = 3;
+
+	/** Sobel edge detection convolution filter. */
+	public static final int CONVOLUTION_FILTER_SOBEL_EDGE = 4;
+
+	/**
+	 * Overlay that is composited onto the frames.
+	 */
+	private static class Overlay {
+		/** Overlay bitmap, null removes the overlay. */
+		final Bitmap bitmap;
+		
+		/** Overlay position. */
+		final int left;
+		
+		/** Overlay position. */
+		final int top;
+		
+		/** Key color. */
+		final int keyColor;
+		
+		/** Key tolerance, zero disables chroma keying. */
+		final int keyTolerance;
+		
+		Overlay(Bitmap bitmap, int left, int top, int keyColor,
+				int keyTolerance) {
+			this.bitmap = bitmap;
+			this.left = left;
+			this.top = top;
+			this.keyColor = keyColor;
+			this.keyTolerance = keyTolerance;
+		}
+	}
+	
+	/** Overlay to apply before the next frame. */
+	private final AtomicReference<Overlay> pendingOverlay =
+			new AtomicReference<Overlay>();
+	
 	/** Is playing. */
 	private final AtomicBoolean isPlaying = new AtomicBoolean();
 	
 	/** Surface holder. */
 	private SurfaceHolder surfaceHolder;
 	
+	/** Render thread. */
+	private Thread renderThread;
+	
 	/**
 	 * On create.
 	 * 
@@ -36,6 +100,34 @@ public class BitmapPlayerActivity extends AbstractPlayerActivity {
 		surfaceHolder.addCallback(surfaceHolderCallback);
 	}
 
+	/**
+	 * Sets the overlay that is alpha blended onto the frames,
+	 * such as a logo or a subtitle. The overlay is copied by
+	 * the renderer before the next frame, so the bitmap can
+	 * be reused for the following overlay after that.
+	 * 
+	 * @param overlay ARGB_8888 overlay, or null to remove.
+	 * @param left overlay position.
+	 * @param top overlay position.
+	 */
+	public void setOverlay(Bitmap overlay, int left, int top) {
+		pendingOverlay.set(new Overlay(overlay, left, top, 0, 0));
+	}
+	
+	/**
+	 * Sets the background that replaces the key colored
+	 * pixels of the frames, like a green screen.
+	 * 
+	 * @param background ARGB_8888 background, or null to remove.
+	 * @param keyColor key color.
+	 * @param keyTolerance key tolerance per color component.
+	 */
+	public void setChromaKeyBackground(Bitmap background, int keyColor,
+			int keyTolerance) {
+		pendingOverlay.set(new Overlay(background, 0, 0, keyColor,
+				keyTolerance));
+	}
+
 	/**
 	 * Surface holder callback listens for surface events.
 	 */
@@ -49,12 +141,20 @@ public class BitmapPlayerActivity extends AbstractPlayerActivity {
 			isPlaying.set(true);
 			
 			// Start renderer on a separate thread
-			new Thread(renderer).start();
+			renderThread = new Thread(renderer);
+			renderThread.start();
 		}
 
 		public void surfaceDestroyed(SurfaceHolder holder) {
 			// Stop playing since surface is destroyed
 			isPlaying.set(false);
+			
+			// Wait for the renderer, the session is closed next
+			try {
+				renderThread.join();
+			} catch (InterruptedException e) {
+				Thread.currentThread().interrupt();
+			}
 		}
 	};
 	
@@ -70,15 +170,37 @@ public class BitmapPlayerActivity extends AbstractPlayerActivity {
 					getHeight(avi), 
 					Bitmap.Config.RGB_565);
 			
+			// Set the requested convolution filter
+			setConvolutionFilter(avi, getIntent().getIntExtra(
+					EXTRA_CONVOLUTION_FILTER, CONVOLUTION_FILTER_NONE));
+			
+			// Set the requested temporal denoise threshold
+			setTemporalDenoise(avi, getIntent().getIntExtra(
+					EXTRA_TEMPORAL_DENOISE, 0));
+			
+			// Enable the auto exposure if requested
+			setAutoExposure(avi, getIntent().getBooleanExtra(
+					EXTRA_AUTO_EXPOSURE, false));
+			
 			// Calculate the delay using the frame rate
 			long frameDelay = (long) (1000 / getFrameRate(avi));
 			
 			// Start rendering while playing
 			while (isPlaying.get()) {
+				// Apply the pending overlay
+				Overlay overlay = pendingOverlay.getAndSet(null);
+				if (overlay != null) {
+					setOverlay(avi, overlay.bitmap, overlay.left, overlay.top,
+							overlay.keyColor, overlay.keyTolerance);
+				}
+				
 				// Render the frame to the bitmap
 				if (!render(avi, bitmap))
 					break;
 				
+				// Start of the present
+				long presentTime = System.nanoTime();
+				
 				// Lock canvas
 				Canvas canvas = surfaceHolder.lockCanvas();
 				
@@ -88,6 +210,9 @@ public class BitmapPlayerActivity extends AbstractPlayerActivity {
 				// Post the canvas for displaying
 				surfaceHolder.unlockCanvasAndPost(canvas);
 				
+				// Report the present
+				reportPresent(avi, presentTime, System.nanoTime());
+				
 				// Wait for the next frame
 				try {
 					Thread.sleep(frameDelay);
@@ -98,6 +223,59 @@ public class BitmapPlayerActivity extends AbstractPlayerActivity {
 		}
 	};
 	
+	/**
+	 * Sets the convolution filter that is applied to the
+	 * frames before they are displayed.
+	 * 
+	 * @param avi file descriptor.
+	 * @param filter convolution filter type.
+	 */
+	private native static void setConvolutionFilter(long avi, int filter);
+	
+	/**
+	 * Enables or disables the auto exposure. When enabled the
+	 * brightness is derived from the frame luma histogram.
+	 * 
+	 * @param avi file descriptor.
+	 * @param enabled auto exposure enabled.
+	 */
+	private native static void setAutoExposure(long avi, boolean enabled);
+	
+	/**
+	 * Sets the temporal denoise threshold. Pixels that change
+	 * less than the threshold are blended with the previous
+	 * frames. Zero disables the filter.
+	 * 
+	 * @param avi file descriptor.
+	 * @param threshold motion threshold.
+	 */
+	private native static void setTemporalDenoise(long avi, int threshold);
+	
+	/**
+	 * Sets the overlay that is composited onto the frames.
+	 * 
+	 * @param avi file descriptor.
+	 * @param overlay ARGB_8888 overlay, or null to remove.
+	 * @param left overlay position.
+	 * @param top overlay position.
+	 * @param keyColor key color.
+	 * @param keyTolerance key tolerance, zero for alpha blending.
+	 */
+	private native static void setOverlay(long avi, Bitmap overlay, int left,
+			int top, int keyColor, int keyTolerance);
+	
+	/**
+	 * Reports a frame present for the statistics, and for
+	 * the native tracing if enabled. Times are from
+	 * System.nanoTime.
+	 * 
+	 * @param avi file descriptor.
+	 * @param startTime start time in nanoseconds.
+	 * @param endTime end time in nanoseconds.
+	 */
+	private native static void reportPresent(long avi, long startTime,
+			long endTime);
+	
 	/**
 	 * Renders the frame from given AVI file descriptor to
 	 * the given Bitmap.